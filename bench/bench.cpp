@@ -0,0 +1,178 @@
+/* ---------------------------------------------------------------------------
+Name:        bench.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench.hpp"
+#include "mem.h"
+
+namespace bench {
+
+    // Allocation counting
+
+    static size_t total_allocs = 0;
+
+    static void *
+    counting_alloc(size_t num, size_t size) {
+        total_allocs++;
+        return calloc(num, size);
+    }
+
+    static void
+    counting_free(void *ptr) {
+        free(ptr);
+    }
+
+    // State
+
+    State::State(size_t n_iterations) noexcept :
+        n_iterations(n_iterations),
+        remaining(n_iterations),
+        running(false),
+        elapsed(clock::duration::zero()),
+        start_allocs(0),
+        allocs(0) {
+    }
+
+    void
+    State::start() noexcept {
+        running = true;
+        start_allocs = total_allocs;
+        start_time = clock::now();
+    }
+
+    void
+    State::stop() noexcept {
+        elapsed = clock::now() - start_time;
+        allocs = total_allocs - start_allocs;
+        running = false;
+    }
+
+    bool
+    State::keep_running() noexcept {
+        if (!running && remaining == n_iterations)
+            start();
+        if (remaining > 0) {
+            remaining--;
+            return true;
+        }
+        if (running)
+            stop();
+        return false;
+    }
+
+    size_t
+    State::iterations() const noexcept {
+        return n_iterations;
+    }
+
+    double
+    State::elapsed_ns() const noexcept {
+        return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+
+    size_t
+    State::n_allocs() const noexcept {
+        return allocs;
+    }
+
+    // Registry
+
+    struct Benchmark {
+        std::string name;
+        BenchFunc func;
+    };
+
+    static std::vector<Benchmark> &
+    registry() {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    void
+    register_benchmark(const std::string &name, BenchFunc func) {
+        registry().push_back(Benchmark{name, func});
+    }
+
+    // Driver
+
+    static const size_t max_iterations = 1000000000;
+
+    static State
+    run_calibrated(const Benchmark &bm, double min_time_ns) {
+        size_t n = 1;
+        for (;;) {
+            State state(n);
+            bm.func(state);
+            double elapsed = state.elapsed_ns();
+            if (elapsed >= min_time_ns || n >= max_iterations)
+                return state;
+            // predict number of iterations needed, grow at most 10-fold
+            double factor = elapsed > 0. ? 1.4 * min_time_ns / elapsed : 10.;
+            if (factor > 10.)
+                factor = 10.;
+            size_t next = (size_t)((double)n * factor);
+            n = next > n ? next : n + 1;
+            if (n > max_iterations)
+                n = max_iterations;
+        }
+    }
+
+    int
+    run_benchmarks(int argc, char *argv[]) {
+        const char *filter = "";
+        double min_time = 0.2;
+        bool list_only = false;
+
+        for (int i = 1; i < argc; ++i) {
+            if (strncmp(argv[i], "--filter=", 9) == 0)
+                filter = argv[i] + 9;
+            else if (strncmp(argv[i], "--min-time=", 11) == 0)
+                min_time = atof(argv[i] + 11);
+            else if (strcmp(argv[i], "--list") == 0)
+                list_only = true;
+            else {
+                fprintf(stderr, "usage: %s [--filter=<substring>] "
+                                "[--min-time=<seconds>] [--list]\n",
+                        argv[0]);
+                return 1;
+            }
+        }
+
+        fpdec_set_mem_funcs(counting_alloc, counting_free);
+        if (!list_only)
+            printf("%-40s %14s %14s %12s\n", "Benchmark", "Time (ns/op)",
+                   "Iterations", "Allocs/op");
+        for (const auto &bm : registry()) {
+            if (strstr(bm.name.c_str(), filter) == NULL)
+                continue;
+            if (list_only) {
+                printf("%s\n", bm.name.c_str());
+                continue;
+            }
+            State state = run_calibrated(bm, min_time * 1e9);
+            double n = (double)state.iterations();
+            printf("%-40s %14.2f %14zu %12.2f\n", bm.name.c_str(),
+                   state.elapsed_ns() / n, state.iterations(),
+                   (double)state.n_allocs() / n);
+            fflush(stdout);
+        }
+        fpdec_set_mem_funcs(NULL, NULL);
+        return 0;
+    }
+
+} // namespace bench
@@ -0,0 +1,67 @@
+/* ---------------------------------------------------------------------------
+Name:        bench.hpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#ifndef FPDEC_BENCH_HPP
+#define FPDEC_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace bench {
+
+    // Minimal benchmark driver modelled after Google Benchmark: a
+    // benchmark function gets a State and loops while keep_running()
+    // returns true. The driver calibrates the number of iterations, times
+    // the loop and counts the allocations done through the library's
+    // allocator.
+
+    class State {
+    public:
+        explicit State(size_t n_iterations) noexcept;
+
+        bool keep_running() noexcept;
+
+        size_t iterations() const noexcept;
+        double elapsed_ns() const noexcept;
+        size_t n_allocs() const noexcept;
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        size_t n_iterations;
+        size_t remaining;
+        bool running;
+        clock::time_point start_time;
+        clock::duration elapsed;
+        size_t start_allocs;
+        size_t allocs;
+
+        void start() noexcept;
+        void stop() noexcept;
+    };
+
+    typedef std::function<void(State &)> BenchFunc;
+
+    void register_benchmark(const std::string &name, BenchFunc func);
+
+    // Runs all registered benchmarks whose name contains the filter given
+    // as --filter=<substring>; --min-time=<seconds> sets the minimal time
+    // per benchmark (default 0.2s), --list only prints the names.
+    int run_benchmarks(int argc, char *argv[]);
+
+} // namespace bench
+
+#endif //FPDEC_BENCH_HPP
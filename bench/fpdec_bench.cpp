@@ -0,0 +1,956 @@
+/* ---------------------------------------------------------------------------
+Name:        fpdec_bench.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "decimalcolumn.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+
+using bench::State;
+
+/*****************************************************************************
+*  Operands
+*****************************************************************************/
+
+// Each kind of operand is held in a pool of values with randomly chosen
+// digits; the benchmarks cycle through the pools, so that branch
+// prediction and caches see realistic, not constant, input.
+
+enum Kind {
+    // prices: up to 6 integral and up to 4 fractional digits
+    PRICE,
+    // shifted ints with 10 to 18 fractional digits
+    FINE,
+    // digit arrays with 20 to 30 fractional digits
+    DYN,
+    // digit arrays with some hundred digits
+    BIG,
+    N_KINDS
+};
+
+static const char *const kind_names[N_KINDS] = {
+    "price", "fine", "dyn", "big"
+};
+
+static const size_t pool_size = 1024;
+static const size_t pool_mask = pool_size - 1;
+
+static std::vector<std::string> literals[N_KINDS];
+static std::vector<fpdec_t> pools[N_KINDS];
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned
+rand_below(unsigned n) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (unsigned)((rng_state * 0x2545f4914f6cdd1dULL) >> 33) % n;
+}
+
+static unsigned
+rand_between(unsigned lo, unsigned hi) {
+    return lo + rand_below(hi - lo + 1);
+}
+
+static std::string
+random_literal(unsigned n_int_digits, unsigned n_frac_digits) {
+    std::string lit;
+    if (rand_below(4) == 0)
+        lit += '-';
+    // leading digit not zero, so that the value is never zero
+    lit += (char)('1' + rand_below(9));
+    for (unsigned i = 1; i < n_int_digits; ++i)
+        lit += (char)('0' + rand_below(10));
+    if (n_frac_digits > 0) {
+        lit += '.';
+        for (unsigned i = 0; i < n_frac_digits; ++i)
+            lit += (char)('0' + rand_below(10));
+    }
+    return lit;
+}
+
+static std::string
+random_literal_of_kind(Kind kind) {
+    switch (kind) {
+        case PRICE:
+            return random_literal(rand_between(1, 6), rand_between(0, 4));
+        case FINE:
+            return random_literal(rand_between(1, 10), rand_between(10, 18));
+        case DYN:
+            return random_literal(rand_between(10, 30),
+                                  rand_between(20, 30));
+        default:
+            return random_literal(rand_between(150, 250),
+                                  rand_between(50, 150));
+    }
+}
+
+static void
+init_pools() {
+    for (int k = 0; k < N_KINDS; ++k) {
+        literals[k].reserve(pool_size);
+        pools[k].resize(pool_size, FPDEC_ZERO);
+        for (size_t i = 0; i < pool_size; ++i) {
+            literals[k].push_back(random_literal_of_kind((Kind)k));
+            fpdec_from_ascii_literal(&pools[k][i], literals[k][i].c_str());
+        }
+    }
+}
+
+static void
+free_pools() {
+    for (int k = 0; k < N_KINDS; ++k)
+        for (auto &fpdec : pools[k])
+            fpdec_reset_to_zero(&fpdec, 0);
+}
+
+/*****************************************************************************
+*  Benchmarks
+*****************************************************************************/
+
+typedef error_t (*bin_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+
+static void
+bm_bin_op(State &state, bin_op op, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    fpdec_t z = FPDEC_ZERO;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        op(&z, &xs[i & pool_mask], &ys[(i * 7 + 3) & pool_mask]);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+// multiplication of two values with n_digits digits each, using the given
+// threshold for switching to Karatsuba multiplication
+static void
+bm_mul_huge(State &state, unsigned n_digits, size_t karatsuba_threshold) {
+    size_t saved_threshold = fpdec_get_karatsuba_threshold();
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+
+    fpdec_from_ascii_literal(&x, random_literal(n_digits, 0).c_str());
+    fpdec_from_ascii_literal(&y, random_literal(n_digits, 0).c_str());
+    fpdec_set_karatsuba_threshold(karatsuba_threshold);
+    while (state.keep_running()) {
+        fpdec_mul(&z, &x, &y);
+        fpdec_reset_to_zero(&z, 0);
+    }
+    fpdec_set_karatsuba_threshold(saved_threshold);
+    fpdec_reset_to_zero(&x, 0);
+    fpdec_reset_to_zero(&y, 0);
+}
+
+typedef error_t (*batch_op)(fpdec_t *, const fpdec_t *, const fpdec_t *,
+                            size_t);
+
+// one iteration processes the whole pool
+static void
+bm_batch_op(State &state, batch_op op, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    std::vector<fpdec_t> zs(pool_size, FPDEC_ZERO);
+
+    while (state.keep_running()) {
+        op(zs.data(), xs.data(), ys.data(), pool_size);
+        for (auto &z : zs)
+            fpdec_reset_to_zero(&z, 0);
+    }
+}
+
+static void
+bm_bin_op_pool(State &state, bin_op op, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    std::vector<fpdec_t> zs(pool_size, FPDEC_ZERO);
+
+    while (state.keep_running()) {
+        for (size_t i = 0; i < pool_size; ++i)
+            op(&zs[i], &xs[i], &ys[i]);
+        for (auto &z : zs)
+            fpdec_reset_to_zero(&z, 0);
+    }
+}
+
+static void
+bm_compare_n(State &state, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    std::vector<int> res(pool_size);
+
+    while (state.keep_running())
+        fpdec_compare_n(res.data(), xs.data(), ys.data(), pool_size, false);
+}
+
+static void
+bm_div(State &state, Kind kx, Kind ky, int prec_limit) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    fpdec_t z = FPDEC_ZERO;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_div(&z, &xs[i & pool_mask], &ys[(i * 7 + 3) & pool_mask],
+                  prec_limit, FPDEC_ROUND_DEFAULT);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_compare(State &state, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+    size_t i = 0;
+    volatile int sum = 0;
+
+    while (state.keep_running()) {
+        sum += fpdec_compare(&xs[i & pool_mask],
+                             &ys[(i * 7 + 3) & pool_mask], false);
+        ++i;
+    }
+}
+
+static void
+bm_from_ascii_literal(State &state, Kind kind) {
+    const std::vector<std::string> &lits = literals[kind];
+    fpdec_t z = FPDEC_ZERO;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_from_ascii_literal(&z, lits[i & pool_mask].c_str());
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_as_ascii_literal(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        char *lit = fpdec_as_ascii_literal(&xs[i & pool_mask], false);
+        fpdec_mem_free(lit);
+        ++i;
+    }
+}
+
+// Hashing via the canonical literal (without trailing zeros) is the
+// baseline for fpdec_hash
+static void
+bm_hash_via_literal(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile size_t sum = 0;
+
+    while (state.keep_running()) {
+        char *lit = fpdec_as_ascii_literal(&xs[i & pool_mask], true);
+        sum += std::hash<std::string>()(lit);
+        fpdec_mem_free(lit);
+        ++i;
+    }
+}
+
+static void
+bm_hash(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile size_t sum = 0;
+
+    while (state.keep_running()) {
+        sum += fpdec_hash(&xs[i & pool_mask]);
+        ++i;
+    }
+}
+
+static void
+bm_decimal128_round_trip(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        uint128_t bits;
+        fpdec_as_decimal128(&bits, &xs[i & pool_mask], FPDEC_IEEE_BID,
+                            FPDEC_ROUND_DEFAULT);
+        fpdec_from_decimal128(&z, bits, FPDEC_IEEE_BID);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+#ifdef __SIZEOF_INT128__
+
+// Minimal text <-> BID decimal128 conversions, standing in for those of a
+// decimal floating point library (coefficients are rounded half to even,
+// exponents are not checked).
+
+static unsigned __int128
+bid128_from_text(const char *text) {
+    const int max_digits = 34;
+    unsigned __int128 coeff = 0;
+    bool neg = *text == '-';
+    int n_digits = 0, q = 0, round_digit = -1;
+    bool sticky = false, in_frac = false;
+    const char *cp = text + (neg || *text == '+');
+
+    for (; *cp != '\0' && *cp != 'e' && *cp != 'E'; ++cp) {
+        if (*cp == '.') {
+            in_frac = true;
+            continue;
+        }
+        unsigned d = (unsigned)(*cp - '0');
+        if (n_digits < max_digits) {
+            coeff = coeff * 10 + d;
+            n_digits += coeff != 0;
+            q -= in_frac;
+        }
+        else {
+            q += !in_frac;
+            if (round_digit < 0)
+                round_digit = (int)d;
+            else
+                sticky = sticky || d != 0;
+        }
+    }
+    if (*cp != '\0')
+        q += atoi(cp + 1);
+    if (round_digit > 5 || (round_digit == 5 && (sticky || coeff % 2 != 0)))
+        ++coeff;
+    if (coeff == (unsigned __int128)10000000000000000ULL *
+                 1000000000000000000ULL) {
+        coeff /= 10;
+        ++q;
+    }
+    return (unsigned __int128)(neg ? 1U : 0U) << 127U |
+           (unsigned __int128)(q + 6176) << 113U | coeff;
+}
+
+// buf must hold at least 48 chars
+static void
+bid128_to_text(char *buf, unsigned __int128 bits) {
+    unsigned __int128 coeff = bits & (((unsigned __int128)1 << 113U) - 1);
+    int q = (int)(bits >> 113U & 0x3FFFU) - 6176;
+    char digits[36];
+    char *cp = digits + sizeof(digits);
+
+    *--cp = '\0';
+    do {
+        *--cp = (char)('0' + (unsigned)(coeff % 10));
+        coeff /= 10;
+    } while (coeff != 0);
+    snprintf(buf, 48, "%s%sE%d", bits >> 127U ? "-" : "", cp, q);
+}
+
+// Baseline: convert to and from decimal128 through text, as needed
+// without direct conversions
+static void
+bm_decimal128_round_trip_via_literal(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        char *lit = fpdec_as_ascii_literal(&xs[i & pool_mask], false);
+        char text[48];
+        bid128_to_text(text, bid128_from_text(lit));
+        fpdec_mem_free(lit);
+        fpdec_from_ascii_literal(&z, text);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+#endif // __SIZEOF_INT128__
+
+static void
+bm_as_double(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile double sum = 0.0;
+    double val;
+
+    while (state.keep_running()) {
+        fpdec_as_double(&val, &xs[i & pool_mask]);
+        sum += val;
+        ++i;
+    }
+}
+
+static void
+bm_as_double_via_literal(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile double sum = 0.0;
+
+    while (state.keep_running()) {
+        char *lit = fpdec_as_ascii_literal(&xs[i & pool_mask], false);
+        sum += strtod(lit, nullptr);
+        fpdec_mem_free(lit);
+        ++i;
+    }
+}
+
+static void
+bm_as_scaled_i64(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile int64_t sum = 0;
+    int64_t val;
+
+    while (state.keep_running()) {
+        fpdec_as_scaled_i64(&val, &xs[i & pool_mask], 2,
+                            FPDEC_ROUND_HALF_EVEN);
+        sum += val;
+        ++i;
+    }
+}
+
+static void
+bm_as_scaled_i64_via_literal(State &state, Kind kind) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+    volatile int64_t sum = 0;
+    char buf[64];
+    size_t len;
+
+    while (state.keep_running()) {
+        fpdec_t t = FPDEC_ZERO;
+        fpdec_adjusted(&t, &xs[i & pool_mask], 2, FPDEC_ROUND_HALF_EVEN);
+        fpdec_as_ascii_literal_to_buffer(buf, sizeof(buf), &len, &t, false);
+        // drop the decimal point
+        if (len < sizeof(buf) && len > 3) {
+            buf[len - 3] = buf[len - 2];
+            buf[len - 2] = buf[len - 1];
+            buf[len - 1] = '\0';
+        }
+        sum += strtoll(buf, nullptr, 10);
+        fpdec_reset_to_zero(&t, 0);
+        ++i;
+    }
+}
+
+static std::vector<double>
+doubles_of_kind(Kind kind) {
+    std::vector<double> vals(pool_size);
+
+    for (size_t i = 0; i < pool_size; ++i)
+        fpdec_as_double(&vals[i], &pools[kind][i]);
+    return vals;
+}
+
+static void
+bm_from_double_shortest(State &state, Kind kind) {
+    const std::vector<double> vals = doubles_of_kind(kind);
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        fpdec_from_double_shortest(&z, vals[i & pool_mask]);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_from_double_via_literal(State &state, Kind kind) {
+    const std::vector<double> vals = doubles_of_kind(kind);
+    size_t i = 0;
+    char buf[32];
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        snprintf(buf, sizeof(buf), "%.17g", vals[i & pool_mask]);
+        fpdec_from_ascii_literal(&z, buf);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_from_double_rounded(State &state, Kind kind, int32_t dec_prec) {
+    const std::vector<double> vals = doubles_of_kind(kind);
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        fpdec_from_double_rounded(&z, vals[i & pool_mask], dec_prec,
+                                  FPDEC_ROUND_HALF_EVEN);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_formatted(State &state, Kind kind, const char *fmt) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        uint8_t *buf = fpdec_formatted(&xs[i & pool_mask],
+                                       (const uint8_t *)fmt);
+        fpdec_mem_free(buf);
+        ++i;
+    }
+}
+
+static void
+bm_formatted_to_buffer(State &state, Kind kind, const char *fmt) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    uint8_t buf[512];
+    size_t len;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_formatted_to_buffer(buf, sizeof(buf), &len, &xs[i & pool_mask],
+                                  (const uint8_t *)fmt);
+        ++i;
+    }
+}
+
+static void
+bm_formatted_spec_to_buffer(State &state, Kind kind, const char *fmt) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    format_spec_t spec;
+    uint8_t buf[512];
+    size_t len;
+    size_t i = 0;
+
+    fpdec_format_compile(&spec, (const uint8_t *)fmt);
+    while (state.keep_running()) {
+        fpdec_formatted_spec_to_buffer(buf, sizeof(buf), &len,
+                                       &xs[i & pool_mask], &spec);
+        ++i;
+    }
+}
+
+static void
+bm_format_with(State &state, Kind kind, const char *fmt) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    format_spec_t spec;
+    size_t i = 0;
+
+    fpdec_format_compile(&spec, (const uint8_t *)fmt);
+    while (state.keep_running()) {
+        uint8_t *buf = fpdec_format_with(&xs[i & pool_mask], &spec);
+        fpdec_mem_free(buf);
+        ++i;
+    }
+}
+
+static void
+bm_adjusted(State &state, Kind kind, int32_t dec_prec) {
+    const std::vector<fpdec_t> &xs = pools[kind];
+    fpdec_t z = FPDEC_ZERO;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_adjusted(&z, &xs[i & pool_mask], dec_prec,
+                       FPDEC_ROUND_DEFAULT);
+        fpdec_reset_to_zero(&z, 0);
+        ++i;
+    }
+}
+
+static void
+bm_decimal_sum(State &state, Kind kind) {
+    std::vector<fpdec::Decimal> values;
+    for (const auto &lit : literals[kind])
+        values.emplace_back(lit);
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec::Decimal sum = values[i & pool_mask] +
+                             values[(i * 7 + 3) & pool_mask];
+        ++i;
+    }
+}
+
+// one iteration processes the whole pool, either as vector of Decimals or
+// as DecimalColumn
+static void
+bm_column_sum(State &state, Kind kind, bool columnar) {
+    std::vector<fpdec::Decimal> values;
+    for (const auto &lit : literals[kind])
+        values.emplace_back(lit);
+    const fpdec::DecimalColumn column(values);
+
+    while (state.keep_running()) {
+        if (columnar)
+            fpdec::Decimal sum = column.sum();
+        else {
+            fpdec::Accumulator acc;
+            for (const auto &val : values)
+                acc += val;
+            fpdec::Decimal sum = acc.sum();
+        }
+    }
+}
+
+static void
+bm_column_add(State &state, Kind kind, bool columnar) {
+    std::vector<fpdec::Decimal> values;
+    for (const auto &lit : literals[kind])
+        values.emplace_back(lit);
+    const fpdec::DecimalColumn column(values);
+
+    while (state.keep_running()) {
+        if (columnar)
+            fpdec::DecimalColumn res = column + column;
+        else {
+            std::vector<fpdec::Decimal> res;
+            res.reserve(pool_size);
+            for (const auto &val : values)
+                res.push_back(val + val);
+        }
+    }
+}
+
+static void
+bm_column_max(State &state, Kind kind, bool columnar) {
+    std::vector<fpdec::Decimal> values;
+    for (const auto &lit : literals[kind])
+        values.emplace_back(lit);
+    const fpdec::DecimalColumn column(values);
+
+    while (state.keep_running()) {
+        if (columnar)
+            fpdec::Decimal max = column.max();
+        else
+            fpdec::Decimal max = *std::max_element(values.begin(),
+                                                   values.end());
+    }
+}
+
+// one iteration shuffles 64k values (by moving them, so without
+// allocations) and sorts them; n_threads == 0 selects std::stable_sort
+static void
+bm_sort(State &state, Kind kind, unsigned n_threads) {
+    const size_t n = 1U << 16U;
+    std::vector<fpdec::Decimal> values;
+    for (size_t i = 0; i < n; ++i)
+        values.emplace_back(literals[kind][(i * 7 + i / pool_size) &
+                                           pool_mask]);
+
+    while (state.keep_running()) {
+        for (size_t i = n - 1; i > 0; --i)
+            std::swap(values[i], values[rand_below((unsigned)i + 1)]);
+        if (n_threads == 0)
+            std::stable_sort(values.begin(), values.end());
+        else
+            fpdec::stable_sort(values.data(), values.data() + n, n_threads);
+    }
+}
+
+// one iteration processes the whole pool
+static void
+bm_dot_mul_add(State &state, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+
+    while (state.keep_running()) {
+        fpdec_t sum = FPDEC_ZERO;
+        for (size_t i = 0; i < pool_size; ++i) {
+            fpdec_t prod = FPDEC_ZERO;
+            fpdec_t t = FPDEC_ZERO;
+            fpdec_mul(&prod, &xs[i], &ys[i]);
+            fpdec_add(&t, &sum, &prod);
+            fpdec_reset_to_zero(&prod, 0);
+            fpdec_reset_to_zero(&sum, 0);
+            sum = t;
+        }
+        fpdec_reset_to_zero(&sum, 0);
+    }
+}
+
+// one iteration processes the whole pool
+static void
+bm_dot(State &state, Kind kx, Kind ky) {
+    const std::vector<fpdec_t> &xs = pools[kx];
+    const std::vector<fpdec_t> &ys = pools[ky];
+
+    while (state.keep_running()) {
+        fpdec_t z = FPDEC_ZERO;
+        fpdec_dot(&z, xs.data(), ys.data(), pool_size);
+        fpdec_reset_to_zero(&z, 0);
+    }
+}
+
+static void
+bm_running_sum_add(State &state, Kind kind) {
+    const std::vector<fpdec_t> &pool = pools[kind];
+    fpdec_t sum = FPDEC_ZERO;
+    size_t i = 0;
+
+    while (state.keep_running()) {
+        fpdec_t t = FPDEC_ZERO;
+        fpdec_add(&t, &sum, &pool[i & pool_mask]);
+        fpdec_reset_to_zero(&sum, 0);
+        sum = t;
+        ++i;
+    }
+    fpdec_reset_to_zero(&sum, 0);
+}
+
+static void
+bm_running_sum_accumulator(State &state, Kind kind) {
+    const std::vector<fpdec_t> &pool = pools[kind];
+    fpdec_accumulator_t acc;
+    size_t i = 0;
+
+    fpdec_accumulator_init(&acc);
+    while (state.keep_running()) {
+        fpdec_accumulator_add(&acc, &pool[i & pool_mask]);
+        ++i;
+    }
+    fpdec_accumulator_reset(&acc);
+}
+
+/*****************************************************************************
+*  Registration
+*****************************************************************************/
+
+static std::string
+pair_name(const char *op, Kind kx, Kind ky) {
+    return std::string(op) + "/" + kind_names[kx] + "_x_" + kind_names[ky];
+}
+
+static void
+register_all() {
+    // the pairs cover all vtab dispatch paths
+    static const Kind pairs[][2] = {
+        {PRICE, PRICE},
+        {FINE, FINE},
+        {PRICE, FINE},
+        {PRICE, DYN},
+        {DYN, PRICE},
+        {DYN, DYN},
+        {BIG, BIG},
+        {BIG, PRICE},
+    };
+    static const struct {
+        const char *name;
+        bin_op op;
+    } bin_ops[] = {
+        {"add", fpdec_add},
+        {"sub", fpdec_sub},
+        {"mul", fpdec_mul},
+    };
+
+    for (const auto &bo : bin_ops)
+        for (const auto &p : pairs) {
+            bin_op op = bo.op;
+            Kind kx = p[0], ky = p[1];
+            bench::register_benchmark(
+                pair_name(bo.name, kx, ky),
+                [op, kx, ky](State &s) { bm_bin_op(s, op, kx, ky); });
+        }
+    for (unsigned n_digits : {500, 1000, 2000, 5000, 20000}) {
+        std::string name = "mul/huge_x_huge/" + std::to_string(n_digits);
+        bench::register_benchmark(
+            name + "/schoolbook",
+            [n_digits](State &s) { bm_mul_huge(s, n_digits, SIZE_MAX); });
+        bench::register_benchmark(
+            name + "/karatsuba",
+            [n_digits](State &s) {
+                bm_mul_huge(s, n_digits, fpdec_get_karatsuba_threshold());
+            });
+    }
+    static const struct {
+        const char *name;
+        bin_op op;
+        batch_op op_n;
+    } batch_ops[] = {
+        {"add", fpdec_add, fpdec_add_n},
+        {"sub", fpdec_sub, fpdec_sub_n},
+        {"mul", fpdec_mul, fpdec_mul_n},
+    };
+    static const Kind batch_pairs[][2] = {
+        {PRICE, PRICE},
+        {FINE, FINE},
+        {DYN, DYN},
+    };
+
+    for (const auto &bo : batch_ops)
+        for (const auto &p : batch_pairs) {
+            bin_op op = bo.op;
+            batch_op op_n = bo.op_n;
+            Kind kx = p[0], ky = p[1];
+            bench::register_benchmark(
+                pair_name(bo.name, kx, ky) + "/loop:1024",
+                [op, kx, ky](State &s) { bm_bin_op_pool(s, op, kx, ky); });
+            bench::register_benchmark(
+                pair_name(bo.name, kx, ky) + "/batch:1024",
+                [op_n, kx, ky](State &s) { bm_batch_op(s, op_n, kx, ky); });
+        }
+    for (const auto &p : batch_pairs) {
+        Kind kx = p[0], ky = p[1];
+        bench::register_benchmark(
+            pair_name("compare", kx, ky) + "/batch:1024",
+            [kx, ky](State &s) { bm_compare_n(s, kx, ky); });
+    }
+    for (const auto &p : batch_pairs) {
+        Kind kx = p[0], ky = p[1];
+        bench::register_benchmark(
+            pair_name("dot", kx, ky) + "/mul_add:1024",
+            [kx, ky](State &s) { bm_dot_mul_add(s, kx, ky); });
+        bench::register_benchmark(
+            pair_name("dot", kx, ky) + "/dot:1024",
+            [kx, ky](State &s) { bm_dot(s, kx, ky); });
+    }
+    for (const auto &p : pairs) {
+        Kind kx = p[0], ky = p[1];
+        bench::register_benchmark(
+            pair_name("div", kx, ky) + "/prec_limit:18",
+            [kx, ky](State &s) { bm_div(s, kx, ky, 18); });
+    }
+    for (const auto &p : pairs) {
+        Kind kx = p[0], ky = p[1];
+        bench::register_benchmark(
+            pair_name("div", kx, ky) + "/exact",
+            [kx, ky](State &s) { bm_div(s, kx, ky, -1); });
+    }
+    for (const auto &p : pairs) {
+        Kind kx = p[0], ky = p[1];
+        bench::register_benchmark(
+            pair_name("compare", kx, ky),
+            [kx, ky](State &s) { bm_compare(s, kx, ky); });
+    }
+    for (int k = 0; k < N_KINDS; ++k) {
+        Kind kind = (Kind)k;
+        std::string name = kind_names[k];
+        bench::register_benchmark(
+            "from_ascii_literal/" + name,
+            [kind](State &s) { bm_from_ascii_literal(s, kind); });
+        bench::register_benchmark(
+            "as_ascii_literal/" + name,
+            [kind](State &s) { bm_as_ascii_literal(s, kind); });
+        bench::register_benchmark(
+            "hash/" + name + "/via_literal",
+            [kind](State &s) { bm_hash_via_literal(s, kind); });
+        bench::register_benchmark(
+            "hash/" + name,
+            [kind](State &s) { bm_hash(s, kind); });
+#ifdef __SIZEOF_INT128__
+        bench::register_benchmark(
+            "decimal128/" + name + "/via_literal",
+            [kind](State &s) {
+                bm_decimal128_round_trip_via_literal(s, kind);
+            });
+#endif // __SIZEOF_INT128__
+        bench::register_benchmark(
+            "decimal128/" + name,
+            [kind](State &s) { bm_decimal128_round_trip(s, kind); });
+        bench::register_benchmark(
+            "as_double/" + name + "/via_literal",
+            [kind](State &s) { bm_as_double_via_literal(s, kind); });
+        bench::register_benchmark(
+            "as_double/" + name,
+            [kind](State &s) { bm_as_double(s, kind); });
+        bench::register_benchmark(
+            "as_scaled_i64/" + name + "/via_literal",
+            [kind](State &s) { bm_as_scaled_i64_via_literal(s, kind); });
+        bench::register_benchmark(
+            "as_scaled_i64/" + name,
+            [kind](State &s) { bm_as_scaled_i64(s, kind); });
+        bench::register_benchmark(
+            "from_double/" + name + "/via_literal",
+            [kind](State &s) { bm_from_double_via_literal(s, kind); });
+        bench::register_benchmark(
+            "from_double/" + name + "/shortest",
+            [kind](State &s) { bm_from_double_shortest(s, kind); });
+        bench::register_benchmark(
+            "from_double/" + name + "/rounded:2",
+            [kind](State &s) { bm_from_double_rounded(s, kind, 2); });
+        bench::register_benchmark(
+            "formatted/" + name + "/,.2f",
+            [kind](State &s) { bm_formatted(s, kind, ",.2f"); });
+        bench::register_benchmark(
+            "format_with/" + name + "/,.2f",
+            [kind](State &s) { bm_format_with(s, kind, ",.2f"); });
+        bench::register_benchmark(
+            "formatted_to_buffer/" + name + "/,.2f",
+            [kind](State &s) { bm_formatted_to_buffer(s, kind, ",.2f"); });
+        bench::register_benchmark(
+            "formatted_spec_to_buffer/" + name + "/,.2f",
+            [kind](State &s) {
+                bm_formatted_spec_to_buffer(s, kind, ",.2f");
+            });
+        bench::register_benchmark(
+            "adjusted/" + name + "/2",
+            [kind](State &s) { bm_adjusted(s, kind, 2); });
+        bench::register_benchmark(
+            "Decimal::operator+/" + name,
+            [kind](State &s) { bm_decimal_sum(s, kind); });
+        bench::register_benchmark(
+            "running_sum/" + name + "/add",
+            [kind](State &s) { bm_running_sum_add(s, kind); });
+        bench::register_benchmark(
+            "running_sum/" + name + "/accumulator",
+            [kind](State &s) { bm_running_sum_accumulator(s, kind); });
+        bench::register_benchmark(
+            "column_sum/" + name + "/decimals",
+            [kind](State &s) { bm_column_sum(s, kind, false); });
+        bench::register_benchmark(
+            "column_sum/" + name,
+            [kind](State &s) { bm_column_sum(s, kind, true); });
+        bench::register_benchmark(
+            "column_add/" + name + "/decimals",
+            [kind](State &s) { bm_column_add(s, kind, false); });
+        bench::register_benchmark(
+            "column_add/" + name,
+            [kind](State &s) { bm_column_add(s, kind, true); });
+        bench::register_benchmark(
+            "column_max/" + name + "/decimals",
+            [kind](State &s) { bm_column_max(s, kind, false); });
+        bench::register_benchmark(
+            "column_max/" + name,
+            [kind](State &s) { bm_column_max(s, kind, true); });
+        bench::register_benchmark(
+            "sort/" + name + "/std",
+            [kind](State &s) { bm_sort(s, kind, 0); });
+        bench::register_benchmark(
+            "sort/" + name,
+            [kind](State &s) { bm_sort(s, kind, 1); });
+        bench::register_benchmark(
+            "sort/" + name + "/4_threads",
+            [kind](State &s) { bm_sort(s, kind, 4); });
+    }
+}
+
+int
+main(int argc, char *argv[]) {
+    int rc;
+
+    init_pools();
+    register_all();
+    rc = bench::run_benchmarks(argc, argv);
+    free_pools();
+    return rc;
+}
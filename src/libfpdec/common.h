@@ -62,6 +62,16 @@ typedef struct fpdec_digit_array fpdec_digit_array_t;
 
 typedef struct fpdec_struct fpdec_t;
 
+typedef struct fpdec_accumulator fpdec_accumulator_t;
+
+// encodings of the IEEE 754 decimal interchange formats
+enum FPDEC_IEEE_ENCODING {
+    // binary integer decimal
+    FPDEC_IEEE_BID = 0,
+    // densely packed decimal
+    FPDEC_IEEE_DPD = 1,
+};
+
 /*****************************************************************************
 *  Macros
 *****************************************************************************/
@@ -88,6 +98,7 @@ typedef struct fpdec_struct fpdec_t;
 #define FPDEC_DIVIDE_BY_ZERO 5
 #define FPDEC_INVALID_FORMAT 6
 #define FPDEC_INCOMPAT_LOCALE 7
+#define FPDEC_INVALID_ENCODING 8
 
 #ifdef __cplusplus
 }
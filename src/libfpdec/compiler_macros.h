@@ -18,9 +18,11 @@ $Revision$
 #if defined(__GNUC__) || defined(__clang__)
 #define UNUSED __attribute__((unused))
 #define FALLTHROUGH __attribute__((fallthrough))
+#define THREAD_LOCAL __thread
 #else
 #define UNUSED
 #define FALLTHROUGH
+#define THREAD_LOCAL _Thread_local
 #endif
 
 #endif //FPDEC_COMPILER_MACROS_H
@@ -0,0 +1,579 @@
+/* ---------------------------------------------------------------------------
+Name:        decimalcolumn.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "decimalcolumn.hpp"
+#include "fpdec.h"
+
+#ifdef __SIZEOF_INT128__
+
+using namespace fpdec;
+
+namespace {
+
+    // flag in the high word of a coefficient marking an large value
+    const uint64_t LARGE_FLAG = 1ULL << 63U;
+    // 10 ^ 38 < 2 ^ 127 < 10 ^ 39
+    const unsigned MAX_N_DEC_DIGITS_IN_COEFF = 38;
+    // max n with 10 ^ n < 2 ^ 64
+    const unsigned UINT64_10_POW_N_CUTOFF = 19;
+
+    struct Pow10Table {
+        uint128_t val[MAX_N_DEC_DIGITS_IN_COEFF + 1];
+
+        Pow10Table() noexcept {
+            val[0] = 1U;
+            for (unsigned i = 1; i <= MAX_N_DEC_DIGITS_IN_COEFF; ++i)
+                val[i] = val[i - 1] * 10U;
+        }
+    };
+
+    const Pow10Table POW10;
+
+    inline uint128_t
+    coeff(const uint64_t lo, const uint64_t hi) noexcept {
+        return (uint128_t)hi << 64U | lo;
+    }
+
+    // Sets c = a * b; returns false if the product does not fit into 127
+    // bits.
+    inline bool
+    mul_checked(uint128_t *c, const uint128_t a, const uint128_t b) noexcept {
+        // the overflow check for 128-bit operands is much slower than a
+        // 64 x 64 bit multiplication
+        if ((a | b) >> 64U == 0) {
+            *c = (uint128_t)(uint64_t)a * (uint64_t)b;
+            return *c >> 127U == 0;
+        }
+        return !__builtin_mul_overflow(a, b, c) && *c >> 127U == 0;
+    }
+
+    // Multiplies the coefficient c (< 2 ^ 127) by 10 ^ n; returns false if
+    // the result does not fit into 127 bits.
+    inline bool
+    rescale(uint128_t *c, const unsigned n) noexcept {
+        if (n > MAX_N_DEC_DIGITS_IN_COEFF)
+            return *c == 0;
+        return mul_checked(c, *c, POW10.val[n]);
+    }
+
+    // Sets t to the coefficient (lo, hi) times 10 ^ d, if it fits into 64
+    // bits, and returns true in that case.
+    inline bool
+    scaled_to_u64(uint64_t *t, const uint64_t lo, const uint64_t hi,
+                  const unsigned d) noexcept {
+        const bool d_fits = d <= UINT64_10_POW_N_CUTOFF;
+        const uint128_t p = (uint128_t)lo * (uint64_t)POW10.val[d_fits ? d :
+                                                                 0];
+        *t = (uint64_t)p;
+        return d_fits & (hi == 0) & (p >> 64U == 0);
+    }
+
+    // Number of decimal digits of c (0 < c < 2 ^ 127)
+    inline int
+    n_dec_digits(const uint128_t c) noexcept {
+        const uint64_t hi = (uint64_t)(c >> 64U);
+        const int n_bits = hi != 0 ? 128 - __builtin_clzll(hi) :
+                           64 - __builtin_clzll((uint64_t)c);
+        // n_bits * log10(2) <= n_dec_digits < n_bits * log10(2) + 1
+        const int n = (n_bits * 1233) >> 12U;
+        return n + (c >= POW10.val[n]);
+    }
+
+    inline void
+    check_same_size(const size_t lhs, const size_t rhs) {
+        if (lhs != rhs)
+            throw std::invalid_argument("Columns differ in size.");
+    }
+
+    // Adds s0 + s1 * 2 ^ 64 + s2 * 2 ^ 128 to the 256-bit value held in
+    // limbs
+    void
+    add_sums(uint64_t limbs[4], const uint128_t s0, const uint128_t s1,
+             const uint128_t s2) noexcept {
+        uint128_t t = (uint128_t)limbs[0] + (uint64_t)s0;
+        limbs[0] = (uint64_t)t;
+        t = (t >> 64U) + limbs[1] + (uint64_t)(s0 >> 64U) + (uint64_t)s1;
+        limbs[1] = (uint64_t)t;
+        t = (t >> 64U) + limbs[2] + (uint64_t)(s1 >> 64U) + (uint64_t)s2;
+        limbs[2] = (uint64_t)t;
+        limbs[3] += (uint64_t)(t >> 64U) + (uint64_t)(s2 >> 64U);
+    }
+
+    // Sums of positive and negative coefficients with the same precision
+    struct SumBucket {
+        fpdec_dec_prec_t prec{0};
+        uint64_t pos[4]{0, 0, 0, 0};
+        uint64_t neg[4]{0, 0, 0, 0};
+    };
+
+    // Sets diff to |x - y| and returns the sign of x - y
+    fpdec_sign_t
+    sub_limbs(uint64_t diff[4], const uint64_t x[4], const uint64_t y[4]) {
+        int i = 3;
+        uint64_t borrow = 0;
+
+        for (; i >= 0 && x[i] == y[i]; --i);
+        if (i < 0) {
+            diff[0] = diff[1] = diff[2] = diff[3] = 0;
+            return FPDEC_SIGN_ZERO;
+        }
+        if (x[i] < y[i])
+            return (fpdec_sign_t)-sub_limbs(diff, y, x);
+        for (i = 0; i < 4; ++i) {
+            diff[i] = x[i] - y[i] - borrow;
+            borrow = x[i] < y[i] || (x[i] == y[i] && borrow);
+        }
+        return FPDEC_SIGN_POS;
+    }
+
+} // namespace
+
+// *** class DecimalColumn *** -----------------------------------------------
+
+// constructor
+
+DecimalColumn::DecimalColumn(const std::vector<Decimal> &vals) {
+    reserve(vals.size());
+    for (const Decimal &val : vals)
+        push_back(val);
+}
+
+// properties
+
+size_t DecimalColumn::size() const noexcept {
+    return sign_.size();
+}
+
+bool DecimalColumn::empty() const noexcept {
+    return sign_.empty();
+}
+
+// element access
+
+Decimal DecimalColumn::operator[](const size_t idx) const {
+    if (hi_[idx] & LARGE_FLAG)
+        return large_[lo_[idx]];
+    return as_decimal(sign_[idx], prec_[idx], coeff(lo_[idx], hi_[idx]));
+}
+
+void DecimalColumn::push_back(const Decimal &val) {
+    resize(size() + 1);
+    store(size() - 1, val);
+}
+
+void DecimalColumn::reserve(const size_t n) {
+    sign_.reserve(n);
+    prec_.reserve(n);
+    lo_.reserve(n);
+    hi_.reserve(n);
+}
+
+void DecimalColumn::clear() noexcept {
+    sign_.clear();
+    prec_.clear();
+    lo_.clear();
+    hi_.clear();
+    large_.clear();
+}
+
+// raw arrays
+
+const fpdec_sign_t *DecimalColumn::signs() const noexcept {
+    return sign_.data();
+}
+
+const fpdec_dec_prec_t *DecimalColumn::precisions() const noexcept {
+    return prec_.data();
+}
+
+const uint64_t *DecimalColumn::coeffs_lo() const noexcept {
+    return lo_.data();
+}
+
+const uint64_t *DecimalColumn::coeffs_hi() const noexcept {
+    return hi_.data();
+}
+
+bool DecimalColumn::is_inline(const size_t idx) const noexcept {
+    return (hi_[idx] & LARGE_FLAG) == 0;
+}
+
+// element-wise operations
+
+DecimalColumn DecimalColumn::operator+(const DecimalColumn &rhs) const {
+    const size_t n = size();
+    DecimalColumn res;
+
+    check_same_size(n, rhs.size());
+    res.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        res.add_elem(i, *this, i, rhs, i, FPDEC_SIGN_POS);
+    return res;
+}
+
+DecimalColumn DecimalColumn::operator-(const DecimalColumn &rhs) const {
+    const size_t n = size();
+    DecimalColumn res;
+
+    check_same_size(n, rhs.size());
+    res.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        res.add_elem(i, *this, i, rhs, i, FPDEC_SIGN_NEG);
+    return res;
+}
+
+DecimalColumn DecimalColumn::operator*(const DecimalColumn &rhs) const {
+    const size_t n = size();
+    DecimalColumn res;
+
+    check_same_size(n, rhs.size());
+    res.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        res.mul_elem(i, *this, i, rhs, i);
+    return res;
+}
+
+std::vector<int> DecimalColumn::compare(const DecimalColumn &rhs) const {
+    const size_t n = size();
+
+    check_same_size(n, rhs.size());
+    std::vector<int> res(n);
+    for (size_t i = 0; i < n; ++i)
+        res[i] = compare_elem(i, rhs, i);
+    return res;
+}
+
+// aggregates
+
+Decimal DecimalColumn::sum() const {
+    const size_t n = size();
+    fpdec_dec_prec_t prec = 0;
+    uint128_t pos_sum = 0U;
+    uint128_t neg_sum = 0U;
+    size_t n_rest = 0;
+    std::vector<SumBucket> buckets(1);
+    size_t k = 0;
+    Accumulator acc;
+
+    // max precision of the non-zero values
+    for (size_t i = 0; i < n; ++i)
+        prec = std::max(prec, (fpdec_dec_prec_t)(prec_[i] &
+                                                 -(sign_[i] != 0)));
+
+    // Inline values whose coefficient, scaled to prec by a 64-bit power of
+    // ten, fits into 64 bits are summed up branch-free in separate sums for
+    // positive and negative values.
+    for (size_t i = 0; i < n; ++i) {
+        // wraps around for zeros with a precision greater than prec
+        const unsigned d = (unsigned)prec - prec_[i];
+        uint64_t t;
+        const uint64_t use =
+            0 - (uint64_t)(scaled_to_u64(&t, lo_[i], hi_[i], d) |
+                           (sign_[i] == 0));
+        const uint64_t is_neg = 0 - (uint64_t)(sign_[i] < 0);
+        pos_sum += t & use & ~is_neg;
+        neg_sum += t & use & is_neg;
+        n_rest += 1U + use;
+    }
+    buckets[0].prec = prec;
+    add_sums(buckets[0].pos, pos_sum, 0U, 0U);
+    add_sums(buckets[0].neg, neg_sum, 0U, 0U);
+
+    // The other inline values are summed up unscaled, separately for each
+    // precision, the large values are added to acc.
+    for (size_t i = 0; n_rest > 0 && i < n; ++i) {
+        const unsigned d = (unsigned)prec - prec_[i];
+        uint64_t t;
+        if (sign_[i] == 0 || scaled_to_u64(&t, lo_[i], hi_[i], d))
+            continue;
+        --n_rest;
+        if (hi_[i] & LARGE_FLAG) {
+            acc += large_[lo_[i]];
+            continue;
+        }
+        if (buckets[k].prec != prec_[i]) {
+            for (k = 0; k < buckets.size() &&
+                        buckets[k].prec != prec_[i]; ++k);
+            if (k == buckets.size()) {
+                buckets.emplace_back();
+                buckets[k].prec = prec_[i];
+            }
+        }
+        add_sums(sign_[i] < 0 ? buckets[k].neg : buckets[k].pos,
+                 coeff(lo_[i], hi_[i]), 0U, 0U);
+    }
+
+    for (const SumBucket &bucket : buckets)
+        acc += bucket_as_decimal(bucket.prec, bucket.pos, bucket.neg);
+    return Decimal(acc.sum(), prec);
+}
+
+Decimal DecimalColumn::min() const {
+    return (*this)[select(-1)];
+}
+
+Decimal DecimalColumn::max() const {
+    return (*this)[select(1)];
+}
+
+// private helpers
+
+void DecimalColumn::resize(const size_t n) {
+    sign_.resize(n);
+    prec_.resize(n);
+    lo_.resize(n);
+    hi_.resize(n);
+}
+
+// Returns a reference to the large value or to buf, set to the inline
+// value
+const Decimal &DecimalColumn::get(const size_t idx, Decimal &buf) const {
+    if (hi_[idx] & LARGE_FLAG)
+        return large_[lo_[idx]];
+    buf = as_decimal(sign_[idx], prec_[idx], coeff(lo_[idx], hi_[idx]));
+    return buf;
+}
+
+void DecimalColumn::store(const size_t idx, Decimal val) {
+    const fpdec_t *x = &val.fpdec;
+    fpdec_sign_t sign;
+    uint128_t c;
+    int64_t exp;
+
+    if (!FPDEC_IS_DYN_ALLOC(x)) {
+        store_inline(idx, FPDEC_SIGN(x), FPDEC_DEC_PREC(x),
+                     coeff(x->lo, x->hi));
+        return;
+    }
+    // val = c * 10 ^ exp with exp >= -dec_prec
+    if (fpdec_as_sign_coeff128_exp(&sign, &c, &exp, x) == 0 &&
+        c >> 127U == 0 && exp + FPDEC_DEC_PREC(x) >= 0 &&
+        rescale(&c, (unsigned)(exp + FPDEC_DEC_PREC(x)))) {
+        store_inline(idx, sign, FPDEC_DEC_PREC(x), c);
+        return;
+    }
+    sign_[idx] = FPDEC_SIGN(x);
+    prec_[idx] = FPDEC_DEC_PREC(x);
+    lo_[idx] = large_.size();
+    hi_[idx] = LARGE_FLAG;
+    large_.push_back(std::move(val));
+}
+
+void DecimalColumn::store_inline(const size_t idx, const fpdec_sign_t sign,
+                                 const fpdec_dec_prec_t prec,
+                                 const uint128_t c) {
+    sign_[idx] = sign;
+    prec_[idx] = prec;
+    lo_[idx] = (uint64_t)c;
+    hi_[idx] = (uint64_t)(c >> 64U);
+}
+
+void DecimalColumn::copy_elem(const size_t idx, const DecimalColumn &src,
+                              const size_t src_idx) {
+    if (src.hi_[src_idx] & LARGE_FLAG) {
+        store(idx, src.large_[src.lo_[src_idx]]);
+        return;
+    }
+    sign_[idx] = src.sign_[src_idx];
+    prec_[idx] = src.prec_[src_idx];
+    lo_[idx] = src.lo_[src_idx];
+    hi_[idx] = src.hi_[src_idx];
+}
+
+// Sets element idx to x[i] + y_sign * y[j], with y_sign = +1 or -1
+void DecimalColumn::add_elem(const size_t idx, const DecimalColumn &x,
+                             const size_t i, const DecimalColumn &y,
+                             const size_t j, const fpdec_sign_t y_sign) {
+    const fpdec_sign_t x_sign_i = x.sign_[i];
+    const fpdec_sign_t y_sign_j = (fpdec_sign_t)(y.sign_[j] * y_sign);
+
+    if (((x.hi_[i] | y.hi_[j]) & LARGE_FLAG) == 0) {
+        const fpdec_dec_prec_t prec = std::max(x.prec_[i], y.prec_[j]);
+        uint128_t a = coeff(x.lo_[i], x.hi_[i]);
+        uint128_t b = coeff(y.lo_[j], y.hi_[j]);
+
+        // same as fpdec_add / fpdec_sub: a zero operand gives the other one
+        if (x_sign_i == FPDEC_SIGN_ZERO) {
+            copy_elem(idx, y, j);
+            sign_[idx] = y_sign_j;
+            return;
+        }
+        if (y_sign_j == FPDEC_SIGN_ZERO) {
+            copy_elem(idx, x, i);
+            return;
+        }
+        if (rescale(&a, prec - x.prec_[i]) &&
+            rescale(&b, prec - y.prec_[j])) {
+            if (x_sign_i != y_sign_j) {
+                if (a >= b)
+                    store_inline(idx, a == b ? FPDEC_SIGN_ZERO : x_sign_i,
+                                 prec, a - b);
+                else
+                    store_inline(idx, y_sign_j, prec, b - a);
+                return;
+            }
+            // a, b < 2 ^ 127 => a + b < 2 ^ 128
+            if ((a + b) >> 127U == 0) {
+                store_inline(idx, x_sign_i, prec, a + b);
+                return;
+            }
+        }
+    }
+    Decimal x_buf, y_buf;
+    const Decimal &x_i = x.get(i, x_buf);
+    const Decimal &y_j = y.get(j, y_buf);
+    store(idx, y_sign == FPDEC_SIGN_POS ? x_i + y_j : x_i - y_j);
+}
+
+void DecimalColumn::mul_elem(const size_t idx, const DecimalColumn &x,
+                             const size_t i, const DecimalColumn &y,
+                             const size_t j) {
+    if (((x.hi_[i] | y.hi_[j]) & LARGE_FLAG) == 0) {
+        const unsigned prec = (unsigned)x.prec_[i] + y.prec_[j];
+        uint128_t c;
+
+        // same as fpdec_mul: a zero operand gives 0 with precision 0
+        if (x.sign_[i] == FPDEC_SIGN_ZERO || y.sign_[j] == FPDEC_SIGN_ZERO) {
+            store_inline(idx, FPDEC_SIGN_ZERO, 0, 0U);
+            return;
+        }
+        if (prec <= FPDEC_MAX_DEC_PREC &&
+            mul_checked(&c, coeff(x.lo_[i], x.hi_[i]),
+                        coeff(y.lo_[j], y.hi_[j]))) {
+            store_inline(idx, (fpdec_sign_t)(x.sign_[i] * y.sign_[j]),
+                         (fpdec_dec_prec_t)prec, c);
+            return;
+        }
+    }
+    Decimal x_buf, y_buf;
+    store(idx, x.get(i, x_buf) * y.get(j, y_buf));
+}
+
+int DecimalColumn::compare_elem(const size_t i, const DecimalColumn &y,
+                                const size_t j) const {
+    const fpdec_sign_t x_sign_i = sign_[i];
+    uint128_t a, b;
+
+    int x_magn, y_magn;
+
+    if (x_sign_i != y.sign_[j])
+        return x_sign_i < y.sign_[j] ? -1 : 1;
+    if (x_sign_i == FPDEC_SIGN_ZERO)
+        return 0;
+    if ((hi_[i] | y.hi_[j]) & LARGE_FLAG) {
+        // values of different magnitude need not be converted
+        x_magn = magnitude_elem(i);
+        y_magn = y.magnitude_elem(j);
+        if (x_magn != y_magn)
+            return x_magn < y_magn ? -x_sign_i : x_sign_i;
+        Decimal x_buf, y_buf;
+        const Decimal &x_i = get(i, x_buf);
+        const Decimal &y_j = y.get(j, y_buf);
+        return x_i < y_j ? -1 : y_j < x_i ? 1 : 0;
+    }
+    a = coeff(lo_[i], hi_[i]);
+    b = coeff(y.lo_[j], y.hi_[j]);
+    // a coefficient exceeding 127 bits after rescaling is greater than
+    // the other one
+    if (prec_[i] < y.prec_[j]) {
+        if (!rescale(&a, y.prec_[j] - prec_[i]))
+            return x_sign_i;
+    }
+    else if (!rescale(&b, prec_[i] - y.prec_[j]))
+        return -x_sign_i;
+    return a < b ? -x_sign_i : a > b ? x_sign_i : 0;
+}
+
+// Same as Decimal::magnitude for a non-zero element
+int DecimalColumn::magnitude_elem(const size_t idx) const {
+    if (hi_[idx] & LARGE_FLAG)
+        return large_[lo_[idx]].magnitude();
+    return n_dec_digits(coeff(lo_[idx], hi_[idx])) - 1 - prec_[idx];
+}
+
+// Returns (pos - neg) * 10 ^ -prec, with pos and neg given as 256-bit
+// values
+Decimal DecimalColumn::bucket_as_decimal(const fpdec_dec_prec_t prec,
+                                         const uint64_t pos[4],
+                                         const uint64_t neg[4]) {
+    uint64_t diff[4];
+    const fpdec_sign_t sign = sub_limbs(diff, pos, neg);
+    const uint128_t lo = coeff(diff[0], diff[1]);
+    const uint128_t hi = coeff(diff[2], diff[3]);
+
+    if (hi == 0U)
+        return as_decimal(sign, prec, lo);
+    const Decimal radix = as_decimal(FPDEC_SIGN_POS, 0, (uint128_t)1U << 64U);
+    return as_decimal(sign, prec, hi) * radix * radix +
+           as_decimal(sign, prec, lo);
+}
+
+// Returns the index of the first min (dir = -1) resp. max (dir = 1) element
+size_t DecimalColumn::select(const int dir) const {
+    const size_t n = size();
+    size_t res = 0;
+
+    if (n == 0)
+        throw std::out_of_range("Empty column.");
+    for (size_t i = 1; i < n; ++i)
+        if (compare_elem(i, *this, res) == dir)
+            res = i;
+    return res;
+}
+
+Decimal DecimalColumn::as_decimal(const fpdec_sign_t sign,
+                                  const fpdec_dec_prec_t prec, uint128_t c) {
+    // c < 2 ^ 128 has at most 39 decimal digits, filled up with at most 18
+    // zeros
+    fpdec_digit_t digits[4];
+    size_t n_digits = 0;
+    unsigned n_frac_digits, n_fill;
+    uint64_t split;
+    Decimal dec;
+    error_t err;
+
+    if (sign == FPDEC_SIGN_ZERO) {
+        dec.fpdec.dec_prec = prec;
+        return dec;
+    }
+    if (prec <= FPDEC_MAX_DEC_PREC_FOR_SHINT && c >> 96U == 0) {
+        // fits into a shifted int
+        dec.fpdec.sign = sign;
+        dec.fpdec.dec_prec = prec;
+        dec.fpdec.lo = (uint64_t)c;
+        dec.fpdec.hi = (uint32_t)(c >> 64U);
+        return dec;
+    }
+    // digits (base 10 ^ 19) of c * 10 ^ -prec, with the fractional part
+    // filled up with zeros to a multiple of 19 decimal digits
+    n_frac_digits = (prec + DEC_DIGITS_PER_DIGIT - 1) / DEC_DIGITS_PER_DIGIT;
+    n_fill = n_frac_digits * DEC_DIGITS_PER_DIGIT - prec;
+    split = (uint64_t)POW10.val[DEC_DIGITS_PER_DIGIT - n_fill];
+    digits[n_digits++] = (fpdec_digit_t)(c % split) *
+                         (fpdec_digit_t)POW10.val[n_fill];
+    for (c /= split; c != 0; c /= RADIX)
+        digits[n_digits++] = (fpdec_digit_t)(c % RADIX);
+    err = fpdec_from_sign_digits_exp(&dec.fpdec, sign, n_digits, digits,
+                                     -(fpdec_exp_t)n_frac_digits);
+    if (err == FPDEC_OK)
+        err = fpdec_adjust(&dec.fpdec, prec, FPDEC_ROUND_DEFAULT);
+    if (err == ENOMEM)
+        throw std::bad_alloc();
+    return dec;
+}
+
+#endif // __SIZEOF_INT128__
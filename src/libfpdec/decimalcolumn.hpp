@@ -0,0 +1,107 @@
+/* ---------------------------------------------------------------------------
+Name:        decimalcolumn.hpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#ifndef FPDEC_DECIMALCOLUMN_HPP
+#define FPDEC_DECIMALCOLUMN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "fpdecimal.hpp"
+
+#ifdef __SIZEOF_INT128__
+
+namespace fpdec {
+
+    // Column of Decimals stored as structure of arrays: the signs, the
+    // precisions and the low and high 64 bits of the coefficients (i.e. the
+    // absolute values times 10 ^ precision) are held in separate contiguous
+    // arrays. Values whose coefficient does not fit into 127 bits (large
+    // values) are kept as Decimals in a vector owned by the column; for
+    // them the high word holds a flag and the low word the index into that
+    // vector. Each of them has its own digit array, allocated like that of
+    // any other Decimal, i.e. they are not packed into shared storage.
+    // The element-wise operations and the aggregates work on the arrays
+    // directly and fall back to Decimal arithmetic only for large values,
+    // for precisions too far apart and on overflow. Their results are equal
+    // to those of the corresponding Decimal operations (resp. an
+    // Accumulator for sum), including the precision.
+    // So, the column pays off for values fitting into 127 bits; operations
+    // on columns dominated by large values are slower than on a
+    // std::vector<Decimal>, due to the additional indirection.
+    // The element-wise operations throw std::invalid_argument if the columns
+    // differ in size, min and max throw std::out_of_range if the column is
+    // empty.
+
+    class DecimalColumn {
+    public:
+        DecimalColumn() noexcept = default;
+        explicit DecimalColumn(const std::vector<Decimal> &);
+        // properties
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        // element access
+        Decimal operator[](size_t) const;
+        void push_back(const Decimal &);
+        void reserve(size_t);
+        void clear() noexcept;
+        // raw arrays
+        const fpdec_sign_t *signs() const noexcept;
+        const fpdec_dec_prec_t *precisions() const noexcept;
+        const uint64_t *coeffs_lo() const noexcept;
+        const uint64_t *coeffs_hi() const noexcept;
+        // true if the element is held in the arrays, not as large value
+        bool is_inline(size_t) const noexcept;
+        // element-wise operations
+        DecimalColumn operator+(const DecimalColumn &) const;
+        DecimalColumn operator-(const DecimalColumn &) const;
+        DecimalColumn operator*(const DecimalColumn &) const;
+        // -1, 0 or 1 for each pair of elements (see Decimal::operator<)
+        std::vector<int> compare(const DecimalColumn &) const;
+        // aggregates
+        Decimal sum() const;
+        Decimal min() const;
+        Decimal max() const;
+
+    private:
+        std::vector<fpdec_sign_t> sign_;
+        std::vector<fpdec_dec_prec_t> prec_;
+        std::vector<uint64_t> lo_;
+        std::vector<uint64_t> hi_;
+        std::vector<Decimal> large_;
+
+        void resize(size_t);
+        const Decimal &get(size_t, Decimal &) const;
+        void store(size_t, Decimal);
+        void store_inline(size_t, fpdec_sign_t, fpdec_dec_prec_t,
+                          uint128_t);
+        void copy_elem(size_t, const DecimalColumn &, size_t);
+        void add_elem(size_t, const DecimalColumn &, size_t,
+                      const DecimalColumn &, size_t, fpdec_sign_t);
+        void mul_elem(size_t, const DecimalColumn &, size_t,
+                      const DecimalColumn &, size_t);
+        int compare_elem(size_t, const DecimalColumn &, size_t) const;
+        int magnitude_elem(size_t) const;
+        size_t select(int) const;
+        static Decimal as_decimal(fpdec_sign_t, fpdec_dec_prec_t,
+                                  uint128_t);
+        static Decimal bucket_as_decimal(fpdec_dec_prec_t, const uint64_t *,
+                                         const uint64_t *);
+    };
+
+}; // namespace fpdec
+
+#endif // __SIZEOF_INT128__
+
+#endif //FPDEC_DECIMALCOLUMN_HPP
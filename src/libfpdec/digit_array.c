@@ -14,12 +14,14 @@ $Revision$
 */
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <string.h>
 
 #include "basemath.h"
 #include "compiler_macros.h"
 #include "digit_array.h"
 #include "digit_array_struct.h"
+#include "fpdec.h"
 #include "rounding_helper.h"
 
 
@@ -63,45 +65,50 @@ digits_copy(const fpdec_digit_array_t *src, fpdec_n_digits_t n_shift,
     return result;
 }
 
-static inline fpdec_digit_t
-dec_digits_to_digit(const dec_digit_t *start, const dec_digit_t *stop) {
-    fpdec_digit_t digit = 0;
-    for (; start < stop; ++start) {
-        digit *= 10;
-        digit += *start;
+fpdec_digit_array_t *
+digits_enlarged(const fpdec_digit_array_t *src, fpdec_n_digits_t n_shift,
+                fpdec_n_digits_t n_alloc) {
+    fpdec_n_digits_t n_signif = src == NULL ? 0 : src->n_signif;
+    fpdec_digit_array_t *result;
+
+    assert(n_alloc >= n_signif + n_shift);
+
+    result = digits_alloc(n_alloc);
+    if (result != NULL && n_signif > 0) {
+        result->n_signif = n_signif + n_shift;
+        memcpy(result->digits + n_shift, src->digits,
+               n_signif * sizeof(fpdec_digit_t));
     }
-    return digit;
+    return result;
 }
 
 error_t
-digits_from_dec_coeff_exp(fpdec_digit_array_t **digit_array, fpdec_exp_t *exp,
-                          size_t n_dec_digits, const dec_digit_t *coeff,
-                          int64_t dec_exp) {
-    size_t n_digits, n_dec_shift;
+digits_from_dec_repr(fpdec_digit_array_t **digit_array, fpdec_exp_t *exp,
+                     const dec_repr_t *dec_repr) {
+    size_t n_dec_digits = dec_repr->n_dec_digits;
+    size_t n_digits, n_dec_shift, n_leading;
     fpdec_digit_t *digit;
-    const dec_digit_t *chunk_start, *chunk_stop;
+    dec_digits_reader_t reader;
 
     assert(n_dec_digits > 0);
 
-    *exp = FLOOR(dec_exp, DEC_DIGITS_PER_DIGIT);
-    n_dec_shift = (size_t)MOD(dec_exp, DEC_DIGITS_PER_DIGIT);
+    *exp = FLOOR(dec_repr->exp, DEC_DIGITS_PER_DIGIT);
+    n_dec_shift = (size_t)MOD(dec_repr->exp, DEC_DIGITS_PER_DIGIT);
     n_digits = CEIL(n_dec_digits + n_dec_shift, DEC_DIGITS_PER_DIGIT);
     *digit_array = digits_alloc(n_digits);
     if (*digit_array == NULL)
         MEMERROR;
 
-    digit = (*digit_array)->digits;
-    chunk_stop = coeff + n_dec_digits;
-    chunk_start = MAX(chunk_stop + n_dec_shift - DEC_DIGITS_PER_DIGIT, coeff);
-    while (chunk_stop > coeff) {
-        *digit = dec_digits_to_digit(chunk_start, chunk_stop);
-        digit++;
-        chunk_stop = chunk_start;
-        chunk_start = MAX(chunk_start - DEC_DIGITS_PER_DIGIT, coeff);
-    }
-    // least significant digit to be shifted?
-    if (n_dec_shift > 0) {
-        (*digit_array)->digits[0] *= u64_10_pow_n(n_dec_shift);
+    // fill in digits from most to least significant; the reader supplies
+    // the zeros needed to shift the least significant digit
+    n_leading = n_dec_digits + n_dec_shift -
+                (n_digits - 1) * DEC_DIGITS_PER_DIGIT;
+    dec_digits_reader_init(&reader, dec_repr);
+    digit = (*digit_array)->digits + n_digits - 1;
+    *digit = dec_digits_read(&reader, n_leading);
+    while (digit > (*digit_array)->digits) {
+        digit--;
+        *digit = dec_digits_read(&reader, DEC_DIGITS_PER_DIGIT);
     }
     // cut-off leading zeroes
     digit = (*digit_array)->digits + n_digits - 1;
@@ -227,6 +234,63 @@ int digits_cmp(fpdec_digit_t *x_digits, fpdec_n_digits_t x_n_digits,
 
 // Basic arithmetic operations
 
+// Helpers operating on spans of digits
+
+// z[0..nz) += y[0..ny), nz >= ny; returns carry out of z
+static unsigned
+span_iadd(fpdec_digit_t *z, size_t nz, const fpdec_digit_t *y, size_t ny) {
+    fpdec_digit_t *z_digit = z;
+    fpdec_digit_t *z_over = z + nz;
+    const fpdec_digit_t *y_over = y + ny;
+    unsigned carry = 0;
+
+    assert(nz >= ny);
+
+    for (; y < y_over; ++y, ++z_digit) {
+        *z_digit += *y + carry;
+        carry = (*z_digit < *y || *z_digit >= RADIX);
+        if (carry)
+            *z_digit -= RADIX;
+    }
+    for (; carry && z_digit < z_over; ++z_digit) {
+        if (*z_digit == MAX_DIGIT)
+            *z_digit = 0;
+        else {
+            (*z_digit)++;
+            carry = 0;
+        }
+    }
+    return carry;
+}
+
+// z[0..nz) -= y[0..ny), nz >= ny; returns borrow out of z
+static unsigned
+span_isub(fpdec_digit_t *z, size_t nz, const fpdec_digit_t *y, size_t ny) {
+    fpdec_digit_t *z_digit = z;
+    fpdec_digit_t *z_over = z + nz;
+    const fpdec_digit_t *y_over = y + ny;
+    fpdec_digit_t d;
+    unsigned borrow = 0;
+
+    assert(nz >= ny);
+
+    for (; y < y_over; ++y, ++z_digit) {
+        d = *z_digit - (*y + borrow);
+        borrow = (d > *z_digit);
+        *z_digit = borrow ? d + RADIX : d;
+    }
+    for (; borrow && z_digit < z_over; ++z_digit) {
+        if (*z_digit == 0)
+            *z_digit = MAX_DIGIT;
+        else {
+            (*z_digit)--;
+            borrow = 0;
+        }
+    }
+    return borrow;
+}
+
+
 bool
 digits_iadd_digit(fpdec_digit_array_t *x, fpdec_digit_t y) {
     bool ovfl = false;
@@ -253,7 +317,7 @@ digits_iadd_digit(fpdec_digit_array_t *x, fpdec_digit_t y) {
 void
 digits_iadd_digits(fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
     fpdec_digit_t *x_digit = x->digits;
-    fpdec_digit_t *total_carry_over_digit = x->digits + x->n_signif;
+    fpdec_digit_t *total_carry_over_digit;
     const fpdec_digit_t *y_digit = y->digits;
     const fpdec_digit_t *y_over = y->digits + y->n_signif;
     unsigned carry = 0;
@@ -261,9 +325,11 @@ digits_iadd_digits(fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
     assert(y->n_signif > 0);
     assert(x->n_alloc > y->n_signif);
     assert(x->n_alloc > x->n_signif);
-    assert(*total_carry_over_digit == 0);
 
     x->n_signif = MAX(x->n_signif, y->n_signif);
+    // the carry-over must be checked above the longer operand
+    total_carry_over_digit = x->digits + x->n_signif;
+    assert(*total_carry_over_digit == 0);
     while (y_digit < y_over) {
         *x_digit += *y_digit + carry;
         carry = (*x_digit < *y_digit || *x_digit >= RADIX);
@@ -315,6 +381,34 @@ digits_isub_digits(fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
         x->n_signif--;
 }
 
+bool
+digits_iadd_digits_shifted(fpdec_digit_array_t *x, const fpdec_digit_t *y,
+                           fpdec_n_digits_t n_y, fpdec_n_digits_t n_shift) {
+    size_t n_signif = MAX((size_t)x->n_signif, (size_t)n_shift + n_y);
+
+    if (n_signif >= x->n_alloc)
+        return false;
+    // digits beyond n_signif are not necessarily zero
+    digits_set_zero(x->digits + x->n_signif, n_signif + 1 - x->n_signif);
+    span_iadd(x->digits + n_shift, n_signif + 1 - n_shift, y, n_y);
+    x->n_signif = n_signif + (x->digits[n_signif] != 0);
+    return true;
+}
+
+bool
+digits_isub_digits_shifted(fpdec_digit_array_t *x, const fpdec_digit_t *y,
+                           fpdec_n_digits_t n_y, fpdec_n_digits_t n_shift) {
+    unsigned UNUSED borrow;
+
+    if ((size_t)n_shift + n_y > x->n_signif)
+        return false;
+    borrow = span_isub(x->digits + n_shift, x->n_signif - n_shift, y, n_y);
+    assert(borrow == 0);
+    while (x->n_signif > 0 && x->digits[x->n_signif - 1] == 0)
+        x->n_signif--;
+    return true;
+}
+
 void
 digits_imul_digit(fpdec_digit_array_t *x, fpdec_digit_t y) {
     fpdec_digit_t *x_over = x->digits + x->n_signif;
@@ -342,29 +436,26 @@ digits_imul_digit(fpdec_digit_array_t *x, fpdec_digit_t y) {
     }
 }
 
+// Helpers for multiplication
+
+// z[0..nx+ny) = x[0..nx) * y[0..ny)
 // See D. E. Knuth, The Art of Computer Programming, Vol. 2, Ch. 4.3.1,
 // Algorithm M
-fpdec_digit_array_t *
-digits_mul(const fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
-    fpdec_digit_array_t *z;
+static void
+span_mul_basecase(fpdec_digit_t *z, const fpdec_digit_t *x, size_t nx,
+                  const fpdec_digit_t *y, size_t ny) {
     fpdec_digit_t *z_digit;
     fpdec_digit_t *z_carry;
     uint128_t t;
 
-    assert(x->n_signif > 0);
-    assert(y->n_signif > 0);
-
-    z = digits_alloc(x->n_signif + y->n_signif);
-    if (z == NULL)
-        MEMERROR_RETVAL(NULL);
-
-    z_carry = z->digits + x->n_signif;
-    for (fpdec_n_digits_t j = 0; j < y->n_signif; ++j) {
-        z_digit = z->digits + j;
-        for (fpdec_n_digits_t i = 0; i < x->n_signif; ++i) {
-            // x->digits[i] <= RADIX - 1 and y->digits[j] <= RADIX - 1 and
+    digits_set_zero(z, nx + ny);
+    z_carry = z + nx;
+    for (size_t j = 0; j < ny; ++j) {
+        z_digit = z + j;
+        for (size_t i = 0; i < nx; ++i) {
+            // x[i] <= RADIX - 1 and y[j] <= RADIX - 1 and
             // *z_digit <= RADIX - 1 and *z_carry <= RADIX - 1
-            u64_mul_u64(&t, x->digits[i], y->digits[j]);
+            u64_mul_u64(&t, x[i], y[j]);
             // t <= RADIX * RADIX - 2 * RADIX + 1
             u128_iadd_u64(&t, *z_digit);
             // t <= RADIX * RADIX - RADIX
@@ -379,6 +470,177 @@ digits_mul(const fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
         }
         z_carry++;
     }
+}
+
+// Operands with at least karatsuba_threshold digits are multiplied using
+// Karatsuba's method. The threshold must be >= 4, so that the operands of
+// the recursive calls are always shorter than the given ones.
+// The threshold may be changed by any thread at any time, so digits_mul
+// reads it once and passes it down to the functions below (which size the
+// scratch space and recurse according to it).
+
+#define KARATSUBA_MIN_THRESHOLD 4
+#define KARATSUBA_DEFAULT_THRESHOLD 24
+
+static atomic_size_t karatsuba_threshold = KARATSUBA_DEFAULT_THRESHOLD;
+
+size_t
+fpdec_get_karatsuba_threshold(void) {
+    return atomic_load_explicit(&karatsuba_threshold, memory_order_relaxed);
+}
+
+void
+fpdec_set_karatsuba_threshold(size_t n_digits) {
+    atomic_store_explicit(&karatsuba_threshold,
+                          MAX(n_digits, KARATSUBA_MIN_THRESHOLD),
+                          memory_order_relaxed);
+}
+
+// Number of digits needed as scratch space by span_mul_karatsuba
+static size_t
+karatsuba_scratch_size(size_t n, size_t threshold) {
+    size_t size = 0, m;
+
+    while (n >= threshold) {
+        m = n - n / 2;
+        size += 4 * (m + 1);
+        n = m + 1;
+    }
+    return size;
+}
+
+// z[0..2n) = x[0..n) * y[0..n)
+// With x = x1 * B + x0 and y = y1 * B + y0 (B = RADIX ^ h):
+// x * y = x1 * y1 * B^2 + ((x0 + x1) * (y0 + y1) - x0 * y0 - x1 * y1) * B
+//         + x0 * y0
+static void
+span_mul_karatsuba(fpdec_digit_t *z, const fpdec_digit_t *x,
+                   const fpdec_digit_t *y, size_t n, fpdec_digit_t *scratch,
+                   size_t threshold) {
+    size_t h, m;
+    fpdec_digit_t *sx, *sy, *p;
+
+    if (n < threshold) {
+        span_mul_basecase(z, x, n, y, n);
+        return;
+    }
+
+    h = n / 2;
+    m = n - h;
+    sx = scratch;
+    sy = sx + m + 1;
+    p = sy + m + 1;
+    scratch = p + 2 * (m + 1);
+
+    // sx = x0 + x1, sy = y0 + y1
+    memcpy(sx, x + h, m * sizeof(fpdec_digit_t));
+    sx[m] = 0;
+    span_iadd(sx, m + 1, x, h);
+    memcpy(sy, y + h, m * sizeof(fpdec_digit_t));
+    sy[m] = 0;
+    span_iadd(sy, m + 1, y, h);
+
+    span_mul_karatsuba(p, sx, sy, m + 1, scratch, threshold);
+    span_mul_karatsuba(z, x, y, h, scratch, threshold);
+    span_mul_karatsuba(z + 2 * h, x + h, y + h, m, scratch, threshold);
+
+    // p = x0 * y1 + x1 * y0 < RADIX ^ (n + 1), so it fits into z[h..2n)
+    span_isub(p, 2 * (m + 1), z, 2 * h);
+    span_isub(p, 2 * (m + 1), z + 2 * h, 2 * m);
+    span_iadd(z + h, 2 * n - h, p, MIN(2 * (m + 1), 2 * n - h));
+}
+
+// Number of digits needed as scratch space by span_mul
+static size_t
+span_mul_scratch_size(size_t nx, size_t ny, size_t threshold) {
+    size_t r;
+
+    assert(nx >= ny);
+
+    if (ny < threshold)
+        return 0;
+    if (nx == ny)
+        return karatsuba_scratch_size(ny, threshold);
+    r = nx % ny;
+    return 2 * ny +
+           MAX(karatsuba_scratch_size(ny, threshold),
+               r > 0 ? span_mul_scratch_size(ny, r, threshold) : 0);
+}
+
+// z[0..nx+ny) = x[0..nx) * y[0..ny), nx >= ny
+// Unbalanced operands are multiplied by splitting the longer one into chunks
+// of the length of the shorter one.
+static void
+span_mul(fpdec_digit_t *z, const fpdec_digit_t *x, size_t nx,
+         const fpdec_digit_t *y, size_t ny, fpdec_digit_t *scratch,
+         size_t threshold) {
+    fpdec_digit_t *t;
+    size_t offset;
+
+    assert(nx >= ny);
+
+    if (ny < threshold) {
+        span_mul_basecase(z, x, nx, y, ny);
+        return;
+    }
+    if (nx == ny) {
+        span_mul_karatsuba(z, x, y, nx, scratch, threshold);
+        return;
+    }
+
+    t = scratch;
+    scratch = t + 2 * ny;
+    digits_set_zero(z, nx + ny);
+    for (offset = 0; offset + ny <= nx; offset += ny) {
+        span_mul_karatsuba(t, x + offset, y, ny, scratch, threshold);
+        span_iadd(z + offset, nx + ny - offset, t, 2 * ny);
+    }
+    if (offset < nx) {
+        span_mul(t, y, ny, x + offset, nx - offset, scratch, threshold);
+        span_iadd(z + offset, nx + ny - offset, t, ny + nx - offset);
+    }
+}
+
+void
+digits_mul_digits(fpdec_digit_t *z, const fpdec_digit_t *x,
+                  fpdec_n_digits_t n_x,
+                  const fpdec_digit_t *y, fpdec_n_digits_t n_y) {
+    span_mul_basecase(z, x, n_x, y, n_y);
+}
+
+fpdec_digit_array_t *
+digits_mul(const fpdec_digit_array_t *x, const fpdec_digit_array_t *y) {
+    const size_t threshold = fpdec_get_karatsuba_threshold();
+    fpdec_digit_array_t *z;
+    fpdec_digit_t *scratch = NULL;
+    size_t n_scratch;
+
+    assert(x->n_signif > 0);
+    assert(y->n_signif > 0);
+
+    if (x->n_signif < y->n_signif) {
+        const fpdec_digit_array_t *t = x;
+        x = y;
+        y = t;
+    }
+
+    z = digits_alloc(x->n_signif + y->n_signif);
+    if (z == NULL)
+        MEMERROR_RETVAL(NULL);
+
+    n_scratch = span_mul_scratch_size(x->n_signif, y->n_signif, threshold);
+    if (n_scratch > 0) {
+        scratch = (fpdec_digit_t *)fpdec_mem_alloc(n_scratch,
+                                                   sizeof(fpdec_digit_t));
+        if (scratch == NULL) {
+            fpdec_mem_free(z);
+            MEMERROR_RETVAL(NULL);
+        }
+    }
+    span_mul(z->digits, x->digits, x->n_signif, y->digits, y->n_signif,
+             scratch, threshold);
+    if (scratch != NULL)
+        fpdec_mem_free(scratch);
     z->n_signif = z->n_alloc;
     return z;
 }
@@ -425,6 +687,62 @@ digits_div_digit(const fpdec_digit_array_t *x,
     return q;
 }
 
+// Steps D3 - D6 of Algorithm D (see below): divides u[0..n] by the
+// normalized divisor v[0..n - 1] (v[n] must be 0), where u[1..n] < v, and
+// replaces u by the remainder. Returns the quotient digit.
+static fpdec_digit_t
+digits_div_step(fpdec_digit_t *u, const fpdec_digit_t *v,
+                const fpdec_n_digits_t n) {
+    const fpdec_n_digits_t n_1 = n - 1;
+    const fpdec_n_digits_t n_2 = n - 2;
+    fpdec_digit_t qhat, rhat, carry, borrow;
+    uint128_t t1, t2;
+
+    // D3: calculate qhat and rhat
+    u64_mul_u64(&t1, u[n], RADIX);
+    u128_iadd_u64(&t1, u[n_1]);
+    rhat = u128_idiv_u64(&t1, v[n_1]);
+    assert(U128_HI(t1) == 0);
+    qhat = U128_LO(t1);
+    u64_mul_u64(&t1, qhat, v[n_2]);
+    u64_mul_u64(&t2, rhat, RADIX);
+    u128_iadd_u64(&t2, u[n_2]);
+    while (qhat >= RADIX || u128_cmp(t1, t2) == 1) {
+        --qhat;
+        // rhat + v[n_1] may exceed UINT64_MAX, so check before adding
+        if (rhat >= RADIX - v[n_1])
+            break;
+        rhat += v[n_1];
+        u128_isub_u64(&t1, v[n_2]);
+        u64_mul_u64(&t2, rhat, RADIX);
+        u128_iadd_u64(&t2, u[n_2]);
+    }
+    // D4: multiply and subtract
+    carry = 0;
+    borrow = 0;
+    for (fpdec_n_digits_t i = 0; i <= n; ++i) {
+        u64_mul_u64(&t1, qhat, v[i]);
+        u128_iadd_u64(&t1, carry);
+        rhat = u128_idiv_radix(&t1);
+        carry = U128_LO(t1);
+        rhat = u[i] - (rhat + borrow);
+        borrow = (rhat > u[i]);
+        u[i] = borrow ? rhat + RADIX : rhat;
+    }
+    // D5: test remainder
+    if (borrow == 0)
+        return qhat;
+    // D6: add back
+    carry = 0;
+    for (fpdec_n_digits_t i = 0; i <= n; ++i) {
+        u[i] += v[i] + carry;
+        carry = (u[i] < v[i] || u[i] >= RADIX);
+        if (carry)
+            u[i] -= RADIX;
+    }
+    return qhat - 1;
+}
+
 // See D. E. Knuth, The Art of Computer Programming, Vol. 2, Ch. 4.3.1,
 // Algorithm D
 fpdec_digit_array_t *
@@ -433,11 +751,8 @@ digits_divmod(const fpdec_digit_array_t *x, const fpdec_n_digits_t x_n_shift,
               fpdec_digit_array_t **rem) {
     const fpdec_n_digits_t m = x->n_signif + x_n_shift;
     const fpdec_n_digits_t n = y->n_signif + y_n_shift;
-    const fpdec_n_digits_t n_1 = n - 1;
-    const fpdec_n_digits_t n_2 = n - 2;
-    fpdec_digit_t d, qhat, rhat, carry, borrow;
+    fpdec_digit_t d;
     fpdec_digit_array_t *xd, *yd, *q;
-    uint128_t t1, t2;
 
     assert(n > 1);
     assert(m >= n);
@@ -463,54 +778,10 @@ digits_divmod(const fpdec_digit_array_t *x, const fpdec_n_digits_t x_n_shift,
     }
     digits_imul_digit(yd, d);
 
-    // D2: loop j from m - n to 0
-    for (int64_t j = m - n; j >= 0; --j) {
-        // D3: calculate qhat and rhat
-        u64_mul_u64(&t1, xd->digits[j + n], RADIX);
-        u128_iadd_u64(&t1, xd->digits[j + n_1]);
-        rhat = u128_idiv_u64(&t1, yd->digits[n_1]);
-        assert(U128_HI(t1) == 0);
-        qhat = U128_LO(t1);
-        u64_mul_u64(&t1, qhat, yd->digits[n_2]);
-        u64_mul_u64(&t2, rhat, RADIX);
-        u128_iadd_u64(&t2, xd->digits[j + n_2]);
-        while (qhat >= RADIX || u128_cmp(t1, t2) == 1) {
-            --qhat;
-            rhat += yd->digits[n_1];
-            if (rhat >= RADIX)
-                break;
-            u128_isub_u64(&t1, yd->digits[n_2]);
-            u64_mul_u64(&t2, rhat, RADIX);
-            u128_iadd_u64(&t2, xd->digits[j + n_2]);
-        }
-        // D4: multiply and subtract
-        carry = 0;
-        borrow = 0;
-        for (fpdec_n_digits_t i = 0; i <= n; ++i) {
-            u64_mul_u64(&t1, qhat, yd->digits[i]);
-            u128_iadd_u64(&t1, carry);
-            rhat = u128_idiv_radix(&t1);
-            carry = U128_LO(t1);
-            rhat = xd->digits[j + i] - (rhat + borrow);
-            borrow = (rhat > xd->digits[j + i]);
-            xd->digits[j + i] = borrow ? rhat + RADIX : rhat;
-        }
-        // D5: test remainder
-        if (borrow == 0)
-            q->digits[j] = qhat;
-        else {
-            // D6: add back
-            q->digits[j] = qhat - 1;
-            carry = 0;
-            for (fpdec_n_digits_t i = 0; i <= n; ++i) {
-                xd->digits[j + i] += yd->digits[i] + carry;
-                carry = (xd->digits[j + i] < yd->digits[i] ||
-                    xd->digits[j + i] >= RADIX);
-                if (carry)
-                    xd->digits[j + i] -= RADIX;
-            }
-        }
-    } // D7: loop j
+    // D2: loop j from m - n to 0, D3 - D6: see digits_div_step
+    for (int64_t j = m - n; j >= 0; --j)
+        q->digits[j] = digits_div_step(xd->digits + j, yd->digits, n);
+    // D7: loop j
     q->n_signif = q->n_alloc;
     // D8: unnormalize (if remainder is wanted)
     if (rem != NULL)
@@ -522,54 +793,125 @@ digits_divmod(const fpdec_digit_array_t *x, const fpdec_n_digits_t x_n_shift,
     return q;
 }
 
+static void
+digits_div_free_buffers(fpdec_digit_array_t *xd, fpdec_digit_array_t *yd,
+                        fpdec_digit_t *u, fpdec_digit_t *q_buf) {
+    if (xd != NULL)
+        fpdec_mem_free(xd);
+    if (yd != NULL)
+        fpdec_mem_free(yd);
+    if (u != NULL)
+        fpdec_mem_free(u);
+    if (q_buf != NULL)
+        fpdec_mem_free(q_buf);
+}
+
+// Long division of x by y, developing the quotient digit by digit (from the
+// most significant one) until the remainder is zero or the quotient has
+// reached the maximal precision allowed by exp. The dividend is extended by
+// zero digits as needed, so the quotient is calculated in one pass, keeping
+// only the current partial remainder (n + 1 digits for a divisor of n
+// digits).
+// On return, exp is decremented by the number of appended zero digits, or,
+// if the division does not terminate within the precision limit, set to
+// FPDEC_MIN_EXP - 1.
 fpdec_digit_array_t *
 digits_div_max_prec(const fpdec_digit_array_t *x,
                     const fpdec_digit_array_t *y,
                     int *exp) {
-    fpdec_digit_array_t *q;
-    int min_n_shift = (int)(y->n_signif) + 1 - (int)(x->n_signif);
-    fpdec_n_digits_t x_n_shift =
-        min_n_shift < 0 ? 0 : (fpdec_n_digits_t)min_n_shift;
-    fpdec_n_digits_t accel = 1;
-    fpdec_n_digits_t max_x_n_shift =
+    const fpdec_n_digits_t n = y->n_signif;
+    const fpdec_n_digits_t max_n_shift =
         (fpdec_n_digits_t)(*exp - FPDEC_MIN_EXP);
+    fpdec_n_digits_t n_shift = 0;
+    fpdec_n_digits_t x_idx;
+    fpdec_digit_array_t *xd, *yd = NULL, *q;
+    fpdec_digit_t *u, *q_buf, *t, d, next, q_digit;
+    size_t n_q = 0, q_size;
+    bool rem_is_zero = false;
+    uint128_t t1;
 
     assert(*exp >= FPDEC_MIN_EXP);
-
-    if (y->n_signif == 1) {
-        fpdec_digit_t d = y->digits[0];
-        fpdec_digit_t r;
-        while (true) {
-            q = digits_div_digit(x, x_n_shift, d, &r);
-            if (x_n_shift >= max_x_n_shift || r == 0)
-                break;
-            fpdec_mem_free(q);
-            accel++;
-            x_n_shift = MIN(x_n_shift + accel * accel, max_x_n_shift);
-        }
-        if (r == 0)
-            *exp -= x_n_shift;
-        else
-            *exp = FPDEC_MIN_EXP - 1;       // signal precision limit exceeded
+    assert(y->digits[n - 1] > 0);
+
+    // normalize (see Algorithm D, step D1)
+    d = (n == 1) ? 1 : RADIX / (y->digits[n - 1] + 1);
+    xd = digits_copy(x, 0, 1);
+    if (n > 1)
+        yd = digits_copy(y, 0, 1);
+    u = (fpdec_digit_t *)fpdec_mem_alloc(n + 1, sizeof(fpdec_digit_t));
+    q_size = 2 * (size_t)x->n_signif + 8;
+    q_buf = (fpdec_digit_t *)fpdec_mem_alloc(q_size, sizeof(fpdec_digit_t));
+    if (xd == NULL || (n > 1 && yd == NULL) || u == NULL || q_buf == NULL) {
+        digits_div_free_buffers(xd, yd, u, q_buf);
+        MEMERROR_RETVAL(NULL);
     }
-    else {
-        fpdec_digit_array_t *r;
-        while (true) {
-            q = digits_divmod(x, x_n_shift, y, 0, &r);
-            if (x_n_shift >= max_x_n_shift || digits_all_zero(r->digits,
-                                                              r->n_signif))
+    digits_imul_digit(xd, d);
+    if (n > 1)
+        digits_imul_digit(yd, d);
+
+    // the leading n - 1 digits of the dividend are less than y, so they
+    // don't give any quotient digits
+    x_idx = xd->n_signif;
+    while (x_idx > 0 && xd->n_signif - x_idx < n - 1) {
+        memmove(u + 1, u, n * sizeof(fpdec_digit_t));
+        u[0] = xd->digits[--x_idx];
+    }
+    while (true) {
+        if (x_idx > 0)
+            next = xd->digits[--x_idx];
+        else {
+            next = 0;
+            n_shift++;
+        }
+        if (n == 1) {
+            u64_mul_u64(&t1, u[0], RADIX);
+            u128_iadd_u64(&t1, next);
+            u[0] = u128_idiv_u64(&t1, y->digits[0]);
+            assert(U128_HI(t1) == 0);
+            q_digit = U128_LO(t1);
+        }
+        else {
+            memmove(u + 1, u, n * sizeof(fpdec_digit_t));
+            u[0] = next;
+            q_digit = digits_div_step(u, yd->digits, n);
+        }
+        // collect quotient digits (most significant first), omitting
+        // leading zeros
+        if (n_q > 0 || q_digit != 0) {
+            if (n_q == q_size) {
+                t = (fpdec_digit_t *)fpdec_mem_alloc(2 * q_size,
+                                                     sizeof(fpdec_digit_t));
+                if (t == NULL) {
+                    digits_div_free_buffers(xd, yd, u, q_buf);
+                    MEMERROR_RETVAL(NULL);
+                }
+                memcpy(t, q_buf, q_size * sizeof(fpdec_digit_t));
+                fpdec_mem_free(q_buf);
+                q_buf = t;
+                q_size *= 2;
+            }
+            q_buf[n_q++] = q_digit;
+        }
+        if (x_idx == 0) {
+            rem_is_zero = digits_all_zero(u, n);
+            if (rem_is_zero || n_shift >= max_n_shift)
                 break;
-            fpdec_mem_free(q);
-            fpdec_mem_free(r);
-            accel++;
-            x_n_shift = MIN(x_n_shift + accel * accel, max_x_n_shift);
         }
-        if (digits_all_zero(r->digits, r->n_signif))
-            *exp -= x_n_shift;
+    }
+
+    q = digits_alloc(MAX(n_q, 1));
+    if (q != NULL) {
+        for (size_t i = 0; i < n_q; ++i)
+            q->digits[i] = q_buf[n_q - 1 - i];
+        q->n_signif = q->n_alloc;
+        if (rem_is_zero)
+            *exp -= n_shift;
         else
             *exp = FPDEC_MIN_EXP - 1;       // signal precision limit exceeded
-        fpdec_mem_free(r);
     }
+    digits_div_free_buffers(xd, yd, u, q_buf);
+    if (q == NULL)
+        MEMERROR_RETVAL(NULL);
     return q;
 }
 
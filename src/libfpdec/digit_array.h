@@ -20,6 +20,7 @@ $Revision$
 #include "common.h"
 #include "helper_macros.h"
 #include "mem.h"
+#include "parser.h"
 #include "rounding.h"
 
 
@@ -39,10 +40,15 @@ fpdec_digit_array_t *
 digits_copy(const fpdec_digit_array_t *src, fpdec_n_digits_t n_shift,
             fpdec_n_digits_t n_add_leading_zeros);
 
+// Same as digits_copy, but with room for n_alloc digits; src may be NULL,
+// denoting an empty array.
+fpdec_digit_array_t *
+digits_enlarged(const fpdec_digit_array_t *src, fpdec_n_digits_t n_shift,
+                fpdec_n_digits_t n_alloc);
+
 error_t
-digits_from_dec_coeff_exp(fpdec_digit_array_t **digit_array, fpdec_exp_t *exp,
-                          size_t n_dec_digits, const dec_digit_t *coeff,
-                          int64_t dec_exp);
+digits_from_dec_repr(fpdec_digit_array_t **digit_array, fpdec_exp_t *exp,
+                     const dec_repr_t *dec_repr);
 
 error_t
 digits_from_digits(fpdec_digit_array_t **digit_array,
@@ -86,9 +92,28 @@ digits_iadd_digits(fpdec_digit_array_t *x, const fpdec_digit_array_t *y);
 void
 digits_isub_digits(fpdec_digit_array_t *x, const fpdec_digit_array_t *y);
 
+// The *_shifted variants operate on x and y * RADIX ^ n_shift in place and
+// return false (leaving x unchanged) if the capacity of x does not suffice
+// for the result. For subtraction, x >= y * RADIX ^ n_shift is required.
+
+bool
+digits_iadd_digits_shifted(fpdec_digit_array_t *x, const fpdec_digit_t *y,
+                           fpdec_n_digits_t n_y, fpdec_n_digits_t n_shift);
+
+bool
+digits_isub_digits_shifted(fpdec_digit_array_t *x, const fpdec_digit_t *y,
+                           fpdec_n_digits_t n_y, fpdec_n_digits_t n_shift);
+
 void
 digits_imul_digit(fpdec_digit_array_t *x, fpdec_digit_t y);
 
+// z[0..n_x+n_y) = x[0..n_x) * y[0..n_y), using the schoolbook method, i.e.
+// meant for short operands
+void
+digits_mul_digits(fpdec_digit_t *z, const fpdec_digit_t *x,
+                  fpdec_n_digits_t n_x,
+                  const fpdec_digit_t *y, fpdec_n_digits_t n_y);
+
 fpdec_digit_array_t *
 digits_mul(const fpdec_digit_array_t *x, const fpdec_digit_array_t *y);
 
@@ -0,0 +1,513 @@
+/* ---------------------------------------------------------------------------
+Name:        fixeddecimal.hpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#ifndef FPDEC_FIXEDDECIMAL_HPP
+#define FPDEC_FIXEDDECIMAL_HPP
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "fpdecimal.hpp"
+#include "fpdec.h"
+
+namespace fpdec {
+
+    namespace detail {
+
+        // Integer types usable as storage of a FixedDecimal, their unsigned
+        // counterparts and the types used for intermediate products
+
+        template<typename Storage>
+        struct storage_traits;
+
+        template<>
+        struct storage_traits<int64_t> {
+            typedef uint64_t unsigned_type;
+#ifdef __SIZEOF_INT128__
+            typedef __int128 wide_type;
+#else
+            typedef int64_t wide_type;
+#endif // __SIZEOF_INT128__
+            static constexpr unsigned max_scale = 18;
+        };
+
+#ifdef __SIZEOF_INT128__
+        template<>
+        struct storage_traits<__int128> {
+            typedef unsigned __int128 unsigned_type;
+            typedef __int128 wide_type;
+            static constexpr unsigned max_scale = 38;
+        };
+#endif // __SIZEOF_INT128__
+
+        template<typename T>
+        constexpr T pow10(unsigned n) {
+            return n == 0 ? T(1) : T(10) * pow10<T>(n - 1);
+        }
+
+        template<typename T>
+        constexpr T abs(T x) {
+            return x < 0 ? -x : x;
+        }
+
+        // Resolves round_default to the current default rounding mode, which
+        // is only known at runtime
+        inline constexpr Rounding
+        resolve(const Rounding rnd) {
+            return rnd != Rounding::round_default ? rnd :
+                   (Rounding)fpdec_get_default_rounding_mode();
+        }
+
+        // Returns true if the quotient truncated to q has to be incremented
+        // (in magnitude) to be rounded according to rnd; r is the remainder
+        // and d the divisor (all as absolute values), neg gives the sign of
+        // the exact quotient.
+        template<typename T>
+        constexpr bool
+        round_away(T q, T r, T d, bool neg, Rounding rnd) {
+            return r == 0 ? false :
+                   rnd == Rounding::round_05up ? q % 5 == 0 :
+                   rnd == Rounding::round_ceiling ? !neg :
+                   rnd == Rounding::round_down ? false :
+                   rnd == Rounding::round_floor ? neg :
+                   rnd == Rounding::round_half_down ? r > d - r :
+                   rnd == Rounding::round_half_even ?
+                   r > d - r || (r == d - r && q % 2 == 1) :
+                   rnd == Rounding::round_half_up ? r >= d - r :
+                   true;
+        }
+
+        template<typename T>
+        constexpr T
+        div_rounded(T q, T r, T d, bool neg, Rounding rnd) {
+            return q + (round_away(abs(q), abs(r), abs(d), neg, rnd) ?
+                        (neg ? T(-1) : T(1)) : T(0));
+        }
+
+        // x / y, rounded according to rnd
+        template<typename T>
+        constexpr T
+        div_rounded(T x, T y, Rounding rnd) {
+            return div_rounded(x / y, x % y, y, (x < 0) != (y < 0),
+                               resolve(rnd));
+        }
+
+        // Coefficient with scale src_scale rescaled to dst_scale
+        template<typename T>
+        constexpr T
+        rescaled(T coeff, unsigned src_scale, unsigned dst_scale,
+                 Rounding rnd) {
+            return src_scale <= dst_scale ?
+                   coeff * pow10<T>(dst_scale - src_scale) :
+                   div_rounded(coeff, pow10<T>(src_scale - dst_scale), rnd);
+        }
+
+        // Magnitude of x as unsigned value (also valid for the min value)
+        template<typename U, typename T>
+        constexpr U magnitude(T x) {
+            return x < 0 ? U(0) - U(x) : U(x);
+        }
+
+        // Quotient q and remainder r of a division
+        template<typename U>
+        struct quot_rem {
+            U q;
+            U r;
+        };
+
+        template<typename U>
+        constexpr U
+        quot_rounded(quot_rem<U> qr, U d, bool neg, Rounding rnd) {
+            return qr.q + (round_away(qr.q, qr.r, d, neg, rnd) ? 1U : 0U);
+        }
+
+        // a * b / d (all as absolute values), rounded according to rnd;
+        // the quotient has to fit into 64 bits
+        constexpr uint64_t
+        mul_div_rounded(uint64_t a, uint64_t b, uint64_t d, bool neg,
+                        Rounding rnd) {
+#ifdef __SIZEOF_INT128__
+            return quot_rounded(
+                quot_rem<uint64_t>{
+                    (uint64_t)((unsigned __int128)a * b / d),
+                    (uint64_t)((unsigned __int128)a * b % d)},
+                d, neg, rnd);
+#else
+            return quot_rounded(quot_rem<uint64_t>{a * b / d, a * b % d},
+                                d, neg, rnd);
+#endif // __SIZEOF_INT128__
+        }
+
+#ifdef __SIZEOF_INT128__
+        typedef unsigned __int128 u128;
+
+        // 256-bit unsigned integer
+        struct u256 {
+            u128 hi;
+            u128 lo;
+        };
+
+        constexpr u128 lo64(u128 x) {
+            return x & UINT64_MAX;
+        }
+
+        constexpr u128 hi64(u128 x) {
+            return x >> 64U;
+        }
+
+        constexpr u256
+        mul_wide_combine(u128 ll, u128 lh, u128 hl, u128 hh, u128 mid) {
+            return u256{hh + hi64(lh) + hi64(hl) + hi64(mid),
+                        lo64(ll) | mid << 64U};
+        }
+
+        constexpr u256
+        mul_wide_parts(u128 ll, u128 lh, u128 hl, u128 hh) {
+            return mul_wide_combine(ll, lh, hl, hh,
+                                    hi64(ll) + lo64(lh) + lo64(hl));
+        }
+
+        // Full 256-bit product of a and b
+        constexpr u256 mul_wide(u128 a, u128 b) {
+            return mul_wide_parts(lo64(a) * lo64(b), lo64(a) * hi64(b),
+                                  hi64(a) * lo64(b), hi64(a) * hi64(b));
+        }
+
+        // Binary long division, shifting the n remaining bits of lo into
+        // the remainder r (< d); carry is the bit shifted out of r.
+        constexpr quot_rem<u128>
+        div_wide_step(u128 q, u128 r, u128 lo, u128 d, unsigned n);
+
+        constexpr quot_rem<u128>
+        div_wide_bit(u128 q, bool carry, u128 r, u128 lo, u128 d,
+                     unsigned n) {
+            return carry || r >= d ?
+                   div_wide_step(q << 1U | 1U, r - d, lo, d, n - 1) :
+                   div_wide_step(q << 1U, r, lo, d, n - 1);
+        }
+
+        constexpr quot_rem<u128>
+        div_wide_step(u128 q, u128 r, u128 lo, u128 d, unsigned n) {
+            return n == 0 ? quot_rem<u128>{q, r} :
+                   div_wide_bit(q, r >> 127U != 0, r << 1U | lo >> 127U,
+                                lo << 1U, d, n);
+        }
+
+        // x / d; the quotient has to fit into 128 bits
+        constexpr quot_rem<u128> div_wide(u256 x, u128 d) {
+            return x.hi == 0 ? quot_rem<u128>{x.lo / d, x.lo % d} :
+                   div_wide_step(0, x.hi, x.lo, d, 128);
+        }
+
+        // a * b / d (all as absolute values), rounded according to rnd;
+        // the quotient has to fit into 128 bits
+        constexpr u128
+        mul_div_rounded(u128 a, u128 b, u128 d, bool neg, Rounding rnd) {
+            return quot_rounded(div_wide(mul_wide(a, b), d), d, neg, rnd);
+        }
+#endif // __SIZEOF_INT128__
+
+    } // namespace detail
+
+    // Decimal number with a fixed number of fractional digits (Scale),
+    // stored as integer coefficient in a signed integer type (int64_t or
+    // __int128, if supported by the compiler).
+    // Construction, comparison and the binary arithmetic operators are
+    // constexpr; the compound assignments (+=, -=, *=, /=) and the
+    // conversions from and to Decimal are not, because C++11 does not allow
+    // modifying an object in a constant expression.
+    // The operators * and / round half to even (the library's default
+    // rounding mode), so that they can be evaluated at compile time; mul and
+    // div take the rounding mode as argument. Rounding::round_default (which
+    // denotes the current default rounding mode) is only allowed at
+    // runtime. Like with built-in integers, overflow is not checked; the
+    // intermediate products of mul and div are calculated with twice the
+    // width of Storage.
+
+    template<unsigned Scale, typename Storage = int64_t>
+    class FixedDecimal {
+        typedef detail::storage_traits<Storage> traits;
+        typedef typename traits::unsigned_type unsigned_type;
+        typedef typename traits::wide_type wide_type;
+
+        static_assert(Scale <= traits::max_scale,
+                      "Scale exceeds the number of digits of Storage.");
+
+    public:
+        typedef Storage storage_type;
+
+        constexpr FixedDecimal() noexcept : coeff(0) {
+        };
+
+        explicit constexpr FixedDecimal(const long long int val) noexcept :
+            coeff(Storage(val) * detail::pow10<Storage>(Scale)) {
+        };
+
+        template<unsigned SrcScale, typename SrcStorage>
+        explicit constexpr
+        FixedDecimal(const FixedDecimal<SrcScale, SrcStorage> &src,
+                     const Rounding rnd = Rounding::round_half_even) :
+            coeff(Storage(detail::rescaled<wide_type>(
+                src.coefficient(), SrcScale, Scale, rnd))) {
+        };
+
+        // Rounds src to Scale fractional digits if necessary. Throws
+        // std::range_error if the result exceeds the range of Storage.
+        explicit FixedDecimal(const Decimal &src,
+                              const Rounding rnd = Rounding::round_default);
+
+        static constexpr FixedDecimal
+        from_coefficient(const Storage coeff) noexcept {
+            return FixedDecimal(coeff, raw_tag());
+        };
+
+        // properties
+
+        static constexpr fpdec_dec_prec_t precision() noexcept {
+            return Scale;
+        };
+
+        constexpr Storage coefficient() const noexcept {
+            return coeff;
+        };
+
+        constexpr fpdec_sign_t sign() const noexcept {
+            return coeff < 0 ? FPDEC_SIGN_NEG :
+                   coeff > 0 ? FPDEC_SIGN_POS : FPDEC_SIGN_ZERO;
+        };
+
+        // conversion (lossless)
+
+        operator Decimal() const;
+
+        // rounding
+
+        // Rounds to n_digits (<= Scale) fractional digits
+        constexpr FixedDecimal
+        rounded(const unsigned n_digits,
+                const Rounding rnd = Rounding::round_half_even) const {
+            return from_coefficient(
+                detail::div_rounded(coeff,
+                                    detail::pow10<Storage>(Scale - n_digits),
+                                    rnd) *
+                detail::pow10<Storage>(Scale - n_digits));
+        };
+
+        // comparison
+
+        constexpr bool operator==(const FixedDecimal &rhs) const noexcept {
+            return coeff == rhs.coeff;
+        };
+
+        constexpr bool operator!=(const FixedDecimal &rhs) const noexcept {
+            return coeff != rhs.coeff;
+        };
+
+        constexpr bool operator<=(const FixedDecimal &rhs) const noexcept {
+            return coeff <= rhs.coeff;
+        };
+
+        constexpr bool operator<(const FixedDecimal &rhs) const noexcept {
+            return coeff < rhs.coeff;
+        };
+
+        constexpr bool operator>=(const FixedDecimal &rhs) const noexcept {
+            return coeff >= rhs.coeff;
+        };
+
+        constexpr bool operator>(const FixedDecimal &rhs) const noexcept {
+            return coeff > rhs.coeff;
+        };
+
+        // arithmetic
+
+        constexpr FixedDecimal operator+() const noexcept {
+            return *this;
+        };
+
+        constexpr FixedDecimal operator-() const noexcept {
+            return from_coefficient(-coeff);
+        };
+
+        constexpr FixedDecimal
+        operator+(const FixedDecimal &rhs) const noexcept {
+            return from_coefficient(coeff + rhs.coeff);
+        };
+
+        constexpr FixedDecimal
+        operator-(const FixedDecimal &rhs) const noexcept {
+            return from_coefficient(coeff - rhs.coeff);
+        };
+
+        constexpr FixedDecimal
+        mul(const FixedDecimal &rhs, const Rounding rnd) const {
+            return with_sign(detail::mul_div_rounded(
+                abs_coeff(), rhs.abs_coeff(),
+                detail::pow10<unsigned_type>(Scale),
+                (coeff < 0) != (rhs.coeff < 0), detail::resolve(rnd)),
+                             (coeff < 0) != (rhs.coeff < 0));
+        };
+
+        // Throws DivisionByZero if rhs is zero
+        constexpr FixedDecimal
+        div(const FixedDecimal &rhs, const Rounding rnd) const {
+            return rhs.coeff == 0 ? throw DivisionByZero() :
+                   with_sign(detail::mul_div_rounded(
+                       abs_coeff(), detail::pow10<unsigned_type>(Scale),
+                       rhs.abs_coeff(), (coeff < 0) != (rhs.coeff < 0),
+                       detail::resolve(rnd)), (coeff < 0) != (rhs.coeff < 0));
+        };
+
+        constexpr FixedDecimal operator*(const FixedDecimal &rhs) const {
+            return mul(rhs, Rounding::round_half_even);
+        };
+
+        constexpr FixedDecimal operator/(const FixedDecimal &rhs) const {
+            return div(rhs, Rounding::round_half_even);
+        };
+
+        FixedDecimal &operator+=(const FixedDecimal &rhs) noexcept {
+            coeff += rhs.coeff;
+            return *this;
+        };
+
+        FixedDecimal &operator-=(const FixedDecimal &rhs) noexcept {
+            coeff -= rhs.coeff;
+            return *this;
+        };
+
+        FixedDecimal &operator*=(const FixedDecimal &rhs) {
+            return *this = *this * rhs;
+        };
+
+        FixedDecimal &operator/=(const FixedDecimal &rhs) {
+            return *this = *this / rhs;
+        };
+
+    private:
+        struct raw_tag {
+        };
+
+        Storage coeff;
+
+        constexpr FixedDecimal(const Storage coeff, raw_tag) noexcept :
+            coeff(coeff) {
+        };
+
+        constexpr unsigned_type abs_coeff() const noexcept {
+            return detail::magnitude<unsigned_type>(coeff);
+        };
+
+        static constexpr FixedDecimal
+        with_sign(const unsigned_type abs_coeff, const bool neg) noexcept {
+            return from_coefficient(neg ? Storage(unsigned_type(0) - abs_coeff)
+                                        : Storage(abs_coeff));
+        };
+    };
+
+    // conversion from and to Decimal
+
+    template<unsigned Scale, typename Storage>
+    FixedDecimal<Scale, Storage>::FixedDecimal(const Decimal &src,
+                                               const Rounding rnd) {
+        Decimal adj(src, Scale, rnd);
+        fpdec_sign_t sign;
+        uint128_t coeff128;
+        int64_t exp;
+        unsigned_type abs_coeff;
+        bool ovfl;
+
+        ovfl = fpdec_as_sign_coeff128_exp(&sign, &coeff128, &exp,
+                                          &adj.fpdec) != 0;
+#ifdef __SIZEOF_INT128__
+        // exp >= -Scale, because adj has Scale fractional digits
+        for (; !ovfl && exp > -(int64_t)Scale; --exp) {
+            ovfl = coeff128 > UINT128_MAX / 10;
+            coeff128 *= 10;
+        }
+        ovfl = ovfl ||
+               coeff128 > (uint128_t)std::numeric_limits<unsigned_type>::max();
+        abs_coeff = (unsigned_type)coeff128;
+#else
+        for (; !ovfl && exp > -(int64_t)Scale; --exp) {
+            ovfl = coeff128.hi != 0 || coeff128.lo > UINT64_MAX / 10;
+            coeff128.lo *= 10;
+        }
+        ovfl = ovfl || coeff128.hi != 0;
+        abs_coeff = coeff128.lo;
+#endif // __SIZEOF_INT128__
+        // the magnitude of the min value of Storage is max value + 1
+        ovfl = ovfl || abs_coeff - (sign < 0) >
+                       (unsigned_type)std::numeric_limits<Storage>::max();
+        if (ovfl)
+            throw std::range_error("Value exceeds the range of "
+                                   "FixedDecimal.");
+        coeff = sign < 0 ? (Storage)(~abs_coeff + 1) : (Storage)abs_coeff;
+    }
+
+    template<unsigned Scale, typename Storage>
+    FixedDecimal<Scale, Storage>::operator Decimal() const {
+        unsigned_type abs_coeff = coeff < 0 ? ~(unsigned_type)coeff + 1 :
+                                  (unsigned_type)coeff;
+        unsigned_type int_part = abs_coeff / detail::pow10<unsigned_type>(Scale);
+        unsigned_type frac_part = abs_coeff -
+                                  int_part *
+                                  detail::pow10<unsigned_type>(Scale);
+        fpdec_digit_t digits[5];
+        size_t n_digits = 0;
+        fpdec_exp_t exp = 0;
+        Decimal dec;
+        error_t err;
+
+        if (coeff == 0) {
+            dec.fpdec.dec_prec = Scale;
+            return dec;
+        }
+        if (Scale <= FPDEC_MAX_DEC_PREC_FOR_SHINT &&
+            abs_coeff >> 32U >> 32U >> 32U == 0) {
+            // fits into a shifted int
+            dec.fpdec.sign = sign();
+            dec.fpdec.dec_prec = Scale;
+            dec.fpdec.lo = (uint64_t)abs_coeff;
+            dec.fpdec.hi = (uint32_t)(abs_coeff >> 32U >> 32U);
+            return dec;
+        }
+        // digits (base 10 ^ 19) of the fractional part, filled up with
+        // zeros to a multiple of 19 decimal digits
+        if (Scale > 19) {
+            frac_part *= detail::pow10<unsigned_type>(2 * 19 - Scale);
+            digits[n_digits++] = (fpdec_digit_t)(frac_part % RADIX);
+            digits[n_digits++] = (fpdec_digit_t)(frac_part / RADIX);
+            exp = -2;
+        }
+        else if (Scale > 0) {
+            frac_part *= detail::pow10<unsigned_type>(19 - Scale);
+            digits[n_digits++] = (fpdec_digit_t)frac_part;
+            exp = -1;
+        }
+        for (; int_part != 0; int_part /= RADIX)
+            digits[n_digits++] = (fpdec_digit_t)(int_part % RADIX);
+        err = fpdec_from_sign_digits_exp(&dec.fpdec, sign(), n_digits,
+                                         digits, exp);
+        if (err == FPDEC_OK)
+            err = fpdec_adjust(&dec.fpdec, Scale, FPDEC_ROUND_DEFAULT);
+        if (err == ENOMEM)
+            throw std::bad_alloc();
+        return dec;
+    }
+
+}; // namespace fpdec
+
+#endif //FPDEC_FIXEDDECIMAL_HPP
@@ -17,6 +17,7 @@ $Revision$
 #include <locale.h>
 #include <memory.h>
 #include <stdbool.h>
+#include "compiler_macros.h"
 #include "format_spec.h"
 
 /*****************************************************************************
@@ -37,6 +38,27 @@ const format_spec_t DFLT_FORMAT = {
 
 const utf8c_t no_fill = {0, ""};
 
+/*****************************************************************************
+*  Per-thread cache of parsed format specs
+*****************************************************************************/
+
+#if FPDEC_FORMAT_CACHE_SIZE > 0
+
+// longer format strings are not cached
+#define FMT_CACHE_MAX_KEY_LEN 31
+
+typedef struct fmt_cache_entry {
+    uint8_t key_len;
+    uint8_t key[FMT_CACHE_MAX_KEY_LEN];
+    format_spec_t spec;
+} fmt_cache_entry_t;
+
+static THREAD_LOCAL fmt_cache_entry_t fmt_cache[FPDEC_FORMAT_CACHE_SIZE];
+static THREAD_LOCAL unsigned fmt_cache_n_used = 0;
+static THREAD_LOCAL unsigned fmt_cache_next = 0;
+
+#endif // FPDEC_FORMAT_CACHE_SIZE
+
 /*****************************************************************************
 *  Functions
 *****************************************************************************/
@@ -163,3 +185,40 @@ parse_format_spec(format_spec_t *spec, const uint8_t *fmt) {
 
     return 0;
 }
+
+int
+parse_format_spec_cached(format_spec_t *spec, const uint8_t *fmt) {
+#if FPDEC_FORMAT_CACHE_SIZE > 0
+    fmt_cache_entry_t *entry;
+    size_t len;
+    int rc;
+
+    for (len = 0; len <= FMT_CACHE_MAX_KEY_LEN && fmt[len] != '\0'; ++len);
+    if (len > FMT_CACHE_MAX_KEY_LEN)
+        return parse_format_spec(spec, fmt);
+
+    for (entry = fmt_cache; entry < fmt_cache + fmt_cache_n_used; ++entry) {
+        if (entry->key_len == len && memcmp(entry->key, fmt, len) == 0) {
+            *spec = entry->spec;
+            return 0;
+        }
+    }
+
+    rc = parse_format_spec(spec, fmt);
+    // locale specific params may change between calls, so don't cache them
+    if (rc != 0 || spec->type == 'n')
+        return rc;
+
+    // replace entries round robin
+    entry = fmt_cache + fmt_cache_next;
+    fmt_cache_next = (fmt_cache_next + 1) % FPDEC_FORMAT_CACHE_SIZE;
+    if (fmt_cache_n_used < FPDEC_FORMAT_CACHE_SIZE)
+        ++fmt_cache_n_used;
+    entry->key_len = (uint8_t)len;
+    memcpy(entry->key, fmt, len);
+    entry->spec = *spec;
+    return 0;
+#else
+    return parse_format_spec(spec, fmt);
+#endif // FPDEC_FORMAT_CACHE_SIZE
+}
@@ -23,6 +23,16 @@ extern "C" {
 #include <stddef.h>
 #include <stdint.h>
 
+/*****************************************************************************
+*  Macros
+*****************************************************************************/
+
+// number of entries of the per-thread cache of parsed format specs
+// (0 disables the cache)
+#ifndef FPDEC_FORMAT_CACHE_SIZE
+#define FPDEC_FORMAT_CACHE_SIZE 8
+#endif // FPDEC_FORMAT_CACHE_SIZE
+
 /*****************************************************************************
 *  Types
 *****************************************************************************/
@@ -107,6 +117,12 @@ utf8_strlen(const uint8_t *cp) {
 int
 parse_format_spec(format_spec_t *spec, const uint8_t *fmt);
 
+// Same as parse_format_spec, but looking up fmt in a small per-thread cache
+// of parsed format specs first. Specs with locale specific params (format
+// type 'n') are not cached.
+int
+parse_format_spec_cached(format_spec_t *spec, const uint8_t *fmt);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
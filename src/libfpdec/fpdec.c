@@ -15,6 +15,7 @@ $Revision$
 */
 
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <wchar.h>
@@ -145,39 +146,18 @@ fpdec_copy(fpdec_t *fpdec, const fpdec_t *src) {
     return FPDEC_OK;
 }
 
-error_t
-fpdec_from_ascii_literal(fpdec_t *fpdec, const char *literal) {
-    size_t n_chars = strlen(literal);
-    dec_repr_t st_dec_repr;
-    dec_repr_t *dec_repr;
+static error_t
+fpdec_from_dec_repr(fpdec_t *fpdec, const dec_repr_t *dec_repr) {
     size_t n_add_zeros, n_dec_digits;
     error_t rc;
 
-    ASSERT_FPDEC_IS_ZEROED(fpdec);
-
-    if (n_chars == 0)
-        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
-
-    if (n_chars <= COEFF_SIZE_THRESHOLD) {
-        dec_repr = &st_dec_repr;
-    }
-    else {
-        dec_repr = fpdec_mem_alloc(offsetof(dec_repr_t, coeff) + n_chars, 1);
-        if (dec_repr == NULL)
-            MEMERROR;
-    }
-    rc = parse_ascii_dec_literal(dec_repr, literal);
-    if (rc != FPDEC_OK)
-        goto EXIT;
-
     fpdec->sign = dec_repr->negative ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
     n_add_zeros = MAX(0, dec_repr->exp);
     n_dec_digits = dec_repr->n_dec_digits + n_add_zeros;
     if (n_dec_digits <= MAX_N_DEC_DIGITS_IN_SHINT &&
         -dec_repr->exp <= MAX_DEC_PREC_FOR_SHINT) {
-        rc = shint_from_dec_coeff(&fpdec->lo, &fpdec->hi,
-                                  dec_repr->coeff, dec_repr->n_dec_digits,
-                                  n_add_zeros);
+        rc = shint_from_dec_repr(&fpdec->lo, &fpdec->hi, dec_repr,
+                                 n_add_zeros);
         if (rc == FPDEC_OK) {
             fpdec->dyn_alloc = false;
             fpdec->normalized = false;
@@ -185,14 +165,15 @@ fpdec_from_ascii_literal(fpdec_t *fpdec, const char *literal) {
             if (fpdec->lo == 0 && fpdec->hi == 0) {
                 fpdec->sign = FPDEC_SIGN_ZERO;
             }
-            goto EXIT;
+            return FPDEC_OK;
         }
     }
-    rc = digits_from_dec_coeff_exp(&(fpdec->digit_array), &(fpdec->exp),
-                                   dec_repr->n_dec_digits, dec_repr->coeff,
-                                   dec_repr->exp);
-    if (rc != FPDEC_OK)
-        goto ERROR;
+    rc = digits_from_dec_repr(&(fpdec->digit_array), &(fpdec->exp),
+                              dec_repr);
+    if (rc != FPDEC_OK) {
+        fpdec_reset_to_zero(fpdec, 0);
+        return rc;
+    }
     fpdec->exp += digits_eliminate_trailing_zeros(fpdec->digit_array);
     fpdec->dyn_alloc = true;
     if (FPDEC_DYN_N_DIGITS(fpdec) > 0) {
@@ -202,15 +183,48 @@ fpdec_from_ascii_literal(fpdec_t *fpdec, const char *literal) {
         fpdec_reset_to_zero(fpdec, 0);
     }
     fpdec->dec_prec = MAX(0, -(dec_repr->exp));
-    goto EXIT;
+    return FPDEC_OK;
+}
 
-ERROR:
-    fpdec_reset_to_zero(fpdec, 0);
+error_t
+fpdec_from_ascii_literal(fpdec_t *fpdec, const char *literal) {
+    return fpdec_from_ascii_chars(fpdec, literal, strlen(literal));
+}
 
-EXIT:
-    if (dec_repr != &st_dec_repr) {
-        fpdec_mem_free(dec_repr);
-    }
+error_t
+fpdec_from_ascii_chars(fpdec_t *fpdec, const char *begin, size_t len) {
+    dec_repr_t dec_repr;
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (len == 0)
+        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
+
+    rc = parse_ascii_dec_literal(&dec_repr, begin, len, NULL);
+    if (rc != FPDEC_OK)
+        return rc;
+    return fpdec_from_dec_repr(fpdec, &dec_repr);
+}
+
+error_t
+fpdec_parse_ascii_chars(fpdec_t *fpdec, const char *begin, size_t len,
+                        const char **end) {
+    dec_repr_t dec_repr;
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+    assert(end != NULL);
+
+    *end = begin;
+    if (len == 0)
+        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
+
+    rc = parse_ascii_dec_literal(&dec_repr, begin, len, end);
+    if (rc == FPDEC_OK)
+        rc = fpdec_from_dec_repr(fpdec, &dec_repr);
+    if (rc != FPDEC_OK)
+        *end = begin;
     return rc;
 }
 
@@ -260,6 +274,55 @@ fpdec_from_long_long(fpdec_t *fpdec, const long long val) {
     return FPDEC_OK;
 }
 
+error_t
+fpdec_from_u64(fpdec_t *fpdec, const uint64_t val) {
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (val > 0) {
+        fpdec->sign = FPDEC_SIGN_POS;
+        fpdec->lo = val;
+    }
+    return FPDEC_OK;
+}
+
+static error_t
+fpdec_from_sign_u128(fpdec_t *fpdec, fpdec_sign_t sign, uint128_t val) {
+    fpdec_digit_t digits[3];
+    size_t n_digits;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (U64_HI(U128_HI(val)) == 0) {
+        // val < 2 ^ 96 fits into a shint
+        fpdec->lo = U128_LO(val);
+        fpdec->hi = U128_HI(val);
+        if (fpdec->lo != 0 || fpdec->hi != 0)
+            fpdec->sign = sign;
+        return FPDEC_OK;
+    }
+    // 2 ^ 96 <= val < 2 ^ 128 < RADIX ^ 3
+    digits[0] = u128_idiv_u64(&val, RADIX);
+    digits[1] = u128_idiv_u64(&val, RADIX);
+    digits[2] = U128_LO(val);
+    n_digits = digits[2] == 0 ? 2 : 3;
+    return fpdec_from_sign_digits_exp(fpdec, sign, n_digits, digits, 0);
+}
+
+error_t
+fpdec_from_u128(fpdec_t *fpdec, const uint128_t val) {
+    return fpdec_from_sign_u128(fpdec, FPDEC_SIGN_POS, val);
+}
+
+#ifdef __SIZEOF_INT128__
+error_t
+fpdec_from_i128(fpdec_t *fpdec, const __int128 val) {
+    if (val < 0)
+        return fpdec_from_sign_u128(fpdec, FPDEC_SIGN_NEG,
+                                    -(uint128_t)val);
+    return fpdec_from_sign_u128(fpdec, FPDEC_SIGN_POS, (uint128_t)val);
+}
+#endif // __int128
+
 error_t
 fpdec_from_sign_digits_exp(fpdec_t *fpdec, fpdec_sign_t sign, size_t n_digits,
                            const fpdec_digit_t *digits, fpdec_exp_t exp) {
@@ -301,11 +364,11 @@ du64_to_digits(fpdec_digit_t *digit, int *n_trailing_zeros_skipped,
     fpdec_n_digits_t n_digits = 0;
 
     assert(lo != 0 || hi != 0);
-    assert(prec <= MAX_N_DEC_DIGITS_IN_SHINT);
+    assert(prec <= MAX_DEC_PREC_FOR_SHINT);
 
     *n_trailing_zeros_skipped = 0;
     if (prec > 0) {
-        *digit = u128_idiv_u32(&t, u64_10_pow_n(prec));
+        *digit = u128_idiv_u64(&t, u64_10_pow_n(prec));
         if (*digit != 0) {
             *digit *= u64_10_pow_n(UINT64_10_POW_N_CUTOFF - prec);
             n_digits++;
@@ -411,15 +474,15 @@ fpdec_dyn_normalize(fpdec_t *fpdec) {
                     FALLTHROUGH;
                 case 0:
                     u64_mul_u64(&f, digits[digit_idx], dec_shift);
-                    // f < RADIX * 10^9
+                    // f < RADIX * 10^18
                     u128_iadd_u128(&shint, &f);
-                    // shint < RADIX + RADIX * 10^9 < 2^96
+                    // shint < RADIX + RADIX * 10^18 < 2^128
                     if (++digit_idx == n_digits)
                         break;
                     FALLTHROUGH;
                 case 1:
                     u64_mul_u64(&f, digits[digit_idx], dec_shift);
-                    // f < RADIX * 10^9
+                    // f < RADIX * 10^18
                     u128_imul_u64(&f, RADIX);
                     if (UINT128_CHECK_MAX(&f)) {
                         SIGNAL_OVERFLOW(&shint);
@@ -446,6 +509,34 @@ fpdec_dyn_normalize(fpdec_t *fpdec) {
     }
 }
 
+// The coefficient of a fpdec as array of digits (base RADIX), referring to
+// the digit array of a dyn fpdec or to buf for a shint
+typedef struct {
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t exp;
+    fpdec_digit_t buf[3];
+} digits_view_t;
+
+static void
+fpdec_get_digits_view(digits_view_t *view, const fpdec_t *fpdec) {
+    int n_trailing_zeros;
+
+    if (FPDEC_IS_DYN_ALLOC(fpdec)) {
+        view->digits = FPDEC_DYN_DIGITS(fpdec);
+        view->n_digits = FPDEC_DYN_N_DIGITS(fpdec);
+        view->exp = FPDEC_DYN_EXP(fpdec);
+    }
+    else {
+        view->digits = view->buf;
+        view->n_digits = du64_to_digits(view->buf, &n_trailing_zeros,
+                                        fpdec->lo, fpdec->hi,
+                                        FPDEC_DEC_PREC(fpdec));
+        view->exp = n_trailing_zeros -
+                    CEIL(FPDEC_DEC_PREC(fpdec), DEC_DIGITS_PER_DIGIT);
+    }
+}
+
 // Properties
 
 static int
@@ -481,7 +572,7 @@ fpdec_magnitude(const fpdec_t *fpdec) {
 
 // Comparison
 
-// Pre-condition: magnitude(x) == magnitude(y)
+// No pre-condition on the magnitudes
 static int
 fpdec_cmp_abs_shint_to_shint(const fpdec_t *x, const fpdec_t *y) {
     uint128_t x_shint = U128_FROM_SHINT(x);
@@ -550,6 +641,10 @@ fpdec_compare(const fpdec_t *x, const fpdec_t *y, const bool ignore_sign) {
     }
 
     // here: x != 0 and y != 0
+    // shifted ints can be compared directly, without taking their
+    // magnitudes
+    if (!FPDEC_IS_DYN_ALLOC(x) && !FPDEC_IS_DYN_ALLOC(y))
+        return fpdec_cmp_abs_shint_to_shint(x, y) * x_sign;
     x_magn = fpdec_magnitude(x);
     y_magn = fpdec_magnitude(y);
     if (x_magn != y_magn)
@@ -558,6 +653,56 @@ fpdec_compare(const fpdec_t *x, const fpdec_t *y, const bool ignore_sign) {
     return DISPATCH_BIN_EXPR(vtab_cmp, x, y) * x_sign;
 }
 
+// Hashing
+
+static inline uint64_t
+hash_combine(uint64_t h, uint64_t val) {
+    h = (h ^ val) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29U);
+}
+
+// Hashes the significant digits (base RADIX, without leading and trailing
+// zeros), the exponent and the sign, which are the same for all
+// representations of a value.
+size_t
+fpdec_hash(const fpdec_t *fpdec) {
+    digits_view_t view;
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t exp;
+    uint64_t h;
+
+    if (FPDEC_EQ_ZERO(fpdec))
+        return 0;
+
+    if (!FPDEC_IS_DYN_ALLOC(fpdec) && fpdec->hi == 0) {
+        // fast path for 64-bit shints, avoiding 128-bit divisions
+        uint64_t p = u64_10_pow_n(FPDEC_DEC_PREC(fpdec));
+        uint64_t int_part = fpdec->lo / p;
+        view.buf[0] = (fpdec->lo % p) *
+                      u64_10_pow_n(DEC_DIGITS_PER_DIGIT -
+                                   FPDEC_DEC_PREC(fpdec));
+        view.buf[1] = int_part % RADIX;
+        view.buf[2] = int_part / RADIX;
+        digits = view.buf;
+        n_digits = 3;
+        exp = -1;
+    }
+    else {
+        fpdec_get_digits_view(&view, fpdec);
+        digits = view.digits;
+        n_digits = view.n_digits;
+        exp = view.exp;
+    }
+    for (; n_digits > 0 && digits[n_digits - 1] == 0; --n_digits);
+    for (; n_digits > 0 && *digits == 0; --n_digits, ++digits, ++exp);
+
+    h = hash_combine((uint64_t)FPDEC_SIGN(fpdec), (uint64_t)exp);
+    for (fpdec_n_digits_t i = 0; i < n_digits; ++i)
+        h = hash_combine(h, digits[i]);
+    return (size_t)(h ^ (h >> 32U));
+}
+
 // Converter
 
 error_t
@@ -624,7 +769,9 @@ fpdec_dyn_adjust_to_prec(fpdec_t *fpdec, int32_t dec_prec,
             FPDEC_DYN_EXP(fpdec) += dec_shift / DEC_DIGITS_PER_DIGIT;
             dec_shift %= DEC_DIGITS_PER_DIGIT;
             quant = u64_10_pow_n(dec_shift);
-            if (round_qr(FPDEC_SIGN(fpdec), 0UL, 0UL, true, quant,
+            // all digits are below a tenth of quant, i.e. the remainder is
+            // less than half of any divisor (0 means 2 ^ 64)
+            if (round_qr(FPDEC_SIGN(fpdec), 0UL, 0UL, true, 0UL,
                          rounding) == 0UL) {
                 FPDEC_DYN_N_DIGITS(fpdec) = 0;
             }
@@ -775,6 +922,54 @@ fpdec_quantized(fpdec_t *fpdec, const fpdec_t *src, fpdec_t *quant,
     return rc;
 }
 
+// Target of a formatting operation: a buffer supplied by the caller or - if
+// buf is NULL - a buffer allocated by the formatting function. A result that
+// possibly does not fit into the caller's buffer is first formatted into a
+// scratch buffer (on the stack, if the result is small enough).
+
+#define FMT_SCRATCH_SIZE 256
+
+typedef struct {
+    uint8_t *buf;
+    size_t buf_size;
+    uint8_t *result;
+    size_t len;
+} fmt_target_t;
+
+static inline uint8_t *
+fmt_target_acquire(const fmt_target_t *target, const size_t max_n_bytes,
+                   uint8_t *scratch) {
+    if (target->buf != NULL) {
+        if (max_n_bytes < target->buf_size)
+            return target->buf;
+        if (max_n_bytes < FMT_SCRATCH_SIZE)
+            return scratch;
+    }
+    return fpdec_mem_alloc(max_n_bytes + 1, 1);
+}
+
+static inline void
+fmt_target_release(const fmt_target_t *target, uint8_t *buf,
+                   const uint8_t *scratch) {
+    if (buf != target->buf && buf != scratch)
+        fpdec_mem_free(buf);
+}
+
+static inline void
+fmt_target_commit(fmt_target_t *target, uint8_t *buf, const uint8_t *stop,
+                  const uint8_t *scratch) {
+    target->len = stop - buf;
+    if (target->buf == NULL) {
+        target->result = buf;
+    }
+    else if (buf != target->buf) {
+        // copy result only if it fits, otherwise just report its length
+        if (target->len < target->buf_size)
+            memcpy(target->buf, buf, target->len + 1);
+        fmt_target_release(target, buf, scratch);
+    }
+}
+
 static inline uint8_t *
 fill_in_zeros(uint8_t *ch, const int n) {
     uint8_t *stop = ch + n;
@@ -833,6 +1028,7 @@ buf_align(uint8_t *buf, size_t n_char, size_t min_width, uint8_t len_sign,
     switch (align) {
         case '=':
             ch += len_sign;
+            n_char -= len_sign;
             n_lpad = n_to_fill;
             break;
         case '>':
@@ -865,43 +1061,57 @@ buf_align(uint8_t *buf, size_t n_char, size_t min_width, uint8_t len_sign,
 
 static inline uint8_t *
 fill_in_digit(uint8_t *buf, fpdec_digit_t digit, const int n) {
-    uint8_t *t = buf + n;
-    for (uint8_t *ch = t - 1; ch >= buf; --ch) {
-        *ch = '0' + (digit % 10);
-        digit /= 10;
-    }
-    return t;
+    return u64_fill_in_dec_digits(buf, digit, n);
+}
+
+static inline uint8_t *
+fill_in_leading_digit(uint8_t *buf, fpdec_digit_t digit) {
+    if (digit == 0)
+        return buf;
+    return u64_fill_in_dec_digits(buf, digit, u64_n_dec_digits(digit));
 }
 
+// max number of decimal digits of an uint128_t
+#define MAX_N_DEC_DIGITS_IN_U128 39
+
 static inline uint8_t *
 fill_in_u128(uint8_t *buf, uint128_t ui) {
-    uint8_t dec_digits[MAX_N_DEC_DIGITS_IN_SHINT];
-    uint8_t *ch = dec_digits;
-    while (U128_NE_ZERO(ui))
-        *ch++ = '0' + u128_idiv_10(&ui);
-    while (--ch >= dec_digits)
-        *buf++ = *ch;
-    return buf;
+    fpdec_digit_t lo_digit, mid_digit;
+
+    if (U128_HI(ui) == 0)
+        return fill_in_leading_digit(buf, U128_LO(ui));
+    // split ui into digits base RADIX
+    lo_digit = u128_idiv_u64(&ui, RADIX);
+    if (U128_HI(ui) == 0)
+        buf = fill_in_leading_digit(buf, U128_LO(ui));
+    else {
+        mid_digit = u128_idiv_u64(&ui, RADIX);
+        buf = fill_in_leading_digit(buf, U128_LO(ui));
+        buf = fill_in_digit(buf, mid_digit, DEC_DIGITS_PER_DIGIT);
+    }
+    return fill_in_digit(buf, lo_digit, DEC_DIGITS_PER_DIGIT);
 }
 
 static inline uint8_t *
 fill_in_u128_padded(uint8_t *buf, uint128_t ui, utf8c_t sep,
                     struct grouping_iter *it, size_t min_width) {
-    size_t len = MAX(MAX_N_DEC_DIGITS_IN_SHINT, min_width + 1) *
+    size_t len = MAX(MAX_N_DEC_DIGITS_IN_U128, min_width + 1) *
                  (1 + sep.n_bytes) + 1;
     uint8_t r2l_buf[len];
     uint8_t *ch = r2l_buf + len - 1;
+    uint8_t dec_digits[MAX_N_DEC_DIGITS_IN_U128];
+    size_t n_dec_digits = fill_in_u128(dec_digits, ui) - dec_digits;
     size_t n_char = 0;
     uint8_t i, n;
 
     *ch = '\0';
     i = n = iter_grouping(it);
-    while (U128_NE_ZERO(ui) || n_char < min_width) {
-        *(--ch) = '0' + u128_idiv_10(&ui);
+    while (n_dec_digits > 0 || n_char < min_width) {
+        *(--ch) = n_dec_digits > 0 ? dec_digits[--n_dec_digits] : '0';
         ++n_char;
         if (n > 0) {
             --i;
-            if (i == 0 && (U128_NE_ZERO(ui) || n_char < min_width)) {
+            if (i == 0 && (n_dec_digits > 0 || n_char < min_width)) {
                 ch = fillin_n_bytes_to_the_left(ch, sep.bytes, sep.n_bytes);
                 ++n_char;
                 i = n = iter_grouping(it);
@@ -916,9 +1126,10 @@ fill_in_u128_padded(uint8_t *buf, uint128_t ui, utf8c_t sep,
     return buf;
 }
 
-static uint8_t *
+static error_t
 fpdec_shint_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
-                      const bool no_trailing_zeros) {
+                      const bool no_trailing_zeros, fmt_target_t *target) {
+    uint8_t scratch[FMT_SCRATCH_SIZE];
     uint8_t *buf;
     uint8_t *ch;
     size_t max_n_bytes;
@@ -949,7 +1160,7 @@ fpdec_shint_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
         int32_t adj_prec = fmt_spec->precision + dec_point_shift;
         rc = fpdec_adjusted(&adj, fpdec, adj_prec, FPDEC_ROUND_DEFAULT);
         if (rc != FPDEC_OK)
-            return NULL;
+            return rc;
         fpdec = &adj;
         dec_prec = fmt_spec->precision;
     }
@@ -958,7 +1169,8 @@ fpdec_shint_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
         1 +     // provision for sign
         // maximum number of integral decimal digits (incl. provision for
         // multi-byte thousands sep character)
-        (MAX_N_DEC_DIGITS_IN_SHINT - dec_prec) * (1 + len_thousands_sep) +
+        (MAX_N_DEC_DIGITS_IN_SHINT - MIN(dec_prec, MAX_DEC_PREC_FOR_SHINT) +
+         n_add_int_zeros) * (1 + len_thousands_sep) +
         // radix point
         len_decimal_point +
         // fractional digits
@@ -968,15 +1180,17 @@ fpdec_shint_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
     // min width (incl. provision for multi-byte fill character) +
     // provision for additional zero infront of a thousands separator
         fmt_spec->min_width * (1 + len_fill) + 1);
-    ch = buf = fpdec_mem_alloc(max_n_bytes + 1, 1);
-    if (buf == NULL)
-        MEMERROR_RETVAL(NULL);
+    ch = buf = fmt_target_acquire(target, max_n_bytes, scratch);
+    if (buf == NULL) {
+        fpdec_reset_to_zero(&adj, 0);
+        MEMERROR;
+    }
 
     // separate integral and fractional part
     uint128_t int_part = U128_FROM_SHINT(fpdec);
     uint64_t frac_part = 0;
-    if (dec_prec > 0)
-        // split shifted int
+    if (dec_prec > 0 && U128_NE_ZERO(int_part))
+        // split shifted int (only zero can have dec_prec > 18 here)
         frac_part = u128_idiv_u64(&int_part, u64_10_pow_n(dec_prec));
     else if (n_add_int_zeros > 0)
         // shift int part
@@ -1037,36 +1251,26 @@ fpdec_shint_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
 
     if (fmt_spec->type == '%')
         *ch++ = '%';
+    *ch = '\0';
 
     if (fmt_spec->min_width > 0) {
         n_char = utf8_strlen(buf);
         if (n_char == SIZE_MAX) {
-            fpdec_mem_free(buf);
-            ERROR_RETVAL(FPDEC_INVALID_FORMAT, NULL);
+            fmt_target_release(target, buf, scratch);
+            fpdec_reset_to_zero(&adj, 0);
+            ERROR(FPDEC_INVALID_FORMAT);
         }
         if (fmt_spec->min_width > n_char) {
             ch = buf_align(buf, n_char, fmt_spec->min_width, len_sign,
                            fmt_spec->align, fmt_spec->fill);
+            *ch = '\0';
         }
     }
 
     fpdec_reset_to_zero(&adj, 0);
     assert(ch <= buf + max_n_bytes);
-    assert(*ch == 0);
-    return buf;
-}
-
-static inline uint8_t *
-fill_in_leading_digit(uint8_t *buf, fpdec_digit_t digit) {
-    uint8_t dec_digits[DEC_DIGITS_PER_DIGIT];
-    uint8_t *ch = dec_digits;
-    while (digit > 0) {
-        *ch++ = '0' + (digit % 10);
-        digit /= 10;
-    }
-    while (--ch >= dec_digits)
-        *buf++ = *ch;
-    return buf;
+    fmt_target_commit(target, buf, ch, scratch);
+    return FPDEC_OK;
 }
 
 static inline uint8_t *
@@ -1079,9 +1283,10 @@ fill_in_digits_padded(uint8_t *buf, const fpdec_digit_t *most_signif_digit,
                      min_width + 1) * (1 + sep.n_bytes) + 1;
     uint8_t r2l_buf[len];
     uint8_t *ch = r2l_buf + len - 1;
+    uint8_t dec_digits[DEC_DIGITS_PER_DIGIT];
     size_t n_char = 0;
+    size_t n_dec_digits;
     uint8_t i, n;
-    fpdec_digit_t t;
 
     *ch = '\0';
     i = n = iter_grouping(it);
@@ -1100,10 +1305,9 @@ fill_in_digits_padded(uint8_t *buf, const fpdec_digit_t *most_signif_digit,
     n_char += n_trailing_zeros;
 
     for (; digit < most_signif_digit; ++digit) {
-        t = *digit;
-        for (int j = 0; j < DEC_DIGITS_PER_DIGIT; ++j) {
-            *(--ch) = '0' + (t % 10);
-            t /= 10;
+        fill_in_digit(dec_digits, *digit, DEC_DIGITS_PER_DIGIT);
+        for (int j = DEC_DIGITS_PER_DIGIT - 1; j >= 0; --j) {
+            *(--ch) = dec_digits[j];
             if (n > 0) {
                 --i;
                 if (i == 0) {
@@ -1119,16 +1323,15 @@ fill_in_digits_padded(uint8_t *buf, const fpdec_digit_t *most_signif_digit,
 
     // most significant digit and zero padding
     if (n_digits > 0)
-        t = *digit;
+        n_dec_digits = fill_in_leading_digit(dec_digits, *digit) - dec_digits;
     else
-        t = 0;
-    while (t > 0 || n_char < min_width) {
-        *(--ch) = '0' + (t % 10);
-        t /= 10;
+        n_dec_digits = 0;
+    while (n_dec_digits > 0 || n_char < min_width) {
+        *(--ch) = n_dec_digits > 0 ? dec_digits[--n_dec_digits] : '0';
         ++n_char;
         if (n > 0) {
             --i;
-            if (i == 0 && (t > 0 || n_char < min_width)) {
+            if (i == 0 && (n_dec_digits > 0 || n_char < min_width)) {
                 ch = fillin_n_bytes_to_the_left(ch, sep.bytes, sep.n_bytes);
                 ++n_char;
                 i = n = iter_grouping(it);
@@ -1143,9 +1346,10 @@ fill_in_digits_padded(uint8_t *buf, const fpdec_digit_t *most_signif_digit,
     return buf;
 }
 
-static uint8_t *
+static error_t
 fpdec_dyn_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
-                    const bool no_trailing_zeros) {
+                    const bool no_trailing_zeros, fmt_target_t *target) {
+    uint8_t scratch[FMT_SCRATCH_SIZE];
     uint8_t *buf;
     uint8_t *ch;
     size_t max_n_bytes;
@@ -1170,12 +1374,10 @@ fpdec_dyn_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
         rc = fpdec_adjusted(&adj, fpdec, needed_dec_prec,
                             FPDEC_ROUND_DEFAULT);
         if (rc != FPDEC_OK)
-            return NULL;
-        if (!FPDEC_IS_DYN_ALLOC(&adj)) {
-            buf = fpdec_shint_formatted(&adj, fmt_spec, no_trailing_zeros);
-            fpdec_reset_to_zero(&adj, 0);
-            return buf;
-        }
+            return rc;
+        if (!FPDEC_IS_DYN_ALLOC(&adj))
+            return fpdec_shint_formatted(&adj, fmt_spec, no_trailing_zeros,
+                                         target);
         fpdec = &adj;
     }
 
@@ -1198,7 +1400,7 @@ fpdec_dyn_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
         else {
             rc = fpdec_mul(&adj, fpdec, &FPDEC_ONE_HUNDRED);
             if (rc != FPDEC_OK)
-                return NULL;
+                return rc;
             fpdec = &adj;
         }
         FPDEC_DEC_PREC(fpdec) = FPDEC_DEC_PREC(fpdec) > 2 ?
@@ -1262,9 +1464,11 @@ fpdec_dyn_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
     // min width (incl. provision for multi-byte fill character) +
     // provision for additional zero infront of a thousands separator
         fmt_spec->min_width * (1 + len_fill) + 1);
-    ch = buf = fpdec_mem_alloc(max_n_bytes + 1, 1);
-    if (buf == NULL)
-        MEMERROR_RETVAL(NULL);
+    ch = buf = fmt_target_acquire(target, max_n_bytes, scratch);
+    if (buf == NULL) {
+        fpdec_reset_to_zero(&adj, 0);
+        MEMERROR;
+    }
 
     // sign to be shown?
     if (FPDEC_LT_ZERO(fpdec)) {     // always show sign for negative numbers
@@ -1336,56 +1540,57 @@ fpdec_dyn_formatted(const fpdec_t *fpdec, const format_spec_t *fmt_spec,
 
     if (fmt_spec->type == '%')
         *ch++ = '%';
+    *ch = '\0';
 
     if (fmt_spec->min_width > 0) {
         n_char = utf8_strlen(buf);
         if (n_char == SIZE_MAX) {
-            fpdec_mem_free(buf);
-            ERROR_RETVAL(FPDEC_INVALID_FORMAT, NULL);
+            fmt_target_release(target, buf, scratch);
+            fpdec_reset_to_zero(&adj, 0);
+            ERROR(FPDEC_INVALID_FORMAT);
         }
         if (fmt_spec->min_width > n_char) {
             ch = buf_align(buf, n_char, fmt_spec->min_width, len_sign,
                            fmt_spec->align, fmt_spec->fill);
+            *ch = '\0';
         }
     }
 
     fpdec_reset_to_zero(&adj, 0);
     assert(ch <= buf + max_n_bytes);
-    assert(*ch == 0);
-    return buf;
+    fmt_target_commit(target, buf, ch, scratch);
+    return FPDEC_OK;
 }
 
-typedef uint8_t *(*v_formatted)(const fpdec_t *, const format_spec_t *,
-                                const bool);
+typedef error_t (*v_formatted)(const fpdec_t *, const format_spec_t *,
+                               const bool, fmt_target_t *);
 
 const v_formatted vtab_formatted[2] = {
     fpdec_shint_formatted,
     fpdec_dyn_formatted,
 };
 
-uint8_t *
-fpdec_formatted(const fpdec_t *fpdec, const uint8_t *format) {
-    format_spec_t fmt_spec;
-    int rc;
+static inline void
+resolve_format_spec(format_spec_t *fmt_spec, const fpdec_t *fpdec) {
+    // precision and decimal point
+    if (fmt_spec->precision == SIZE_MAX)
+        fmt_spec->precision = FPDEC_DEC_PREC(fpdec);
+    if (fmt_spec->precision == 0)                   // if number is integral
+        fmt_spec->decimal_point.n_bytes = 0;        // suppress decimal point
+}
 
-    rc = parse_format_spec(&fmt_spec, format);
+static inline error_t
+parse_format(format_spec_t *fmt_spec, const uint8_t *format) {
+    int rc = parse_format_spec_cached(fmt_spec, format);
     if (rc == -1)
-        ERROR_RETVAL(FPDEC_INVALID_FORMAT, NULL);
+        ERROR(FPDEC_INVALID_FORMAT);
     if (rc == -2)
-        ERROR_RETVAL(FPDEC_INCOMPAT_LOCALE, NULL);
-
-    // precision and decimal point
-    if (fmt_spec.precision == SIZE_MAX)
-        fmt_spec.precision = FPDEC_DEC_PREC(fpdec);
-    if (fmt_spec.precision == 0)                    // if number is integral
-        fmt_spec.decimal_point.n_bytes = 0;         // suppress decimal point
-
-    return DISPATCH_FUNC_VA(vtab_formatted, fpdec, &fmt_spec, false);
+        ERROR(FPDEC_INCOMPAT_LOCALE);
+    return FPDEC_OK;
 }
 
-char *
-fpdec_as_ascii_literal(const fpdec_t *fpdec,
-                       const bool no_trailing_zeros) {
+static inline format_spec_t
+ascii_literal_format_spec(const fpdec_t *fpdec) {
     format_spec_t fmt_spec = {
         .fill = {0, ""},
         .align = '<',
@@ -1397,8 +1602,104 @@ fpdec_as_ascii_literal(const fpdec_t *fpdec,
         .precision = FPDEC_DEC_PREC(fpdec),
         .type = 'f'
     };
-    return (char *)DISPATCH_FUNC_VA(vtab_formatted, fpdec, &fmt_spec,
-                                    no_trailing_zeros);
+    return fmt_spec;
+}
+
+uint8_t *
+fpdec_formatted(const fpdec_t *fpdec, const uint8_t *format) {
+    format_spec_t fmt_spec;
+    fmt_target_t target = {NULL, 0, NULL, 0};
+
+    if (parse_format(&fmt_spec, format) != FPDEC_OK)
+        return NULL;
+    resolve_format_spec(&fmt_spec, fpdec);
+    if (DISPATCH_FUNC_VA(vtab_formatted, fpdec, &fmt_spec, false,
+                         &target) != FPDEC_OK)
+        return NULL;
+    return target.result;
+}
+
+error_t
+fpdec_format_compile(format_spec_t *spec, const uint8_t *format) {
+    return parse_format(spec, format);
+}
+
+uint8_t *
+fpdec_format_with(const fpdec_t *fpdec, const format_spec_t *spec) {
+    format_spec_t fmt_spec = *spec;
+    fmt_target_t target = {NULL, 0, NULL, 0};
+
+    resolve_format_spec(&fmt_spec, fpdec);
+    if (DISPATCH_FUNC_VA(vtab_formatted, fpdec, &fmt_spec, false,
+                         &target) != FPDEC_OK)
+        return NULL;
+    return target.result;
+}
+
+char *
+fpdec_as_ascii_literal(const fpdec_t *fpdec,
+                       const bool no_trailing_zeros) {
+    format_spec_t fmt_spec = ascii_literal_format_spec(fpdec);
+    fmt_target_t target = {NULL, 0, NULL, 0};
+
+    if (DISPATCH_FUNC_VA(vtab_formatted, fpdec, &fmt_spec, no_trailing_zeros,
+                         &target) != FPDEC_OK)
+        return NULL;
+    return (char *)target.result;
+}
+
+static error_t
+fpdec_format_to_buffer(uint8_t *buf, size_t buf_size, size_t *len,
+                       const fpdec_t *fpdec, const format_spec_t *fmt_spec,
+                       const bool no_trailing_zeros) {
+    uint8_t dummy;
+    error_t rc;
+
+    if (buf == NULL) {      // only length requested
+        assert(buf_size == 0);
+        buf = &dummy;
+        buf_size = 0;
+    }
+    fmt_target_t target = {buf, buf_size, NULL, 0};
+    rc = DISPATCH_FUNC_VA(vtab_formatted, fpdec, fmt_spec, no_trailing_zeros,
+                          &target);
+    *len = target.len;
+    return rc;
+}
+
+error_t
+fpdec_formatted_to_buffer(uint8_t *buf, size_t buf_size, size_t *len,
+                          const fpdec_t *fpdec, const uint8_t *format) {
+    format_spec_t fmt_spec;
+    error_t rc;
+
+    rc = parse_format(&fmt_spec, format);
+    if (rc != FPDEC_OK)
+        return rc;
+    resolve_format_spec(&fmt_spec, fpdec);
+    return fpdec_format_to_buffer(buf, buf_size, len, fpdec, &fmt_spec,
+                                  false);
+}
+
+error_t
+fpdec_formatted_spec_to_buffer(uint8_t *buf, size_t buf_size, size_t *len,
+                               const fpdec_t *fpdec,
+                               const format_spec_t *spec) {
+    format_spec_t fmt_spec = *spec;
+
+    resolve_format_spec(&fmt_spec, fpdec);
+    return fpdec_format_to_buffer(buf, buf_size, len, fpdec, &fmt_spec,
+                                  false);
+}
+
+error_t
+fpdec_as_ascii_literal_to_buffer(char *buf, size_t buf_size, size_t *len,
+                                 const fpdec_t *fpdec,
+                                 const bool no_trailing_zeros) {
+    format_spec_t fmt_spec = ascii_literal_format_spec(fpdec);
+
+    return fpdec_format_to_buffer((uint8_t *)buf, buf_size, len, fpdec,
+                                  &fmt_spec, no_trailing_zeros);
 }
 
 int
@@ -1468,521 +1769,2797 @@ fpdec_as_sign_coeff128_exp(fpdec_sign_t *sign, uint128_t *coeff, int64_t *exp,
     return 0;
 }
 
-// Basic arithmetic operations
-
-static inline fpdec_dec_prec_t
-make_adjusted_shints(uint128_t *x_shint, uint128_t *y_shint,
-                     const fpdec_dec_prec_t x_dec_prec,
-                     const fpdec_dec_prec_t y_dec_prec) {
-    int shift = x_dec_prec - y_dec_prec;
-    fpdec_dec_prec_t prec;
-
-    if (shift == 0)
-        prec = x_dec_prec;
-    else if (shift > 0) {
-        prec = x_dec_prec;
-        // y_shint < 2^96 and 0 <= shift <= 9
-        u128_imul_10_pow_n(y_shint, shift);
-        // y_shint < 2^96 * 10^9 < 2^128
-    }
-    else {
-        prec = y_dec_prec;
-        u128_idecshift(x_shint, FPDEC_SIGN_POS, -shift, FPDEC_ROUND_DEFAULT);
+// Conversion to integers
+
+// Multiplies x by 10 ^ n, returns false if the result does not fit into
+// 128 bits
+static bool
+u128_imul_10_pow_n_checked(uint128_t *x, int64_t n) {
+    uint128_t lo_prod, hi_prod;
+    int k;
+
+    for (; n > 0; n -= k) {
+        k = (int)MIN(n, UINT64_10_POW_N_CUTOFF);
+        u64_mul_u64(&lo_prod, U128_LO(*x), u64_10_pow_n(k));
+        u64_mul_u64(&hi_prod, U128_HI(*x), u64_10_pow_n(k));
+        if (U128_HI(hi_prod) != 0 ||
+            U128_LO(hi_prod) > UINT64_MAX - U128_HI(lo_prod))
+            return false;
+        U128_FROM_LO_HI(x, U128_LO(lo_prod),
+                        U128_LO(hi_prod) + U128_HI(lo_prod));
     }
-    return prec;
+    return true;
 }
 
+// Sets sign and magn to the sign and the magnitude of fpdec * 10 ^ scale
+// rounded to an integer.
 static error_t
-fpdec_add_abs_shint_to_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    uint128_t x_shint = U128_FROM_SHINT(x);
-    uint128_t y_shint = U128_FROM_SHINT(y);
+fpdec_as_sign_scaled_u128(fpdec_sign_t *sign, uint128_t *magn,
+                          const fpdec_t *fpdec, const int32_t scale,
+                          const enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_t adj = FPDEC_ZERO;
+    int64_t exp;
+    error_t rc;
 
-    FPDEC_DEC_PREC(z) = make_adjusted_shints(&x_shint, &y_shint,
-                                             FPDEC_DEC_PREC(x),
-                                             FPDEC_DEC_PREC(y));
-    u128_iadd_u128(&x_shint, &y_shint);
-    z->lo = U128_LO(x_shint);
-    z->hi = U128_HI(x_shint);
-    if (U128_FITS_SHINT(x_shint))
+    *sign = FPDEC_SIGN(fpdec);
+    *magn = UINT128_ZERO;
+    if (ABS(scale) > FPDEC_MAX_DEC_PREC)
+        ERROR(FPDEC_PREC_LIMIT_EXCEEDED);
+    if (*sign == FPDEC_SIGN_ZERO)
         return FPDEC_OK;
-    else
-        return fpdec_shint_to_dyn(z);
-}
 
-static error_t
-fpdec_add_abs_dyn_to_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    fpdec_n_digits_t n_shift, n_add_zeros;
-    fpdec_digit_array_t *z_digits;
-    const fpdec_digit_array_t *s_digits;
-    fpdec_exp_t z_exp;
+    if (!FPDEC_IS_DYN_ALLOC(fpdec) && scale >= 0) {
+        int32_t shift = scale - FPDEC_DEC_PREC(fpdec);
 
-    if (FPDEC_DYN_EXP(x) == FPDEC_DYN_EXP(y)) {
-        n_shift = 0;                // no need to adjust exponents
-        n_add_zeros = 1;            // provision for potential carry-over
-        if (FPDEC_DYN_N_DIGITS(x) >= FPDEC_DYN_N_DIGITS(y)) {
-            z_digits = digits_copy(x->digit_array, n_shift, n_add_zeros);
-            if (z_digits == NULL)
-                MEMERROR;
-            s_digits = y->digit_array;
+        U128_FROM_LO_HI(magn, fpdec->lo, fpdec->hi);
+        if (shift < 0) {
+            // -18 <= shift < 0
+            u128_idecshift(magn, *sign, shift, rounding);
+            return FPDEC_OK;
         }
-        else {
-            z_digits = digits_copy(y->digit_array, n_shift, n_add_zeros);
-            if (z_digits == NULL)
-                MEMERROR;
-            s_digits = x->digit_array;
-        }
-        z_exp = FPDEC_DYN_EXP(x);
-    }
-    else if (FPDEC_DYN_EXP(x) > FPDEC_DYN_EXP(y)) {
-        n_shift = FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y);
-        n_add_zeros = MAX((int)FPDEC_DYN_N_DIGITS(y) -
-                          (int)FPDEC_DYN_N_DIGITS(x) -
-                          (int)n_shift + 1,
-                          1);
-        z_digits = digits_copy(x->digit_array, n_shift, n_add_zeros);
-        if (z_digits == NULL)
-            MEMERROR;
-        s_digits = y->digit_array;
-        z_exp = FPDEC_DYN_EXP(y);
-    }
-    else {
-        n_shift = FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x);
-        n_add_zeros = MAX((int)FPDEC_DYN_N_DIGITS(x) -
-                          (int)FPDEC_DYN_N_DIGITS(y) -
-                          (int)n_shift + 1,
-                          1);
-        z_digits = digits_copy(y->digit_array, n_shift, n_add_zeros);
-        if (z_digits == NULL)
-            MEMERROR;
-        s_digits = x->digit_array;
-        z_exp = FPDEC_DYN_EXP(x);
+        if (!u128_imul_10_pow_n_checked(magn, shift))
+            ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+        return FPDEC_OK;
     }
-    digits_iadd_digits(z_digits, s_digits);
-    z->exp = z_exp + digits_eliminate_trailing_zeros(z_digits);
-    z->digit_array = z_digits;
-    z->dyn_alloc = true;
-    z->normalized = true;
+
+    rc = fpdec_adjusted(&adj, fpdec, scale, rounding);
+    if (rc != FPDEC_OK)
+        return rc;
+    rc = fpdec_as_sign_coeff128_exp(sign, magn, &exp, &adj);
+    fpdec_reset_to_zero(&adj, 0);
+    if (rc != 0)
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+    // adj is a multiple of 10 ^ -scale and its coeff has no trailing zeros,
+    // so exp + scale >= 0 unless adj is 0
+    if (*sign != FPDEC_SIGN_ZERO &&
+        !u128_imul_10_pow_n_checked(magn, exp + scale))
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
     return FPDEC_OK;
 }
 
-static error_t
-fpdec_add_abs_dyn_to_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+error_t
+fpdec_as_scaled_i64(int64_t *val, const fpdec_t *fpdec, const int32_t scale,
+                    const enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_sign_t sign;
+    uint128_t magn;
     error_t rc;
-    fpdec_t s;
 
-    rc = fpdec_copy_shint_as_dyn(&s, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_add_abs_dyn_to_dyn(z, &s, y);
-        fpdec_reset_to_zero(&s, 0);
+    rc = fpdec_as_sign_scaled_u128(&sign, &magn, fpdec, scale, rounding);
+    if (rc == FPDEC_PREC_LIMIT_EXCEEDED)
+        return rc;
+    if (rc != FPDEC_OK || U128_HI(magn) != 0 ||
+        U128_LO(magn) > (uint64_t)INT64_MAX + (sign < 0)) {
+        *val = sign < 0 ? INT64_MIN : INT64_MAX;
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
     }
-    return rc;
+    *val = sign < 0 ? (int64_t)(0 - U128_LO(magn)) : (int64_t)U128_LO(magn);
+    return FPDEC_OK;
 }
 
-static error_t
-fpdec_add_abs_shint_to_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+error_t
+fpdec_as_i64(int64_t *val, const fpdec_t *fpdec,
+             const enum FPDEC_ROUNDING_MODE rounding) {
+    return fpdec_as_scaled_i64(val, fpdec, 0, rounding);
+}
+
+#ifdef __SIZEOF_INT128__
+error_t
+fpdec_as_i128(__int128 *val, const fpdec_t *fpdec,
+              const enum FPDEC_ROUNDING_MODE rounding) {
+    const uint128_t max_magn = UINT128_MAX >> 1U;
+    fpdec_sign_t sign;
+    uint128_t magn;
     error_t rc;
-    fpdec_t s;
 
-    rc = fpdec_copy_shint_as_dyn(&s, y);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_add_abs_dyn_to_dyn(z, x, &s);
-        fpdec_reset_to_zero(&s, 0);
+    rc = fpdec_as_sign_scaled_u128(&sign, &magn, fpdec, 0, rounding);
+    if (rc != FPDEC_OK || magn > max_magn + (sign < 0)) {
+        *val = sign < 0 ? -(__int128)max_magn - 1 : (__int128)max_magn;
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
     }
-    return rc;
+    *val = sign < 0 ? (__int128)(0 - magn) : (__int128)magn;
+    return FPDEC_OK;
+}
+#endif // __int128
+
+// Binary serialization
+
+// Header byte: bits 7..4 format version, bit 3 reserved (0), bit 2 set for
+// a digit array, bits 1..0 sign (0: zero, 1: positive, 2: negative)
+#define ENC_FORMAT_VERSION 1U
+#define ENC_VERSION_SHIFT 4U
+#define ENC_RESERVED_BIT 0x08U
+#define ENC_DYN_BIT 0x04U
+#define ENC_SIGN_MASK 0x03U
+#define ENC_SIGN_POS 0x01U
+#define ENC_SIGN_NEG 0x02U
+
+static inline size_t
+varint_size(uint64_t val) {
+    size_t size = 1;
+
+    for (; val >= 0x80U; val >>= 7U)
+        size++;
+    return size;
 }
 
-typedef error_t (*v_math_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+static inline uint8_t *
+varint_put(uint8_t *buf, uint64_t val) {
+    for (; val >= 0x80U; val >>= 7U)
+        *buf++ = (uint8_t)(val | 0x80U);
+    *buf++ = (uint8_t)val;
+    return buf;
+}
 
-const v_math_op vtab_add_abs[4] = {
-    fpdec_add_abs_shint_to_shint,
-    fpdec_add_abs_dyn_to_shint,
-    fpdec_add_abs_shint_to_dyn,
-    fpdec_add_abs_dyn_to_dyn
-};
+// Reads a varint from the bytes [*pos, end) and advances pos; returns false
+// if the varint is truncated or exceeds 64 bits.
+static inline bool
+varint_get(uint64_t *val, const uint8_t **pos, const uint8_t *end) {
+    const uint8_t *p = *pos;
+    uint64_t res = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+
+    do {
+        if (p == end || shift > 63 || (shift == 63 && *p > 1))
+            return false;
+        byte = *p++;
+        res |= (uint64_t)(byte & 0x7FU) << shift;
+        shift += 7;
+    } while (byte >= 0x80U);
+    *val = res;
+    *pos = p;
+    return true;
+}
 
-// pre-condition: x >= y
-static error_t
-fpdec_sub_abs_shint_from_shint(fpdec_t *z, const fpdec_t *x,
-                               const fpdec_t *y) {
-    uint128_t x_shint = U128_FROM_SHINT(x);
-    uint128_t y_shint = U128_FROM_SHINT(y);
+static inline uint64_t
+zigzag_encode(int64_t val) {
+    return ((uint64_t)val << 1U) ^ (uint64_t)(val < 0 ? -1 : 0);
+}
 
-    FPDEC_DEC_PREC(z) = make_adjusted_shints(&x_shint, &y_shint,
-                                             FPDEC_DEC_PREC(x),
-                                             FPDEC_DEC_PREC(y));
-    u128_isub_u128(&x_shint, &y_shint);
-    z->lo = U128_LO(x_shint);
-    z->hi = U128_HI(x_shint);
+static inline int64_t
+zigzag_decode(uint64_t val) {
+    return (int64_t)(val >> 1U) ^ -(int64_t)(val & 1U);
+}
+
+// The significant digits of a non-zero dyn fpdec (i.e. without leading and
+// trailing zeros) and the corresponding exponent
+static void
+dyn_signif_digits(const fpdec_digit_t **digits, fpdec_n_digits_t *n_digits,
+                  fpdec_exp_t *exp, const fpdec_t *fpdec) {
+    const fpdec_digit_t *first = FPDEC_DYN_DIGITS(fpdec);
+    fpdec_n_digits_t n = FPDEC_DYN_N_DIGITS(fpdec);
+    fpdec_exp_t e = FPDEC_DYN_EXP(fpdec);
+
+    for (; n > 0 && first[n - 1] == 0; --n);
+    for (; n > 0 && *first == 0; --n, ++first, ++e);
+    assert(n > 0);
+    *digits = first;
+    *n_digits = n;
+    *exp = e;
+}
+
+size_t
+fpdec_encoded_size(const fpdec_t *fpdec) {
+    size_t size = 1 + varint_size(FPDEC_DEC_PREC(fpdec));
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t exp;
+
+    if (FPDEC_EQ_ZERO(fpdec))
+        return size;
+    if (!FPDEC_IS_DYN_ALLOC(fpdec))
+        return size + varint_size(fpdec->lo) + varint_size(fpdec->hi);
+    dyn_signif_digits(&digits, &n_digits, &exp, fpdec);
+    size += varint_size(zigzag_encode(exp)) + varint_size(n_digits);
+    for (fpdec_n_digits_t i = 0; i < n_digits; ++i)
+        size += varint_size(digits[i]);
+    return size;
+}
+
+error_t
+fpdec_encode(uint8_t *buf, size_t buf_size, size_t *len,
+             const fpdec_t *fpdec) {
+    uint8_t header = ENC_FORMAT_VERSION << ENC_VERSION_SHIFT;
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t exp;
+
+    *len = fpdec_encoded_size(fpdec);
+    if (*len > buf_size)
+        return FPDEC_OK;
+
+    if (FPDEC_GT_ZERO(fpdec))
+        header |= ENC_SIGN_POS;
+    else if (FPDEC_LT_ZERO(fpdec))
+        header |= ENC_SIGN_NEG;
+    if (FPDEC_IS_DYN_ALLOC(fpdec) && !FPDEC_EQ_ZERO(fpdec))
+        header |= ENC_DYN_BIT;
+    *buf++ = header;
+    buf = varint_put(buf, FPDEC_DEC_PREC(fpdec));
+    if (FPDEC_EQ_ZERO(fpdec))
+        return FPDEC_OK;
+    if (!FPDEC_IS_DYN_ALLOC(fpdec)) {
+        buf = varint_put(buf, fpdec->lo);
+        varint_put(buf, fpdec->hi);
+        return FPDEC_OK;
+    }
+    dyn_signif_digits(&digits, &n_digits, &exp, fpdec);
+    buf = varint_put(buf, zigzag_encode(exp));
+    buf = varint_put(buf, n_digits);
+    for (fpdec_n_digits_t i = 0; i < n_digits; ++i)
+        buf = varint_put(buf, digits[i]);
     return FPDEC_OK;
 }
 
-static error_t
-fpdec_sub_abs_dyn_from_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    fpdec_n_digits_t n_shift;
-    fpdec_digit_array_t *z_digits;
-    fpdec_digit_array_t *s_digits;
-    bool s_digits_is_copy = false;
-    fpdec_exp_t z_exp;
+// Reads n_digits digits from [*pos, end) into a new digit array; returns
+// NULL (with errno set) if memory can't be allocated or the digits are
+// invalid.
+static fpdec_digit_array_t *
+decode_digits(const uint8_t **pos, const uint8_t *end,
+              fpdec_n_digits_t n_digits) {
+    fpdec_digit_array_t *digit_array = digits_enlarged(NULL, 0, n_digits);
+    uint64_t digit;
+
+    if (digit_array == NULL)
+        ERROR_RETVAL(ENOMEM, NULL);
+    for (fpdec_n_digits_t i = 0; i < n_digits; ++i) {
+        if (!varint_get(&digit, pos, end) || digit >= RADIX) {
+            fpdec_mem_free(digit_array);
+            ERROR_RETVAL(FPDEC_INVALID_ENCODING, NULL);
+        }
+        digit_array->digits[i] = digit;
+    }
+    digit_array->n_signif = n_digits;
+    if (digit_array->digits[0] == 0 ||
+        digit_array->digits[n_digits - 1] == 0) {
+        fpdec_mem_free(digit_array);
+        ERROR_RETVAL(FPDEC_INVALID_ENCODING, NULL);
+    }
+    return digit_array;
+}
 
-    if (FPDEC_DYN_EXP(x) == FPDEC_DYN_EXP(y)) {
-        n_shift = 0;                // no need to adjust exponents
-        z_digits = digits_copy(x->digit_array, n_shift, 0);
-        if (z_digits == NULL)
-            MEMERROR;
-        s_digits = y->digit_array;
-        z_exp = FPDEC_DYN_EXP(x);
+error_t
+fpdec_decode(fpdec_t *fpdec, const uint8_t *buf, size_t buf_size,
+             size_t *len) {
+    const uint8_t *pos = buf;
+    const uint8_t *end = buf + buf_size;
+    uint64_t dec_prec, lo, hi, zz_exp, n_digits;
+    int64_t exp;
+    unsigned sign_bits;
+    fpdec_digit_array_t *digit_array;
+    fpdec_digit_t digit;
+    int64_t n_frac_digits;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (buf_size == 0 ||
+        *buf >> ENC_VERSION_SHIFT != ENC_FORMAT_VERSION ||
+        (*buf & ENC_RESERVED_BIT) != 0 ||
+        (sign_bits = *buf & ENC_SIGN_MASK) == ENC_SIGN_MASK)
+        ERROR(FPDEC_INVALID_ENCODING);
+    pos++;
+    if (!varint_get(&dec_prec, &pos, end) || dec_prec > FPDEC_MAX_DEC_PREC)
+        ERROR(FPDEC_INVALID_ENCODING);
+
+    if (sign_bits == 0) {
+        if ((*buf & ENC_DYN_BIT) != 0)
+            ERROR(FPDEC_INVALID_ENCODING);
+        fpdec->dec_prec = dec_prec;
+        *len = pos - buf;
+        return FPDEC_OK;
     }
-    else if (FPDEC_DYN_EXP(x) > FPDEC_DYN_EXP(y)) {
-        n_shift = FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y);
-        z_digits = digits_copy(x->digit_array, n_shift, 0);
-        if (z_digits == NULL)
-            MEMERROR;
-        s_digits = y->digit_array;
-        z_exp = FPDEC_DYN_EXP(y);
+
+    if ((*buf & ENC_DYN_BIT) == 0) {
+        if (dec_prec > MAX_DEC_PREC_FOR_SHINT ||
+            !varint_get(&lo, &pos, end) || !varint_get(&hi, &pos, end) ||
+            hi > UINT32_MAX || (lo == 0 && hi == 0))
+            ERROR(FPDEC_INVALID_ENCODING);
+        fpdec->lo = lo;
+        fpdec->hi = hi;
     }
     else {
-        z_digits = digits_copy(x->digit_array, 0, 0);
-        if (z_digits == NULL)
-            MEMERROR;
-        n_shift = FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x);
-        s_digits = digits_copy(y->digit_array, n_shift, 0);
-        if (s_digits == NULL) {
-            fpdec_mem_free((void *)z_digits);
-            MEMERROR;
+        // each digit takes at least one byte
+        if (!varint_get(&zz_exp, &pos, end) ||
+            !varint_get(&n_digits, &pos, end) ||
+            n_digits == 0 || n_digits > (uint64_t)(end - pos) ||
+            n_digits > UINT32_MAX)
+            ERROR(FPDEC_INVALID_ENCODING);
+        exp = zigzag_decode(zz_exp);
+        if (exp < FPDEC_MIN_EXP || exp > FPDEC_MAX_EXP)
+            ERROR(FPDEC_INVALID_ENCODING);
+        digit_array = decode_digits(&pos, end, n_digits);
+        if (digit_array == NULL)
+            return errno;
+        // the precision must cover all fractional digits
+        n_frac_digits = -exp * DEC_DIGITS_PER_DIGIT;
+        for (digit = digit_array->digits[0]; digit % 10 == 0; digit /= 10)
+            n_frac_digits--;
+        if (n_frac_digits > (int64_t)dec_prec) {
+            fpdec_mem_free(digit_array);
+            ERROR(FPDEC_INVALID_ENCODING);
         }
-        s_digits_is_copy = true;
-        z_exp = FPDEC_DYN_EXP(x);
+        fpdec->dyn_alloc = true;
+        fpdec->normalized = true;
+        fpdec->exp = exp;
+        fpdec->digit_array = digit_array;
     }
-    digits_isub_digits(z_digits, s_digits);
-    if (s_digits_is_copy)
-        fpdec_mem_free((void *)s_digits);
-    z->exp = z_exp;
-    z->digit_array = z_digits;
-    z->dyn_alloc = true;
-    fpdec_dyn_normalize(z);
+    fpdec->sign = sign_bits == ENC_SIGN_NEG ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
+    fpdec->dec_prec = dec_prec;
+    *len = pos - buf;
     return FPDEC_OK;
 }
 
-static error_t
-fpdec_sub_abs_dyn_from_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    error_t rc;
-    fpdec_t s;
-
-    rc = fpdec_copy_shint_as_dyn(&s, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_sub_abs_dyn_from_dyn(z, &s, y);
-        fpdec_reset_to_zero(&s, 0);
+// Order preserving keys
+
+// Header byte of a key: zero, or the sign together with the decimal
+// exponent e (|value| = 0.d[1] d[2] .. d[n] * 10 ^ e, d[1] != 0), either
+// embedded (-62 <= e <= 62) or following as 8 byte big-endian biased int.
+// The header bytes of negative values are the negated ones of the
+// corresponding positive values, so that 0x01 .. 0x7F < 0x80 < 0x81 .. 0xFF.
+#define KEY_ZERO 0x80U
+#define KEY_EXP_BELOW 0x81U
+#define KEY_EXP_BIAS 0xC0U
+#define KEY_EXP_ABOVE 0xFFU
+#define KEY_MAX_SMALL_EXP 62
+#define KEY_N_EXP_BYTES 8
+#define KEY_N_PREC_BYTES 2
+
+// Decimal exponent and number of significant decimal digits of a non-zero
+// fpdec, i.e. |fpdec| = 0.d[1] d[2] .. d[n_dec_digits] * 10 ^ exp
+static void
+key_signif(int64_t *exp, size_t *n_dec_digits, const fpdec_t *fpdec) {
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t dyn_exp;
+    unsigned n_lead, n_trailing_zeros = 0;
+    uint128_t coeff;
+
+    if (!FPDEC_IS_DYN_ALLOC(fpdec)) {
+        coeff = U128_FROM_SHINT(fpdec);
+        n_trailing_zeros = u128_eliminate_trailing_zeros(
+            &coeff, MAX_N_DEC_DIGITS_IN_SHINT);
+        *n_dec_digits = u128_n_dec_digits(U128_LO(coeff), U128_HI(coeff));
+        *exp = (int64_t)*n_dec_digits + n_trailing_zeros -
+               FPDEC_DEC_PREC(fpdec);
+        return;
     }
-    return rc;
+    dyn_signif_digits(&digits, &n_digits, &dyn_exp, fpdec);
+    n_lead = u64_n_dec_digits(digits[n_digits - 1]);
+    n_trailing_zeros = u64_n_trailing_dec_zeros(digits[0]);
+    *n_dec_digits = (size_t)(n_digits - 1) * DEC_DIGITS_PER_DIGIT + n_lead -
+                    n_trailing_zeros;
+    *exp = ((int64_t)dyn_exp + n_digits - 1) * DEC_DIGITS_PER_DIGIT + n_lead;
 }
 
-static error_t
-fpdec_sub_abs_shint_from_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    error_t rc;
-    fpdec_t s;
+size_t
+fpdec_key_size(const fpdec_t *fpdec) {
+    int64_t exp;
+    size_t n_dec_digits;
 
-    rc = fpdec_copy_shint_as_dyn(&s, y);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_sub_abs_dyn_from_dyn(z, x, &s);
-        fpdec_reset_to_zero(&s, 0);
+    if (FPDEC_EQ_ZERO(fpdec))
+        return 1 + KEY_N_PREC_BYTES;
+    key_signif(&exp, &n_dec_digits, fpdec);
+    return 1 + (ABS(exp) > KEY_MAX_SMALL_EXP ? KEY_N_EXP_BYTES : 0) +
+           CEIL(n_dec_digits, 2) + KEY_N_PREC_BYTES;
+}
+
+// The significant decimal digits are written in pairs, one byte per pair:
+// 2 * pair + 1, or 2 * pair for the last one (padded with a 0 if needed),
+// so that no key is a prefix of another one. Like the exponent bytes, they
+// are complemented for negative values (the precision bytes written by
+// fpdec_encode_key are not). Bytes beyond end are dropped.
+typedef struct key_digit_writer {
+    uint8_t *pos;
+    uint8_t *end;
+    uint8_t mask;
+    size_t n_left;
+    int half;
+} key_digit_writer_t;
+
+static inline void
+key_put_digits(key_digit_writer_t *w, const uint8_t *chars, size_t n) {
+    const uint8_t *ch = chars;
+    const uint8_t *stop = chars + n;
+    int pair;
+
+    if (w->half >= 0 && ch < stop && w->pos < w->end) {
+        pair = w->half * 10 + (*ch++ - '0');
+        --w->n_left;
+        *w->pos++ = (uint8_t)(2 * pair + (w->n_left > 0)) ^ w->mask;
+        w->half = -1;
+    }
+    for (; stop - ch >= 2 && w->pos < w->end; ch += 2) {
+        pair = (ch[0] - '0') * 10 + (ch[1] - '0');
+        w->n_left -= 2;
+        *w->pos++ = (uint8_t)(2 * pair + (w->n_left > 0)) ^ w->mask;
+    }
+    if (ch < stop && w->pos < w->end) {
+        --w->n_left;
+        if (w->n_left > 0)
+            w->half = *ch - '0';
+        else
+            *w->pos++ = (uint8_t)(2 * (*ch - '0') * 10) ^ w->mask;
     }
-    return rc;
 }
 
-const v_math_op vtab_sub_abs[4] = {
-    fpdec_sub_abs_shint_from_shint,
-    fpdec_sub_abs_dyn_from_shint,
-    fpdec_sub_abs_shint_from_dyn,
-    fpdec_sub_abs_dyn_from_dyn
-};
+// Writes the key of fpdec without the precision to buf, but not beyond end.
+// Returns a pointer to the byte following the written ones and sets
+// complete to false if bytes were dropped.
+static uint8_t *
+key_put_value(uint8_t *buf, uint8_t *end, bool *complete,
+              const fpdec_t *fpdec) {
+    const bool neg = FPDEC_LT_ZERO(fpdec);
+    key_digit_writer_t w = {buf + 1, end, neg ? 0xFFU : 0U, 0, -1};
+    uint8_t chars[MAX_N_DEC_DIGITS_IN_U128];
+    const fpdec_digit_t *digits;
+    fpdec_n_digits_t n_digits;
+    fpdec_exp_t dyn_exp;
+    uint8_t header;
+    int64_t exp;
+    uint64_t biased_exp;
+    size_t n;
+
+    assert(buf < end);
+
+    if (FPDEC_EQ_ZERO(fpdec)) {
+        *buf = KEY_ZERO;
+        *complete = true;
+        return buf + 1;
+    }
+    if (!FPDEC_IS_DYN_ALLOC(fpdec)) {
+        // the trailing zeros are dropped from the chars, not the coeff
+        n = fill_in_u128(chars, U128_FROM_SHINT(fpdec)) - chars;
+        exp = (int64_t)n - FPDEC_DEC_PREC(fpdec);
+        for (w.n_left = n; chars[w.n_left - 1] == '0'; --w.n_left);
+    }
+    else
+        key_signif(&exp, &w.n_left, fpdec);
+    if (exp < -KEY_MAX_SMALL_EXP)
+        header = KEY_EXP_BELOW;
+    else if (exp > KEY_MAX_SMALL_EXP)
+        header = KEY_EXP_ABOVE;
+    else
+        header = (uint8_t)(KEY_EXP_BIAS + exp);
+    *buf = neg ? (uint8_t)(0x100U - header) : header;
+    if (header == KEY_EXP_BELOW || header == KEY_EXP_ABOVE) {
+        biased_exp = (uint64_t)exp ^ 0x8000000000000000ULL;
+        for (int i = KEY_N_EXP_BYTES - 1; i >= 0 && w.pos < end; --i)
+            *w.pos++ = (uint8_t)(biased_exp >> (8U * i)) ^ w.mask;
+    }
+    if (!FPDEC_IS_DYN_ALLOC(fpdec))
+        key_put_digits(&w, chars, w.n_left);
+    else {
+        dyn_signif_digits(&digits, &n_digits, &dyn_exp, fpdec);
+        n = fill_in_leading_digit(chars, digits[n_digits - 1]) - chars;
+        key_put_digits(&w, chars, MIN(n, w.n_left));
+        for (fpdec_n_digits_t i = n_digits - 1;
+             i > 0 && w.n_left > 0 && w.pos < end; --i) {
+            fill_in_digit(chars, digits[i - 1], DEC_DIGITS_PER_DIGIT);
+            key_put_digits(&w, chars, MIN(DEC_DIGITS_PER_DIGIT, w.n_left));
+        }
+    }
+    // the last digit pair is pending as long as n_left > 0
+    *complete = w.n_left == 0;
+    return w.pos;
+}
 
 error_t
-fpdec_add(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    int cmp;
+fpdec_encode_key(uint8_t *buf, size_t buf_size, size_t *len,
+                 const fpdec_t *fpdec) {
+    uint8_t *pos;
+    bool complete;
 
-    ASSERT_FPDEC_IS_ZEROED(z);
+    *len = fpdec_key_size(fpdec);
+    if (*len > buf_size)
+        return FPDEC_OK;
 
-    if (FPDEC_EQ_ZERO(x))
-        return fpdec_copy(z, y);
-    if (FPDEC_EQ_ZERO(y))
-        return fpdec_copy(z, x);
+    pos = key_put_value(buf, buf + *len - KEY_N_PREC_BYTES, &complete,
+                        fpdec);
+    assert(complete);
+    *pos++ = (uint8_t)(FPDEC_DEC_PREC(fpdec) >> 8U);
+    *pos++ = (uint8_t)FPDEC_DEC_PREC(fpdec);
+    assert(pos == buf + *len);
+    return FPDEC_OK;
+}
 
-    FPDEC_DEC_PREC(z) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
-    if (FPDEC_SIGN(x) == FPDEC_SIGN(y)) {
-        // same sign => x + y = sign(x) (|x| + |y|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(x);
-        return DISPATCH_BIN_OP(vtab_add_abs, z, x, y);
+bool
+fpdec_key_prefix(uint8_t *buf, size_t n, const fpdec_t *fpdec) {
+    uint8_t *pos;
+    bool complete;
+
+    assert(n > 0);
+
+    pos = key_put_value(buf, buf + n, &complete, fpdec);
+    memset(pos, 0, buf + n - pos);
+    return complete;
+}
+
+// Sets the coefficient of the shifted int with precision dec_prec from the
+// n_dec_digits decimal digits encoded as pairs at pos, with value
+// = 0.d[1] .. d[n] * 10 ^ exp. Returns false if it doesn't fit.
+static bool
+key_decode_shint(fpdec_t *fpdec, const uint8_t *pos, uint8_t mask,
+                 size_t n_dec_digits, int64_t exp, unsigned dec_prec) {
+    uint128_t coeff = UINT128_ZERO;
+
+    if (dec_prec > MAX_DEC_PREC_FOR_SHINT ||
+        exp + dec_prec > MAX_N_DEC_DIGITS_IN_SHINT)
+        return false;
+    // coeff = 0.d[1] .. d[n] * 10 ^ (exp + dec_prec) < 10 ^ 29
+    for (const uint8_t *p = pos; p < pos + n_dec_digits / 2; ++p) {
+        u128_imul_u64(&coeff, 100);
+        u128_iadd_u64(&coeff, (*p ^ mask) >> 1U);
     }
-    // sign(x) != sign(y) ...
-    cmp = fpdec_compare(x, y, true);
-    if (cmp == 1) {
-        // ... and |x| > |y| => x + y = sign(x) (|x| - |y|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(x);
-        return DISPATCH_BIN_OP(vtab_sub_abs, z, x, y);
+    if (n_dec_digits % 2 != 0) {
+        u128_imul_u64(&coeff, 10);
+        u128_iadd_u64(&coeff, ((pos[n_dec_digits / 2] ^ mask) >> 1U) / 10);
     }
-    if (cmp == -1) {
-        // ... and |x| < |y| => x + y = sign(y) (|y| - |x|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(y);
-        return DISPATCH_BIN_OP(vtab_sub_abs, z, y, x);
+    u128_imul_10_pow_n_checked(&coeff,
+                               exp + dec_prec - (int64_t)n_dec_digits);
+    if (U64_HI(U128_HI(coeff)) != 0)
+        return false;
+    fpdec->lo = U128_LO(coeff);
+    fpdec->hi = U128_HI(coeff);
+    return true;
+}
+
+// Builds the non-zero digit array value from the n_dec_digits decimal
+// digits encoded as pairs at pos, with value = 0.d[1] .. d[n] * 10 ^ exp
+static error_t
+key_decode_dyn(fpdec_t *fpdec, const uint8_t *pos, uint8_t mask,
+               size_t n_dec_digits, int64_t exp) {
+    int64_t q = exp - (int64_t)n_dec_digits;
+    int64_t dyn_exp = FLOOR(q, DEC_DIGITS_PER_DIGIT);
+    size_t n_total = n_dec_digits + (size_t)(q - dyn_exp *
+                                             DEC_DIGITS_PER_DIGIT);
+    size_t n_digits = CEIL(n_total, DEC_DIGITS_PER_DIGIT);
+    fpdec_digit_array_t *digit_array;
+    fpdec_digit_t *digit;
+    fpdec_digit_t acc = 0;
+    size_t n_in_digit;
+    unsigned d;
+
+    if (dyn_exp < FPDEC_MIN_EXP || dyn_exp > FPDEC_MAX_EXP ||
+        n_digits > UINT32_MAX)
+        ERROR(FPDEC_INVALID_ENCODING);
+    digit_array = digits_enlarged(NULL, 0, (fpdec_n_digits_t)n_digits);
+    if (digit_array == NULL)
+        MEMERROR;
+    digit = digit_array->digits + n_digits - 1;
+    // number of dec digits in the most significant digit
+    n_in_digit = n_total - (n_digits - 1) * DEC_DIGITS_PER_DIGIT;
+    for (size_t i = 0; i < n_total; ++i) {
+        if (i >= n_dec_digits)
+            d = 0;
+        else if (i % 2 == 0)
+            d = ((pos[i / 2] ^ mask) >> 1U) / 10U;
+        else
+            d = ((pos[i / 2] ^ mask) >> 1U) % 10U;
+        acc = acc * 10 + d;
+        if (--n_in_digit == 0) {
+            *digit-- = acc;
+            acc = 0;
+            n_in_digit = DEC_DIGITS_PER_DIGIT;
+        }
     }
-    // ... and |x| = |y| => x + y = 0
+    digit_array->n_signif = (fpdec_n_digits_t)n_digits;
+    fpdec->dyn_alloc = true;
+    fpdec->normalized = true;
+    fpdec->exp = (fpdec_exp_t)dyn_exp;
+    fpdec->digit_array = digit_array;
     return FPDEC_OK;
 }
 
 error_t
-fpdec_sub(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    int cmp;
+fpdec_decode_key(fpdec_t *fpdec, const uint8_t *buf, size_t buf_size,
+                 size_t *len) {
+    const uint8_t *pos = buf + 1;
+    const uint8_t *end = buf + buf_size;
+    const uint8_t *digits;
+    uint8_t header, mask = 0;
+    int64_t exp = 0;
+    uint64_t biased_exp = 0;
+    size_t n_dec_digits = 0;
+    unsigned dec_prec, pair = 0;
+    error_t rc;
 
-    ASSERT_FPDEC_IS_ZEROED(z);
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
 
-    if (FPDEC_EQ_ZERO(x))
-        return fpdec_neg(z, y);
-    if (FPDEC_EQ_ZERO(y))
-        return fpdec_copy(z, x);
-
-    FPDEC_DEC_PREC(z) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
-    if (FPDEC_SIGN(x) != FPDEC_SIGN(y)) {
-        // sign(x) != sign(y) => x - y = sign(x) (|x| + |y|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(x);
-        return DISPATCH_BIN_OP(vtab_add_abs, z, x, y);
+    if (buf_size == 0 || *buf == 0)
+        ERROR(FPDEC_INVALID_ENCODING);
+    header = *buf;
+    if (header < KEY_ZERO) {
+        mask = 0xFFU;
+        header = (uint8_t)(0x100U - header);
     }
-    // same sign ...
-    cmp = fpdec_compare(x, y, true);
-    if (cmp == 1) {
-        // ... and |x| > |y| => x - y = sign(x) (|x| - |y|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(x);
-        return DISPATCH_BIN_OP(vtab_sub_abs, z, x, y);
+
+    if (header != KEY_ZERO) {
+        if (header == KEY_EXP_BELOW || header == KEY_EXP_ABOVE) {
+            if (end - pos < KEY_N_EXP_BYTES)
+                ERROR(FPDEC_INVALID_ENCODING);
+            for (int i = 0; i < KEY_N_EXP_BYTES; ++i)
+                biased_exp = (biased_exp << 8U) | (*pos++ ^ mask);
+            exp = (int64_t)(biased_exp ^ 0x8000000000000000ULL);
+            // the exponent must not fit into the header
+            if ((header == KEY_EXP_BELOW) != (exp < -KEY_MAX_SMALL_EXP) ||
+                (header == KEY_EXP_ABOVE) != (exp > KEY_MAX_SMALL_EXP))
+                ERROR(FPDEC_INVALID_ENCODING);
+        }
+        else
+            exp = (int64_t)header - KEY_EXP_BIAS;
+        // digit pairs, the last one marked by an even byte
+        digits = pos;
+        do {
+            if (pos == end || (pair = (*pos ^ mask) >> 1U) > 99 ||
+                (pos == digits && pair < 10))
+                ERROR(FPDEC_INVALID_ENCODING);
+            n_dec_digits += 2;
+        } while (((*pos++ ^ mask) & 1U) == 1);
+        if (pair == 0)
+            ERROR(FPDEC_INVALID_ENCODING);
+        if (pair % 10 == 0)
+            --n_dec_digits;
     }
-    if (cmp == -1) {
-        // ... and |x| < |y| => x - y = ~sign(y) (|y| - |x|)
-        FPDEC_SIGN(z) = FPDEC_SIGN(y) * -1;
-        return DISPATCH_BIN_OP(vtab_sub_abs, z, y, x);
+
+    if (end - pos < KEY_N_PREC_BYTES)
+        ERROR(FPDEC_INVALID_ENCODING);
+    dec_prec = ((unsigned)pos[0] << 8U) | pos[1];
+    pos += KEY_N_PREC_BYTES;
+    // the precision must cover all fractional digits
+    if (header != KEY_ZERO && (int64_t)n_dec_digits - exp > (int64_t)dec_prec)
+        ERROR(FPDEC_INVALID_ENCODING);
+
+    if (header != KEY_ZERO &&
+        !key_decode_shint(fpdec, digits, mask, n_dec_digits, exp, dec_prec)) {
+        rc = key_decode_dyn(fpdec, digits, mask, n_dec_digits, exp);
+        if (rc != FPDEC_OK)
+            return rc;
     }
-    // ... and |x| = |y| => x - y = 0
+    if (header != KEY_ZERO)
+        fpdec->sign = mask == 0 ? FPDEC_SIGN_POS : FPDEC_SIGN_NEG;
+    fpdec->dec_prec = dec_prec;
+    *len = pos - buf;
     return FPDEC_OK;
 }
 
+// Conversion from / to IEEE 754 decimal formats
+
+// Parameters of the decimal interchange formats: number of coefficient
+// digits and range of the exponent q (with the coefficient taken as
+// integer); the biased exponent is q - q_min.
+typedef struct {
+    int n_digits;
+    int q_min;
+    int q_max;
+} ieee_dec_fmt_t;
+
+static const ieee_dec_fmt_t DECIMAL64 = {16, -398, 369};
+static const ieee_dec_fmt_t DECIMAL128 = {34, -6176, 6111};
+
+// Converts the (canonical) coefficient coeff with exponent q
 static error_t
-fpdec_mul_abs_shint_by_u64(fpdec_t *z, const fpdec_t *x, const uint64_t y) {
-    uint128_t z_shint = U128_FROM_SHINT(x);
+fpdec_from_ieee_coeff_exp(fpdec_t *fpdec, fpdec_sign_t sign, uint128_t coeff,
+                          int q) {
+    uint64_t lo = U128_LO(coeff);
+    uint64_t hi = U128_HI(coeff);
+    unsigned n_dec_digits;
+    fpdec_digit_t digits[3];
+    fpdec_exp_t exp;
+    int shift;
+    uint128_t t;
+    error_t rc;
 
-    u128_imul_u64(&z_shint, y);
-    if (U128_FITS_SHINT(z_shint)) {
-        z->lo = U128_LO(z_shint);
-        z->hi = U128_HI(z_shint);
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (lo == 0 && hi == 0) {
+        fpdec->dec_prec = q < 0 ? -q : 0;
         return FPDEC_OK;
     }
-    return FPDEC_N_DIGITS_LIMIT_EXCEEDED;
+    n_dec_digits = u128_n_dec_digits(lo, hi);
+    if (q <= 0 && -q <= MAX_DEC_PREC_FOR_SHINT && U64_HI(hi) == 0) {
+        fpdec->sign = sign;
+        fpdec->dec_prec = -q;
+        fpdec->lo = lo;
+        fpdec->hi = hi;
+        return FPDEC_OK;
+    }
+    if (q > 0 && n_dec_digits + q < MAX_N_DEC_DIGITS_IN_SHINT) {
+        // coeff * 10 ^ q < 10 ^ 28 < 2 ^ 96
+        if (q > UINT64_10_POW_N_CUTOFF) {
+            u128_imul_10_pow_n(&coeff, UINT64_10_POW_N_CUTOFF);
+            q -= UINT64_10_POW_N_CUTOFF;
+        }
+        u128_imul_10_pow_n(&coeff, q);
+        fpdec->sign = sign;
+        fpdec->lo = U128_LO(coeff);
+        fpdec->hi = U128_HI(coeff);
+        return FPDEC_OK;
+    }
+
+    // coeff * 10 ^ q = (digits base RADIX) * RADIX ^ exp
+    exp = q >= 0 ? q / DEC_DIGITS_PER_DIGIT :
+          -CEIL(-q, DEC_DIGITS_PER_DIGIT);
+    shift = q - exp * DEC_DIGITS_PER_DIGIT;
+    t = coeff;
+    lo = u128_idiv_u64(&t, RADIX);
+    hi = U128_LO(t);    // < 10 ^ 15
+    u64_mul_u64(&t, lo, u64_10_pow_n(shift));
+    digits[0] = u128_idiv_u64(&t, RADIX);
+    lo = U128_LO(t);
+    u64_mul_u64(&t, hi, u64_10_pow_n(shift));
+    u128_iadd_u64(&t, lo);
+    digits[1] = u128_idiv_u64(&t, RADIX);
+    digits[2] = U128_LO(t);
+    rc = fpdec_from_sign_digits_exp(fpdec, sign, 3, digits, exp);
+    if (rc != FPDEC_OK)
+        return rc;
+    if (FPDEC_IS_DYN_ALLOC(fpdec)) {
+        fpdec->dec_prec = q < 0 ? -q : 0;
+        return FPDEC_OK;
+    }
+    // integral value with a precision too large for a shint
+    return fpdec_adjust(fpdec, q < 0 ? -q : 0, FPDEC_ROUND_DEFAULT);
+}
+
+// Multiplies coeff by 10 ^ n, n <= 2 * UINT64_10_POW_N_CUTOFF
+static inline void
+ieee_coeff_shift(uint128_t *coeff, int n) {
+    if (n > UINT64_10_POW_N_CUTOFF) {
+        u128_imul_10_pow_n(coeff, UINT64_10_POW_N_CUTOFF);
+        n -= UINT64_10_POW_N_CUTOFF;
+    }
+    if (n > 0)
+        u128_imul_10_pow_n(coeff, n);
+}
+
+// Gives the coefficient of the digits of the dyn fpdec at and above 10 ^ q,
+// rounded according to rounding, without creating an adjusted copy.
+// Requires the most significant digit to be at or above 10 ^ q and the
+// rounded coefficient to fit into a uint128_t.
+static void
+dyn_coeff_rounded(uint128_t *coeff, const fpdec_t *fpdec, int64_t q,
+                  enum FPDEC_ROUNDING_MODE rounding) {
+    const fpdec_digit_t *digits = FPDEC_DYN_DIGITS(fpdec);
+    const int64_t exp = FPDEC_DYN_EXP(fpdec);
+    fpdec_n_digits_t n = FPDEC_DYN_N_DIGITS(fpdec);
+    fpdec_digit_t quot = 0, rem, divisor;
+    int64_t idx = (int64_t)n - 1;
+    int shift;
+    bool delta = false;
+
+    *coeff = UINT128_ZERO;
+    // digits completely at or above 10 ^ q
+    for (; idx >= 0 && (idx + exp) * DEC_DIGITS_PER_DIGIT >= q; --idx) {
+        u128_imul_u64(coeff, RADIX);
+        u128_iadd_u64(coeff, digits[idx]);
+        quot = digits[idx];
+    }
+    if (idx < 0) {
+        // exact, fill up with zeros down to 10 ^ q
+        ieee_coeff_shift(coeff, (int)(exp * DEC_DIGITS_PER_DIGIT - q));
+        return;
+    }
+    // digits[idx] is (partially) below 10 ^ q
+    shift = (int)(q - (idx + exp) * DEC_DIGITS_PER_DIGIT);
+    assert(0 < shift && shift <= DEC_DIGITS_PER_DIGIT);
+    if (shift < DEC_DIGITS_PER_DIGIT) {
+        divisor = u64_10_pow_n(shift);
+        quot = digits[idx] / divisor;
+        rem = digits[idx] % divisor;
+        u128_imul_10_pow_n(coeff, DEC_DIGITS_PER_DIGIT - shift);
+        u128_iadd_u64(coeff, quot);
+    }
+    else {
+        divisor = RADIX;
+        rem = digits[idx];
+    }
+    while (--idx >= 0 && !delta)
+        delta = digits[idx] != 0;
+    // quot has the same last decimal digit as coeff, which is all that
+    // round_qr looks at
+    if ((rem != 0 || delta) &&
+        round_qr(FPDEC_SIGN(fpdec), quot, rem, delta, divisor, rounding))
+        u128_iadd_u64(coeff, 1);
 }
 
+// Gives the coefficient and exponent representing fpdec in the format fmt,
+// preferring the exponent -dec_prec (as IEEE 754 does for results of
+// arithmetic). Values with more significant digits than the format can
+// hold or with an exponent below q_min are rounded according to rounding.
 static error_t
-fpdec_mul_abs_dyn_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    fpdec_digit_array_t *z_digits;
+fpdec_as_ieee_coeff_exp(fpdec_sign_t *sign, uint128_t *coeff, int *q,
+                        const fpdec_t *fpdec, const ieee_dec_fmt_t *fmt,
+                        enum FPDEC_ROUNDING_MODE rounding) {
+    int preferred_q = -(int)FPDEC_DEC_PREC(fpdec);
+    fpdec_t adj = FPDEC_ZERO;
     int64_t exp;
+    int magn, dec_prec, n_dec_digits, shift;
+    error_t rc;
 
-    z_digits = digits_mul(x->digit_array, y->digit_array);
-    if (z_digits == NULL)
-        MEMERROR;
-    exp = (int64_t)FPDEC_DYN_EXP(x) + (int64_t)FPDEC_DYN_EXP(y);
-    if (exp > FPDEC_MAX_EXP || exp < INT32_MIN) {
-        fpdec_mem_free((void *)z_digits);
-        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+    if (FPDEC_EQ_ZERO(fpdec)) {
+        *sign = FPDEC_SIGN_ZERO;
+        *coeff = UINT128_ZERO;
+        *q = MAX(preferred_q, fmt->q_min);
+        return FPDEC_OK;
     }
-    z->exp = (fpdec_exp_t)exp;
-    z->digit_array = z_digits;
-    FPDEC_IS_DYN_ALLOC(z) = true;
+    if (fpdec_as_sign_coeff128_exp(sign, coeff, &exp, fpdec) != 0 ||
+        u128_n_dec_digits(U128_LO(*coeff), U128_HI(*coeff)) >
+        (unsigned)fmt->n_digits || exp < fmt->q_min) {
+        magn = fpdec_magnitude(fpdec);
+        if (magn > fmt->q_max + fmt->n_digits - 1)
+            ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+        dec_prec = MIN(fmt->n_digits - 1 - magn, -fmt->q_min);
+        if (FPDEC_IS_DYN_ALLOC(fpdec) &&
+            dec_prec == fmt->n_digits - 1 - magn) {
+            // round the digit array directly into the coefficient
+            *sign = FPDEC_SIGN(fpdec);
+            dyn_coeff_rounded(coeff, fpdec, -dec_prec, rounding);
+            exp = -dec_prec;
+            if (u128_n_dec_digits(U128_LO(*coeff), U128_HI(*coeff)) >
+                (unsigned)fmt->n_digits) {
+                // rounded up to 10 ^ n_digits
+                u128_idiv_u64(coeff, 10);
+                ++exp;
+            }
+        }
+        else {
+            rc = fpdec_adjusted(&adj, fpdec, dec_prec, rounding);
+            if (rc != FPDEC_OK)
+                return rc;
+            if (FPDEC_EQ_ZERO(&adj)) {
+                fpdec_reset_to_zero(&adj, 0);
+                *sign = FPDEC_SIGN_ZERO;
+                *coeff = UINT128_ZERO;
+                *q = fmt->q_min;
+                return FPDEC_OK;
+            }
+            rc = fpdec_as_sign_coeff128_exp(sign, coeff, &exp, &adj);
+            assert(rc == 0);
+            fpdec_reset_to_zero(&adj, 0);
+        }
+        preferred_q = -dec_prec;
+    }
+    n_dec_digits = u128_n_dec_digits(U128_LO(*coeff), U128_HI(*coeff));
+    // clamp exponent by adding trailing zeros to the coefficient
+    if (exp > fmt->q_max) {
+        shift = exp - fmt->q_max;
+        if (n_dec_digits + shift > fmt->n_digits)
+            ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+        ieee_coeff_shift(coeff, shift);
+        exp = fmt->q_max;
+        n_dec_digits += shift;
+    }
+    // approach the preferred exponent as far as the coefficient allows
+    preferred_q = MAX(preferred_q, fmt->q_min);
+    if (exp > preferred_q) {
+        shift = MIN(exp - preferred_q, fmt->n_digits - n_dec_digits);
+        ieee_coeff_shift(coeff, shift);
+        exp -= shift;
+    }
+    *q = (int)exp;
     return FPDEC_OK;
 }
 
-static error_t
-fpdec_mul_abs_shint_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    error_t rc;
-    fpdec_t x_dyn;
+// Densely packed decimal: 3 decimal digits <-> 10-bit declet
+
+static inline unsigned
+dpd_from_bin(unsigned val) {
+    unsigned d1 = val / 100, d2 = val / 10 % 10, d3 = val % 10;
+
+    switch ((d1 >> 3U) << 2U | (d2 >> 3U) << 1U | d3 >> 3U) {
+        case 0:     // bcd fgh 0 jkm
+            return d1 << 7U | d2 << 4U | d3;
+        case 1:     // bcd fgh 1 00m
+            return d1 << 7U | d2 << 4U | 0x8U | (d3 & 1U);
+        case 2:     // bcd jkh 1 01m
+            return d1 << 7U | (d3 & 6U) << 4U | (d2 & 1U) << 4U | 0xAU |
+                   (d3 & 1U);
+        case 3:     // bcd 10h 1 11m
+            return d1 << 7U | 0x40U | (d2 & 1U) << 4U | 0xEU | (d3 & 1U);
+        case 4:     // jkd fgh 1 10m
+            return (d3 & 6U) << 7U | (d1 & 1U) << 7U | d2 << 4U | 0xCU |
+                   (d3 & 1U);
+        case 5:     // fgd 01h 1 11m
+            return (d2 & 6U) << 7U | (d1 & 1U) << 7U | 0x20U |
+                   (d2 & 1U) << 4U | 0xEU | (d3 & 1U);
+        case 6:     // jkd 00h 1 11m
+            return (d3 & 6U) << 7U | (d1 & 1U) << 7U | (d2 & 1U) << 4U |
+                   0xEU | (d3 & 1U);
+        default:    // 00d 11h 1 11m
+            return (d1 & 1U) << 7U | 0x60U | (d2 & 1U) << 4U | 0xEU |
+                   (d3 & 1U);
+    }
+}
 
-    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_mul_abs_dyn_by_dyn(z, &x_dyn, y);
-        fpdec_reset_to_zero(&x_dyn, 0);
+static inline unsigned
+dpd_to_bin(unsigned declet) {
+    unsigned pqr = declet >> 7U & 7U, stu = declet >> 4U & 7U;
+    unsigned wxy = declet & 7U;
+    unsigned r = pqr & 1U, u = stu & 1U, y = wxy & 1U;
+    unsigned d1, d2, d3;
+
+    if ((declet & 0x8U) == 0) {
+        d1 = pqr;
+        d2 = stu;
+        d3 = wxy;
     }
-    return rc;
+    else {
+        switch (wxy >> 1U) {
+            case 0:
+                d1 = pqr;
+                d2 = stu;
+                d3 = 8 | y;
+                break;
+            case 1:
+                d1 = pqr;
+                d2 = 8 | u;
+                d3 = (stu & 6U) | y;
+                break;
+            case 2:
+                d1 = 8 | r;
+                d2 = stu;
+                d3 = (pqr & 6U) | y;
+                break;
+            default:
+                switch (stu >> 1U) {
+                    case 0:
+                        d1 = 8 | r;
+                        d2 = 8 | u;
+                        d3 = (pqr & 6U) | y;
+                        break;
+                    case 1:
+                        d1 = 8 | r;
+                        d2 = (pqr & 6U) | u;
+                        d3 = 8 | y;
+                        break;
+                    case 2:
+                        d1 = pqr;
+                        d2 = 8 | u;
+                        d3 = 8 | y;
+                        break;
+                    default:
+                        d1 = 8 | r;
+                        d2 = 8 | u;
+                        d3 = 8 | y;
+                }
+        }
+    }
+    return d1 * 100 + d2 * 10 + d3;
 }
 
-static error_t
-fpdec_mul_abs_dyn_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    return fpdec_mul_abs_shint_by_dyn(z, y, x);
+// val < 1000 ^ n_declets, n_declets <= 6
+static inline uint64_t
+declets_from_u64(uint64_t val, unsigned n_declets) {
+    uint64_t declets = 0;
+
+    for (unsigned i = 0; i < n_declets; ++i, val /= 1000)
+        declets |= (uint64_t)dpd_from_bin(val % 1000) << (10U * i);
+    return declets;
 }
 
-static error_t
-fpdec_mul_abs_shint_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    error_t rc;
-    fpdec_t y_dyn;
+static inline uint64_t
+declets_to_u64(uint64_t declets, unsigned n_declets) {
+    uint64_t val = 0;
 
-    if (x->hi == 0 && fpdec_mul_abs_shint_by_u64(z, y, x->lo) == FPDEC_OK)
-        return FPDEC_OK;
-    if (y->hi == 0 && fpdec_mul_abs_shint_by_u64(z, x, y->lo) == FPDEC_OK)
-        return FPDEC_OK;
+    for (unsigned i = n_declets; i > 0; --i)
+        val = val * 1000 + dpd_to_bin(declets >> (10U * (i - 1)) & 0x3FFU);
+    return val;
+}
 
-    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_mul_abs_shint_by_dyn(z, x, &y_dyn);
-        fpdec_reset_to_zero(&y_dyn, 0);
-    }
-    return rc;
+// Combination field of the DPD encoding: 2 msbs of the biased exponent and
+// the leading digit
+static inline unsigned
+dpd_comb(unsigned exp_msbs, unsigned lead_digit) {
+    return lead_digit < 8 ? exp_msbs << 3U | lead_digit :
+           0x18U | exp_msbs << 1U | (lead_digit & 1U);
 }
 
-const v_math_op vtab_mul_abs[4] = {
-    fpdec_mul_abs_shint_by_shint,
-    fpdec_mul_abs_shint_by_dyn,
-    fpdec_mul_abs_dyn_by_shint,
-    fpdec_mul_abs_dyn_by_dyn
-};
+// Bit patterns of decimal64
 
-error_t
-fpdec_mul(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
-    error_t rc;
+#define DEC64_SIGN_BIT 0x8000000000000000ULL
+#define DEC64_COEFF_MASK_LARGE ((1ULL << 51U) - 1)
+#define DEC64_COEFF_MASK ((1ULL << 53U) - 1)
+#define DEC64_MAX_COEFF 9999999999999999ULL
 
-    ASSERT_FPDEC_IS_ZEROED(z);
+static inline bool
+dec64_is_special(uint64_t bits) {
+    return (bits >> 59U & 0xFU) == 0xFU;
+}
 
-    if (FPDEC_EQ_ZERO(x) || FPDEC_EQ_ZERO(y))
-        return FPDEC_OK;
+static inline uint64_t
+bid64_encode(bool neg, uint64_t coeff, int q) {
+    uint64_t biased_exp = q - DECIMAL64.q_min;
+    uint64_t bits = neg ? DEC64_SIGN_BIT : 0;
 
-    FPDEC_SIGN(z) = FPDEC_SIGN(x) * FPDEC_SIGN(y);
-    FPDEC_DEC_PREC(z) = FPDEC_DEC_PREC(x) + FPDEC_DEC_PREC(y);
-    if (FPDEC_DEC_PREC(z) < FPDEC_DEC_PREC(x))
-        ERROR(FPDEC_PREC_LIMIT_EXCEEDED);
-    if (FPDEC_DEC_PREC(z) <= MAX_DEC_PREC_FOR_SHINT ||
-        FPDEC_IS_DYN_ALLOC(x) || FPDEC_IS_DYN_ALLOC(y)) {
-        rc = DISPATCH_BIN_OP(vtab_mul_abs, z, x, y);
+    if (coeff <= DEC64_COEFF_MASK)
+        return bits | biased_exp << 53U | coeff;
+    return bits | 0x3ULL << 61U | biased_exp << 51U |
+           (coeff & DEC64_COEFF_MASK_LARGE);
+}
+
+static inline void
+bid64_decode(uint64_t *coeff, int *q, uint64_t bits) {
+    if ((bits >> 61U & 0x3U) != 0x3U) {
+        *q = (int)(bits >> 53U & 0x3FFU) + DECIMAL64.q_min;
+        *coeff = bits & DEC64_COEFF_MASK;
     }
     else {
-        // force result to dyn variant
-        fpdec_t x_dyn;
-        rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
-        if (rc == FPDEC_OK) {
-            rc = DISPATCH_BIN_OP(vtab_mul_abs, z, &x_dyn, y);
-            fpdec_reset_to_zero(&x_dyn, 0);
-        }
+        *q = (int)(bits >> 51U & 0x3FFU) + DECIMAL64.q_min;
+        *coeff = 1ULL << 53U | (bits & DEC64_COEFF_MASK_LARGE);
     }
-    if (FPDEC_IS_DYN_ALLOC(z))
-        fpdec_dyn_normalize(z);
-    return rc;
+    // non-canonical coefficients are taken as 0
+    if (*coeff > DEC64_MAX_COEFF)
+        *coeff = 0;
 }
 
-error_t
-fpdec_divmod_abs_dyn_by_dyn(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
-                            const fpdec_t *y, bool neg_quot) {
-    const fpdec_n_digits_t n_shift_x =
-        MAX(0, FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y));
-    const fpdec_n_digits_t n_shift_y =
-        MAX(0, FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x));
-    fpdec_digit_array_t *q_digits, *r_digits;
+static inline uint64_t
+dpd64_encode(bool neg, uint64_t coeff, int q) {
+    uint64_t biased_exp = q - DECIMAL64.q_min;
+    uint64_t lead_digit = coeff / 1000000000000000ULL;
 
-    if (FPDEC_DYN_N_DIGITS(y) == 1 && n_shift_y == 0) {
-        q_digits = digits_div_digit(x->digit_array, n_shift_x,
-                                    FPDEC_DYN_DIGITS(y)[0], &r->lo);
-        if (q_digits == NULL)
-            MEMERROR;
-        // adjust negativ quotient?
-        if (neg_quot && r->lo != 0) {
-            // Because there is a remainder,
-            // q_digits < x->digits * RADIX ^ n_shift_x.
-            // x->digits <= RADIX ^ x->n_signif - 1, so
-            // q_digits < RADIX ^ (x->n_signif + n_shift_x) - 1.
-            // That means we can safely increment q_digits.
-            digits_iadd_digit(q_digits, 1);
-            r->lo = FPDEC_DYN_DIGITS(y)[0] - r->lo;
-        }
+    return (neg ? DEC64_SIGN_BIT : 0) |
+           (uint64_t)dpd_comb(biased_exp >> 8U, lead_digit) << 58U |
+           (biased_exp & 0xFFU) << 50U |
+           declets_from_u64(coeff % 1000000000000000ULL, 5);
+}
+
+static inline void
+dpd64_decode(uint64_t *coeff, int *q, uint64_t bits) {
+    unsigned comb = bits >> 58U & 0x1FU;
+    unsigned exp_msbs, lead_digit;
+
+    if ((comb >> 3U) != 0x3U) {
+        exp_msbs = comb >> 3U;
+        lead_digit = comb & 0x7U;
     }
     else {
-        q_digits = digits_divmod(x->digit_array, n_shift_x, y->digit_array,
-                                 n_shift_y, &r_digits);
-        if (q_digits == NULL) {
-            fpdec_mem_free(r_digits);
-            MEMERROR;
-        }
-        if (r_digits == NULL) {
-            fpdec_mem_free(q_digits);
-            MEMERROR;
-        }
-        r->digit_array = r_digits;
-        r->dyn_alloc = true;
-        FPDEC_DYN_EXP(r) = MIN(FPDEC_DYN_EXP(y), FPDEC_DYN_EXP(x));
-        // adjust negativ quotient?
-        if (neg_quot && !digits_all_zero(r_digits->digits,
-                                         r_digits->n_signif)) {
-            error_t rc;
-            fpdec_t t = *r;
-            *r = FPDEC_ZERO;
-            fpdec_dyn_normalize(&t);
-            rc = fpdec_sub(r, y, &t);
-            fpdec_reset_to_zero(&t, 0);
-            if (rc != FPDEC_OK) {
-                fpdec_mem_free(q_digits);
-                return rc;
-            }
-            // Safe to increment q_digits. See comment above.
-            digits_iadd_digit(q_digits, 1);
-        }
+        exp_msbs = comb >> 1U & 0x3U;
+        lead_digit = 8 | (comb & 1U);
     }
-    q->digit_array = q_digits;
-    q->dyn_alloc = true;
-    FPDEC_DYN_EXP(q) = 0;
-    return FPDEC_OK;
+    *q = (int)(exp_msbs << 8U | (bits >> 50U & 0xFFU)) + DECIMAL64.q_min;
+    *coeff = lead_digit * 1000000000000000ULL +
+             declets_to_u64(bits & ((1ULL << 50U) - 1), 5);
 }
 
-error_t
-fpdec_divmod_abs_dyn_by_shint(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
-                              const fpdec_t *y, bool neg_quot) {
-    error_t rc;
-    fpdec_t y_dyn;
+// Bit patterns of decimal128 (handled as two 64-bit halves)
 
-    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_divmod_abs_dyn_by_dyn(q, r, x, &y_dyn, neg_quot);
-        fpdec_reset_to_zero(&y_dyn, 0);
-    }
-    return rc;
+#define DEC128_COEFF_MASK_HI ((1ULL << 49U) - 1)
+#define DEC128_EXP_CONT_MASK 0xFFFU
+#define DEC_10_POW_18 1000000000000000000ULL
+
+static inline bool
+dec128_is_special(uint64_t hi) {
+    return dec64_is_special(hi);
 }
 
-error_t
-fpdec_divmod_abs_shint_by_dyn(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
-                              const fpdec_t *y, bool neg_quot) {
-    error_t rc;
-    fpdec_t x_dyn;
+static inline void
+bid128_encode(uint64_t *hi, uint64_t *lo, bool neg, uint128_t coeff, int q) {
+    uint64_t biased_exp = q - DECIMAL128.q_min;
 
-    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_divmod_abs_dyn_by_dyn(q, r, &x_dyn, y, neg_quot);
-        fpdec_reset_to_zero(&x_dyn, 0);
+    // canonical coefficients are < 10 ^ 34 < 2 ^ 113
+    *hi = (neg ? DEC64_SIGN_BIT : 0) | biased_exp << 49U | U128_HI(coeff);
+    *lo = U128_LO(coeff);
+}
+
+static inline void
+bid128_decode(uint128_t *coeff, int *q, uint64_t hi, uint64_t lo) {
+    if ((hi >> 61U & 0x3U) != 0x3U) {
+        *q = (int)(hi >> 49U & 0x3FFFU) + DECIMAL128.q_min;
+        U128_FROM_LO_HI(coeff, lo, hi & DEC128_COEFF_MASK_HI);
+        // non-canonical coefficients are taken as 0
+        if ((hi & DEC128_COEFF_MASK_HI) > U128_10_pows[15][1] ||
+            ((hi & DEC128_COEFF_MASK_HI) == U128_10_pows[15][1] &&
+             lo >= U128_10_pows[15][0]))
+            *coeff = UINT128_ZERO;
+    }
+    else {
+        // coefficient would exceed 2 ^ 113 => non-canonical
+        *q = (int)(hi >> 47U & 0x3FFFU) + DECIMAL128.q_min;
+        *coeff = UINT128_ZERO;
     }
-    return rc;
 }
 
-error_t
-fpdec_divmod_abs_shint_by_shint(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
-                                const fpdec_t *y, bool neg_quot) {
-    uint128_t q_shint = U128_FROM_SHINT(x);
+static inline void
+dpd128_encode(uint64_t *hi, uint64_t *lo, bool neg, uint128_t coeff, int q) {
+    uint64_t biased_exp = q - DECIMAL128.q_min;
+    uint128_t t = coeff;
+    uint64_t low18 = u128_idiv_u64(&t, DEC_10_POW_18);
+    uint64_t high16 = U128_LO(t);
+    uint64_t lead_digit = high16 / 1000000000000000ULL;
+    uint64_t declets_lo = declets_from_u64(low18, 6);
+    uint64_t declets_hi = declets_from_u64(high16 % 1000000000000000ULL, 5);
+
+    // 11 declets in bits 0 .. 109, exponent continuation in bits 110 .. 121
+    *lo = declets_lo | declets_hi << 60U;
+    *hi = (neg ? DEC64_SIGN_BIT : 0) |
+          (uint64_t)dpd_comb(biased_exp >> 12U, lead_digit) << 58U |
+          (biased_exp & DEC128_EXP_CONT_MASK) << 46U | declets_hi >> 4U;
+}
+
+static inline void
+dpd128_decode(uint128_t *coeff, int *q, uint64_t hi, uint64_t lo) {
+    unsigned comb = hi >> 58U & 0x1FU;
+    unsigned exp_msbs, lead_digit;
+    uint64_t declets_lo = lo & ((1ULL << 60U) - 1);
+    uint64_t declets_hi = lo >> 60U | (hi & ((1ULL << 46U) - 1)) << 4U;
+
+    if ((comb >> 3U) != 0x3U) {
+        exp_msbs = comb >> 3U;
+        lead_digit = comb & 0x7U;
+    }
+    else {
+        exp_msbs = comb >> 1U & 0x3U;
+        lead_digit = 8 | (comb & 1U);
+    }
+    *q = (int)(exp_msbs << 12U | (hi >> 46U & DEC128_EXP_CONT_MASK)) +
+         DECIMAL128.q_min;
+    u64_mul_u64(coeff, lead_digit * 1000000000000000ULL +
+                       declets_to_u64(declets_hi, 5), DEC_10_POW_18);
+    u128_iadd_u64(coeff, declets_to_u64(declets_lo, 6));
+}
+
+error_t
+fpdec_from_decimal64(fpdec_t *fpdec, uint64_t bits,
+                     enum FPDEC_IEEE_ENCODING encoding) {
+    uint64_t coeff;
+    uint128_t t;
+    int q;
+
+    if (dec64_is_special(bits))
+        ERROR(FPDEC_INVALID_ENCODING);
+    if (encoding == FPDEC_IEEE_BID)
+        bid64_decode(&coeff, &q, bits);
+    else
+        dpd64_decode(&coeff, &q, bits);
+    U128_FROM_LO_HI(&t, coeff, 0);
+    return fpdec_from_ieee_coeff_exp(fpdec, (bits & DEC64_SIGN_BIT) ?
+                                            FPDEC_SIGN_NEG : FPDEC_SIGN_POS,
+                                     t, q);
+}
+
+error_t
+fpdec_from_decimal128(fpdec_t *fpdec, uint128_t bits,
+                      enum FPDEC_IEEE_ENCODING encoding) {
+    uint64_t hi = U128_HI(bits);
+    uint64_t lo = U128_LO(bits);
+    uint128_t coeff;
+    int q;
+
+    if (dec128_is_special(hi))
+        ERROR(FPDEC_INVALID_ENCODING);
+    if (encoding == FPDEC_IEEE_BID)
+        bid128_decode(&coeff, &q, hi, lo);
+    else
+        dpd128_decode(&coeff, &q, hi, lo);
+    return fpdec_from_ieee_coeff_exp(fpdec, (hi & DEC64_SIGN_BIT) ?
+                                            FPDEC_SIGN_NEG : FPDEC_SIGN_POS,
+                                     coeff, q);
+}
+
+error_t
+fpdec_as_decimal64(uint64_t *bits, const fpdec_t *fpdec,
+                   enum FPDEC_IEEE_ENCODING encoding,
+                   enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_sign_t sign;
+    uint128_t coeff;
+    int q;
+    error_t rc;
+
+    rc = fpdec_as_ieee_coeff_exp(&sign, &coeff, &q, fpdec, &DECIMAL64,
+                                 rounding);
+    if (rc != FPDEC_OK)
+        return rc;
+    if (encoding == FPDEC_IEEE_BID)
+        *bits = bid64_encode(sign < 0, U128_LO(coeff), q);
+    else
+        *bits = dpd64_encode(sign < 0, U128_LO(coeff), q);
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_as_decimal128(uint128_t *bits, const fpdec_t *fpdec,
+                    enum FPDEC_IEEE_ENCODING encoding,
+                    enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_sign_t sign;
+    uint128_t coeff;
+    uint64_t hi, lo;
+    int q;
+    error_t rc;
+
+    rc = fpdec_as_ieee_coeff_exp(&sign, &coeff, &q, fpdec, &DECIMAL128,
+                                 rounding);
+    if (rc != FPDEC_OK)
+        return rc;
+    if (encoding == FPDEC_IEEE_BID)
+        bid128_encode(&hi, &lo, sign < 0, coeff, q);
+    else
+        dpd128_encode(&hi, &lo, sign < 0, coeff, q);
+    U128_FROM_LO_HI(bits, lo, hi);
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_from_decimal64_n(fpdec_t *z, const uint64_t *bits, size_t n,
+                       enum FPDEC_IEEE_ENCODING encoding) {
+    error_t rc;
+
+    for (size_t i = 0; i < n; ++i) {
+        rc = fpdec_from_decimal64(&z[i], bits[i], encoding);
+        if (rc != FPDEC_OK) {
+            for (size_t j = 0; j < i; ++j)
+                fpdec_reset_to_zero(&z[j], 0);
+            return rc;
+        }
+    }
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_from_decimal128_n(fpdec_t *z, const uint128_t *bits, size_t n,
+                        enum FPDEC_IEEE_ENCODING encoding) {
+    error_t rc;
+
+    for (size_t i = 0; i < n; ++i) {
+        rc = fpdec_from_decimal128(&z[i], bits[i], encoding);
+        if (rc != FPDEC_OK) {
+            for (size_t j = 0; j < i; ++j)
+                fpdec_reset_to_zero(&z[j], 0);
+            return rc;
+        }
+    }
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_as_decimal64_n(uint64_t *bits, const fpdec_t *x, size_t n,
+                     enum FPDEC_IEEE_ENCODING encoding,
+                     enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+
+    for (size_t i = 0; i < n; ++i) {
+        rc = fpdec_as_decimal64(&bits[i], &x[i], encoding, rounding);
+        if (rc != FPDEC_OK)
+            return rc;
+    }
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_as_decimal128_n(uint128_t *bits, const fpdec_t *x, size_t n,
+                      enum FPDEC_IEEE_ENCODING encoding,
+                      enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+
+    for (size_t i = 0; i < n; ++i) {
+        rc = fpdec_as_decimal128(&bits[i], &x[i], encoding, rounding);
+        if (rc != FPDEC_OK)
+            return rc;
+    }
+    return FPDEC_OK;
+}
+
+// Conversion from / to double
+
+// Layout of an IEEE 754 binary64 value: significand with hidden bit, range
+// of the exponent of its least significant bit (for the significand taken
+// as integer) and range of the decimal magnitude of finite non-zero values
+#define DOUBLE_HIDDEN_BIT (1ULL << 52U)
+#define DOUBLE_SIGNIF_MASK (DOUBLE_HIDDEN_BIT - 1)
+#define DOUBLE_MIN_LSB_EXP -1074
+#define DOUBLE_MAX_LSB_EXP 971
+#define DOUBLE_MIN_MAGN -324
+#define DOUBLE_MAX_MAGN 308
+
+// Unsigned binary integer (64-bit limbs, least significant first), large
+// enough for the exact expansion of any double scaled to an integer
+// (< 2 ^ 2610) and for the scaled coefficients in fpdec_as_double
+// (< 2 ^ 2780)
+#define BIN_INT_MAX_N_LIMBS 48
+
+typedef struct bin_int {
+    unsigned n_limbs;
+    uint64_t limbs[BIN_INT_MAX_N_LIMBS];
+} bin_int_t;
+
+static inline void
+bin_int_from_u64(bin_int_t *x, uint64_t val) {
+    x->limbs[0] = val;
+    x->n_limbs = val != 0;
+}
+
+static inline unsigned
+bin_int_n_bits(const bin_int_t *x) {
+    if (x->n_limbs == 0)
+        return 0;
+    return (x->n_limbs - 1) * 64 +
+           u64_most_signif_bit_pos(x->limbs[x->n_limbs - 1]) + 1;
+}
+
+// x = x * y + z
+static void
+bin_int_imul_u64_add(bin_int_t *x, uint64_t y, uint64_t z) {
+    uint128_t t;
+
+    for (unsigned i = 0; i < x->n_limbs; ++i) {
+        u64_mul_u64(&t, x->limbs[i], y);
+        u128_iadd_u64(&t, z);
+        x->limbs[i] = U128_LO(t);
+        z = U128_HI(t);
+    }
+    if (z != 0) {
+        assert(x->n_limbs < BIN_INT_MAX_N_LIMBS);
+        x->limbs[x->n_limbs++] = z;
+    }
+}
+
+// x = x / y, returns the remainder
+static uint64_t
+bin_int_idiv_u64(bin_int_t *x, uint64_t y) {
+    uint128_t t;
+    uint64_t r = 0;
+
+    for (unsigned i = x->n_limbs; i > 0; --i) {
+        U128_FROM_LO_HI(&t, x->limbs[i - 1], r);
+        r = u128_idiv_u64(&t, y);
+        x->limbs[i - 1] = U128_LO(t);
+    }
+    while (x->n_limbs > 0 && x->limbs[x->n_limbs - 1] == 0)
+        --x->n_limbs;
+    return r;
+}
+
+// x = x * 5 ^ n
+static void
+bin_int_imul_5_pow_n(bin_int_t *x, unsigned n) {
+    unsigned k;
+
+    for (; n > 0; n -= k) {
+        k = MIN(n, UINT64_10_POW_N_CUTOFF);
+        bin_int_imul_u64_add(x, u64_10_pow_n(k) >> k, 0);
+    }
+}
+
+// x = x / 5 ^ n (truncated), returns true if the remainder is not 0
+static bool
+bin_int_idiv_5_pow_n(bin_int_t *x, unsigned n) {
+    bool inexact = false;
+    unsigned k;
+
+    // floor(floor(x / a) / b) = floor(x / (a * b))
+    for (; n > 0; n -= k) {
+        k = MIN(n, UINT64_10_POW_N_CUTOFF);
+        inexact |= bin_int_idiv_u64(x, u64_10_pow_n(k) >> k) != 0;
+    }
+    return inexact;
+}
+
+// x = x * 2 ^ n
+static void
+bin_int_ishl(bin_int_t *x, unsigned n) {
+    unsigned n_limbs = n / 64, n_bits = n % 64, i;
+
+    if (x->n_limbs == 0)
+        return;
+    if (n_bits != 0) {
+        uint64_t carry = x->limbs[x->n_limbs - 1] >> (64 - n_bits);
+        for (i = x->n_limbs - 1; i > 0; --i)
+            x->limbs[i] = x->limbs[i] << n_bits |
+                          x->limbs[i - 1] >> (64 - n_bits);
+        x->limbs[0] <<= n_bits;
+        if (carry != 0) {
+            assert(x->n_limbs < BIN_INT_MAX_N_LIMBS);
+            x->limbs[x->n_limbs++] = carry;
+        }
+    }
+    if (n_limbs != 0) {
+        assert(x->n_limbs + n_limbs <= BIN_INT_MAX_N_LIMBS);
+        memmove(x->limbs + n_limbs, x->limbs, x->n_limbs * sizeof(uint64_t));
+        memset(x->limbs, 0, n_limbs * sizeof(uint64_t));
+        x->n_limbs += n_limbs;
+    }
+}
+
+// The 64 most significant bits of x (x >= 2 ^ 63, or 0 if x is 0);
+// *n_shifted is set to the number of bits below them and *sticky, if any of
+// these is set.
+static uint64_t
+bin_int_top_u64(const bin_int_t *x, unsigned *n_shifted, bool *sticky) {
+    unsigned n_bits, n_lz, i;
+    uint64_t top;
+
+    if (x->n_limbs == 0) {
+        *n_shifted = 0;
+        return 0;
+    }
+    n_bits = bin_int_n_bits(x);
+    n_lz = 64 - (n_bits - (x->n_limbs - 1) * 64);
+    i = x->n_limbs - 1;
+    top = x->limbs[i];
+
+    assert(n_bits >= 64);
+    if (n_lz != 0) {
+        --i;
+        top = top << n_lz | x->limbs[i] >> (64 - n_lz);
+        *sticky |= (x->limbs[i] << n_lz) != 0;
+    }
+    while (i > 0)
+        *sticky |= x->limbs[--i] != 0;
+    *n_shifted = n_bits - 64;
+    return top;
+}
+
+// z = x + y
+static void
+bin_int_add(bin_int_t *z, const bin_int_t *x, const bin_int_t *y) {
+    unsigned n = MAX(x->n_limbs, y->n_limbs);
+    uint64_t carry = 0, a, b, t;
+
+    for (unsigned i = 0; i < n; ++i) {
+        a = i < x->n_limbs ? x->limbs[i] : 0;
+        b = i < y->n_limbs ? y->limbs[i] : 0;
+        t = a + carry;
+        carry = t < carry;
+        z->limbs[i] = t + b;
+        carry += z->limbs[i] < b;
+    }
+    if (carry != 0) {
+        assert(n < BIN_INT_MAX_N_LIMBS);
+        z->limbs[n++] = carry;
+    }
+    z->n_limbs = n;
+}
+
+// x = x - y, requires x >= y
+static void
+bin_int_isub(bin_int_t *x, const bin_int_t *y) {
+    uint64_t borrow = 0, b, t;
+
+    for (unsigned i = 0; i < x->n_limbs; ++i) {
+        b = i < y->n_limbs ? y->limbs[i] : 0;
+        t = x->limbs[i] - borrow;
+        borrow = t > x->limbs[i];
+        borrow += t < b;
+        x->limbs[i] = t - b;
+    }
+    assert(borrow == 0);
+    while (x->n_limbs > 0 && x->limbs[x->n_limbs - 1] == 0)
+        --x->n_limbs;
+}
+
+// x = x - y * z, requires x >= y * z
+static void
+bin_int_isub_mul_u64(bin_int_t *x, const bin_int_t *y, uint64_t z) {
+    uint128_t t;
+    uint64_t carry = 0, borrow = 0, p, v;
+
+    for (unsigned i = 0; i < x->n_limbs; ++i) {
+        u64_mul_u64(&t, i < y->n_limbs ? y->limbs[i] : 0, z);
+        u128_iadd_u64(&t, carry);
+        p = U128_LO(t);
+        carry = U128_HI(t);
+        v = x->limbs[i] - borrow;
+        borrow = v > x->limbs[i];
+        borrow += v < p;
+        x->limbs[i] = v - p;
+    }
+    assert(borrow == 0 && carry == 0);
+    while (x->n_limbs > 0 && x->limbs[x->n_limbs - 1] == 0)
+        --x->n_limbs;
+}
+
+static int
+bin_int_cmp(const bin_int_t *x, const bin_int_t *y) {
+    if (x->n_limbs != y->n_limbs)
+        return x->n_limbs < y->n_limbs ? -1 : 1;
+    for (unsigned i = x->n_limbs; i > 0; --i)
+        if (x->limbs[i - 1] != y->limbs[i - 1])
+            return x->limbs[i - 1] < y->limbs[i - 1] ? -1 : 1;
+    return 0;
+}
+
+// Splits the finite double val into sign, significand and binary exponent
+// (|val| = m * 2 ^ e2, with m odd or 0); returns false for infinities and
+// NaNs.
+static bool
+double_decompose(bool *neg, uint64_t *m, int *e2, double val) {
+    uint64_t bits;
+    unsigned biased_exp;
+
+    memcpy(&bits, &val, sizeof(bits));
+    *neg = (bits >> 63U) != 0;
+    biased_exp = (bits >> 52U) & 0x7FFU;
+    *m = bits & DOUBLE_SIGNIF_MASK;
+    if (biased_exp == 0x7FFU)
+        return false;
+    if (biased_exp == 0)
+        *e2 = DOUBLE_MIN_LSB_EXP;
+    else {
+        *m |= DOUBLE_HIDDEN_BIT;
+        *e2 = (int)biased_exp + DOUBLE_MIN_LSB_EXP - 1;
+    }
+    if (*m != 0) {
+        unsigned n_tz = u64_most_signif_bit_pos(*m & -*m);
+        *m >>= n_tz;
+        *e2 += (int)n_tz;
+    }
+    return true;
+}
+
+// Rounds m * 2 ^ e2 (with m >= 2 ^ 63 and sticky indicating further
+// non-zero bits below m) to the nearest double (ties to even); returns false
+// if the result overflows.
+static bool
+u64_scaled_as_double(double *val, bool neg, uint64_t m, int e2, bool sticky) {
+    // exponent of the least significant bit of the 53-bit significand
+    int exp = e2 + 11;
+    unsigned shift = 11;
+    uint64_t signif, rem, tie, bits;
+
+    assert(m >= 0x8000000000000000ULL);
+
+    if (exp < DOUBLE_MIN_LSB_EXP) {
+        // subnormal or zero
+        shift = (unsigned)(DOUBLE_MIN_LSB_EXP - e2);
+        exp = DOUBLE_MIN_LSB_EXP;
+    }
+    if (shift < 64) {
+        signif = m >> shift;
+        rem = m & ((1ULL << shift) - 1);
+        tie = 1ULL << (shift - 1);
+    }
+    else {
+        // m * 2 ^ e2 < 2 ^ (DOUBLE_MIN_LSB_EXP - shift + 64)
+        signif = 0;
+        rem = shift == 64 ? m : 0;
+        tie = 0x8000000000000000ULL;
+    }
+    if (rem > tie || (rem == tie && (sticky || (signif & 1U)))) {
+        ++signif;
+        if (signif == DOUBLE_HIDDEN_BIT << 1U) {
+            signif >>= 1U;
+            ++exp;
+        }
+    }
+    if (signif >= DOUBLE_HIDDEN_BIT) {
+        if (exp > DOUBLE_MAX_LSB_EXP)
+            return false;
+        bits = (uint64_t)(exp - DOUBLE_MIN_LSB_EXP + 1) << 52U |
+               (signif & DOUBLE_SIGNIF_MASK);
+    }
+    else
+        bits = signif;
+    if (neg)
+        bits |= 0x8000000000000000ULL;
+    memcpy(val, &bits, sizeof(bits));
+    return true;
+}
+
+// Converts x * 10 ^ q (with sticky indicating a non-zero remainder below x)
+// to the nearest double; x is destroyed.
+static bool
+bin_int_scaled_as_double(double *val, bool neg, bin_int_t *x, int q,
+                         bool sticky) {
+    unsigned n_bits, shift, k;
+    uint64_t m;
+    int e2;
+
+    if (q >= 0) {
+        bin_int_imul_5_pow_n(x, q);
+        e2 = q;
+    }
+    else {
+        // x * 2 ^ shift / 5 ^ k gets more than 64 bits
+        // (2378 / 1024 > log2(5))
+        k = -q;
+        n_bits = bin_int_n_bits(x);
+        shift = 67 + (k * 2378U >> 10U);
+        shift = shift > n_bits ? shift - n_bits : 0;
+        bin_int_ishl(x, shift);
+        sticky |= bin_int_idiv_5_pow_n(x, k);
+        e2 = q - (int)shift;
+    }
+    n_bits = bin_int_n_bits(x);
+    if (n_bits < 64) {
+        bin_int_ishl(x, 64 - n_bits);
+        e2 -= (int)(64 - n_bits);
+    }
+    m = bin_int_top_u64(x, &shift, &sticky);
+    if (m == 0) {
+        *val = neg ? -0.0 : 0.0;
+        return true;
+    }
+    return u64_scaled_as_double(val, neg, m, e2 + (int)shift, sticky);
+}
+
+error_t
+fpdec_from_double(fpdec_t *fpdec, double val) {
+    fpdec_digit_t digits[BIN_INT_MAX_N_LIMBS + 2];
+    size_t n_digits;
+    fpdec_exp_t exp = 0;
+    bin_int_t x;
+    uint128_t t;
+    uint64_t m;
+    unsigned k = 0;
+    int e2;
+    bool neg;
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (!double_decompose(&neg, &m, &e2, val))
+        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
+    if (m == 0)
+        return FPDEC_OK;
+
+    if (e2 >= 0) {
+        if (u64_most_signif_bit_pos(m) + e2 < 96) {
+            // m * 2 ^ e2 < 2 ^ 96
+            fpdec->sign = neg ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
+            if (e2 >= 64) {
+                fpdec->lo = 0;
+                fpdec->hi = m << (e2 - 64);
+            }
+            else {
+                fpdec->lo = m << e2;
+                fpdec->hi = e2 == 0 ? 0 : m >> (64 - e2);
+            }
+            return FPDEC_OK;
+        }
+        bin_int_from_u64(&x, m);
+        bin_int_ishl(&x, e2);
+    }
+    else {
+        // m * 2 ^ -k = m * 5 ^ k / 10 ^ k
+        k = -e2;
+        if (k <= MAX_DEC_PREC_FOR_SHINT) {
+            // m * 5 ^ k < 2 ^ 53 * 2 ^ 42
+            u64_mul_u64(&t, m, u64_10_pow_n(k) >> k);
+            fpdec->sign = neg ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
+            fpdec->dec_prec = k;
+            fpdec->lo = U128_LO(t);
+            fpdec->hi = U128_HI(t);
+            return FPDEC_OK;
+        }
+        // align the coefficient to digits base RADIX
+        exp = -(fpdec_exp_t)CEIL(k, DEC_DIGITS_PER_DIGIT);
+        bin_int_from_u64(&x, m);
+        bin_int_imul_5_pow_n(&x, k);
+        bin_int_imul_u64_add(
+            &x, u64_10_pow_n(-exp * DEC_DIGITS_PER_DIGIT - (int)k), 0);
+    }
+    for (n_digits = 0; x.n_limbs > 0; ++n_digits)
+        digits[n_digits] = bin_int_idiv_u64(&x, RADIX);
+    rc = fpdec_from_sign_digits_exp(fpdec, neg ? FPDEC_SIGN_NEG :
+                                           FPDEC_SIGN_POS,
+                                    n_digits, digits, exp);
+    if (rc == FPDEC_OK && k > 0)
+        // m is odd, so the expansion has exactly k fractional digits
+        fpdec->dec_prec = k;
+    return rc;
+}
+
+// Rounds m * 2 ^ -k (k > 0) to dec_prec <= MAX_DEC_PREC_FOR_SHINT
+// fractional digits; returns false, leaving fpdec untouched, if the result
+// does not fit into a shint.
+static bool
+double_rounded_as_shint(fpdec_t *fpdec, bool neg, uint64_t m, unsigned k,
+                        int32_t dec_prec, enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_sign_t sign = neg ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
+    uint128_t quot, t;
+    uint64_t lo, hi, rem;
+    bool delta = false;
+
+    assert(k > 0);
+    assert(0 <= dec_prec && dec_prec <= MAX_DEC_PREC_FOR_SHINT);
+
+    // m * 10 ^ dec_prec < 2 ^ 113
+    u64_mul_u64(&t, m, u64_10_pow_n(dec_prec));
+    lo = U128_LO(t);
+    hi = U128_HI(t);
+    // quot = t / 2 ^ k, rem = remainder scaled to 2 ^ 64 (truncated, with
+    // delta set if the truncated bits are not all 0)
+    if (k < 64) {
+        U128_FROM_LO_HI(&quot, lo >> k | hi << (64 - k), hi >> k);
+        rem = lo << (64 - k);
+    }
+    else if (k < 128) {
+        U128_FROM_LO_HI(&quot, hi >> (k - 64), 0);
+        rem = k == 64 ? lo : hi << (128 - k) | lo >> (k - 64);
+        delta = k > 64 && lo << (128 - k) != 0;
+    }
+    else {
+        // 0 < t / 2 ^ k < 2 ^ -15
+        quot = UINT128_ZERO;
+        rem = 0;
+        delta = true;
+    }
+    if (rem != 0 || delta) {
+        // round_qr only looks at the last decimal digit of the quotient
+        t = quot;
+        if (round_qr(sign, u128_idiv_u64(&t, 10), rem, delta, 0, rounding))
+            u128_incr(&quot);
+    }
+    if (U64_HI(U128_HI(quot)) != 0)
+        return false;
+    fpdec->sign = U128_NE_ZERO(quot) ? sign : FPDEC_SIGN_ZERO;
+    fpdec->dec_prec = dec_prec;
+    fpdec->lo = U128_LO(quot);
+    fpdec->hi = U128_HI(quot);
+    return true;
+}
+
+error_t
+fpdec_from_double_rounded(fpdec_t *fpdec, double val, int32_t dec_prec,
+                          enum FPDEC_ROUNDING_MODE rounding) {
+    uint64_t m;
+    int e2;
+    bool neg;
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    if (!double_decompose(&neg, &m, &e2, val))
+        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
+    if (m == 0) {
+        if (ABS(dec_prec) > FPDEC_MAX_DEC_PREC)
+            ERROR(FPDEC_PREC_LIMIT_EXCEEDED);
+        fpdec->dec_prec = MAX(dec_prec, 0);
+        return FPDEC_OK;
+    }
+    if (e2 < 0 && 0 <= dec_prec &&
+        dec_prec <= MAX_DEC_PREC_FOR_SHINT &&
+        double_rounded_as_shint(fpdec, neg, m, -e2, dec_prec, rounding))
+        return FPDEC_OK;
+
+    rc = fpdec_from_double(fpdec, val);
+    if (rc != FPDEC_OK)
+        return rc;
+    rc = fpdec_adjust(fpdec, dec_prec, rounding);
+    if (rc != FPDEC_OK)
+        fpdec_reset_to_zero(fpdec, 0);
+    return rc;
+}
+
+// Shortest decimal for a double (Steele and White's free-format algorithm
+// with exact integers, as refined by Burger and Dybvig)
+//
+// For the finite, positive double f * 2 ^ e2 (f with hidden bit, i.e. not
+// normalized) r / s is the value not yet emitted as digits, m_minus / s and
+// m_plus / s are the distances to the boundaries of the interval of values
+// converting to the double. All are initially scaled by 10 ^ -k, so that
+// (r + m_plus) / s < 1, and by 10 with each generated digit. Digits are
+// generated until one of the boundaries gets reached; then, if both could be
+// reached, the last digit is rounded to nearest (ties to even).
+//
+// The digit generators start with the estimate *k, adjust it and return the
+// number of digits accumulated in *digits (at most 17). The boundaries
+// themselves convert to the double if f is even (ties to even) and the gap
+// below a power of 2 is half the one above it (unequal_gaps).
+
+// Generates the digits with 128-bit integers; requires -110 <= e2 <= 60,
+// so that neither s nor 10 * r exceed 2 ^ 124.
+static int
+double_shortest_digits_u128(uint64_t *digits, int *k, uint64_t f, int e2,
+                            bool unequal_gaps) {
+    const bool incl = (f & 1U) == 0;
+    const unsigned shift = unequal_gaps ? 2 : 1;
+    uint128_t r, s, m_minus, m_plus, t, s_mult[4];
+    int n, n_digits = 0, cmp;
+    bool low, high;
+
+    assert(-110 <= e2 && e2 <= 60);
+
+    if (e2 >= 0) {
+        u64_mul_u64(&r, f, 1ULL << (e2 + shift));
+        U128_FROM_LO_HI(&s, 1ULL << shift, 0);
+        U128_FROM_LO_HI(&m_minus, 1ULL << e2, 0);
+    }
+    else {
+        U128_FROM_LO_HI(&r, f << shift, 0);
+        n = (int)shift - e2;
+        if (n < 64)
+            U128_FROM_LO_HI(&s, 1ULL << n, 0);
+        else
+            U128_FROM_LO_HI(&s, 0, 1ULL << (n - 64));
+        U128_FROM_LO_HI(&m_minus, 1, 0);
+    }
+    for (n = ABS(*k); n > 0; n -= UINT64_10_POW_N_CUTOFF) {
+        if (*k >= 0)
+            u128_imul_10_pow_n(&s, MIN(n, UINT64_10_POW_N_CUTOFF));
+        else {
+            u128_imul_10_pow_n(&r, MIN(n, UINT64_10_POW_N_CUTOFF));
+            u128_imul_10_pow_n(&m_minus, MIN(n, UINT64_10_POW_N_CUTOFF));
+        }
+    }
+    m_plus = m_minus;
+    if (unequal_gaps)
+        u128_iadd_u128(&m_plus, &m_minus);
+    for (;;) {
+        t = r;
+        u128_iadd_u128(&t, &m_plus);
+        if (u128_cmp(t, s) < (incl ? 0 : 1))
+            break;
+        u128_imul_u64(&s, 10);
+        ++*k;
+    }
+
+    // multiples of s for the binary digit search
+    s_mult[0] = s;
+    for (n = 1; n < 4; ++n) {
+        s_mult[n] = s_mult[n - 1];
+        u128_iadd_u128(&s_mult[n], &s_mult[n - 1]);
+    }
+
+    *digits = 0;
+    for (;;) {
+        unsigned d = 0;
+
+        u128_imul_u64(&r, 10);
+        u128_imul_u64(&m_minus, 10);
+        if (unequal_gaps)
+            u128_imul_u64(&m_plus, 10);
+        else
+            m_plus = m_minus;
+        // r < 10 * s
+        for (n = 3; n >= 0; --n)
+            if (u128_cmp(r, s_mult[n]) >= 0) {
+                u128_isub_u128(&r, &s_mult[n]);
+                d += 1U << n;
+            }
+        ++n_digits;
+        low = u128_cmp(r, m_minus) < (incl ? 1 : 0);
+        t = r;
+        u128_iadd_u128(&t, &m_plus);
+        high = u128_cmp(t, s) >= (incl ? 0 : 1);
+        if (low && high) {
+            t = r;
+            u128_iadd_u128(&t, &r);
+            cmp = u128_cmp(t, s);
+            d += cmp > 0 || (cmp == 0 && d % 2 != 0);
+        }
+        else
+            d += high;
+        *digits = *digits * 10 + d;
+        if (low || high)
+            return n_digits;
+    }
+}
+
+// Generates the digits with binary integers on the stack; works for any
+// finite double. Common factors of 2 are removed from r, s and m_minus,
+// which keeps them about a third smaller for large and small doubles.
+static int
+double_shortest_digits_bin_int(uint64_t *digits, int *k, uint64_t f, int e2,
+                               bool unequal_gaps) {
+    const bool incl = (f & 1U) == 0;
+    const unsigned shift = unequal_gaps ? 2 : 1;
+    const unsigned k_pos = *k >= 0 ? *k : 0, k_neg = *k < 0 ? -*k : 0;
+    const unsigned e2_pos = e2 >= 0 ? e2 : 0, e2_neg = e2 < 0 ? -e2 : 0;
+    unsigned r_shift = e2_pos + shift + k_neg, s_shift = shift + e2_neg + k_pos;
+    unsigned m_shift = e2_pos + k_neg, n_common;
+    bin_int_t r, s, m_minus, m_plus_unequal, t;
+    bin_int_t *m_plus = &m_minus;
+    uint64_t s_top, r_top;
+    uint128_t r_top2;
+    unsigned n_s_limbs, norm_shift;
+    int n_digits = 0, cmp;
+    bool low, high;
+
+    n_common = MIN(MIN(r_shift, s_shift), m_shift);
+    bin_int_from_u64(&r, f);
+    bin_int_imul_5_pow_n(&r, k_neg);
+    bin_int_ishl(&r, r_shift - n_common);
+    bin_int_from_u64(&s, 1);
+    bin_int_imul_5_pow_n(&s, k_pos);
+    bin_int_ishl(&s, s_shift - n_common);
+    bin_int_from_u64(&m_minus, 1);
+    bin_int_imul_5_pow_n(&m_minus, k_neg);
+    bin_int_ishl(&m_minus, m_shift - n_common);
+    if (unequal_gaps) {
+        bin_int_add(&m_plus_unequal, &m_minus, &m_minus);
+        m_plus = &m_plus_unequal;
+    }
+    for (;;) {
+        bin_int_add(&t, &r, m_plus);
+        if (bin_int_cmp(&t, &s) < (incl ? 0 : 1))
+            break;
+        bin_int_imul_u64_add(&s, 10, 0);
+        ++*k;
+    }
+    // normalize s, so that the top 128 bits of r divided by the top limb of
+    // s give the next digit or one less
+    n_s_limbs = s.n_limbs;
+    norm_shift = 63 - u64_most_signif_bit_pos(s.limbs[n_s_limbs - 1]);
+    bin_int_ishl(&s, norm_shift);
+    bin_int_ishl(&r, norm_shift);
+    bin_int_ishl(&m_minus, norm_shift);
+    if (unequal_gaps)
+        bin_int_ishl(&m_plus_unequal, norm_shift);
+    s_top = s.limbs[n_s_limbs - 1];
+
+    *digits = 0;
+    for (;;) {
+        unsigned d;
+
+        bin_int_imul_u64_add(&r, 10, 0);
+        bin_int_imul_u64_add(&m_minus, 10, 0);
+        if (unequal_gaps)
+            bin_int_imul_u64_add(&m_plus_unequal, 10, 0);
+        // r < 10 * s, so r has at most n_s_limbs + 1 limbs
+        U128_FROM_LO_HI(&r_top2,
+                        r.n_limbs >= n_s_limbs ? r.limbs[n_s_limbs - 1] : 0,
+                        r.n_limbs > n_s_limbs ? r.limbs[n_s_limbs] : 0);
+        if (s_top == UINT64_MAX)
+            d = (unsigned)U128_HI(r_top2);
+        else {
+            u128_idiv_u64(&r_top2, s_top + 1);
+            d = (unsigned)U128_LO(r_top2);
+        }
+        if (d > 0)
+            bin_int_isub_mul_u64(&r, &s, d);
+        if (bin_int_cmp(&r, &s) >= 0) {
+            bin_int_isub(&r, &s);
+            ++d;
+        }
+        ++n_digits;
+        low = bin_int_cmp(&r, &m_minus) < (incl ? 1 : 0);
+        // r + m_plus < (r_top + 2) * 2 ^ (64 * (n_s_limbs - 1)) <= s, if
+        // m_plus has less limbs than s and r_top + 1 < s_top
+        r_top = r.n_limbs == n_s_limbs ? r.limbs[n_s_limbs - 1] : 0;
+        if (m_plus->n_limbs < n_s_limbs && r_top + 1 < s_top)
+            high = false;
+        else {
+            bin_int_add(&t, &r, m_plus);
+            high = bin_int_cmp(&t, &s) >= (incl ? 0 : 1);
+        }
+        if (low && high) {
+            bin_int_add(&t, &r, &r);
+            cmp = bin_int_cmp(&t, &s);
+            d += cmp > 0 || (cmp == 0 && d % 2 != 0);
+        }
+        else
+            d += high;
+        *digits = *digits * 10 + d;
+        if (low || high)
+            return n_digits;
+    }
+}
+
+// Gives the shortest decimal coeff * 10 ^ q (without trailing zeros)
+// converting back to the double f * 2 ^ e2 and, if there are several, the
+// one nearest to it.
+static void
+double_shortest_decimal(uint64_t *coeff, int *q, uint64_t f, int e2,
+                        bool unequal_gaps) {
+    // 78913 / 2 ^ 18 ~ log10(2), so k is at most 2 below the smallest k
+    // with (r + m_plus) / s < 1
+    int k = FLOOR(((int)u64_most_signif_bit_pos(f) + e2) * 78913, 1 << 18) +
+            1;
+    int n_digits;
+
+    if (-110 <= e2 && e2 <= 60)
+        n_digits = double_shortest_digits_u128(coeff, &k, f, e2,
+                                               unequal_gaps);
+    else
+        n_digits = double_shortest_digits_bin_int(coeff, &k, f, e2,
+                                                  unequal_gaps);
+    assert(n_digits <= 17);
+    *q = k - n_digits;
+    // the last digit may have been rounded up to 10
+    while (*coeff % 10 == 0) {
+        *coeff /= 10;
+        ++*q;
+    }
+}
+
+// Finds the shortest decimal for val by rounding it to an increasing number
+// of digits until the result converts back to val. Fast as long as the
+// candidates are shifted ints, i.e. for 0.1 <= |val| < 2 ^ 93.
+static error_t
+double_shortest_by_search(fpdec_t *fpdec, double val) {
+    static const enum FPDEC_ROUNDING_MODE roundings[3] = {
+        FPDEC_ROUND_HALF_EVEN, FPDEC_ROUND_FLOOR, FPDEC_ROUND_CEILING
+    };
+    fpdec_t t = FPDEC_ZERO;
+    fpdec_sign_t sign;
+    uint128_t coeff;
+    int64_t exp;
+    uint64_t m;
+    int e2, magn, n_signif;
+    double d;
+    bool neg, found = false;
+    error_t rc;
+
+    double_decompose(&neg, &m, &e2, val);
+
+    // 2 ^ e2 <= |val| < 2 ^ (e2 + 1), so the decimal magnitude of val is
+    // about e2 * log10(2) (78913 / 2 ^ 18 ~ log10(2)); truncating val to 17
+    // or 18 digits based on that gives the exact magnitude.
+    e2 += (int)u64_most_signif_bit_pos(m);
+    magn = FLOOR(e2 * 78913, 1 << 18);
+    rc = fpdec_from_double_rounded(&t, val, 16 - magn, FPDEC_ROUND_DOWN);
+    if (rc != FPDEC_OK)
+        return rc;
+    magn = fpdec_magnitude(&t);
+    fpdec_reset_to_zero(&t, 0);
+
+    // With p significant bits (53, less for subnormals) any decimal with up
+    // to floor((p - 1) * log10(2)) digits converting to val is the nearest
+    // one with that number of digits; 17 digits always suffice. If the
+    // nearest decimal with more digits does not convert to val, the
+    // neighbour on the other side of val may (next to a power of 2).
+    n_signif = MIN(e2 - DOUBLE_MIN_LSB_EXP + 1, 53);
+    n_signif = MAX(FLOOR((n_signif - 1) * 78913, 1 << 18), 1);
+    for (; n_signif <= 17 && !found; ++n_signif)
+        for (int i = 0; i < 3 && !found; ++i) {
+            rc = fpdec_from_double_rounded(&t, val, n_signif - 1 - magn,
+                                           roundings[i]);
+            if (rc != FPDEC_OK)
+                return rc;
+            found = fpdec_as_double(&d, &t) == FPDEC_OK && d == val;
+            if (!found)
+                fpdec_reset_to_zero(&t, 0);
+        }
+    assert(found);
+
+    // strip trailing zeros
+    if (fpdec_as_sign_coeff128_exp(&sign, &coeff, &exp, &t) != 0) {
+        *fpdec = t;
+        return FPDEC_OK;
+    }
+    fpdec_reset_to_zero(&t, 0);
+    return fpdec_from_ieee_coeff_exp(fpdec, sign, coeff, (int)exp);
+}
+
+error_t
+fpdec_from_double_shortest(fpdec_t *fpdec, double val) {
+    uint64_t bits, f, coeff;
+    unsigned biased_exp;
+    uint128_t t;
+    int e2, e2_top, q, magn;
+
+    ASSERT_FPDEC_IS_ZEROED(fpdec);
+
+    memcpy(&bits, &val, sizeof(bits));
+    biased_exp = (bits >> 52U) & 0x7FFU;
+    f = bits & DOUBLE_SIGNIF_MASK;
+    if (biased_exp == 0x7FFU)
+        ERROR(FPDEC_INVALID_DECIMAL_LITERAL);
+    if (biased_exp == 0) {
+        if (f == 0)
+            return FPDEC_OK;
+        e2 = DOUBLE_MIN_LSB_EXP;
+    }
+    else {
+        f |= DOUBLE_HIDDEN_BIT;
+        e2 = (int)biased_exp + DOUBLE_MIN_LSB_EXP - 1;
+    }
+    // 2 ^ e2_top <= |val| < 2 ^ (e2_top + 1), so the decimal magnitude of
+    // val is magn or magn + 1 (78913 / 2 ^ 18 ~ log10(2))
+    e2_top = (int)u64_most_signif_bit_pos(f) + e2;
+    magn = FLOOR(e2_top * 78913, 1 << 18);
+    // For 0.1 <= |val| < 2 ^ 93 all candidates of the search are shifted
+    // ints, so it allocates nothing and is faster than generating digits.
+    if (magn >= -1 && e2_top < 93)
+        return double_shortest_by_search(fpdec, val);
+    // the gap below a power of 2 is half the one above it
+    double_shortest_decimal(&coeff, &q, f, e2,
+                            f == DOUBLE_HIDDEN_BIT && biased_exp > 1);
+    U128_FROM_LO_HI(&t, coeff, 0);
+    return fpdec_from_ieee_coeff_exp(fpdec, (bits >> 63U) != 0 ?
+                                            FPDEC_SIGN_NEG : FPDEC_SIGN_POS,
+                                     t, q);
+}
+
+error_t
+fpdec_as_double(double *val, const fpdec_t *fpdec) {
+    static const double exact_10_pows[MAX_DEC_PREC_FOR_SHINT + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+    };
+    // digits (base RADIX) needed to distinguish a value from the halfway
+    // points between doubles (which have at most 767 significant digits)
+    const fpdec_n_digits_t max_n_digits = 43;
+    bool neg = FPDEC_SIGN(fpdec) == FPDEC_SIGN_NEG;
+    bool sticky = false;
+    bin_int_t x;
+    int q;
+
+    if (FPDEC_EQ_ZERO(fpdec)) {
+        *val = 0.0;
+        return FPDEC_OK;
+    }
+    if (!FPDEC_IS_DYN_ALLOC(fpdec)) {
+        if (fpdec->hi == 0 && fpdec->lo <= DOUBLE_HIDDEN_BIT << 1U) {
+            // both operands exact, so the quotient is correctly rounded
+            *val = (double)fpdec->lo / exact_10_pows[FPDEC_DEC_PREC(fpdec)];
+            if (neg)
+                *val = -*val;
+            return FPDEC_OK;
+        }
+        x.limbs[0] = fpdec->lo;
+        x.limbs[1] = fpdec->hi;
+        x.n_limbs = fpdec->hi != 0 ? 2 : 1;
+        q = -(int)FPDEC_DEC_PREC(fpdec);
+    }
+    else {
+        const fpdec_digit_t *digits = FPDEC_DYN_DIGITS(fpdec);
+        fpdec_n_digits_t n_digits = FPDEC_DYN_N_DIGITS(fpdec);
+        fpdec_n_digits_t n_skipped;
+        int magn = fpdec_magnitude(fpdec);
+
+        if (magn > DOUBLE_MAX_MAGN) {
+            *val = neg ? -HUGE_VAL : HUGE_VAL;
+            ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+        }
+        if (magn < DOUBLE_MIN_MAGN) {
+            // less than half of the least subnormal
+            *val = neg ? -0.0 : 0.0;
+            return FPDEC_OK;
+        }
+        n_skipped = n_digits > max_n_digits ? n_digits - max_n_digits : 0;
+        for (fpdec_n_digits_t i = 0; i < n_skipped; ++i)
+            sticky |= digits[i] != 0;
+        x.n_limbs = 0;
+        for (fpdec_n_digits_t i = n_digits; i > n_skipped; --i)
+            bin_int_imul_u64_add(&x, RADIX, digits[i - 1]);
+        q = (FPDEC_DYN_EXP(fpdec) + (int)n_skipped) * DEC_DIGITS_PER_DIGIT;
+    }
+    if (!bin_int_scaled_as_double(val, neg, &x, q, sticky)) {
+        *val = neg ? -HUGE_VAL : HUGE_VAL;
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+    }
+    return FPDEC_OK;
+}
+
+// Basic arithmetic operations
+
+// Scales the shint with the lower precision to the precision of the other
+// one. As both are < 2^96 and 0 <= shift <= 18, the scaled value may
+// exceed 2^128; in that case it is set to UINT128_MAX (check with
+// SHINTS_OVERFLOWED).
+static inline fpdec_dec_prec_t
+make_adjusted_shints(uint128_t *x_shint, uint128_t *y_shint,
+                     const fpdec_dec_prec_t x_dec_prec,
+                     const fpdec_dec_prec_t y_dec_prec) {
+    int shift = x_dec_prec - y_dec_prec;
+    fpdec_dec_prec_t prec;
+
+    if (shift == 0)
+        prec = x_dec_prec;
+    else if (shift > 0) {
+        prec = x_dec_prec;
+        u128_imul_10_pow_n(y_shint, shift);
+    }
+    else {
+        prec = y_dec_prec;
+        u128_imul_10_pow_n(x_shint, -shift);
+    }
+    return prec;
+}
+
+#define SHINTS_OVERFLOWED(x, y) \
+    (UINT128_CHECK_MAX(x) || UINT128_CHECK_MAX(y))
+
+typedef error_t (*v_math_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+
+// Fallback for shint operands whose adjusted values exceed 128 bits
+static error_t
+fpdec_apply_op_to_shints_as_dyn(v_math_op op, fpdec_t *z, const fpdec_t *x,
+                                const fpdec_t *y) {
+    error_t rc;
+    fpdec_t x_dyn, y_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+        if (rc == FPDEC_OK) {
+            rc = op(z, &x_dyn, &y_dyn);
+            fpdec_reset_to_zero(&y_dyn, 0);
+        }
+        fpdec_reset_to_zero(&x_dyn, 0);
+    }
+    return rc;
+}
+
+static error_t
+fpdec_add_abs_dyn_to_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    fpdec_n_digits_t n_shift, n_add_zeros;
+    fpdec_digit_array_t *z_digits;
+    const fpdec_digit_array_t *s_digits;
+    fpdec_exp_t z_exp;
+
+    if (FPDEC_DYN_EXP(x) == FPDEC_DYN_EXP(y)) {
+        n_shift = 0;                // no need to adjust exponents
+        n_add_zeros = 1;            // provision for potential carry-over
+        if (FPDEC_DYN_N_DIGITS(x) >= FPDEC_DYN_N_DIGITS(y)) {
+            z_digits = digits_copy(x->digit_array, n_shift, n_add_zeros);
+            if (z_digits == NULL)
+                MEMERROR;
+            s_digits = y->digit_array;
+        }
+        else {
+            z_digits = digits_copy(y->digit_array, n_shift, n_add_zeros);
+            if (z_digits == NULL)
+                MEMERROR;
+            s_digits = x->digit_array;
+        }
+        z_exp = FPDEC_DYN_EXP(x);
+    }
+    else if (FPDEC_DYN_EXP(x) > FPDEC_DYN_EXP(y)) {
+        n_shift = FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y);
+        n_add_zeros = MAX((int)FPDEC_DYN_N_DIGITS(y) -
+                          (int)FPDEC_DYN_N_DIGITS(x) -
+                          (int)n_shift + 1,
+                          1);
+        z_digits = digits_copy(x->digit_array, n_shift, n_add_zeros);
+        if (z_digits == NULL)
+            MEMERROR;
+        s_digits = y->digit_array;
+        z_exp = FPDEC_DYN_EXP(y);
+    }
+    else {
+        n_shift = FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x);
+        n_add_zeros = MAX((int)FPDEC_DYN_N_DIGITS(x) -
+                          (int)FPDEC_DYN_N_DIGITS(y) -
+                          (int)n_shift + 1,
+                          1);
+        z_digits = digits_copy(y->digit_array, n_shift, n_add_zeros);
+        if (z_digits == NULL)
+            MEMERROR;
+        s_digits = x->digit_array;
+        z_exp = FPDEC_DYN_EXP(x);
+    }
+    digits_iadd_digits(z_digits, s_digits);
+    z->exp = z_exp + digits_eliminate_trailing_zeros(z_digits);
+    z->digit_array = z_digits;
+    z->dyn_alloc = true;
+    z->normalized = true;
+    return FPDEC_OK;
+}
+
+static error_t
+fpdec_add_abs_shint_to_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    uint128_t x_shint = U128_FROM_SHINT(x);
+    uint128_t y_shint = U128_FROM_SHINT(y);
+
+    FPDEC_DEC_PREC(z) = make_adjusted_shints(&x_shint, &y_shint,
+                                             FPDEC_DEC_PREC(x),
+                                             FPDEC_DEC_PREC(y));
+    if (SHINTS_OVERFLOWED(&x_shint, &y_shint))
+        return fpdec_apply_op_to_shints_as_dyn(fpdec_add_abs_dyn_to_dyn,
+                                               z, x, y);
+    u128_iadd_u128(&x_shint, &y_shint);
+    if (u128_cmp(x_shint, y_shint) < 0)
+        // sum overflowed
+        return fpdec_apply_op_to_shints_as_dyn(fpdec_add_abs_dyn_to_dyn,
+                                               z, x, y);
+    if (U128_FITS_SHINT(x_shint)) {
+        z->lo = U128_LO(x_shint);
+        z->hi = U128_HI(x_shint);
+        return FPDEC_OK;
+    }
+    else
+        return fpdec_set_dyn_coeff(z, U128_LO(x_shint), U128_HI(x_shint));
+}
+
+static error_t
+fpdec_add_abs_dyn_to_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t s;
+
+    rc = fpdec_copy_shint_as_dyn(&s, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_add_abs_dyn_to_dyn(z, &s, y);
+        fpdec_reset_to_zero(&s, 0);
+    }
+    return rc;
+}
+
+static error_t
+fpdec_add_abs_shint_to_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t s;
+
+    rc = fpdec_copy_shint_as_dyn(&s, y);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_add_abs_dyn_to_dyn(z, x, &s);
+        fpdec_reset_to_zero(&s, 0);
+    }
+    return rc;
+}
+
+const v_math_op vtab_add_abs[4] = {
+    fpdec_add_abs_shint_to_shint,
+    fpdec_add_abs_dyn_to_shint,
+    fpdec_add_abs_shint_to_dyn,
+    fpdec_add_abs_dyn_to_dyn
+};
+
+static error_t
+fpdec_sub_abs_dyn_from_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    fpdec_n_digits_t n_shift;
+    fpdec_digit_array_t *z_digits;
+    fpdec_digit_array_t *s_digits;
+    bool s_digits_is_copy = false;
+    fpdec_exp_t z_exp;
+
+    if (FPDEC_DYN_EXP(x) == FPDEC_DYN_EXP(y)) {
+        n_shift = 0;                // no need to adjust exponents
+        z_digits = digits_copy(x->digit_array, n_shift, 0);
+        if (z_digits == NULL)
+            MEMERROR;
+        s_digits = y->digit_array;
+        z_exp = FPDEC_DYN_EXP(x);
+    }
+    else if (FPDEC_DYN_EXP(x) > FPDEC_DYN_EXP(y)) {
+        n_shift = FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y);
+        z_digits = digits_copy(x->digit_array, n_shift, 0);
+        if (z_digits == NULL)
+            MEMERROR;
+        s_digits = y->digit_array;
+        z_exp = FPDEC_DYN_EXP(y);
+    }
+    else {
+        z_digits = digits_copy(x->digit_array, 0, 0);
+        if (z_digits == NULL)
+            MEMERROR;
+        n_shift = FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x);
+        s_digits = digits_copy(y->digit_array, n_shift, 0);
+        if (s_digits == NULL) {
+            fpdec_mem_free((void *)z_digits);
+            MEMERROR;
+        }
+        s_digits_is_copy = true;
+        z_exp = FPDEC_DYN_EXP(x);
+    }
+    digits_isub_digits(z_digits, s_digits);
+    if (s_digits_is_copy)
+        fpdec_mem_free((void *)s_digits);
+    z->exp = z_exp;
+    z->digit_array = z_digits;
+    z->dyn_alloc = true;
+    fpdec_dyn_normalize(z);
+    return FPDEC_OK;
+}
+
+// pre-condition: x > y
+static error_t
+fpdec_sub_abs_shint_from_shint(fpdec_t *z, const fpdec_t *x,
+                               const fpdec_t *y) {
+    uint128_t x_shint = U128_FROM_SHINT(x);
+    uint128_t y_shint = U128_FROM_SHINT(y);
+
+    FPDEC_DEC_PREC(z) = make_adjusted_shints(&x_shint, &y_shint,
+                                             FPDEC_DEC_PREC(x),
+                                             FPDEC_DEC_PREC(y));
+    if (SHINTS_OVERFLOWED(&x_shint, &y_shint))
+        return fpdec_apply_op_to_shints_as_dyn(fpdec_sub_abs_dyn_from_dyn,
+                                               z, x, y);
+    u128_isub_u128(&x_shint, &y_shint);
+    if (U128_FITS_SHINT(x_shint)) {
+        z->lo = U128_LO(x_shint);
+        z->hi = U128_HI(x_shint);
+        return FPDEC_OK;
+    }
+    else
+        return fpdec_set_dyn_coeff(z, U128_LO(x_shint), U128_HI(x_shint));
+}
+
+static error_t
+fpdec_sub_abs_dyn_from_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t s;
+
+    rc = fpdec_copy_shint_as_dyn(&s, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_sub_abs_dyn_from_dyn(z, &s, y);
+        fpdec_reset_to_zero(&s, 0);
+    }
+    return rc;
+}
+
+static error_t
+fpdec_sub_abs_shint_from_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t s;
+
+    rc = fpdec_copy_shint_as_dyn(&s, y);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_sub_abs_dyn_from_dyn(z, x, &s);
+        fpdec_reset_to_zero(&s, 0);
+    }
+    return rc;
+}
+
+const v_math_op vtab_sub_abs[4] = {
+    fpdec_sub_abs_shint_from_shint,
+    fpdec_sub_abs_dyn_from_shint,
+    fpdec_sub_abs_shint_from_dyn,
+    fpdec_sub_abs_dyn_from_dyn
+};
+
+error_t
+fpdec_add(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    int cmp;
+
+    ASSERT_FPDEC_IS_ZEROED(z);
+
+    if (FPDEC_EQ_ZERO(x))
+        return fpdec_copy(z, y);
+    if (FPDEC_EQ_ZERO(y))
+        return fpdec_copy(z, x);
+
+    FPDEC_DEC_PREC(z) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
+    if (FPDEC_SIGN(x) == FPDEC_SIGN(y)) {
+        // same sign => x + y = sign(x) (|x| + |y|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(x);
+        return DISPATCH_BIN_OP(vtab_add_abs, z, x, y);
+    }
+    // sign(x) != sign(y) ...
+    cmp = fpdec_compare(x, y, true);
+    if (cmp == 1) {
+        // ... and |x| > |y| => x + y = sign(x) (|x| - |y|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(x);
+        return DISPATCH_BIN_OP(vtab_sub_abs, z, x, y);
+    }
+    if (cmp == -1) {
+        // ... and |x| < |y| => x + y = sign(y) (|y| - |x|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(y);
+        return DISPATCH_BIN_OP(vtab_sub_abs, z, y, x);
+    }
+    // ... and |x| = |y| => x + y = 0
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_sub(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    int cmp;
+
+    ASSERT_FPDEC_IS_ZEROED(z);
+
+    if (FPDEC_EQ_ZERO(x))
+        return fpdec_neg(z, y);
+    if (FPDEC_EQ_ZERO(y))
+        return fpdec_copy(z, x);
+
+    FPDEC_DEC_PREC(z) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
+    if (FPDEC_SIGN(x) != FPDEC_SIGN(y)) {
+        // sign(x) != sign(y) => x - y = sign(x) (|x| + |y|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(x);
+        return DISPATCH_BIN_OP(vtab_add_abs, z, x, y);
+    }
+    // same sign ...
+    cmp = fpdec_compare(x, y, true);
+    if (cmp == 1) {
+        // ... and |x| > |y| => x - y = sign(x) (|x| - |y|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(x);
+        return DISPATCH_BIN_OP(vtab_sub_abs, z, x, y);
+    }
+    if (cmp == -1) {
+        // ... and |x| < |y| => x - y = ~sign(y) (|y| - |x|)
+        FPDEC_SIGN(z) = FPDEC_SIGN(y) * -1;
+        return DISPATCH_BIN_OP(vtab_sub_abs, z, y, x);
+    }
+    // ... and |x| = |y| => x - y = 0
+    return FPDEC_OK;
+}
+
+static error_t
+fpdec_mul_abs_shint_by_u64(fpdec_t *z, const fpdec_t *x, const uint64_t y) {
+    uint128_t z_shint = U128_FROM_SHINT(x);
+
+    u128_imul_u64(&z_shint, y);
+    if (U128_FITS_SHINT(z_shint)) {
+        z->lo = U128_LO(z_shint);
+        z->hi = U128_HI(z_shint);
+        return FPDEC_OK;
+    }
+    return FPDEC_N_DIGITS_LIMIT_EXCEEDED;
+}
+
+static error_t
+fpdec_mul_abs_dyn_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    fpdec_digit_array_t *z_digits;
+    int64_t exp;
+
+    z_digits = digits_mul(x->digit_array, y->digit_array);
+    if (z_digits == NULL)
+        MEMERROR;
+    exp = (int64_t)FPDEC_DYN_EXP(x) + (int64_t)FPDEC_DYN_EXP(y);
+    if (exp > FPDEC_MAX_EXP || exp < INT32_MIN) {
+        fpdec_mem_free((void *)z_digits);
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+    }
+    z->exp = (fpdec_exp_t)exp;
+    z->digit_array = z_digits;
+    FPDEC_IS_DYN_ALLOC(z) = true;
+    return FPDEC_OK;
+}
+
+static error_t
+fpdec_mul_abs_shint_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t x_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_mul_abs_dyn_by_dyn(z, &x_dyn, y);
+        fpdec_reset_to_zero(&x_dyn, 0);
+    }
+    return rc;
+}
+
+static error_t
+fpdec_mul_abs_dyn_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    return fpdec_mul_abs_shint_by_dyn(z, y, x);
+}
+
+static error_t
+fpdec_mul_abs_shint_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+    fpdec_t y_dyn;
+
+    if (x->hi == 0 && fpdec_mul_abs_shint_by_u64(z, y, x->lo) == FPDEC_OK)
+        return FPDEC_OK;
+    if (y->hi == 0 && fpdec_mul_abs_shint_by_u64(z, x, y->lo) == FPDEC_OK)
+        return FPDEC_OK;
+
+    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_mul_abs_shint_by_dyn(z, x, &y_dyn);
+        fpdec_reset_to_zero(&y_dyn, 0);
+    }
+    return rc;
+}
+
+// Multiplies the coefficients of the shints x and y directly into a digit
+// array (used when the precision of the product exceeds
+// MAX_DEC_PREC_FOR_SHINT, so that it can't be stored as shint).
+static error_t
+fpdec_mul_abs_shint_by_shint_as_dyn(fpdec_t *z, const fpdec_t *x,
+                                    const fpdec_t *y) {
+    const int n_frac_digits = CEIL(FPDEC_DEC_PREC(z), DEC_DIGITS_PER_DIGIT);
+    const int n_shift = n_frac_digits * DEC_DIGITS_PER_DIGIT -
+                        FPDEC_DEC_PREC(z);
+    // The product of two 96-bit coefficients is < 2 ^ 192, shifted by
+    // n_shift (<= 18) decimal digits it's < 2 ^ 256 < RADIX ^ 5.
+    uint64_t words[4];
+    fpdec_digit_t digits[5];
+    unsigned n_words = 4, n_digits = 0, n_trailing_zeros = 0;
+    uint64_t f, carry;
+    uint128_t t, u;
+    error_t rc;
+
+    assert(!FPDEC_IS_DYN_ALLOC(x) && !FPDEC_IS_DYN_ALLOC(y));
+    assert(n_shift < DEC_DIGITS_PER_DIGIT);
+
+    // words[0..2] = x * y
+    u64_mul_u64(&t, x->lo, y->lo);
+    words[0] = U128_LO(t);
+    carry = U128_HI(t);
+    u64_mul_u64(&t, x->lo, y->hi);
+    u64_mul_u64(&u, x->hi, y->lo);
+    u128_iadd_u128(&t, &u);         // < 2 ^ 161
+    u128_iadd_u64(&t, carry);
+    words[1] = U128_LO(t);
+    words[2] = U128_HI(t) + (uint64_t)x->hi * y->hi;
+    // words = words * 10 ^ n_shift
+    f = u64_10_pow_n(n_shift);
+    carry = 0;
+    for (unsigned i = 0; i < 3; ++i) {
+        u64_mul_u64(&t, words[i], f);
+        u128_iadd_u64(&t, carry);
+        words[i] = U128_LO(t);
+        carry = U128_HI(t);
+    }
+    words[3] = carry;
+    // convert to base RADIX
+    while (n_words > 0 && words[n_words - 1] == 0)
+        --n_words;
+    while (n_words > 0) {
+        uint64_t r = 0;
+        for (unsigned i = n_words; i > 0; --i) {
+            U128_FROM_LO_HI(&t, words[i - 1], r);
+            r = u128_idiv_radix(&t);
+            words[i - 1] = U128_LO(t);
+        }
+        digits[n_digits++] = r;
+        while (n_words > 0 && words[n_words - 1] == 0)
+            --n_words;
+    }
+    while (digits[n_trailing_zeros] == 0)
+        ++n_trailing_zeros;
+    rc = digits_from_digits(&z->digit_array, digits + n_trailing_zeros,
+                            n_digits - n_trailing_zeros);
+    if (rc == FPDEC_OK) {
+        z->dyn_alloc = true;
+        z->exp = (int)n_trailing_zeros - n_frac_digits;
+    }
+    return rc;
+}
+
+const v_math_op vtab_mul_abs[4] = {
+    fpdec_mul_abs_shint_by_shint,
+    fpdec_mul_abs_shint_by_dyn,
+    fpdec_mul_abs_dyn_by_shint,
+    fpdec_mul_abs_dyn_by_dyn
+};
+
+error_t
+fpdec_mul(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(z);
+
+    if (FPDEC_EQ_ZERO(x) || FPDEC_EQ_ZERO(y))
+        return FPDEC_OK;
+
+    FPDEC_SIGN(z) = FPDEC_SIGN(x) * FPDEC_SIGN(y);
+    FPDEC_DEC_PREC(z) = FPDEC_DEC_PREC(x) + FPDEC_DEC_PREC(y);
+    if (FPDEC_DEC_PREC(z) < FPDEC_DEC_PREC(x))
+        ERROR(FPDEC_PREC_LIMIT_EXCEEDED);
+    if (FPDEC_DEC_PREC(z) <= MAX_DEC_PREC_FOR_SHINT ||
+        FPDEC_IS_DYN_ALLOC(x) || FPDEC_IS_DYN_ALLOC(y)) {
+        rc = DISPATCH_BIN_OP(vtab_mul_abs, z, x, y);
+    }
+    else
+        // force result to dyn variant
+        rc = fpdec_mul_abs_shint_by_shint_as_dyn(z, x, y);
+    if (FPDEC_IS_DYN_ALLOC(z))
+        fpdec_dyn_normalize(z);
+    return rc;
+}
+
+error_t
+fpdec_divmod_abs_dyn_by_dyn(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
+                            const fpdec_t *y, bool neg_quot) {
+    const fpdec_n_digits_t n_shift_x =
+        MAX(0, FPDEC_DYN_EXP(x) - FPDEC_DYN_EXP(y));
+    const fpdec_n_digits_t n_shift_y =
+        MAX(0, FPDEC_DYN_EXP(y) - FPDEC_DYN_EXP(x));
+    fpdec_digit_array_t *q_digits, *r_digits;
+
+    if (FPDEC_DYN_N_DIGITS(y) == 1 && n_shift_y == 0) {
+        fpdec_digit_t r_digit;
+        q_digits = digits_div_digit(x->digit_array, n_shift_x,
+                                    FPDEC_DYN_DIGITS(y)[0], &r_digit);
+        if (q_digits == NULL)
+            MEMERROR;
+        // adjust negativ quotient?
+        if (neg_quot && r_digit != 0) {
+            // Because there is a remainder,
+            // q_digits < x->digits * RADIX ^ n_shift_x.
+            // x->digits <= RADIX ^ x->n_signif - 1, so
+            // q_digits < RADIX ^ (x->n_signif + n_shift_x) - 1.
+            // That means we can safely increment q_digits.
+            digits_iadd_digit(q_digits, 1);
+            r_digit = FPDEC_DYN_DIGITS(y)[0] - r_digit;
+        }
+        // remainder is given in units of RADIX ^ y->exp
+        if (r_digit != 0) {
+            error_t rc = digits_from_digits(&r->digit_array, &r_digit, 1);
+            if (rc != FPDEC_OK) {
+                fpdec_mem_free(q_digits);
+                return rc;
+            }
+            r->dyn_alloc = true;
+            FPDEC_DYN_EXP(r) = FPDEC_DYN_EXP(y);
+        }
+    }
+    else {
+        q_digits = digits_divmod(x->digit_array, n_shift_x, y->digit_array,
+                                 n_shift_y, &r_digits);
+        if (q_digits == NULL) {
+            fpdec_mem_free(r_digits);
+            MEMERROR;
+        }
+        if (r_digits == NULL) {
+            fpdec_mem_free(q_digits);
+            MEMERROR;
+        }
+        r->digit_array = r_digits;
+        r->dyn_alloc = true;
+        FPDEC_DYN_EXP(r) = MIN(FPDEC_DYN_EXP(y), FPDEC_DYN_EXP(x));
+        // adjust negativ quotient?
+        if (neg_quot && !digits_all_zero(r_digits->digits,
+                                         r_digits->n_signif)) {
+            error_t rc;
+            fpdec_t t = *r;
+            *r = FPDEC_ZERO;
+            fpdec_dyn_normalize(&t);
+            rc = fpdec_sub(r, y, &t);
+            fpdec_reset_to_zero(&t, 0);
+            if (rc != FPDEC_OK) {
+                fpdec_mem_free(q_digits);
+                return rc;
+            }
+            // Safe to increment q_digits. See comment above.
+            digits_iadd_digit(q_digits, 1);
+        }
+    }
+    q->digit_array = q_digits;
+    q->dyn_alloc = true;
+    FPDEC_DYN_EXP(q) = 0;
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_divmod_abs_dyn_by_shint(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
+                              const fpdec_t *y, bool neg_quot) {
+    error_t rc;
+    fpdec_t y_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_divmod_abs_dyn_by_dyn(q, r, x, &y_dyn, neg_quot);
+        fpdec_reset_to_zero(&y_dyn, 0);
+    }
+    return rc;
+}
+
+error_t
+fpdec_divmod_abs_shint_by_dyn(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
+                              const fpdec_t *y, bool neg_quot) {
+    error_t rc;
+    fpdec_t x_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_divmod_abs_dyn_by_dyn(q, r, &x_dyn, y, neg_quot);
+        fpdec_reset_to_zero(&x_dyn, 0);
+    }
+    return rc;
+}
+
+error_t
+fpdec_divmod_abs_shint_by_shint(fpdec_t *q, fpdec_t *r, const fpdec_t *x,
+                                const fpdec_t *y, bool neg_quot) {
+    uint128_t q_shint = U128_FROM_SHINT(x);
     uint128_t y_shint = U128_FROM_SHINT(y);
     uint128_t r_shint;
 
     FPDEC_DEC_PREC(r) = make_adjusted_shints(&q_shint, &y_shint,
                                              FPDEC_DEC_PREC(x),
                                              FPDEC_DEC_PREC(y));
-    u128_idiv_u128(&r_shint, &q_shint, &y_shint);
-    // adjust negativ quotient?
-    if (neg_quot && U128_NE_ZERO(r_shint)) {
-        u128_incr(&q_shint);
-        u128_isub_u128(&y_shint, &r_shint);
-        r_shint = y_shint;
-    }
-    if (U128_FITS_SHINT(q_shint)) {
-        q->lo = U128_LO(q_shint);
-        q->hi = U128_HI(q_shint);
-        r->lo = U128_LO(r_shint);
-        r->hi = U128_HI(r_shint);
-        return FPDEC_OK;
+    if (!SHINTS_OVERFLOWED(&q_shint, &y_shint)) {
+        u128_idiv_u128(&r_shint, &q_shint, &y_shint);
+        // adjust negativ quotient?
+        if (neg_quot && U128_NE_ZERO(r_shint)) {
+            u128_incr(&q_shint);
+            u128_isub_u128(&y_shint, &r_shint);
+            r_shint = y_shint;
+        }
+        if (U128_FITS_SHINT(q_shint) && U128_FITS_SHINT(r_shint)) {
+            q->lo = U128_LO(q_shint);
+            q->hi = U128_HI(q_shint);
+            r->lo = U128_LO(r_shint);
+            r->hi = U128_HI(r_shint);
+            return FPDEC_OK;
+        }
     }
-    else {
+    // adjusted operands or results exceed the shint limits
+    {
         error_t rc;
         fpdec_t x_dyn;
         rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
@@ -2147,7 +4724,9 @@ fpdec_div_abs_dyn_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
             // result < 10 ^ -prec_limit (before rounding)
             // and may be rounded to 10 ^ -prec_limit
             fpdec_digit_t digit = u64_10_pow_n(d_shift);
-            digit *= round_qr(FPDEC_SIGN(z), 0, 0, true, digit, rounding);
+            // (divisor 0 means 2 ^ 64, so that the remainder is less than
+            // half of it even if digit == 1)
+            digit *= round_qr(FPDEC_SIGN(z), 0, 0, true, 0, rounding);
             if (digit != 0) {
                 FPDEC_DYN_EXP(z) = -prec_limit / DEC_DIGITS_PER_DIGIT;
                 rc = digits_from_digits(&(z->digit_array), &digit, 1);
@@ -2157,163 +4736,891 @@ fpdec_div_abs_dyn_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
             }
         }
     }
-    return FPDEC_OK;
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_div_abs_dyn_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                           const int prec_limit,
+                           const enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+    fpdec_t y_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_div_abs_dyn_by_dyn(z, x, &y_dyn, prec_limit, rounding);
+        fpdec_reset_to_zero(&y_dyn, 0);
+    }
+    return rc;
+}
+
+error_t
+fpdec_div_abs_shint_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                           const int prec_limit,
+                           const enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+    fpdec_t x_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_div_abs_dyn_by_dyn(z, &x_dyn, y, prec_limit, rounding);
+        fpdec_reset_to_zero(&x_dyn, 0);
+    }
+    return rc;
+}
+
+error_t
+fpdec_div_shints_as_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                        const int prec_limit,
+                        const enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+    fpdec_t x_dyn;
+    fpdec_t y_dyn;
+
+    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
+    if (rc == FPDEC_OK) {
+        rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+        if (rc == FPDEC_OK) {
+            rc = fpdec_div_abs_dyn_by_dyn(z, &x_dyn, &y_dyn, prec_limit,
+                                          rounding);
+            fpdec_reset_to_zero(&y_dyn, 0);
+        }
+        fpdec_reset_to_zero(&x_dyn, 0);
+    }
+    return rc;
+}
+
+error_t
+fpdec_div_abs_shint_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                             const int prec_limit,
+                             const enum FPDEC_ROUNDING_MODE rounding) {
+    uint128_t divident = U128_FROM_SHINT(x);
+    uint128_t divisor = U128_FROM_SHINT(y);
+    uint128_t rem = UINT128_ZERO;
+    int shift;
+    unsigned n_trailing_zeros;
+
+    if (prec_limit == -1)
+        shift = MAX_DEC_PREC_FOR_SHINT - FPDEC_DEC_PREC(x) +
+                FPDEC_DEC_PREC(y);
+    else
+        shift = MIN(prec_limit, MAX_DEC_PREC_FOR_SHINT) - FPDEC_DEC_PREC(x) +
+                FPDEC_DEC_PREC(y);
+    if (shift > 0) {
+        // 0 < shift <= 36
+        if (shift > UINT64_10_POW_N_CUTOFF) {
+            u128_imul_10_pow_n(&divident, UINT64_10_POW_N_CUTOFF);
+            u128_imul_10_pow_n(&divident, shift - UINT64_10_POW_N_CUTOFF);
+        }
+        else
+            u128_imul_10_pow_n(&divident, shift);
+        if (UINT128_CHECK_MAX(&divident))
+            // divident possibly overflowed
+            return fpdec_div_shints_as_dyn(z, x, y, prec_limit, rounding);
+    }
+    else if (shift < 0) {
+        // -18 <= shift < 0
+        u128_imul_10_pow_n(&divisor, -shift);
+        if (UINT128_CHECK_MAX(&divisor))
+            // divisor possibly overflowed
+            return fpdec_div_shints_as_dyn(z, x, y, prec_limit, rounding);
+    }
+    u128_idiv_u128(&rem, &divident, &divisor);
+    if (U128_NE_ZERO(rem)) {
+        if (prec_limit == -1 || prec_limit > MAX_DEC_PREC_FOR_SHINT) {
+            // result is not exact enough
+            return fpdec_div_shints_as_dyn(z, x, y, prec_limit, rounding);
+        }
+        else {
+            // result (in divident) truncated to prec_limit, check rounding
+            if (round_u128(FPDEC_SIGN(z), &divident, &rem, &divisor,
+                           rounding))
+                u128_incr(&divident);
+            FPDEC_DEC_PREC(z) = prec_limit;
+        }
+    }
+    else {
+        if (prec_limit == -1 && shift > 0) {
+            shift = MIN(shift, MAX_DEC_PREC_FOR_SHINT);
+            n_trailing_zeros = u128_eliminate_trailing_zeros(&divident,
+                                                             shift);
+            FPDEC_DEC_PREC(z) = MAX_DEC_PREC_FOR_SHINT - n_trailing_zeros;
+        }
+        else if (prec_limit > MAX_DEC_PREC_FOR_SHINT) {
+            error_t rc;
+            FPDEC_DEC_PREC(z) = MAX_DEC_PREC_FOR_SHINT;
+            rc = fpdec_set_dyn_coeff(z, U128_LO(divident),
+                                     U128_HI(divident));
+            FPDEC_DEC_PREC(z) = prec_limit;
+            return rc;
+        }
+        else
+            FPDEC_DEC_PREC(z) = prec_limit;
+    }
+    if (U128_FITS_SHINT(divident)) {
+        z->lo = U128_LO(divident);
+        z->hi = U128_HI(divident);
+        return FPDEC_OK;
+    }
+    else
+        return fpdec_set_dyn_coeff(z, U128_LO(divident), U128_HI(divident));
+}
+
+typedef error_t (*v_div_op)(fpdec_t *, const fpdec_t *, const fpdec_t *,
+                            const int, const enum FPDEC_ROUNDING_MODE);
+
+const v_div_op vtab_div_abs[4] = {
+    fpdec_div_abs_shint_by_shint,
+    fpdec_div_abs_shint_by_dyn,
+    fpdec_div_abs_dyn_by_shint,
+    fpdec_div_abs_dyn_by_dyn
+};
+
+error_t
+fpdec_div(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+          const int prec_limit, const enum FPDEC_ROUNDING_MODE rounding) {
+    error_t rc;
+
+    ASSERT_FPDEC_IS_ZEROED(z);
+    assert(prec_limit >= -1);
+    assert(prec_limit <= FPDEC_MAX_DEC_PREC);
+
+    if (FPDEC_EQ_ZERO(y))
+        ERROR(FPDEC_DIVIDE_BY_ZERO);
+
+    if (FPDEC_EQ_ZERO(x))
+        return FPDEC_OK;
+
+    FPDEC_SIGN(z) = FPDEC_SIGN(x) * FPDEC_SIGN(y);
+    rc = DISPATCH_BIN_OP_VA(vtab_div_abs, z, x, y, prec_limit, rounding);
+    if (rc != FPDEC_OK)
+        return rc;
+
+    if (FPDEC_IS_DYN_ALLOC(z))
+        fpdec_dyn_normalize(z);
+    else {
+        if (z->lo == 0 && z->hi == 0)
+            FPDEC_SIGN(z) = FPDEC_SIGN_ZERO;
+    }
+    return FPDEC_OK;
+}
+
+// Batch operations
+
+// The fast variants handle the common case of two non-zero shints without
+// any dispatch; they return false (leaving z untouched) if the operands do
+// not qualify or the result does not fit into a shint.
+
+static inline bool
+fpdec_add_shints_fast(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                      const fpdec_sign_t y_sign) {
+    const fpdec_sign_t x_sign = FPDEC_SIGN(x);
+    uint128_t x_shint, y_shint;
+    fpdec_dec_prec_t dec_prec;
+
+    if (FPDEC_IS_DYN_ALLOC(x) || FPDEC_IS_DYN_ALLOC(y) ||
+        x_sign == FPDEC_SIGN_ZERO || y_sign == FPDEC_SIGN_ZERO)
+        return false;
+
+    x_shint = U128_FROM_SHINT(x);
+    y_shint = U128_FROM_SHINT(y);
+    dec_prec = make_adjusted_shints(&x_shint, &y_shint, FPDEC_DEC_PREC(x),
+                                    FPDEC_DEC_PREC(y));
+    if (SHINTS_OVERFLOWED(&x_shint, &y_shint))
+        return false;
+    if (x_sign == y_sign) {
+        u128_iadd_u128(&x_shint, &y_shint);
+        if (u128_cmp(x_shint, y_shint) < 0)     // sum overflowed
+            return false;
+        FPDEC_SIGN(z) = x_sign;
+    }
+    else {
+        switch (u128_cmp(x_shint, y_shint)) {
+            case 1:
+                u128_isub_u128(&x_shint, &y_shint);
+                FPDEC_SIGN(z) = x_sign;
+                break;
+            case -1:
+                u128_isub_u128(&y_shint, &x_shint);
+                x_shint = y_shint;
+                FPDEC_SIGN(z) = y_sign;
+                break;
+            default:
+                // x + y = 0
+                FPDEC_DEC_PREC(z) = dec_prec;
+                return true;
+        }
+    }
+    if (!U128_FITS_SHINT(x_shint)) {
+        FPDEC_SIGN(z) = FPDEC_SIGN_ZERO;
+        return false;
+    }
+    FPDEC_DEC_PREC(z) = dec_prec;
+    z->lo = U128_LO(x_shint);
+    z->hi = U128_HI(x_shint);
+    return true;
+}
+
+static inline bool
+fpdec_add_fast(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    return fpdec_add_shints_fast(z, x, y, FPDEC_SIGN(y));
+}
+
+static inline bool
+fpdec_sub_fast(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    return fpdec_add_shints_fast(z, x, y, -FPDEC_SIGN(y));
+}
+
+static inline bool
+fpdec_mul_fast(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    uint128_t z_shint;
+    unsigned dec_prec = FPDEC_DEC_PREC(x) + FPDEC_DEC_PREC(y);
+
+    if (FPDEC_IS_DYN_ALLOC(x) || FPDEC_IS_DYN_ALLOC(y) ||
+        FPDEC_EQ_ZERO(x) || FPDEC_EQ_ZERO(y) || x->hi != 0 || y->hi != 0 ||
+        dec_prec > MAX_DEC_PREC_FOR_SHINT)
+        return false;
+
+    u64_mul_u64(&z_shint, x->lo, y->lo);
+    if (!U128_FITS_SHINT(z_shint))
+        return false;
+    FPDEC_SIGN(z) = FPDEC_SIGN(x) * FPDEC_SIGN(y);
+    FPDEC_DEC_PREC(z) = dec_prec;
+    z->lo = U128_LO(z_shint);
+    z->hi = U128_HI(z_shint);
+    return true;
+}
+
+typedef bool (*v_fast_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+
+// y_stride == 0 => y is a scalar
+static inline error_t
+fpdec_apply_op_n(v_fast_op fast_op, v_math_op op, fpdec_t *z,
+                 const fpdec_t *x, const fpdec_t *y, const size_t y_stride,
+                 const size_t n) {
+    error_t rc;
+
+    for (size_t i = 0; i < n; ++i, y += y_stride) {
+        ASSERT_FPDEC_IS_ZEROED(z + i);
+        if (fast_op(z + i, x + i, y))
+            continue;
+        rc = op(z + i, x + i, y);
+        if (rc != FPDEC_OK) {
+            for (size_t j = 0; j <= i; ++j)
+                fpdec_reset_to_zero(z + j, 0);
+            return rc;
+        }
+    }
+    return FPDEC_OK;
+}
+
+error_t
+fpdec_add_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n) {
+    return fpdec_apply_op_n(fpdec_add_fast, fpdec_add, z, x, y, 1, n);
+}
+
+error_t
+fpdec_sub_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n) {
+    return fpdec_apply_op_n(fpdec_sub_fast, fpdec_sub, z, x, y, 1, n);
+}
+
+error_t
+fpdec_mul_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n) {
+    return fpdec_apply_op_n(fpdec_mul_fast, fpdec_mul, z, x, y, 1, n);
+}
+
+error_t
+fpdec_add_scalar_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                   size_t n) {
+    return fpdec_apply_op_n(fpdec_add_fast, fpdec_add, z, x, y, 0, n);
+}
+
+error_t
+fpdec_mul_scalar_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
+                   size_t n) {
+    return fpdec_apply_op_n(fpdec_mul_fast, fpdec_mul, z, x, y, 0, n);
+}
+
+void
+fpdec_compare_n(int *res, const fpdec_t *x, const fpdec_t *y, size_t n,
+                bool ignore_sign) {
+    for (size_t i = 0; i < n; ++i)
+        res[i] = fpdec_compare(x + i, y + i, ignore_sign);
+}
+
+void
+fpdec_compare_scalar_n(int *res, const fpdec_t *x, const fpdec_t *y,
+                       size_t n, bool ignore_sign) {
+    for (size_t i = 0; i < n; ++i)
+        res[i] = fpdec_compare(x + i, y, ignore_sign);
+}
+
+// In-place operations
+
+// The following functions operate on the digit array of x (which must be
+// different from y) and return false, leaving x unchanged, if its exponent
+// is greater than that of y or its capacity does not suffice.
+
+static bool
+fpdec_dyn_iadd_abs(fpdec_t *x, const fpdec_t *y) {
+    digits_view_t y_view;
+
+    assert(FPDEC_IS_DYN_ALLOC(x));
+    assert(x != y);
+
+    fpdec_get_digits_view(&y_view, y);
+    if (y_view.exp < FPDEC_DYN_EXP(x) ||
+        !digits_iadd_digits_shifted(x->digit_array, y_view.digits,
+                                    y_view.n_digits,
+                                    y_view.exp - FPDEC_DYN_EXP(x)))
+        return false;
+    FPDEC_DEC_PREC(x) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
+    FPDEC_DYN_EXP(x) += digits_eliminate_trailing_zeros(x->digit_array);
+    return true;
+}
+
+// pre-condition: |x| > |y|
+static bool
+fpdec_dyn_isub_abs(fpdec_t *x, const fpdec_t *y) {
+    digits_view_t y_view;
+
+    assert(FPDEC_IS_DYN_ALLOC(x));
+    assert(x != y);
+
+    fpdec_get_digits_view(&y_view, y);
+    if (y_view.exp < FPDEC_DYN_EXP(x) ||
+        !digits_isub_digits_shifted(x->digit_array, y_view.digits,
+                                    y_view.n_digits,
+                                    y_view.exp - FPDEC_DYN_EXP(x)))
+        return false;
+    FPDEC_DEC_PREC(x) = MAX(FPDEC_DEC_PREC(x), FPDEC_DEC_PREC(y));
+    fpdec_dyn_normalize(x);
+    return true;
+}
+
+// Handles y being a shint with a coefficient < RADIX
+static bool
+fpdec_dyn_imul_abs(fpdec_t *x, const fpdec_t *y,
+                   const fpdec_dec_prec_t dec_prec) {
+    fpdec_digit_array_t *x_digits = x->digit_array;
+    fpdec_dec_prec_t y_dec_prec = FPDEC_DEC_PREC(y);
+    uint128_t f;
+
+    assert(FPDEC_IS_DYN_ALLOC(x));
+
+    if (FPDEC_IS_DYN_ALLOC(y) || y->hi != 0 || y->lo >= RADIX)
+        return false;
+    if (y_dec_prec == 0) {
+        if (x_digits->n_signif >= x_digits->n_alloc)
+            return false;
+        digits_imul_digit(x_digits, y->lo);
+    }
+    else {
+        // x * y = x * y->lo * 10 ^ (DEC_DIGITS_PER_DIGIT - y_dec_prec) / RADIX
+        if (FPDEC_DYN_EXP(x) == INT32_MIN)
+            return false;
+        u64_mul_u64(&f, y->lo,
+                    u64_10_pow_n(DEC_DIGITS_PER_DIGIT - y_dec_prec));
+        if (U128_HI(f) == 0 && U128_LO(f) < RADIX) {
+            if (x_digits->n_signif >= x_digits->n_alloc)
+                return false;
+            digits_imul_digit(x_digits, U128_LO(f));
+        }
+        else {
+            if (x_digits->n_signif + 1 >= x_digits->n_alloc)
+                return false;
+            digits_imul_digit(x_digits, y->lo);
+            digits_imul_digit(x_digits, u64_10_pow_n(DEC_DIGITS_PER_DIGIT -
+                                                     y_dec_prec));
+        }
+        FPDEC_DYN_EXP(x)--;
+    }
+    FPDEC_SIGN(x) *= FPDEC_SIGN(y);
+    FPDEC_DEC_PREC(x) = dec_prec;
+    fpdec_dyn_normalize(x);
+    return true;
+}
+
+// Replaces x by z, the result of op applied to x and y
+static error_t
+fpdec_apply_op_in_place(v_fast_op fast_op, v_math_op op, fpdec_t *x,
+                        const fpdec_t *y) {
+    fpdec_t z = FPDEC_ZERO;
+    error_t rc;
+
+    if (fast_op(&z, x, y)) {
+        // x is a shint here, so nothing to free
+        *x = z;
+        return FPDEC_OK;
+    }
+    rc = op(&z, x, y);
+    if (rc == FPDEC_OK) {
+        fpdec_reset_to_zero(x, 0);
+        *x = z;
+    }
+    return rc;
+}
+
+static error_t
+fpdec_iadd_signed(fpdec_t *x, const fpdec_t *y, const fpdec_sign_t y_sign) {
+    if (FPDEC_IS_DYN_ALLOC(x) && x != y && y_sign != FPDEC_SIGN_ZERO) {
+        if (FPDEC_SIGN(x) == y_sign) {
+            if (fpdec_dyn_iadd_abs(x, y))
+                return FPDEC_OK;
+        }
+        else if (fpdec_compare(x, y, true) == 1 && fpdec_dyn_isub_abs(x, y))
+            return FPDEC_OK;
+    }
+    if (y_sign == FPDEC_SIGN(y))
+        return fpdec_apply_op_in_place(fpdec_add_fast, fpdec_add, x, y);
+    else
+        return fpdec_apply_op_in_place(fpdec_sub_fast, fpdec_sub, x, y);
 }
 
 error_t
-fpdec_div_abs_dyn_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
-                           const int prec_limit,
-                           const enum FPDEC_ROUNDING_MODE rounding) {
+fpdec_iadd(fpdec_t *x, const fpdec_t *y) {
+    return fpdec_iadd_signed(x, y, FPDEC_SIGN(y));
+}
+
+error_t
+fpdec_isub(fpdec_t *x, const fpdec_t *y) {
+    return fpdec_iadd_signed(x, y, -FPDEC_SIGN(y));
+}
+
+error_t
+fpdec_imul(fpdec_t *x, const fpdec_t *y) {
+    fpdec_dec_prec_t dec_prec = FPDEC_DEC_PREC(x) + FPDEC_DEC_PREC(y);
+
+    if (FPDEC_IS_DYN_ALLOC(x) && x != y && !FPDEC_EQ_ZERO(y) &&
+        dec_prec >= FPDEC_DEC_PREC(x) && fpdec_dyn_imul_abs(x, y, dec_prec))
+        return FPDEC_OK;
+    return fpdec_apply_op_in_place(fpdec_mul_fast, fpdec_mul, x, y);
+}
+
+error_t
+fpdec_idiv(fpdec_t *x, const fpdec_t *y, int prec_limit,
+           enum FPDEC_ROUNDING_MODE rounding) {
+    fpdec_t z = FPDEC_ZERO;
     error_t rc;
-    fpdec_t y_dyn;
 
-    rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
+    rc = fpdec_div(&z, x, y, prec_limit, rounding);
     if (rc == FPDEC_OK) {
-        rc = fpdec_div_abs_dyn_by_dyn(z, x, &y_dyn, prec_limit, rounding);
-        fpdec_reset_to_zero(&y_dyn, 0);
+        fpdec_reset_to_zero(x, 0);
+        *x = z;
     }
     return rc;
 }
 
-error_t
-fpdec_div_abs_shint_by_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
-                           const int prec_limit,
-                           const enum FPDEC_ROUNDING_MODE rounding) {
-    error_t rc;
-    fpdec_t x_dyn;
+// Accumulator
 
-    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_div_abs_dyn_by_dyn(z, &x_dyn, y, prec_limit, rounding);
-        fpdec_reset_to_zero(&x_dyn, 0);
+void
+fpdec_accumulator_init(fpdec_accumulator_t *acc) {
+    memset((void *)acc, 0, sizeof(fpdec_accumulator_t));
+}
+
+// Sets *enlarged to a copy of reg shifted by n_shift digits with room for
+// at least n_needed digits, or to NULL if reg can be used as it is
+static error_t
+accumulator_enlarged(fpdec_digit_array_t **enlarged,
+                     const fpdec_digit_array_t *reg,
+                     fpdec_n_digits_t n_shift, size_t n_needed) {
+    size_t n_alloc = reg == NULL ? 0 : reg->n_alloc;
+
+    *enlarged = NULL;
+    if (n_shift == 0 && n_needed <= n_alloc)
+        return FPDEC_OK;
+    // grow geometrically to make reallocations rare
+    n_alloc = MAX(MAX(n_needed, 2 * n_alloc), 4);
+    if (n_alloc > UINT32_MAX)
+        ERROR(FPDEC_N_DIGITS_LIMIT_EXCEEDED);
+    *enlarged = digits_enlarged(reg, n_shift, n_alloc);
+    if (*enlarged == NULL)
+        MEMERROR;
+    return FPDEC_OK;
+}
+
+static inline void
+accumulator_replace(fpdec_digit_array_t **reg,
+                    fpdec_digit_array_t *enlarged) {
+    if (enlarged != NULL) {
+        if (*reg != NULL)
+            fpdec_mem_free(*reg);
+        *reg = enlarged;
     }
+}
+
+// Replaces *reg by a copy with room for at least n_needed digits, if
+// necessary
+static error_t
+accumulator_reserve(fpdec_digit_array_t **reg, size_t n_needed) {
+    fpdec_digit_array_t *enlarged;
+    error_t rc;
+
+    rc = accumulator_enlarged(&enlarged, *reg, 0, n_needed);
+    if (rc == FPDEC_OK)
+        accumulator_replace(reg, enlarged);
     return rc;
 }
 
-error_t
-fpdec_div_shints_as_dyn(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
-                        const int prec_limit,
-                        const enum FPDEC_ROUNDING_MODE rounding) {
+static error_t
+accumulator_add_digits(fpdec_accumulator_t *acc, fpdec_sign_t sign,
+                       const fpdec_digit_t *digits, fpdec_n_digits_t n_digits,
+                       fpdec_exp_t exp) {
+    fpdec_digit_array_t **reg = sign == FPDEC_SIGN_NEG ? &acc->neg : &acc->pos;
+    fpdec_n_digits_t n_signif, n_shift;
     error_t rc;
-    fpdec_t x_dyn;
-    fpdec_t y_dyn;
 
-    rc = fpdec_copy_shint_as_dyn(&x_dyn, x);
-    if (rc == FPDEC_OK) {
-        rc = fpdec_copy_shint_as_dyn(&y_dyn, y);
-        if (rc == FPDEC_OK) {
-            rc = fpdec_div_abs_dyn_by_dyn(z, &x_dyn, &y_dyn, prec_limit,
-                                          rounding);
-            fpdec_reset_to_zero(&y_dyn, 0);
+    assert(n_digits > 0);
+
+    if (acc->pos == NULL && acc->neg == NULL)
+        acc->exp = exp;
+    else if (exp < acc->exp) {
+        // align the registers to the smaller exponent; both are replaced
+        // only after both shifted copies have been allocated, so that the
+        // accumulator is left unchanged if that fails
+        fpdec_digit_array_t *pos = NULL, *neg = NULL;
+        n_shift = acc->exp - exp;
+        if (acc->pos != NULL) {
+            rc = accumulator_enlarged(&pos, acc->pos, n_shift,
+                                      (size_t)acc->pos->n_signif + n_shift +
+                                      1);
+            if (rc != FPDEC_OK)
+                return rc;
         }
-        fpdec_reset_to_zero(&x_dyn, 0);
+        if (acc->neg != NULL) {
+            rc = accumulator_enlarged(&neg, acc->neg, n_shift,
+                                      (size_t)acc->neg->n_signif + n_shift +
+                                      1);
+            if (rc != FPDEC_OK) {
+                if (pos != NULL)
+                    fpdec_mem_free(pos);
+                return rc;
+            }
+        }
+        accumulator_replace(&acc->pos, pos);
+        accumulator_replace(&acc->neg, neg);
+        acc->exp = exp;
     }
+    n_shift = exp - acc->exp;
+    n_signif = *reg == NULL ? 0 : (*reg)->n_signif;
+    rc = accumulator_reserve(reg, MAX((size_t)n_signif,
+                                      (size_t)n_shift + n_digits) + 1);
+    if (rc != FPDEC_OK)
+        return rc;
+    digits_iadd_digits_shifted(*reg, digits, n_digits, n_shift);
+    return FPDEC_OK;
+}
+
+// Moves the pending sum into the corresponding register
+static error_t
+accumulator_flush_pending(fpdec_accumulator_t *acc, fpdec_sign_t sign) {
+    uint128_t *pending = sign == FPDEC_SIGN_NEG ? &acc->pending_neg :
+                         &acc->pending_pos;
+    fpdec_digit_t digits[3];
+    int n_trailing_zeros;
+    fpdec_n_digits_t n_digits;
+    error_t rc;
+
+    if (U128P_EQ_ZERO(pending))
+        return FPDEC_OK;
+    n_digits = du64_to_digits(digits, &n_trailing_zeros, U128P_LO(pending),
+                              U128P_HI(pending), acc->pending_prec);
+    rc = accumulator_add_digits(acc, sign, digits, n_digits,
+                                n_trailing_zeros -
+                                CEIL(acc->pending_prec, DEC_DIGITS_PER_DIGIT));
+    if (rc == FPDEC_OK)
+        U128_FROM_LO_HI(pending, 0, 0);
     return rc;
 }
 
+static error_t
+accumulator_flush(fpdec_accumulator_t *acc) {
+    error_t rc;
+
+    rc = accumulator_flush_pending(acc, FPDEC_SIGN_POS);
+    if (rc != FPDEC_OK)
+        return rc;
+    return accumulator_flush_pending(acc, FPDEC_SIGN_NEG);
+}
+
+// Adds the coefficient t (< 2 ^ 124) with dec_prec fractional digits to the
+// pending sum, if possible without loss; returns false otherwise.
+static bool
+accumulator_add_to_pending(fpdec_accumulator_t *acc, fpdec_sign_t sign,
+                           uint128_t t, fpdec_dec_prec_t dec_prec) {
+    uint128_t *pending = sign == FPDEC_SIGN_NEG ? &acc->pending_neg :
+                         &acc->pending_pos;
+
+    assert(U128_HI(t) < (1ULL << 60U));
+    assert(dec_prec <= MAX_DEC_PREC_FOR_SHINT);
+
+    if (dec_prec > acc->pending_prec) {
+        // raise the precision of the pending sums, which have to be moved
+        // to the registers before
+        if (accumulator_flush(acc) != FPDEC_OK)
+            return false;
+        acc->pending_prec = dec_prec;
+    }
+    else if (dec_prec < acc->pending_prec) {
+        if (U128_HI(t) != 0)
+            return false;
+        // < 2 ^ 124
+        u64_mul_u64(&t, U128_LO(t),
+                    u64_10_pow_n(acc->pending_prec - dec_prec));
+    }
+    // keep the pending sum < 2 ^ 126, so that it fits into 3 digits
+    if (U128P_HI(pending) >= (1ULL << 61U) &&
+        accumulator_flush_pending(acc, sign) != FPDEC_OK)
+        return false;
+    u128_iadd_u128(pending, &t);
+    return true;
+}
+
+static inline bool
+accumulator_add_shint(fpdec_accumulator_t *acc, fpdec_sign_t sign,
+                      const fpdec_t *x) {
+    uint128_t t = U128_RHS(x->lo, x->hi);
+
+    return accumulator_add_to_pending(acc, sign, t, FPDEC_DEC_PREC(x));
+}
+
+static error_t
+accumulator_add_signed(fpdec_accumulator_t *acc, const fpdec_t *x,
+                       fpdec_sign_t sign) {
+    digits_view_t x_view;
+    error_t rc;
+
+    // like fpdec_add, adding zero does not change the sum
+    if (sign == FPDEC_SIGN_ZERO)
+        return FPDEC_OK;
+    if (FPDEC_IS_DYN_ALLOC(x) ||
+        !accumulator_add_shint(acc, sign, x)) {
+        fpdec_get_digits_view(&x_view, x);
+        rc = accumulator_add_digits(acc, sign, x_view.digits,
+                                    x_view.n_digits, x_view.exp);
+        if (rc != FPDEC_OK)
+            return rc;
+    }
+    acc->dec_prec = MAX(acc->dec_prec, FPDEC_DEC_PREC(x));
+    return FPDEC_OK;
+}
+
 error_t
-fpdec_div_abs_shint_by_shint(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
-                             const int prec_limit,
-                             const enum FPDEC_ROUNDING_MODE rounding) {
-    uint128_t divident = U128_FROM_SHINT(x);
-    uint128_t divisor = U128_FROM_SHINT(y);
-    uint128_t rem = UINT128_ZERO;
-    int shift;
-    unsigned n_trailing_zeros;
+fpdec_accumulator_add(fpdec_accumulator_t *acc, const fpdec_t *x) {
+    return accumulator_add_signed(acc, x, FPDEC_SIGN(x));
+}
 
-    if (prec_limit == -1)
-        shift = MAX_DEC_PREC_FOR_SHINT - FPDEC_DEC_PREC(x) +
-                FPDEC_DEC_PREC(y);
+error_t
+fpdec_accumulator_sub(fpdec_accumulator_t *acc, const fpdec_t *x) {
+    return accumulator_add_signed(acc, x, -FPDEC_SIGN(x));
+}
+
+error_t
+fpdec_accumulator_add_long_long(fpdec_accumulator_t *acc, long long val) {
+    fpdec_sign_t sign = val < 0 ? FPDEC_SIGN_NEG : FPDEC_SIGN_POS;
+    fpdec_digit_t digit;
+    uint128_t t;
+
+    if (val == 0)
+        return FPDEC_OK;
+    // |LLONG_MIN| can't be represented as long long
+    digit = val < 0 ? (fpdec_digit_t)(-(val + 1)) + 1 : (fpdec_digit_t)val;
+    U128_FROM_LO_HI(&t, digit, 0);
+    if (accumulator_add_to_pending(acc, sign, t, 0))
+        return FPDEC_OK;
+    return accumulator_add_digits(acc, sign, &digit, 1, 0);
+}
+
+error_t
+fpdec_accumulator_result(fpdec_t *z, fpdec_accumulator_t *acc) {
+    fpdec_digit_array_t *pos, *neg, *diff;
+    fpdec_n_digits_t n_pos, n_neg;
+    error_t rc;
+    int cmp;
+
+    ASSERT_FPDEC_IS_ZEROED(z);
+
+    if (acc->pos == NULL && acc->neg == NULL) {
+        // only 128-bit sums, the result may fit into a shifted int
+        uint128_t t;
+
+        cmp = u128_cmp(acc->pending_pos, acc->pending_neg);
+        if (cmp > 0)
+            u128_sub_u128(&t, &acc->pending_pos, &acc->pending_neg);
+        else
+            u128_sub_u128(&t, &acc->pending_neg, &acc->pending_pos);
+        if (cmp == 0) {
+            FPDEC_DEC_PREC(z) = acc->dec_prec;
+            return FPDEC_OK;
+        }
+        if (U128_HI(t) <= UINT32_MAX) {
+            FPDEC_SIGN(z) = cmp > 0 ? FPDEC_SIGN_POS : FPDEC_SIGN_NEG;
+            FPDEC_DEC_PREC(z) = acc->pending_prec;
+            z->lo = U128_LO(t);
+            z->hi = (uint32_t)U128_HI(t);
+            rc = fpdec_adjust(z, acc->dec_prec, FPDEC_ROUND_DEFAULT);
+            if (rc != FPDEC_OK)
+                fpdec_reset_to_zero(z, 0);
+            return rc;
+        }
+    }
+
+    rc = accumulator_flush(acc);
+    if (rc != FPDEC_OK)
+        return rc;
+
+    pos = acc->pos;
+    neg = acc->neg;
+    n_pos = pos == NULL ? 0 : pos->n_signif;
+    n_neg = neg == NULL ? 0 : neg->n_signif;
+    // the registers are aligned at their least significant digit
+    if (n_pos != n_neg)
+        cmp = CMP(n_pos, n_neg);
+    else if (n_pos == 0)
+        cmp = 0;
     else
-        shift = MIN(prec_limit, MAX_DEC_PREC_FOR_SHINT) - FPDEC_DEC_PREC(x) +
-                FPDEC_DEC_PREC(y);
-    if (shift > 0) {
-        u128_imul_10_pow_n(&divident, shift);
-        if (UINT128_CHECK_MAX(&divident))
-            // divident possibly overflowed
-            return fpdec_div_shints_as_dyn(z, x, y, prec_limit, rounding);
+        cmp = digits_cmp(pos->digits, n_pos, neg->digits, n_neg);
+
+    if (cmp == 0) {
+        FPDEC_DEC_PREC(z) = acc->dec_prec;
+        return FPDEC_OK;
     }
-    else if (shift < 0)
-        // divisor < 2^96 and shift >= -9 => divisor * 10^-shift < 2^128
-        u128_imul_10_pow_n(&divisor, -shift);
-    u128_idiv_u128(&rem, &divident, &divisor);
-    if (U128_NE_ZERO(rem)) {
-        if (prec_limit == -1 || prec_limit > MAX_DEC_PREC_FOR_SHINT) {
-            // result is not exact enough
-            return fpdec_div_shints_as_dyn(z, x, y, prec_limit, rounding);
+    if (n_neg == 0)
+        rc = fpdec_from_sign_digits_exp(z, FPDEC_SIGN_POS, n_pos, pos->digits,
+                                        acc->exp);
+    else if (n_pos == 0)
+        rc = fpdec_from_sign_digits_exp(z, FPDEC_SIGN_NEG, n_neg, neg->digits,
+                                        acc->exp);
+    else {
+        if (cmp > 0) {
+            diff = digits_copy(pos, 0, 0);
+            if (diff == NULL)
+                MEMERROR;
+            digits_isub_digits_shifted(diff, neg->digits, n_neg, 0);
         }
         else {
-            // result (in divident) truncated to prec_limit, check rounding
-            if (round_u128(FPDEC_SIGN(z), &divident, &rem, &divisor,
-                           rounding))
-                u128_incr(&divident);
-            FPDEC_DEC_PREC(z) = prec_limit;
+            diff = digits_copy(neg, 0, 0);
+            if (diff == NULL)
+                MEMERROR;
+            digits_isub_digits_shifted(diff, pos->digits, n_pos, 0);
         }
+        rc = fpdec_from_sign_digits_exp(z, cmp > 0 ? FPDEC_SIGN_POS :
+                                           FPDEC_SIGN_NEG,
+                                        diff->n_signif, diff->digits,
+                                        acc->exp);
+        fpdec_mem_free(diff);
     }
-    else {
-        if (prec_limit == -1 && shift > 0) {
-            shift = MIN(shift, MAX_DEC_PREC_FOR_SHINT);
-            n_trailing_zeros = u128_eliminate_trailing_zeros(&divident,
-                                                             shift);
-            FPDEC_DEC_PREC(z) = MAX_DEC_PREC_FOR_SHINT - n_trailing_zeros;
-        }
-        else if (prec_limit > MAX_DEC_PREC_FOR_SHINT) {
-            FPDEC_DEC_PREC(z) = MAX_DEC_PREC_FOR_SHINT;
-            z->lo = U128_LO(divident);
-            z->hi = U128_HI(divident);
-            fpdec_shint_to_dyn(z);
-            FPDEC_DEC_PREC(z) = prec_limit;
+    if (rc != FPDEC_OK)
+        return rc;
+    // exact, because no value added has more fractional digits
+    rc = fpdec_adjust(z, acc->dec_prec, FPDEC_ROUND_DEFAULT);
+    if (rc != FPDEC_OK)
+        fpdec_reset_to_zero(z, 0);
+    return rc;
+}
+
+void
+fpdec_accumulator_reset(fpdec_accumulator_t *acc) {
+    if (acc->pos != NULL)
+        fpdec_mem_free(acc->pos);
+    if (acc->neg != NULL)
+        fpdec_mem_free(acc->neg);
+    fpdec_accumulator_init(acc);
+}
+
+error_t
+fpdec_accumulator_add_product(fpdec_accumulator_t *acc, const fpdec_t *x,
+                              const fpdec_t *y) {
+    fpdec_sign_t sign = FPDEC_SIGN(x) * FPDEC_SIGN(y);
+    unsigned dec_prec = FPDEC_DEC_PREC(x) + FPDEC_DEC_PREC(y);
+    digits_view_t x_view, y_view;
+    fpdec_digit_t digits[16];
+    fpdec_n_digits_t n_digits;
+    fpdec_t prod;
+    uint128_t t;
+    int64_t exp;
+    error_t rc;
+
+    if (sign == FPDEC_SIGN_ZERO)
+        return FPDEC_OK;
+    if (dec_prec > FPDEC_MAX_DEC_PREC)
+        ERROR(FPDEC_PREC_LIMIT_EXCEEDED);
+
+    if (!FPDEC_IS_DYN_ALLOC(x) && !FPDEC_IS_DYN_ALLOC(y) && x->hi == 0 &&
+        y->hi == 0 && dec_prec <= MAX_DEC_PREC_FOR_SHINT) {
+        // product of 64-bit coefficients goes to the 128-bit sums
+        u64_mul_u64(&t, x->lo, y->lo);
+        if (U128_HI(t) < (1ULL << 60U) &&
+            accumulator_add_to_pending(acc, sign, t, dec_prec)) {
+            acc->dec_prec = MAX(acc->dec_prec, dec_prec);
             return FPDEC_OK;
         }
-        else
-            FPDEC_DEC_PREC(z) = prec_limit;
     }
-    if (U128_FITS_SHINT(divident)) {
-        z->lo = U128_LO(divident);
-        z->hi = U128_HI(divident);
-        return FPDEC_OK;
+
+    fpdec_get_digits_view(&x_view, x);
+    fpdec_get_digits_view(&y_view, y);
+    if (x_view.n_digits + y_view.n_digits > 16) {
+        // long operands: take the detour via fpdec_mul
+        prod = FPDEC_ZERO;
+        rc = fpdec_mul(&prod, x, y);
+        if (rc == FPDEC_OK)
+            rc = accumulator_add_signed(acc, &prod, sign);
+        fpdec_reset_to_zero(&prod, 0);
+        return rc;
     }
-    else
-        return fpdec_set_dyn_coeff(z, U128_LO(divident), U128_HI(divident));
+    digits_mul_digits(digits, x_view.digits, x_view.n_digits, y_view.digits,
+                      y_view.n_digits);
+    n_digits = x_view.n_digits + y_view.n_digits;
+    while (digits[n_digits - 1] == 0)
+        n_digits--;
+    exp = (int64_t)x_view.exp + (int64_t)y_view.exp;
+    if (exp > FPDEC_MAX_EXP || exp < INT32_MIN)
+        ERROR(FPDEC_EXP_LIMIT_EXCEEDED);
+    rc = accumulator_add_digits(acc, sign, digits, n_digits,
+                                (fpdec_exp_t)exp);
+    if (rc != FPDEC_OK)
+        return rc;
+    acc->dec_prec = MAX(acc->dec_prec, dec_prec);
+    return FPDEC_OK;
 }
 
-typedef error_t (*v_div_op)(fpdec_t *, const fpdec_t *, const fpdec_t *,
-                            const int, const enum FPDEC_ROUNDING_MODE);
-
-const v_div_op vtab_div_abs[4] = {
-    fpdec_div_abs_shint_by_shint,
-    fpdec_div_abs_shint_by_dyn,
-    fpdec_div_abs_dyn_by_shint,
-    fpdec_div_abs_dyn_by_dyn
-};
+// Fused multiply-add and dot product
 
 error_t
-fpdec_div(fpdec_t *z, const fpdec_t *x, const fpdec_t *y,
-          const int prec_limit, const enum FPDEC_ROUNDING_MODE rounding) {
+fpdec_fma(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, const fpdec_t *w) {
+    fpdec_accumulator_t acc;
     error_t rc;
 
     ASSERT_FPDEC_IS_ZEROED(z);
-    assert(prec_limit >= -1);
-    assert(prec_limit <= FPDEC_MAX_DEC_PREC);
 
-    if (FPDEC_EQ_ZERO(y))
-        ERROR(FPDEC_DIVIDE_BY_ZERO);
+    // same as fpdec_add with a zero product
+    if (FPDEC_EQ_ZERO(x) || FPDEC_EQ_ZERO(y))
+        return fpdec_copy(z, w);
 
-    if (FPDEC_EQ_ZERO(x))
-        return FPDEC_OK;
+    fpdec_accumulator_init(&acc);
+    rc = fpdec_accumulator_add_product(&acc, x, y);
+    if (rc == FPDEC_OK)
+        rc = fpdec_accumulator_add(&acc, w);
+    if (rc == FPDEC_OK)
+        rc = fpdec_accumulator_result(z, &acc);
+    fpdec_accumulator_reset(&acc);
+    return rc;
+}
 
-    FPDEC_SIGN(z) = FPDEC_SIGN(x) * FPDEC_SIGN(y);
-    rc = DISPATCH_BIN_OP_VA(vtab_div_abs, z, x, y, prec_limit, rounding);
-    if (rc != FPDEC_OK)
-        return rc;
+error_t
+fpdec_dot(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n) {
+    fpdec_accumulator_t acc;
+    error_t rc = FPDEC_OK;
 
-    if (FPDEC_IS_DYN_ALLOC(z))
-        fpdec_dyn_normalize(z);
-    else {
-        if (z->lo == 0 && z->hi == 0)
-            FPDEC_SIGN(z) = FPDEC_SIGN_ZERO;
-    }
-    return FPDEC_OK;
+    ASSERT_FPDEC_IS_ZEROED(z);
+
+    fpdec_accumulator_init(&acc);
+    for (size_t i = 0; i < n && rc == FPDEC_OK; ++i)
+        rc = fpdec_accumulator_add_product(&acc, x + i, y + i);
+    if (rc == FPDEC_OK)
+        rc = fpdec_accumulator_result(z, &acc);
+    fpdec_accumulator_reset(&acc);
+    return rc;
 }
 
 // Deallocator
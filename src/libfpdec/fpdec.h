@@ -22,6 +22,7 @@ extern "C" {
 #endif // __cplusplus
 
 #include "common.h"
+#include "format_spec.h"
 #include "mem.h"
 #include "rounding.h"
 
@@ -57,12 +58,35 @@ fpdec_copy(fpdec_t *fpdec, const fpdec_t *src);
 error_t
 fpdec_from_ascii_literal(fpdec_t *fpdec, const char *literal);
 
+// Same as fpdec_from_ascii_literal, but taking the len chars starting at
+// begin, which need not be terminated by a NUL char.
+error_t
+fpdec_from_ascii_chars(fpdec_t *fpdec, const char *begin, size_t len);
+
+// Parses the longest prefix of the len chars starting at begin (after
+// leading whitespace) which forms a decimal literal and sets end to the
+// first char following it. On failure end is set to begin.
+error_t
+fpdec_parse_ascii_chars(fpdec_t *fpdec, const char *begin, size_t len,
+                        const char **end);
+
 error_t
 fpdec_from_unicode_literal(fpdec_t *fpdec, const wchar_t *literal);
 
 error_t
 fpdec_from_long_long(fpdec_t *fpdec, long long val);
 
+error_t
+fpdec_from_u64(fpdec_t *fpdec, uint64_t val);
+
+error_t
+fpdec_from_u128(fpdec_t *fpdec, uint128_t val);
+
+#ifdef __SIZEOF_INT128__
+error_t
+fpdec_from_i128(fpdec_t *fpdec, __int128 val);
+#endif // __int128
+
 error_t
 fpdec_from_sign_digits_exp(fpdec_t *fpdec, fpdec_sign_t sign,
                            size_t n_digits,
@@ -79,6 +103,13 @@ fpdec_magnitude(const fpdec_t *fpdec);
 int
 fpdec_compare(const fpdec_t *x, const fpdec_t *y, bool ignore_sign);
 
+// Hashing
+
+// Returns a hash of the value of fpdec, independent of its precision and
+// internal representation, so that values comparing equal have equal hashes.
+size_t
+fpdec_hash(const fpdec_t *fpdec);
+
 // Converter
 
 error_t
@@ -109,10 +140,214 @@ fpdec_as_ascii_literal(const fpdec_t *fpdec, bool no_trailing_zeros);
 uint8_t *
 fpdec_formatted(const fpdec_t *fpdec, const uint8_t *format);
 
+// The *_to_buffer variants write the result (incl. a terminating NUL) into
+// the buffer of size buf_size given by the caller and set len to the length
+// of the result (excl. the NUL). If len >= buf_size, the buffer was too
+// small and has not been changed. buf may be NULL (with buf_size 0) to just
+// get the length.
+
+error_t
+fpdec_as_ascii_literal_to_buffer(char *buf, size_t buf_size, size_t *len,
+                                 const fpdec_t *fpdec,
+                                 bool no_trailing_zeros);
+
+error_t
+fpdec_formatted_to_buffer(uint8_t *buf, size_t buf_size, size_t *len,
+                          const fpdec_t *fpdec, const uint8_t *format);
+
+// Same as fpdec_formatted_to_buffer, but taking a format spec already
+// parsed by parse_format_spec.
+error_t
+fpdec_formatted_spec_to_buffer(uint8_t *buf, size_t buf_size, size_t *len,
+                               const fpdec_t *fpdec,
+                               const format_spec_t *spec);
+
+// Pre-compiled format specs
+
+// fpdec_formatted and fpdec_formatted_to_buffer look up the given format in a
+// small per-thread cache of parsed specs. Callers using a fixed format can
+// avoid even that lookup by compiling it once into a format_spec_t, which
+// then can be passed to fpdec_format_with or fpdec_formatted_spec_to_buffer.
+// For format type 'n' the locale specific params are taken from the locale
+// current at compile time.
+
+error_t
+fpdec_format_compile(format_spec_t *spec, const uint8_t *format);
+
+uint8_t *
+fpdec_format_with(const fpdec_t *fpdec, const format_spec_t *spec);
+
 int
 fpdec_as_sign_coeff128_exp(fpdec_sign_t *sign, uint128_t *coeff, int64_t *exp,
                            const fpdec_t *fpdec);
 
+// Conversion to integers
+
+// The following functions set val to the value of fpdec rounded to an
+// integer using the given rounding mode. If the result does not fit into
+// the target type, val is set to the min resp. max value of that type and
+// FPDEC_EXP_LIMIT_EXCEEDED is returned.
+
+error_t
+fpdec_as_i64(int64_t *val, const fpdec_t *fpdec,
+             enum FPDEC_ROUNDING_MODE rounding);
+
+#ifdef __SIZEOF_INT128__
+error_t
+fpdec_as_i128(__int128 *val, const fpdec_t *fpdec,
+              enum FPDEC_ROUNDING_MODE rounding);
+#endif // __int128
+
+// Same as fpdec_as_i64, but for fpdec * 10 ^ scale, i.e. the number of units
+// of 10 ^ -scale (f.e. cents for scale 2).
+error_t
+fpdec_as_scaled_i64(int64_t *val, const fpdec_t *fpdec, int32_t scale,
+                    enum FPDEC_ROUNDING_MODE rounding);
+
+// Binary serialization
+
+// The binary encoding of a fpdec does not depend on the platform (byte
+// order, word size). It consists of a header byte (format version, sign
+// and internal representation) followed by unsigned LEB128 varints: the
+// precision and, for a shifted int, the low and high part of its
+// coefficient resp., for a digit array, the (zigzag encoded) exponent, the
+// number of digits and the digits, least significant first.
+
+// Returns the number of bytes needed to encode fpdec.
+size_t
+fpdec_encoded_size(const fpdec_t *fpdec);
+
+// Writes the encoding of fpdec into the buffer of size buf_size given by
+// the caller and sets len to its length. If len > buf_size, the buffer was
+// too small and has not been changed.
+error_t
+fpdec_encode(uint8_t *buf, size_t buf_size, size_t *len,
+             const fpdec_t *fpdec);
+
+// Decodes the value encoded at the start of the buf_size bytes at buf
+// (which need not be aligned) into the zeroed fpdec and sets len to the
+// number of bytes read. Returns FPDEC_INVALID_ENCODING if the bytes do not
+// hold a valid encoding (of the current format version).
+error_t
+fpdec_decode(fpdec_t *fpdec, const uint8_t *buf, size_t buf_size,
+             size_t *len);
+
+// Order preserving keys
+
+// A key is a byte string whose lexicographic (memcmp) order equals the
+// numeric order of the encoded values. It consists of a header byte (sign
+// and, for small magnitudes, the decimal exponent), optionally the
+// exponent as 8 byte biased big-endian int, the significant decimal digits
+// as one byte per pair of digits and, as the last two bytes, the precision
+// (big-endian). Exponent and digit bytes are complemented for negative
+// values, the precision bytes never are. So, keys of values comparing equal
+// differ only in their last two bytes, which order them by increasing
+// precision, regardless of the sign.
+
+// Returns the number of bytes needed for the key of fpdec.
+size_t
+fpdec_key_size(const fpdec_t *fpdec);
+
+// Writes the key of fpdec into the buffer of size buf_size given by the
+// caller and sets len to its length. If len > buf_size, the buffer was too
+// small and has not been changed.
+error_t
+fpdec_encode_key(uint8_t *buf, size_t buf_size, size_t *len,
+                 const fpdec_t *fpdec);
+
+// Writes the first n (> 0) bytes of the key of fpdec without the precision
+// into buf, padded with zeros if the key is shorter. Returns true if the
+// prefix holds the complete key (without the precision). The prefixes of
+// two values compare like the values, except that different values may
+// have equal prefixes if these are not complete.
+bool
+fpdec_key_prefix(uint8_t *buf, size_t n, const fpdec_t *fpdec);
+
+// Decodes the key at the start of the buf_size bytes at buf into the zeroed
+// fpdec and sets len to the number of bytes read. Returns
+// FPDEC_INVALID_ENCODING if the bytes do not hold a valid key.
+error_t
+fpdec_decode_key(fpdec_t *fpdec, const uint8_t *buf, size_t buf_size,
+                 size_t *len);
+
+// Conversion from / to IEEE 754 decimal formats
+
+// The following functions convert from / to the bit patterns of the
+// decimal64 and decimal128 interchange formats, in binary integer (BID)
+// or densely packed decimal (DPD) encoding. Infinities and NaNs give
+// FPDEC_INVALID_ENCODING, non-canonical coefficients are taken as 0. The
+// exponent of a converted value becomes its precision and vice versa (if
+// the coefficient can hold the necessary digits). Values with more
+// significant digits than the format can hold are rounded according to
+// rounding; values too large give FPDEC_EXP_LIMIT_EXCEEDED.
+
+error_t
+fpdec_from_decimal64(fpdec_t *fpdec, uint64_t bits,
+                     enum FPDEC_IEEE_ENCODING encoding);
+
+error_t
+fpdec_from_decimal128(fpdec_t *fpdec, uint128_t bits,
+                      enum FPDEC_IEEE_ENCODING encoding);
+
+error_t
+fpdec_as_decimal64(uint64_t *bits, const fpdec_t *fpdec,
+                   enum FPDEC_IEEE_ENCODING encoding,
+                   enum FPDEC_ROUNDING_MODE rounding);
+
+error_t
+fpdec_as_decimal128(uint128_t *bits, const fpdec_t *fpdec,
+                    enum FPDEC_IEEE_ENCODING encoding,
+                    enum FPDEC_ROUNDING_MODE rounding);
+
+// Column variants, converting n values. If an error occurs, the fpdecs
+// converted so far are reset to zero resp. the content of bits is
+// undefined.
+
+error_t
+fpdec_from_decimal64_n(fpdec_t *z, const uint64_t *bits, size_t n,
+                       enum FPDEC_IEEE_ENCODING encoding);
+
+error_t
+fpdec_from_decimal128_n(fpdec_t *z, const uint128_t *bits, size_t n,
+                        enum FPDEC_IEEE_ENCODING encoding);
+
+error_t
+fpdec_as_decimal64_n(uint64_t *bits, const fpdec_t *x, size_t n,
+                     enum FPDEC_IEEE_ENCODING encoding,
+                     enum FPDEC_ROUNDING_MODE rounding);
+
+error_t
+fpdec_as_decimal128_n(uint128_t *bits, const fpdec_t *x, size_t n,
+                      enum FPDEC_IEEE_ENCODING encoding,
+                      enum FPDEC_ROUNDING_MODE rounding);
+
+// Conversion from / to double
+
+// The following functions convert without going through a decimal literal.
+// Infinities and NaNs give FPDEC_INVALID_DECIMAL_LITERAL.
+
+// Exact binary expansion of val (up to 1074 fractional digits)
+error_t
+fpdec_from_double(fpdec_t *fpdec, double val);
+
+// val rounded to dec_prec fractional digits (dec_prec < 0: to a multiple of
+// 10 ^ -dec_prec)
+error_t
+fpdec_from_double_rounded(fpdec_t *fpdec, double val, int32_t dec_prec,
+                          enum FPDEC_ROUNDING_MODE rounding);
+
+// Shortest decimal (at most 17 significant digits) converting back to val;
+// from several candidates with the same number of digits the one nearest to
+// val is chosen. Memory is only allocated for a result not fitting into a
+// shifted int.
+error_t
+fpdec_from_double_shortest(fpdec_t *fpdec, double val);
+
+// The double nearest to fpdec (ties to even). Values too large give
+// FPDEC_EXP_LIMIT_EXCEEDED, with val set to +/- HUGE_VAL.
+error_t
+fpdec_as_double(double *val, const fpdec_t *fpdec);
+
 // Basic arithmetic operations
 
 error_t
@@ -131,6 +366,115 @@ fpdec_div(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, int prec_limit,
 error_t
 fpdec_divmod(fpdec_t *q, fpdec_t *r, const fpdec_t *x, const fpdec_t *y);
 
+// z = x * y + w, calculated without an intermediate fpdec for the product;
+// gives the same result as fpdec_mul followed by fpdec_add.
+error_t
+fpdec_fma(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, const fpdec_t *w);
+
+// z = sum(x[i] * y[i] for i in 0 .. n-1), summed up exactly in an
+// accumulator (see below). The result has the max precision of the non-zero
+// products.
+error_t
+fpdec_dot(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+// Multiplication of values with large coefficients switches from the
+// schoolbook method to Karatsuba's method if both coefficients have at
+// least the given number of internal digits (base 10^19). Values less than
+// 4 are raised to 4. The threshold is process-wide; changing it does not
+// affect multiplications already in progress in other threads.
+
+size_t
+fpdec_get_karatsuba_threshold(void);
+
+void
+fpdec_set_karatsuba_threshold(size_t n_digits);
+
+// In-place operations
+
+// The following functions replace x by the result of the corresponding
+// operation applied to x and y (which may be the same as x). If x holds a
+// digit array with enough capacity for the result, it is reused. If an
+// error occurs, x is left unchanged.
+
+error_t
+fpdec_iadd(fpdec_t *x, const fpdec_t *y);
+
+error_t
+fpdec_isub(fpdec_t *x, const fpdec_t *y);
+
+error_t
+fpdec_imul(fpdec_t *x, const fpdec_t *y);
+
+error_t
+fpdec_idiv(fpdec_t *x, const fpdec_t *y, int prec_limit,
+           enum FPDEC_ROUNDING_MODE rounding);
+
+// Batch operations
+
+// The following functions apply the corresponding operation element-wise
+// to the arrays x and y of n values, giving the (zeroed) array z. The
+// *_scalar_n variants take a single value y instead of an array. If an
+// error occurs, all results are reset to zero.
+// Only elements which are shints with a shint result take a dedicated fast
+// path. All other elements (digit arrays, products with more than 18
+// fractional digits, results too large for a shint) are computed by the
+// scalar function, at the same cost and with the same allocations (one
+// digit array per result) as a loop over it.
+
+error_t
+fpdec_add_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+error_t
+fpdec_sub_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+error_t
+fpdec_mul_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+error_t
+fpdec_add_scalar_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+error_t
+fpdec_mul_scalar_n(fpdec_t *z, const fpdec_t *x, const fpdec_t *y, size_t n);
+
+void
+fpdec_compare_n(int *res, const fpdec_t *x, const fpdec_t *y, size_t n,
+                bool ignore_sign);
+
+void
+fpdec_compare_scalar_n(int *res, const fpdec_t *x, const fpdec_t *y,
+                       size_t n, bool ignore_sign);
+
+// Accumulator
+
+// An accumulator sums up values of any precision exactly, without creating
+// intermediate fpdecs. Its registers grow as needed and are reused for all
+// values added. The result has the max precision of all non-zero values
+// added.
+// fpdec_accumulator_reset frees the registers and empties the accumulator.
+
+void
+fpdec_accumulator_init(fpdec_accumulator_t *acc);
+
+error_t
+fpdec_accumulator_add(fpdec_accumulator_t *acc, const fpdec_t *x);
+
+error_t
+fpdec_accumulator_sub(fpdec_accumulator_t *acc, const fpdec_t *x);
+
+error_t
+fpdec_accumulator_add_long_long(fpdec_accumulator_t *acc, long long val);
+
+// Adds the exact product of x and y.
+error_t
+fpdec_accumulator_add_product(fpdec_accumulator_t *acc, const fpdec_t *x,
+                              const fpdec_t *y);
+
+error_t
+fpdec_accumulator_result(fpdec_t *z, fpdec_accumulator_t *acc);
+
+void
+fpdec_accumulator_reset(fpdec_accumulator_t *acc);
+
 // Deallocator
 
 void
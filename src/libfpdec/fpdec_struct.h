@@ -43,10 +43,33 @@ struct fpdec_struct {
     };
 };
 
+// Running sum of fpdecs. The sums of the positive values and of the
+// absolute values of the negative values are held separately, so that
+// adding a value never needs a comparison or a borrow. Shifted ints are
+// summed up in 128-bit integers with a common precision; the remaining
+// values (and the 128-bit sums before they could overflow) are added to
+// digit arrays with a common exponent. A zeroed struct denotes an empty
+// sum.
+struct fpdec_accumulator {
+    fpdec_dec_prec_t dec_prec;      // max number of fractional digits added
+    fpdec_dec_prec_t pending_prec;  // number of fractional digits of the
+    //                                 128-bit sums
+    fpdec_exp_t exp;                // exponent of the digit arrays
+    uint128_t pending_pos;          // 128-bit sums
+    uint128_t pending_neg;
+    fpdec_digit_array_t *pos;       // digit arrays
+    fpdec_digit_array_t *neg;
+};
+
 /*****************************************************************************
 *  Macros
 *****************************************************************************/
 
+// Limits
+
+// Max number of fractional digits of a value held as shifted int
+#define FPDEC_MAX_DEC_PREC_FOR_SHINT 18
+
 // Properties
 
 #define FPDEC_IS_DYN_ALLOC(fpdec) (((fpdec_t*)fpdec)->dyn_alloc)
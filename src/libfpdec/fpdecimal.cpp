@@ -12,7 +12,14 @@ $Source$
 $Revision$
 */
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include "fpdecimal.hpp"
 #include "fpdec.h"
 #include "digit_array_struct.h"
@@ -32,6 +39,8 @@ throw_exc(const error_t err, const std::string &val = {}) {
             throw InvalidDecimalLiteral(val);
         case FPDEC_DIVIDE_BY_ZERO:
             throw DivisionByZero();
+        case FPDEC_INVALID_ENCODING:
+            throw InvalidEncoding();
         case ENOMEM:
             throw std::bad_alloc();
         default:
@@ -40,6 +49,26 @@ throw_exc(const error_t err, const std::string &val = {}) {
     }
 }
 
+// *** class CompiledFormat *** ----------------------------------------------
+
+CompiledFormat::CompiledFormat(const std::string &fmt) {
+    error_t err = fpdec_format_compile(&spec, (const uint8_t *)fmt.c_str());
+    if (err != FPDEC_OK)
+        throw InvalidFormat(fmt);
+}
+
+// *** class RoundingContext *** ---------------------------------------------
+
+RoundingContext::RoundingContext(const Rounding rnd) noexcept {
+    saved_rounding = (Rounding)fpdec_get_thread_default_rounding_mode();
+    fpdec_set_thread_default_rounding_mode((FPDEC_ROUNDING_MODE)rnd);
+}
+
+RoundingContext::~RoundingContext() {
+    fpdec_set_thread_default_rounding_mode(
+        (FPDEC_ROUNDING_MODE)saved_rounding);
+}
+
 // *** class Decimal *** -----------------------------------------------------
 
 // constructors
@@ -70,9 +99,16 @@ Decimal::Decimal(Decimal &&src) noexcept {
 
 Decimal::Decimal(const std::string &val) {
     fpdec = FPDEC_ZERO;
-    error_t err = fpdec_from_ascii_literal(&fpdec, val.c_str());
+    error_t err = fpdec_from_ascii_chars(&fpdec, val.data(), val.size());
     if (err != FPDEC_OK)
-        throw_exc(err);
+        throw_exc(err, val);
+}
+
+Decimal::Decimal(const char *chars, const size_t len) {
+    fpdec = FPDEC_ZERO;
+    error_t err = fpdec_from_ascii_chars(&fpdec, chars, len);
+    if (err != FPDEC_OK)
+        throw_exc(err, std::string(chars, len));
 }
 
 Decimal::Decimal(const long long int val) noexcept {
@@ -107,6 +143,28 @@ int Decimal::magnitude() const {
 
 // operators
 
+Decimal &Decimal::operator=(const Decimal &rhs) {
+    if (this != &rhs) {
+        fpdec_t cpy = FPDEC_ZERO;
+        error_t err = fpdec_copy(&cpy, &rhs.fpdec);
+        if (err != FPDEC_OK)
+            throw_exc(err);
+        fpdec_reset_to_zero(&fpdec, 0);
+        fpdec = cpy;
+    }
+    return *this;
+}
+
+Decimal &Decimal::operator=(Decimal &&rhs) noexcept {
+    if (this != &rhs) {
+        fpdec_reset_to_zero(&fpdec, 0);
+        fpdec = rhs.fpdec;
+        // steal digit array
+        rhs.fpdec = FPDEC_ZERO;
+    }
+    return *this;
+}
+
 Decimal Decimal::operator+() const noexcept {
     return *this;
 }
@@ -176,6 +234,34 @@ Decimal Decimal::operator/(const Decimal &rhs) const {
     return dec;
 }
 
+Decimal &Decimal::operator+=(const Decimal &rhs) {
+    error_t err = fpdec_iadd(&fpdec, &rhs.fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Decimal &Decimal::operator-=(const Decimal &rhs) {
+    error_t err = fpdec_isub(&fpdec, &rhs.fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Decimal &Decimal::operator*=(const Decimal &rhs) {
+    error_t err = fpdec_imul(&fpdec, &rhs.fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Decimal &Decimal::operator/=(const Decimal &rhs) {
+    error_t err = fpdec_idiv(&fpdec, &rhs.fpdec, -1, FPDEC_ROUND_DEFAULT);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
 // member functions
 
 std::string Decimal::dump() {
@@ -199,6 +285,127 @@ std::string Decimal::dump() {
     return buf.str();
 }
 
+size_t Decimal::hash() const noexcept {
+    return fpdec_hash(&fpdec);
+}
+
+size_t Decimal::encoded_size() const noexcept {
+    return fpdec_encoded_size(&fpdec);
+}
+
+std::vector<uint8_t> Decimal::encoded() const {
+    std::vector<uint8_t> buf(fpdec_encoded_size(&fpdec));
+    size_t len;
+    fpdec_encode(buf.data(), buf.size(), &len, &fpdec);
+    return buf;
+}
+
+Decimal Decimal::decoded(const uint8_t *buf, const size_t size,
+                         size_t *n_read) {
+    Decimal dec;
+    size_t len;
+    error_t err = fpdec_decode(&dec.fpdec, buf, size, &len);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    if (n_read != nullptr)
+        *n_read = len;
+    return dec;
+}
+
+std::vector<uint8_t> Decimal::key() const {
+    std::vector<uint8_t> buf(fpdec_key_size(&fpdec));
+    size_t len;
+    fpdec_encode_key(buf.data(), buf.size(), &len, &fpdec);
+    return buf;
+}
+
+Decimal Decimal::from_key(const uint8_t *buf, const size_t size,
+                          size_t *n_read) {
+    Decimal dec;
+    size_t len;
+    error_t err = fpdec_decode_key(&dec.fpdec, buf, size, &len);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    if (n_read != nullptr)
+        *n_read = len;
+    return dec;
+}
+
+bool Decimal::key_prefix(uint8_t *buf, const size_t n) const noexcept {
+    return fpdec_key_prefix(buf, n, &fpdec);
+}
+
+Decimal Decimal::from_double(const double val) {
+    Decimal dec;
+    error_t err = fpdec_from_double(&dec.fpdec, val);
+    if (err != FPDEC_OK)
+        throw_exc(err, std::to_string(val));
+    return dec;
+}
+
+Decimal Decimal::from_double(const double val, const int32_t prec,
+                             const Rounding rnd) {
+    Decimal dec;
+    error_t err = fpdec_from_double_rounded(&dec.fpdec, val, prec,
+                                            (FPDEC_ROUNDING_MODE)rnd);
+    if (err != FPDEC_OK)
+        throw_exc(err, std::to_string(val));
+    return dec;
+}
+
+Decimal Decimal::shortest_from_double(const double val) {
+    Decimal dec;
+    error_t err = fpdec_from_double_shortest(&dec.fpdec, val);
+    if (err != FPDEC_OK)
+        throw_exc(err, std::to_string(val));
+    return dec;
+}
+
+double Decimal::as_double() const {
+    double val;
+    error_t err = fpdec_as_double(&val, &fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return val;
+}
+
+std::string Decimal::format(const CompiledFormat &fmt) const {
+    char buf[64];
+    size_t len;
+    error_t err;
+
+    err = fpdec_formatted_spec_to_buffer((uint8_t *)buf, sizeof(buf), &len,
+                                         &fpdec, &fmt.spec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    if (len < sizeof(buf))
+        return std::string(buf, len);
+    // result did not fit into the local buffer
+    std::string res(len, '\0');
+    err = fpdec_formatted_spec_to_buffer((uint8_t *)&res[0], len + 1, &len,
+                                         &fpdec, &fmt.spec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return res;
+}
+
+int64_t Decimal::as_i64(const Rounding rnd) const {
+    int64_t val;
+    error_t err = fpdec_as_i64(&val, &fpdec, (FPDEC_ROUNDING_MODE)rnd);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return val;
+}
+
+int64_t Decimal::as_scaled_i64(const int32_t scale, const Rounding rnd) const {
+    int64_t val;
+    error_t err = fpdec_as_scaled_i64(&val, &fpdec, scale,
+                                      (FPDEC_ROUNDING_MODE)rnd);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return val;
+}
+
 // interacting with integers
 
 bool fpdec::operator==(const long long int lhs, const Decimal &rhs) noexcept {
@@ -224,3 +431,355 @@ bool fpdec::operator>=(const long long int lhs, const Decimal &rhs) noexcept {
 bool fpdec::operator>(const long long int lhs, const Decimal &rhs) noexcept {
     return rhs < (Decimal)lhs;
 }
+
+// *** class Accumulator *** -------------------------------------------------
+
+Accumulator::Accumulator() noexcept {
+    fpdec_accumulator_init(&acc);
+}
+
+Accumulator::~Accumulator() {
+    fpdec_accumulator_reset(&acc);
+}
+
+Accumulator &Accumulator::operator+=(const Decimal &rhs) {
+    error_t err = fpdec_accumulator_add(&acc, &rhs.fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Accumulator &Accumulator::operator-=(const Decimal &rhs) {
+    error_t err = fpdec_accumulator_sub(&acc, &rhs.fpdec);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Accumulator &Accumulator::operator+=(const long long int rhs) {
+    error_t err = fpdec_accumulator_add_long_long(&acc, rhs);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return *this;
+}
+
+Decimal Accumulator::sum() {
+    Decimal dec;
+    error_t err = fpdec_accumulator_result(&dec.fpdec, &acc);
+    if (err != FPDEC_OK)
+        throw_exc(err);
+    return dec;
+}
+
+void Accumulator::clear() noexcept {
+    fpdec_accumulator_reset(&acc);
+}
+
+// *** sorting and searching *** ---------------------------------------------
+
+namespace {
+
+    // The key prefix fills the remainder of a 32 byte KeyedIndex, so, with
+    // 8 byte indices, it holds up to 44 significant digits.
+    const size_t KEY_PREFIX_SIZE = 32 - sizeof(size_t) - sizeof(bool);
+    // min number of elements per thread
+    const size_t MIN_CHUNK_SIZE = 1U << 15U;
+    // max number of elements sorted by comparison instead of radix sort
+    const size_t MAX_CMP_SORT_SIZE = 64;
+
+    struct KeyedIndex {
+        uint8_t key[KEY_PREFIX_SIZE];
+        bool complete;
+        size_t idx;
+    };
+    static_assert(sizeof(KeyedIndex) == 32,
+                  "Size of KeyedIndex should be 32!");
+
+    // Orders by key prefix, comparing the referenced Decimals only if the
+    // prefixes are equal but incomplete
+    struct KeyedIndexLess {
+        const Decimal *base;
+
+        bool operator()(const KeyedIndex &lhs,
+                        const KeyedIndex &rhs) const noexcept {
+            int cmp = memcmp(lhs.key, rhs.key, KEY_PREFIX_SIZE);
+            if (cmp != 0)
+                return cmp < 0;
+            // equal prefixes are either both complete or both incomplete
+            return !lhs.complete && base[lhs.idx] < base[rhs.idx];
+        }
+    };
+
+    // A set of threads started once and used for all phases of a sort.
+    // run(n_tasks, func) calls func(i) for i in [0, n_tasks), spread over
+    // the workers and the calling thread, and returns when all calls are
+    // done. The first exception thrown by func is propagated by run after
+    // all calls have finished.
+    class Workers {
+    public:
+        explicit Workers(unsigned n_threads) {
+            threads.reserve(n_threads - 1);
+            try {
+                for (unsigned i = 1; i < n_threads; ++i)
+                    threads.emplace_back(&Workers::work, this);
+            }
+            catch (...) {
+                shut_down();
+                throw;
+            }
+        }
+
+        Workers(const Workers &) = delete;
+        Workers &operator=(const Workers &) = delete;
+
+        ~Workers() {
+            shut_down();
+        }
+
+        template<typename Func>
+        void
+        run(unsigned n_tasks, const Func &func) {
+            const std::function<void(unsigned)> f(func);
+            std::unique_lock<std::mutex> lock(mtx);
+
+            task = &f;
+            n_open = n_tasks;
+            n_running = n_tasks;
+            error = nullptr;
+            cv_task.notify_all();
+            do_tasks(lock);
+            cv_done.wait(lock, [this] { return n_running == 0; });
+            task = nullptr;
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mtx;
+        std::condition_variable cv_task;
+        std::condition_variable cv_done;
+        const std::function<void(unsigned)> *task = nullptr;
+        unsigned n_open = 0;
+        unsigned n_running = 0;
+        bool stopping = false;
+        std::exception_ptr error;
+
+        // Calls task for the open indices, with lock held in between.
+        void
+        do_tasks(std::unique_lock<std::mutex> &lock) {
+            while (n_open > 0) {
+                unsigned i = --n_open;
+                lock.unlock();
+                try {
+                    (*task)(i);
+                }
+                catch (...) {
+                    lock.lock();
+                    if (!error)
+                        error = std::current_exception();
+                    lock.unlock();
+                }
+                lock.lock();
+                if (--n_running == 0)
+                    cv_done.notify_one();
+            }
+        }
+
+        void
+        work() {
+            std::unique_lock<std::mutex> lock(mtx);
+            for (;;) {
+                cv_task.wait(lock,
+                             [this] { return stopping || n_open > 0; });
+                if (stopping)
+                    return;
+                do_tasks(lock);
+            }
+        }
+
+        void
+        shut_down() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            cv_task.notify_all();
+            for (std::thread &t : threads)
+                t.join();
+        }
+    };
+
+    void
+    fill_in_keys(KeyedIndex *begin, KeyedIndex *end, const Decimal *base,
+                 size_t first_idx) {
+        for (KeyedIndex *ki = begin; ki < end; ++ki) {
+            ki->idx = first_idx++;
+            ki->complete = base[ki->idx].key_prefix(ki->key,
+                                                    KEY_PREFIX_SIZE);
+        }
+    }
+
+    // Stable MSD radix sort of [begin, end) by the key prefix bytes from
+    // byte on (the preceding ones being equal), using tmp as buffer of the
+    // same size. Bytes equal in all keys are skipped, small ranges and runs
+    // of equal keys (often duplicates, which are already in order) are left
+    // to the comparison based sort.
+    void
+    radix_sort(KeyedIndex *begin, KeyedIndex *end, KeyedIndex *tmp,
+               size_t byte, const KeyedIndexLess &less) {
+        const size_t n = end - begin;
+        size_t counts[256];
+        size_t offset = 0;
+
+        if (n <= MAX_CMP_SORT_SIZE) {
+            if (!std::is_sorted(begin, end, less))
+                std::stable_sort(begin, end, less);
+            return;
+        }
+        for (; byte < KEY_PREFIX_SIZE; ++byte) {
+            std::fill(counts, counts + 256, 0);
+            for (const KeyedIndex *ki = begin; ki < end; ++ki)
+                ++counts[ki->key[byte]];
+            if (counts[begin->key[byte]] != n)
+                break;
+        }
+        if (byte == KEY_PREFIX_SIZE) {
+            if (!begin->complete && !std::is_sorted(begin, end, less))
+                std::stable_sort(begin, end, less);
+            return;
+        }
+        for (size_t i = 0; i < 256; ++i) {
+            size_t t = counts[i];
+            counts[i] = offset;
+            offset += t;
+        }
+        for (const KeyedIndex *ki = begin; ki < end; ++ki)
+            tmp[counts[ki->key[byte]]++] = *ki;
+        std::copy(tmp, tmp + n, begin);
+        // counts[i] is now the end of bucket i
+        offset = 0;
+        for (size_t i = 0; i < 256; ++i) {
+            if (counts[i] - offset > 1)
+                radix_sort(begin + offset, begin + counts[i], tmp + offset,
+                           byte + 1, less);
+            offset = counts[i];
+        }
+    }
+
+    // Moves the elements of [first, first + n) into the order given by
+    // keys, following the cycles of the permutation. Elements in place are
+    // marked in keys by idx referring to their own position.
+    void
+    permute(Decimal *first, std::vector<KeyedIndex> &keys) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i].idx == i)
+                continue;
+            Decimal t(std::move(first[i]));
+            size_t j = i;
+            for (size_t src = keys[j].idx; src != i; src = keys[j].idx) {
+                first[j] = std::move(first[src]);
+                keys[j].idx = j;
+                j = src;
+            }
+            first[j] = std::move(t);
+            keys[j].idx = j;
+        }
+    }
+
+    std::vector<KeyedIndex>
+    sorted_keys(Decimal *first, Decimal *last, unsigned n_threads) {
+        const size_t n = last - first;
+        const unsigned n_cores = std::thread::hardware_concurrency();
+        const KeyedIndexLess less{first};
+        std::vector<KeyedIndex> keys(n);
+        std::vector<KeyedIndex> tmp(n);
+        size_t chunk_size;
+
+        // more threads than cores only add overhead
+        if (n_cores > 0)
+            n_threads = std::min(n_threads, n_cores);
+        n_threads = (unsigned)std::max<size_t>(
+            1, std::min<size_t>(n_threads, n / MIN_CHUNK_SIZE));
+        if (n_threads == 1) {
+            fill_in_keys(&keys[0], &keys[0] + n, first, 0);
+            radix_sort(&keys[0], &keys[0] + n, &tmp[0], 0, less);
+            return keys;
+        }
+        chunk_size = (n + n_threads - 1) / n_threads;
+
+        Workers workers(n_threads);
+        workers.run(n_threads, [&](unsigned i) {
+            size_t begin = std::min(n, i * chunk_size);
+            size_t end = std::min(n, begin + chunk_size);
+            fill_in_keys(&keys[begin], &keys[0] + end, first, begin);
+            radix_sort(&keys[begin], &keys[0] + end, &tmp[begin], 0,
+                       less);
+        });
+
+        // merge sorted chunks pairwise
+        for (; chunk_size < n; chunk_size *= 2) {
+            unsigned n_pairs = (unsigned)((n + 2 * chunk_size - 1) /
+                                          (2 * chunk_size));
+            workers.run(n_pairs, [&](unsigned i) {
+                size_t begin = i * 2 * chunk_size;
+                size_t mid = std::min(n, begin + chunk_size);
+                size_t end = std::min(n, mid + chunk_size);
+                std::merge(keys.begin() + begin, keys.begin() + mid,
+                           keys.begin() + mid, keys.begin() + end,
+                           tmp.begin() + begin, less);
+            });
+            keys.swap(tmp);
+        }
+        return keys;
+    }
+
+} // namespace
+
+void fpdec::sort(Decimal *first, Decimal *last, const unsigned n_threads) {
+    fpdec::stable_sort(first, last, n_threads);
+}
+
+void fpdec::stable_sort(Decimal *first, Decimal *last,
+                        const unsigned n_threads) {
+    if (last - first < 2)
+        return;
+    std::vector<KeyedIndex> keys = sorted_keys(first, last, n_threads);
+
+    permute(first, keys);
+}
+
+void fpdec::nth_element(Decimal *first, Decimal *nth, Decimal *last) {
+    const size_t n = last - first;
+    std::vector<KeyedIndex> keys(n);
+
+    if (nth >= last || n < 2)
+        return;
+    fill_in_keys(&keys[0], &keys[0] + n, first, 0);
+    std::nth_element(keys.begin(), keys.begin() + (nth - first), keys.end(),
+                     KeyedIndexLess{first});
+    permute(first, keys);
+}
+
+const Decimal *fpdec::lower_bound(const Decimal *first, const Decimal *last,
+                                  const Decimal &value) noexcept {
+    uint8_t value_key[KEY_PREFIX_SIZE];
+    uint8_t key[KEY_PREFIX_SIZE];
+    bool complete = value.key_prefix(value_key, KEY_PREFIX_SIZE);
+    size_t count = last - first;
+    size_t step;
+    int cmp;
+
+    while (count > 0) {
+        step = count / 2;
+        first[step].key_prefix(key, KEY_PREFIX_SIZE);
+        cmp = memcmp(key, value_key, KEY_PREFIX_SIZE);
+        if (cmp < 0 || (cmp == 0 && !complete && first[step] < value)) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
@@ -15,9 +15,17 @@ $Revision$
 #ifndef FPDEC_FPDECIMAL_HPP
 #define FPDEC_FPDECIMAL_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 #include "common.h"
+#include "format_spec.h"
 #include "fpdec_struct.h"
 
 namespace fpdec {
@@ -49,6 +57,23 @@ namespace fpdec {
         };
     };
 
+    class InvalidEncoding : public std::invalid_argument {
+    public:
+        InvalidEncoding() :
+            std::invalid_argument("Invalid binary encoding of a Decimal.") {
+        };
+    };
+
+    class InvalidFormat : public std::invalid_argument {
+    public:
+        std::string invalid_format;
+
+        explicit InvalidFormat(const std::string fmt) :
+            std::invalid_argument("Invalid format spec"),
+            invalid_format(fmt) {
+        };
+    };
+
     // The members of 'Rounding' must be kept in sync with FPDEC_ROUNDING
     // in rounding.h !!!
 
@@ -75,6 +100,38 @@ namespace fpdec {
         round_up,
     };
 
+    // Sets the default rounding mode of the current thread for the lifetime
+    // of the object, restoring the previous one when the object is
+    // destroyed.
+
+    class RoundingContext {
+    public:
+        explicit RoundingContext(Rounding) noexcept;
+        RoundingContext(const RoundingContext &) = delete;
+        RoundingContext &operator=(const RoundingContext &) = delete;
+        ~RoundingContext();
+
+    private:
+        Rounding saved_rounding;
+    };
+
+    template<unsigned Scale, typename Storage>
+    class FixedDecimal;
+
+    // A format spec parsed once, to be used repeatedly with
+    // Decimal::format. For format type 'n' the locale specific params are
+    // taken from the locale current at construction.
+
+    class CompiledFormat {
+    public:
+        explicit CompiledFormat(const std::string &);
+
+    private:
+        format_spec_t spec{};
+
+        friend class Decimal;
+    };
+
     class Decimal {
     public:
         Decimal() noexcept;
@@ -83,6 +140,14 @@ namespace fpdec {
                 Rounding = Rounding::round_default);
         Decimal(Decimal &&) noexcept;
         explicit Decimal(const std::string &);
+        Decimal(const char *, size_t);
+#if __cplusplus >= 201703L
+        // inline, so that it is available independent of the standard the
+        // library was compiled with
+        explicit Decimal(const std::string_view val) :
+            Decimal(val.data(), val.size()) {
+        };
+#endif
         explicit Decimal(long long int) noexcept;
         ~Decimal();
         // properties
@@ -90,8 +155,8 @@ namespace fpdec {
         fpdec_dec_prec_t precision() const noexcept;
         int magnitude() const;
         // operators
-        Decimal &operator=(const Decimal &) = default;
-        Decimal &operator=(Decimal &&) = default;
+        Decimal &operator=(const Decimal &);
+        Decimal &operator=(Decimal &&) noexcept;
         Decimal operator+() const noexcept;
         Decimal operator-() const;
         bool operator==(const Decimal &) const noexcept;
@@ -104,12 +169,68 @@ namespace fpdec {
         Decimal operator-(const Decimal &) const;
         Decimal operator*(const Decimal &) const;
         Decimal operator/(const Decimal &) const;
+        Decimal &operator+=(const Decimal &);
+        Decimal &operator-=(const Decimal &);
+        Decimal &operator*=(const Decimal &);
+        Decimal &operator/=(const Decimal &);
         // member functions
         std::string dump();
+        // same for all Decimals comparing equal
+        size_t hash() const noexcept;
+        // binary serialization (see fpdec_encode / fpdec_decode)
+        size_t encoded_size() const noexcept;
+        std::vector<uint8_t> encoded() const;
+        // Decodes the value encoded at the start of the size bytes at buf;
+        // if n_read is given, it is set to the number of bytes read.
+        static Decimal decoded(const uint8_t *buf, size_t size,
+                               size_t *n_read = nullptr);
+        // order preserving keys (see fpdec_encode_key / fpdec_decode_key)
+        std::vector<uint8_t> key() const;
+        static Decimal from_key(const uint8_t *buf, size_t size,
+                                size_t *n_read = nullptr);
+        // see fpdec_key_prefix
+        bool key_prefix(uint8_t *buf, size_t n) const noexcept;
+        // conversion from / to double (see fpdec_from_double etc.)
+        static Decimal from_double(double);
+        static Decimal from_double(double, int32_t,
+                                   Rounding = Rounding::round_default);
+        static Decimal shortest_from_double(double);
+        double as_double() const;
+        // formatting with a pre-compiled format spec
+        std::string format(const CompiledFormat &) const;
+        // conversion to integers (see fpdec_as_i64 etc.)
+        int64_t as_i64(Rounding = Rounding::round_default) const;
+        int64_t as_scaled_i64(int32_t,
+                              Rounding = Rounding::round_default) const;
 
     private:
         fpdec_t fpdec{};
         explicit Decimal(const fpdec_t *);
+
+        friend class Accumulator;
+        friend class DecimalColumn;
+        template<unsigned Scale, typename Storage>
+        friend class FixedDecimal;
+    };
+
+    // Exact running sum of Decimals and integers, reusing its internal
+    // registers for all values added.
+
+    class Accumulator {
+    public:
+        Accumulator() noexcept;
+        Accumulator(const Accumulator &) = delete;
+        Accumulator &operator=(const Accumulator &) = delete;
+        ~Accumulator();
+        Accumulator &operator+=(const Decimal &);
+        Accumulator &operator-=(const Decimal &);
+        Accumulator &operator+=(long long int);
+        // member functions
+        Decimal sum();
+        void clear() noexcept;
+
+    private:
+        fpdec_accumulator_t acc{};
     };
 
     // interacting with integers
@@ -120,6 +241,42 @@ namespace fpdec {
     bool operator>=(long long int, const Decimal &) noexcept;
     bool operator>(long long int, const Decimal &) noexcept;
 
+    // Sorting and searching arrays of Decimals
+
+    // These functions compute an order preserving key prefix (see
+    // fpdec_key_prefix) for each element once, sort the prefixes by radix
+    // sort and compare the Decimals themselves only where their prefixes
+    // are equal but incomplete. The elements are moved, not copied.
+    // sort and stable_sort split the work across n_threads threads, each
+    // sorting a chunk of the array, and merge the sorted chunks. Both sort
+    // stable, sort is provided for symmetry with std::sort.
+    // The additional threads are started once per call and used for all of
+    // its phases. No more threads than cores are used, and none for less
+    // than 32k elements per thread, so smaller arrays are sorted with fewer
+    // threads or in the calling thread only.
+    // Allocations done in these threads use the process-wide allocator,
+    // not a thread-specific one set by the caller (see mem.h); blocks
+    // cached by the pool in such a thread are freed when it exits.
+
+    void sort(Decimal *first, Decimal *last, unsigned n_threads = 1);
+    void stable_sort(Decimal *first, Decimal *last, unsigned n_threads = 1);
+    void nth_element(Decimal *first, Decimal *nth, Decimal *last);
+    // Returns a pointer to the first element of the sorted array
+    // [first, last) not less than value.
+    const Decimal *lower_bound(const Decimal *first, const Decimal *last,
+                               const Decimal &value) noexcept;
+
 }; // namespace fpdec
 
+namespace std {
+
+    template<>
+    struct hash<fpdec::Decimal> {
+        size_t operator()(const fpdec::Decimal &dec) const noexcept {
+            return dec.hash();
+        };
+    };
+
+}; // namespace std
+
 #endif //FPDEC_FPDECIMAL_HPP
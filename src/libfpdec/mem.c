@@ -0,0 +1,364 @@
+/* ---------------------------------------------------------------------------
+Name:        mem.c
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "compiler_macros.h"
+#include "mem.h"
+
+/*****************************************************************************
+*  Macros
+*****************************************************************************/
+
+#define POOL_N_SIZE_CLASSES 8
+#define POOL_MIN_BLOCK_SIZE 32          // 32 << 7 = 4096 is max block size
+#define POOL_MAX_CACHED_BLOCKS 256      // per size class
+
+#define ARENA_CHUNK_SIZE 65536
+
+/*****************************************************************************
+*  Types
+*****************************************************************************/
+
+// Pair of allocation / deallocation functions. Pairs set as process-wide
+// allocator are kept in a list and never freed, so that a reader never
+// sees a dangling pair (and never an alloc function combined with the free
+// function of another pair).
+typedef struct mem_funcs {
+    mem_alloc_func alloc;
+    mem_free_func free;
+    struct mem_funcs *next;
+} mem_funcs_t;
+
+// Header put in front of each block handed out by the pool. While the block
+// is in use it holds the size class, while it is cached it links the free
+// list.
+typedef union pool_block_header {
+    unsigned size_class;
+    union pool_block_header *next;
+    max_align_t align;
+} pool_block_header_t;
+
+struct pool_size_class {
+    pool_block_header_t *free_list;
+    size_t n_cached;
+};
+
+// Chunk of memory handed out piecewise by the arena; chunks are linked from
+// the most recent to the oldest one.
+typedef struct arena_chunk {
+    struct arena_chunk *prev;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} arena_chunk_t;
+
+/*****************************************************************************
+*  Variables
+*****************************************************************************/
+
+static mem_funcs_t default_mem_funcs = {calloc, free, NULL};
+static _Atomic(mem_funcs_t *) global_mem_funcs = &default_mem_funcs;
+static _Atomic(mem_funcs_t *) registered_mem_funcs = &default_mem_funcs;
+
+static THREAD_LOCAL mem_alloc_func thread_mem_alloc = NULL;
+static THREAD_LOCAL mem_free_func thread_mem_free = NULL;
+
+static THREAD_LOCAL struct pool_size_class pool[POOL_N_SIZE_CLASSES];
+
+static THREAD_LOCAL arena_chunk_t *arena = NULL;
+
+#ifndef _WIN32
+static pthread_once_t thread_cleanup_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_cleanup_key;
+static THREAD_LOCAL bool thread_cleanup_registered = false;
+#endif
+
+/*****************************************************************************
+*  Functions
+*****************************************************************************/
+
+// Allocation / deallocation
+
+void *
+fpdec_mem_alloc(size_t num, size_t size) {
+    if (thread_mem_alloc != NULL)
+        return thread_mem_alloc(num, size);
+    return atomic_load_explicit(&global_mem_funcs,
+                                memory_order_acquire)->alloc(num, size);
+}
+
+void
+fpdec_mem_free(void *ptr) {
+    if (thread_mem_free != NULL)
+        thread_mem_free(ptr);
+    else
+        atomic_load_explicit(&global_mem_funcs,
+                             memory_order_acquire)->free(ptr);
+}
+
+// Pluggable allocator
+
+// Returns the registered pair (alloc_func, free_func), registering it if
+// necessary, or NULL if that fails.
+static mem_funcs_t *
+register_mem_funcs(mem_alloc_func alloc_func, mem_free_func free_func) {
+    mem_funcs_t *head = atomic_load_explicit(&registered_mem_funcs,
+                                             memory_order_acquire);
+    mem_funcs_t *funcs;
+
+    for (funcs = head; funcs != NULL; funcs = funcs->next)
+        if (funcs->alloc == alloc_func && funcs->free == free_func)
+            return funcs;
+    funcs = malloc(sizeof(mem_funcs_t));
+    if (funcs == NULL)
+        return NULL;
+    funcs->alloc = alloc_func;
+    funcs->free = free_func;
+    do {
+        // a pair registered concurrently by another thread may be
+        // registered twice, which does no harm
+        funcs->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &registered_mem_funcs, &head, funcs, memory_order_release,
+        memory_order_acquire));
+    return funcs;
+}
+
+void
+fpdec_get_mem_funcs(mem_alloc_func *alloc_func, mem_free_func *free_func) {
+    const mem_funcs_t *funcs = atomic_load_explicit(&global_mem_funcs,
+                                                    memory_order_acquire);
+
+    *alloc_func = funcs->alloc;
+    *free_func = funcs->free;
+}
+
+error_t
+fpdec_set_mem_funcs(mem_alloc_func alloc_func, mem_free_func free_func) {
+    mem_funcs_t *funcs = &default_mem_funcs;
+
+    assert((alloc_func == NULL) == (free_func == NULL));
+
+    if (alloc_func != NULL) {
+        funcs = register_mem_funcs(alloc_func, free_func);
+        if (funcs == NULL)
+            return ENOMEM;
+    }
+    atomic_store_explicit(&global_mem_funcs, funcs, memory_order_release);
+    return FPDEC_OK;
+}
+
+void
+fpdec_get_thread_mem_funcs(mem_alloc_func *alloc_func,
+                           mem_free_func *free_func) {
+    *alloc_func = thread_mem_alloc;
+    *free_func = thread_mem_free;
+}
+
+void
+fpdec_set_thread_mem_funcs(mem_alloc_func alloc_func,
+                           mem_free_func free_func) {
+    assert((alloc_func == NULL) == (free_func == NULL));
+
+    thread_mem_alloc = alloc_func;
+    thread_mem_free = free_func;
+}
+
+// Release of thread-local memory at thread exit
+
+static void
+arena_release(bool keep_one);
+
+#ifndef _WIN32
+static void
+thread_cleanup(void *unused UNUSED) {
+    thread_cleanup_registered = false;
+    fpdec_pool_clear();
+    arena_release(false);
+}
+
+static void
+create_thread_cleanup_key(void) {
+    (void)pthread_key_create(&thread_cleanup_key, thread_cleanup);
+}
+
+// Makes sure that the blocks cached by the pool and the chunks held by the
+// arena are freed when the calling thread exits. (A thread-specific value
+// must be set for the key destructor to be called.)
+static inline void
+register_thread_cleanup(void) {
+    if (!thread_cleanup_registered) {
+        (void)pthread_once(&thread_cleanup_once, create_thread_cleanup_key);
+        thread_cleanup_registered =
+            pthread_setspecific(thread_cleanup_key,
+                                &thread_cleanup_registered) == 0;
+    }
+}
+#else
+static inline void
+register_thread_cleanup(void) {
+}
+#endif
+
+// Built-in pool allocator
+
+static inline unsigned
+pool_size_class(size_t n_bytes) {
+    size_t block_size = POOL_MIN_BLOCK_SIZE;
+    unsigned size_class = 0;
+
+    while (block_size < n_bytes && size_class < POOL_N_SIZE_CLASSES) {
+        block_size <<= 1U;
+        size_class++;
+    }
+    return size_class;
+}
+
+void *
+fpdec_pool_alloc(size_t num, size_t size) {
+    size_t n_bytes = num * size;
+    pool_block_header_t *block;
+    unsigned size_class;
+
+    if (size != 0 && n_bytes / size != num)     // overflow
+        return NULL;
+
+    size_class = pool_size_class(n_bytes);
+    if (size_class < POOL_N_SIZE_CLASSES) {
+        block = pool[size_class].free_list;
+        if (block != NULL) {
+            pool[size_class].free_list = block->next;
+            pool[size_class].n_cached--;
+            memset((void *)(block + 1), 0, n_bytes);
+        }
+        else {
+            block = calloc(1, sizeof(pool_block_header_t) +
+                              ((size_t)POOL_MIN_BLOCK_SIZE << size_class));
+            if (block == NULL)
+                return NULL;
+        }
+    }
+    else {
+        block = calloc(1, sizeof(pool_block_header_t) + n_bytes);
+        if (block == NULL)
+            return NULL;
+    }
+    block->size_class = size_class;
+    return (void *)(block + 1);
+}
+
+void
+fpdec_pool_free(void *ptr) {
+    pool_block_header_t *block;
+    unsigned size_class;
+
+    if (ptr == NULL)
+        return;
+
+    block = (pool_block_header_t *)ptr - 1;
+    size_class = block->size_class;
+    if (size_class < POOL_N_SIZE_CLASSES &&
+        pool[size_class].n_cached < POOL_MAX_CACHED_BLOCKS) {
+        register_thread_cleanup();
+        block->next = pool[size_class].free_list;
+        pool[size_class].free_list = block;
+        pool[size_class].n_cached++;
+    }
+    else
+        free(block);
+}
+
+void
+fpdec_pool_clear(void) {
+    pool_block_header_t *block;
+
+    for (unsigned size_class = 0; size_class < POOL_N_SIZE_CLASSES;
+         ++size_class) {
+        while ((block = pool[size_class].free_list) != NULL) {
+            pool[size_class].free_list = block->next;
+            free(block);
+        }
+        pool[size_class].n_cached = 0;
+    }
+}
+
+// Built-in arena allocator
+
+static void
+arena_release(bool keep_one) {
+    arena_chunk_t *chunk;
+
+    while ((chunk = arena) != NULL) {
+        if (keep_one && chunk->prev == NULL &&
+            chunk->size == ARENA_CHUNK_SIZE) {
+            chunk->used = 0;
+            break;
+        }
+        arena = chunk->prev;
+        free(chunk);
+    }
+}
+
+void *
+fpdec_arena_alloc(size_t num, size_t size) {
+    size_t n_bytes = num * size;
+    size_t n_needed;
+    arena_chunk_t *chunk = arena;
+    void *ptr;
+
+    if (size != 0 && n_bytes / size != num)     // overflow
+        return NULL;
+
+    // keep the pieces aligned
+    n_needed = (n_bytes + sizeof(max_align_t) - 1) &
+               ~(sizeof(max_align_t) - 1);
+    if (n_needed < n_bytes)                     // overflow
+        return NULL;
+    if (chunk == NULL || chunk->size - chunk->used < n_needed) {
+        size_t chunk_size = n_needed > ARENA_CHUNK_SIZE ?
+                            n_needed : ARENA_CHUNK_SIZE;
+        if (chunk_size > SIZE_MAX - sizeof(arena_chunk_t))
+            return NULL;
+        chunk = malloc(sizeof(arena_chunk_t) + chunk_size);
+        if (chunk == NULL)
+            return NULL;
+        register_thread_cleanup();
+        chunk->prev = arena;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        arena = chunk;
+    }
+    ptr = (char *)chunk->data + chunk->used;
+    chunk->used += n_needed;
+    memset(ptr, 0, n_bytes);
+    return ptr;
+}
+
+void
+fpdec_arena_free(void *ptr UNUSED) {
+}
+
+void
+fpdec_arena_reset(void) {
+    arena_release(true);
+}
@@ -15,13 +15,107 @@ $Revision$
 #ifndef FPDEC_MEM_H
 #define FPDEC_MEM_H
 
-#include <malloc.h>
-#include "compiler_macros.h"
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
 
+#include <stddef.h>
+#include "common.h"
+
+/*****************************************************************************
+*  Types
+*****************************************************************************/
+
+// An allocator must behave like calloc, i.e. return zeroed memory for an
+// array of num elements of the given size, or NULL if it fails.
 typedef void * (*mem_alloc_func)(size_t num, size_t size);
 typedef void (*mem_free_func)(void *);
 
-static mem_alloc_func fpdec_mem_alloc UNUSED = calloc;
-static mem_free_func fpdec_mem_free UNUSED = free;
+/*****************************************************************************
+*  Functions
+*****************************************************************************/
+
+// Allocation / deallocation (used for all memory allocated by the library)
+
+void *
+fpdec_mem_alloc(size_t num, size_t size);
+
+void
+fpdec_mem_free(void *ptr);
+
+// Pluggable allocator
+//
+// The process-wide allocator defaults to calloc / free. Setting a
+// thread-specific allocator overrides the process-wide one for all
+// allocations done by the calling thread. Passing NULL for both functions
+// resets to the default (calloc / free resp. the process-wide allocator).
+// Memory must always be freed by the allocator which allocated it, so the
+// allocator must not be changed while values allocated by it are still in
+// use (unless its free function is able to handle them).
+// The process-wide pair of functions is replaced atomically, i.e. other
+// threads see either the old or the new pair, never a mix of both. Each
+// distinct pair set is registered once (which may fail with ENOMEM) and
+// stays allocated until the process ends.
+
+void
+fpdec_get_mem_funcs(mem_alloc_func *alloc_func, mem_free_func *free_func);
+
+error_t
+fpdec_set_mem_funcs(mem_alloc_func alloc_func, mem_free_func free_func);
+
+void
+fpdec_get_thread_mem_funcs(mem_alloc_func *alloc_func,
+                           mem_free_func *free_func);
+
+void
+fpdec_set_thread_mem_funcs(mem_alloc_func alloc_func,
+                           mem_free_func free_func);
+
+// Built-in pool allocator
+//
+// Blocks up to 4096 bytes are taken from thread-local free lists organized
+// in size classes (powers of 2), larger blocks are directly allocated from
+// the heap. Freed blocks are kept in the free list of the freeing thread
+// (up to a limit per size class). fpdec_pool_clear returns all blocks
+// cached by the calling thread to the heap; blocks still in use are not
+// affected. The cached blocks of a thread are also returned to the heap
+// when the thread exits.
+// The pool can be activated by passing fpdec_pool_alloc and fpdec_pool_free
+// to one of the setter functions given above.
+
+void *
+fpdec_pool_alloc(size_t num, size_t size);
+
+void
+fpdec_pool_free(void *ptr);
+
+void
+fpdec_pool_clear(void);
+
+// Built-in arena allocator
+//
+// Blocks are cut from thread-local chunks of 64 KiB (larger blocks get a
+// chunk of their own). fpdec_arena_free does nothing; instead
+// fpdec_arena_reset releases all blocks allocated by the calling thread's
+// arena at once (keeping one chunk for reuse). Thus, all values allocated
+// via the arena must be abandoned before the reset; they must not be used
+// (nor be reset to zero) afterwards. The chunks of a thread are returned
+// to the heap when the thread exits.
+// The arena can be activated by passing fpdec_arena_alloc and
+// fpdec_arena_free to one of the setter functions given above; as it is
+// thread-local, fpdec_set_thread_mem_funcs is the natural choice.
+
+void *
+fpdec_arena_alloc(size_t num, size_t size);
+
+void
+fpdec_arena_free(void *ptr);
+
+void
+fpdec_arena_reset(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
 
 #endif //FPDEC_MEM_H
@@ -22,25 +22,39 @@ $Revision$
 *  Functions
 *****************************************************************************/
 
-static inline void
-fill_in_digits(dec_repr_t *dec_repr, const char *dec_chars,
-               const size_t n_dec_digits) {
-    const char *curr_char = dec_chars;
-    dec_digit_t *curr_digit = dec_repr->coeff + dec_repr->n_dec_digits;
-    for (size_t i = 0; i < n_dec_digits; ++i) {
-        *curr_digit = *curr_char - '0';
+static inline const char *
+skip_zeros(const char *curr_char, const char *end) {
+    while (end - curr_char >= 8 && chars_are_8_zeros(curr_char)) {
+        curr_char += 8;
+    }
+    while (curr_char < end && *curr_char == '0') {
+        curr_char++;
+    }
+    return curr_char;
+}
+
+static inline const char *
+skip_digits(const char *curr_char, const char *end) {
+    while (end - curr_char >= 8 && chars_are_8_digits(curr_char)) {
+        curr_char += 8;
+    }
+    while (curr_char < end && isdigit(*curr_char)) {
         curr_char++;
-        curr_digit++;
     }
-    dec_repr->n_dec_digits += n_dec_digits;
+    return curr_char;
 }
 
 // parse for a Decimal
 // [+|-]<int>[.<frac>][<e|E>[+|-]<exp>] or
 // [+|-].<frac>[<e|E>[+|-]<exp>].
+// If end is NULL, the literal must be consumed completely (except for
+// trailing whitespace), otherwise parsing stops after the longest valid
+// prefix and end is set to the first char not consumed.
 error_t
-parse_ascii_dec_literal(dec_repr_t *result, const char *literal) {
+parse_ascii_dec_literal(dec_repr_t *result, const char *literal,
+                        size_t n_chars, const char **end_of_literal) {
     const char *curr_char = literal;
+    const char *end = literal + n_chars;
     const char *int_part = NULL;
     const char *signif_int_part = NULL;
     ptrdiff_t len_int_part;
@@ -48,10 +62,10 @@ parse_ascii_dec_literal(dec_repr_t *result, const char *literal) {
     ptrdiff_t len_frac_part = 0;
     int64_t t;
 
-    while isspace(*curr_char) {
+    while (curr_char < end && isspace(*curr_char)) {
         curr_char++;
     }
-    if (*curr_char == 0) return FPDEC_INVALID_DECIMAL_LITERAL;
+    if (curr_char == end) return FPDEC_INVALID_DECIMAL_LITERAL;
 
     result->negative = false;
     result->exp = 0;
@@ -65,59 +79,65 @@ parse_ascii_dec_literal(dec_repr_t *result, const char *literal) {
             curr_char++;
     }
     int_part = curr_char;
-    while (*curr_char == '0') {
-        curr_char++;
-    }
+    curr_char = skip_zeros(curr_char, end);
     signif_int_part = curr_char;
-    while (isdigit(*curr_char)) {
-        curr_char++;
-    }
+    curr_char = skip_digits(curr_char, end);
     len_int_part = curr_char - signif_int_part;
-    if (*curr_char == '.') {
+    frac_part = curr_char;
+    if (curr_char < end && *curr_char == '.') {
         curr_char++;
         frac_part = curr_char;
-        while (isdigit(*curr_char)) {
-            curr_char++;
-        }
+        curr_char = skip_digits(curr_char, end);
         len_frac_part = curr_char - frac_part;
     }
     if (len_int_part == 0 && len_frac_part == 0) {
-        if (*int_part == '0') {
+        if (int_part < end && *int_part == '0') {
             signif_int_part = int_part;
             len_int_part = 1;
         }
         else
             return FPDEC_INVALID_DECIMAL_LITERAL;
     }
-    if (*curr_char == 'e' || *curr_char == 'E') {
+    if (curr_char < end && (*curr_char == 'e' || *curr_char == 'E')) {
+        const char *exp_part = curr_char;
         int8_t sign = 1;
         int64_t exp = 0;
         curr_char++;
-        switch (*curr_char) {
-            case '-':
-                sign = -1;
-                FALLTHROUGH;
-            case '+':
+        if (curr_char < end) {
+            switch (*curr_char) {
+                case '-':
+                    sign = -1;
+                    FALLTHROUGH;
+                case '+':
+                    curr_char++;
+            }
+        }
+        if (curr_char < end && isdigit(*curr_char)) {
+            while (curr_char < end && isdigit(*curr_char)) {
+                t = exp;
+                exp = exp * 10 + (*curr_char - '0');
+                if (exp < t)    // overflow occured!
+                    return FPDEC_EXP_LIMIT_EXCEEDED;
                 curr_char++;
-                break;
-            default:
-                if (!isdigit(*curr_char))
-                    return FPDEC_INVALID_DECIMAL_LITERAL;
+            }
+            result->exp = sign * exp;
         }
-        while isdigit(*curr_char) {
-            t = exp;
-            exp = exp * 10 + (*curr_char - '0');
-            if (exp < t)    // overflow occured!
-                return FPDEC_EXP_LIMIT_EXCEEDED;
+        else if (end_of_literal != NULL)
+            // not an exponent, so the prefix ends before the 'e'
+            curr_char = exp_part;
+        else
+            return FPDEC_INVALID_DECIMAL_LITERAL;
+    }
+    if (end_of_literal != NULL) {
+        *end_of_literal = curr_char;
+    }
+    else {
+        while (curr_char < end && isspace(*curr_char)) {
             curr_char++;
         }
-        result->exp = sign * exp;
-    }
-    while isspace(*curr_char) {
-        curr_char++;
+        if (curr_char != end)
+            return FPDEC_INVALID_DECIMAL_LITERAL;
     }
-    if (*curr_char != 0)
-        return FPDEC_INVALID_DECIMAL_LITERAL;
     t = result->exp;
     result->exp -= len_frac_part;
     if (result->exp > t)    // overflow occured!
@@ -129,7 +149,10 @@ parse_ascii_dec_literal(dec_repr_t *result, const char *literal) {
     }
     if (-result->exp > FPDEC_MAX_DEC_PREC)
         return FPDEC_PREC_LIMIT_EXCEEDED;
-    fill_in_digits(result, signif_int_part, len_int_part);
-    fill_in_digits(result, frac_part, len_frac_part);
+    result->int_digits = signif_int_part;
+    result->n_int_digits = len_int_part;
+    result->frac_digits = frac_part;
+    result->n_frac_digits = len_frac_part;
+    result->n_dec_digits = len_int_part + len_frac_part;
     return FPDEC_OK;
 }
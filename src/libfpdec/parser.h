@@ -15,6 +15,8 @@ $Revision$
 #ifndef FPDEC_PARSER_H
 #define FPDEC_PARSER_H
 
+#include <string.h>
+
 #include "common.h"
 #include "helper_macros.h"
 #include "uint64_math.h"
@@ -24,21 +26,143 @@ $Revision$
 *  Types
 *****************************************************************************/
 
-#define COEFF_SIZE_THRESHOLD 255
-
 // represent decimal number as (negative ? -1 : 1) * coeff * pow(10, exp)
+// The decimal digits of coeff are not copied, they are referenced in the
+// parsed literal: the significant integral digits followed by the
+// fractional digits.
 typedef struct {
     bool negative;
     int64_t exp;
     size_t n_dec_digits;
-    dec_digit_t coeff[COEFF_SIZE_THRESHOLD];
+    const char *int_digits;
+    size_t n_int_digits;
+    const char *frac_digits;
+    size_t n_frac_digits;
 } dec_repr_t;
 
+// sequential reader for the decimal digits of a dec_repr_t
+typedef struct {
+    const char *curr;
+    const char *stop;
+    const char *next;
+    const char *next_stop;
+} dec_digits_reader_t;
+
 /*****************************************************************************
 *  Functions
 *****************************************************************************/
 
 error_t
-parse_ascii_dec_literal(dec_repr_t *result, const char *literal);
+parse_ascii_dec_literal(dec_repr_t *result, const char *literal,
+                        size_t n_chars, const char **end_of_literal);
+
+// SWAR conversion of ascii digits, 8 at a time
+
+static inline uint64_t
+load_8_chars(const char *chars) {
+    uint64_t val;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&val, chars, sizeof(val));
+#else
+    const unsigned char *uchars = (const unsigned char *)chars;
+    val = 0;
+    for (int i = 7; i >= 0; --i)
+        val = (val << 8U) | uchars[i];
+#endif
+    return val;     // first char in lowest byte
+}
+
+static inline bool
+chars_are_8_digits(const char *chars) {
+    uint64_t val = load_8_chars(chars);
+    // each byte must be 0x3X, and adding 6 must not carry into high nibble
+    return ((val & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((val + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4U))
+           == 0x3333333333333333ULL;
+}
+
+static inline bool
+chars_are_8_zeros(const char *chars) {
+    return load_8_chars(chars) == 0x3030303030303030ULL;
+}
+
+static inline uint32_t
+u32_from_8_digits(const char *chars) {
+    uint64_t val = load_8_chars(chars) & 0x0F0F0F0F0F0F0F0FULL;
+    // combine pairs, quads and octets of digits
+    val = (val * 2561U) >> 8U;
+    val = ((val & 0x00FF00FF00FF00FFULL) * 6553601U) >> 16U;
+    return (uint32_t)(((val & 0x0000FFFF0000FFFFULL) * 42949672960001ULL)
+                      >> 32U);
+}
+
+static inline uint32_t
+u32_from_4_digits(const char *chars) {
+    uint32_t val;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&val, chars, sizeof(val));
+#else
+    const unsigned char *uchars = (const unsigned char *)chars;
+    val = uchars[0] | (uchars[1] << 8U) | (uchars[2] << 16U) |
+          ((uint32_t)uchars[3] << 24U);
+#endif
+    val &= 0x0F0F0F0FU;
+    val = ((val * 10U) + (val >> 8U)) & 0x00FF00FFU;
+    return ((val * 100U) + (val >> 16U)) & 0xFFFFU;
+}
+
+static inline uint64_t
+u64_from_digits(const char *chars, size_t n_digits) {
+    uint64_t val = 0;
+
+    assert(n_digits <= UINT64_10_POW_N_CUTOFF);
+
+    for (; n_digits >= 8; n_digits -= 8, chars += 8)
+        val = val * 100000000UL + u32_from_8_digits(chars);
+    if (n_digits >= 4) {
+        val = val * 10000U + u32_from_4_digits(chars);
+        n_digits -= 4;
+        chars += 4;
+    }
+    for (; n_digits > 0; --n_digits, ++chars)
+        val = val * 10U + (*chars - '0');
+    return val;
+}
+
+// Digits reader
+
+static inline void
+dec_digits_reader_init(dec_digits_reader_t *reader,
+                       const dec_repr_t *dec_repr) {
+    reader->curr = dec_repr->int_digits;
+    reader->stop = dec_repr->int_digits + dec_repr->n_int_digits;
+    reader->next = dec_repr->frac_digits;
+    reader->next_stop = dec_repr->frac_digits + dec_repr->n_frac_digits;
+}
+
+// Returns the value of the next n_digits decimal digits. Missing digits at
+// the end of the coefficient are taken as zeros.
+static inline uint64_t
+dec_digits_read(dec_digits_reader_t *reader, size_t n_digits) {
+    uint64_t val = 0;
+    size_t n;
+
+    assert(n_digits <= UINT64_10_POW_N_CUTOFF);
+
+    while (n_digits > 0) {
+        if (reader->curr == reader->stop) {
+            if (reader->next == reader->next_stop)
+                return val * u64_10_pow_n(n_digits);
+            reader->curr = reader->next;
+            reader->stop = reader->next_stop;
+            reader->next = reader->next_stop;
+        }
+        n = MIN(n_digits, (size_t)(reader->stop - reader->curr));
+        val = val * u64_10_pow_n(n) + u64_from_digits(reader->curr, n);
+        reader->curr += n;
+        n_digits -= n;
+    }
+    return val;
+}
 
 #endif //FPDEC_PARSER_H
@@ -14,16 +14,24 @@ $Revision$
 */
 
 #include <assert.h>
+#include <stdatomic.h>
 
+#include "compiler_macros.h"
 #include "rounding_helper.h"
 
 
-static enum FPDEC_ROUNDING_MODE dflt_rounding_mode = FPDEC_ROUND_HALF_EVEN;
+static _Atomic enum FPDEC_ROUNDING_MODE dflt_rounding_mode =
+    FPDEC_ROUND_HALF_EVEN;
+
+static THREAD_LOCAL enum FPDEC_ROUNDING_MODE thread_dflt_rounding_mode =
+    FPDEC_ROUND_DEFAULT;
 
 
 enum FPDEC_ROUNDING_MODE
 fpdec_get_default_rounding_mode() {
-    return dflt_rounding_mode;
+    if (thread_dflt_rounding_mode != FPDEC_ROUND_DEFAULT)
+        return thread_dflt_rounding_mode;
+    return atomic_load_explicit(&dflt_rounding_mode, memory_order_relaxed);
 }
 
 
@@ -32,7 +40,23 @@ fpdec_set_default_rounding_mode(enum FPDEC_ROUNDING_MODE rnd) {
     assert(rnd > FPDEC_ROUND_DEFAULT);
     assert(rnd <= FPDEC_MAX_ROUNDING_MODE);
 
-    dflt_rounding_mode = rnd;
+    atomic_store_explicit(&dflt_rounding_mode, rnd, memory_order_relaxed);
+    return rnd;
+}
+
+
+enum FPDEC_ROUNDING_MODE
+fpdec_get_thread_default_rounding_mode() {
+    return thread_dflt_rounding_mode;
+}
+
+
+enum FPDEC_ROUNDING_MODE
+fpdec_set_thread_default_rounding_mode(enum FPDEC_ROUNDING_MODE rnd) {
+    assert(rnd >= FPDEC_ROUND_DEFAULT);
+    assert(rnd <= FPDEC_MAX_ROUNDING_MODE);
+
+    thread_dflt_rounding_mode = rnd;
     return rnd;
 }
 
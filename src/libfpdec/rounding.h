@@ -46,4 +46,16 @@ fpdec_get_default_rounding_mode();
 enum FPDEC_ROUNDING_MODE
 fpdec_set_default_rounding_mode(enum FPDEC_ROUNDING_MODE);
 
+// The default rounding mode can be overridden per thread. If set, the
+// thread-specific mode is used instead of the process-wide default for
+// all operations done in the calling thread.
+// FPDEC_ROUND_DEFAULT is returned resp. can be set to indicate that no
+// thread-specific mode is set.
+
+enum FPDEC_ROUNDING_MODE
+fpdec_get_thread_default_rounding_mode();
+
+enum FPDEC_ROUNDING_MODE
+fpdec_set_thread_default_rounding_mode(enum FPDEC_ROUNDING_MODE);
+
 #endif //FPDEC_ROUNDING_H
@@ -110,7 +110,8 @@ round_u128(fpdec_sign_t sign, uint128_t *quot, uint128_t *rem,
     switch (rounding) {
         case FPDEC_ROUND_05UP:
             // Round down unless last digit is 0 or 5
-            if (U128P_LO(quot) % 5 == 0)
+            // (2 ^ 64 % 5 == 1, so quot % 5 is the sum of its words % 5)
+            if ((U128P_HI(quot) % 5 + U128P_LO(quot) % 5) % 5 == 0)
                 return true;
             break;
         case FPDEC_ROUND_CEILING:
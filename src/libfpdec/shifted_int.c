@@ -33,61 +33,66 @@ int
 shint_cmp_abs(uint128_t x, fpdec_dec_prec_t x_prec,
               uint128_t y, fpdec_dec_prec_t y_prec) {
     // Based on the limits of the shifted int representation:
-    // x < 2^96, y < 2^96, 0 <= x_prec <= 9, 0 <= y_prec <= 9
-    if (x_prec < y_prec)
-        // 0 <= y_prec - x_prec <= 9
-        // => x * 10^(y_prec - x_prec) <= 2^96 * 10^9 < 2^128
+    // x < 2^96, y < 2^96, 0 <= x_prec <= 18, 0 <= y_prec <= 18
+    // Aligning the precisions may overflow 2^128; in that case the aligned
+    // value is greater than the other one.
+    if (x_prec < y_prec) {
         u128_imul_10_pow_n(&x, y_prec - x_prec);
-    else if (y_prec < x_prec)
-        // 0 <= x_prec - y_prec <= 9
-        // => y * 10^(x_prec - y_prec) <= 2^96 * 10^9 < 2^128
+        if (UINT128_CHECK_MAX(&x))
+            return 1;
+    }
+    else if (y_prec < x_prec) {
         u128_imul_10_pow_n(&y, x_prec - y_prec);
+        if (UINT128_CHECK_MAX(&y))
+            return -1;
+    }
     return u128_cmp(x, y);
 }
 
 // Converter
 
 error_t
-shint_from_dec_coeff(uint64_t *lo, uint32_t *hi, const dec_digit_t *coeff,
-                     const size_t n_dec_digits, const size_t n_add_zeros) {
-    const dec_digit_t *stop = coeff + n_dec_digits;
-    const dec_digit_t *cut = MIN(coeff + UINT64_10_POW_N_CUTOFF, stop);
+shint_from_dec_repr(uint64_t *lo, uint32_t *hi, const dec_repr_t *dec_repr,
+                    const size_t n_add_zeros) {
+    size_t n_dec_digits = dec_repr->n_dec_digits;
+    dec_digits_reader_t reader;
+    uint128_t sh;
     uint64_t t;
 
-    *hi = 0;
-    *lo = *coeff;
-    coeff++;
+    assert(n_dec_digits <= MAX_N_DEC_DIGITS_IN_SHINT);
 
-    for (; coeff < cut; ++coeff) {
-        *lo *= 10UL;
-        *lo += *coeff;              // *coeff is < 10, so no overflow here
+    if (n_dec_digits <= UINT64_10_POW_N_CUTOFF) {
+        t = u64_from_digits(dec_repr->int_digits, dec_repr->n_int_digits);
+        if (dec_repr->n_frac_digits > 0) {
+            t = t * u64_10_pow_n(dec_repr->n_frac_digits) +
+                u64_from_digits(dec_repr->frac_digits,
+                                dec_repr->n_frac_digits);
+        }
+        U128_FROM_LO_HI(&sh, t, 0);
     }
-    for (; coeff < stop; ++coeff) {
-        t = *hi * 10UL +
-            U64_HI(U64_HI(*lo) * 10UL + U64_HI(U64_LO(*lo) * 10UL));
-        *lo *= 10UL;
-        *lo += *coeff;
-        if (*lo < *coeff)
-            t++;
-        if (U64_HI(t))
-            goto OVERFLOW;
-        *hi = t;
+    else {
+        dec_digits_reader_init(&reader, dec_repr);
+        // leading digits * 10^19 + trailing 19 digits, can't overflow 2^128
+        t = dec_digits_read(&reader, n_dec_digits - UINT64_10_POW_N_CUTOFF);
+        u64_mul_u64(&sh, t, u64_10_pow_n(UINT64_10_POW_N_CUTOFF));
+        t = dec_digits_read(&reader, UINT64_10_POW_N_CUTOFF);
+        u128_iadd_u64(&sh, t);
     }
     if (n_add_zeros > 0) {
         uint8_t n_left_to_shift = n_add_zeros;
         uint8_t n_shift;
-        uint128_t sh;
-        U128_FROM_LO_HI(&sh, *lo, *hi);
         while (n_left_to_shift > 0) {
             n_shift = MIN(n_left_to_shift, UINT64_10_POW_N_CUTOFF);
             u128_imul_10_pow_n(&sh, n_shift);
-            if (UINT128_CHECK_MAX(&sh) || U64_HI(U128_HI(sh)))
+            if (UINT128_CHECK_MAX(&sh))
                 goto OVERFLOW;
             n_left_to_shift -= n_shift;
         }
-        *hi = (uint32_t)U128_HI(sh);
-        *lo = U128_LO(sh);
     }
+    if (!U128_FITS_SHINT(sh))
+        goto OVERFLOW;
+    *hi = (uint32_t)U128_HI(sh);
+    *lo = U128_LO(sh);
     return FPDEC_OK;
 
 OVERFLOW:
@@ -98,18 +103,26 @@ OVERFLOW:
 
 // Decimal shift
 
-static void
+// delta indicates non-zero digits already shifted out of x; returns true if
+// the result is inexact
+static bool
 u128_idivr_10_pow_n(uint128_t *x, const fpdec_sign_t sign, const uint8_t n,
+                    const bool delta,
                     const enum FPDEC_ROUNDING_MODE rounding) {
     uint64_t rem, divisor;
+    uint128_t t;
 
     assert(n <= UINT64_10_POW_N_CUTOFF);
 
     divisor = u64_10_pow_n(n);
     rem = u128_idiv_u64(x, divisor);
-    if (rem > 0 && round_qr(sign, U128P_LO(x), rem, false, divisor, rounding)
-                   > 0)
+    if (rem == 0 && !delta)
+        return false;
+    // round_qr only looks at the last decimal digit of the quotient
+    t = *x;
+    if (round_qr(sign, u128_idiv_10(&t), rem, delta, divisor, rounding) > 0)
         u128_incr(x);
+    return true;
 }
 
 void
@@ -126,10 +139,12 @@ u128_idecshift(uint128_t *ui, fpdec_sign_t sign, int32_t n_dec_digits,
     if (n_dec_digits < 0) {
         n_dec_digits = -n_dec_digits;
         int32_t dec_shift = MIN(n_dec_digits, UINT64_10_POW_N_CUTOFF);
+        bool delta = false;
         if (dec_shift < n_dec_digits) {
-            u128_idivr_10_pow_n(ui, sign, dec_shift, FPDEC_ROUND_DOWN);
+            delta = u128_idivr_10_pow_n(ui, sign, dec_shift, false,
+                                        FPDEC_ROUND_DOWN);
             dec_shift = n_dec_digits - dec_shift;
         }
-        u128_idivr_10_pow_n(ui, sign, dec_shift, rounding);
+        u128_idivr_10_pow_n(ui, sign, dec_shift, delta, rounding);
     }
 }
@@ -17,11 +17,12 @@ $Revision$
 #ifndef FPDEC_SHIFTED_INT_H
 #define FPDEC_SHIFTED_INT_H
 
-#include <math.h>
 #include <stddef.h>
 
 #include "basemath.h"
+#include "fpdec_struct.h"
 #include "helper_macros.h"
+#include "parser.h"
 #include "rounding_helper.h"
 
 /*****************************************************************************
@@ -29,14 +30,13 @@ $Revision$
 *****************************************************************************/
 
 #define MAX_N_DEC_DIGITS_IN_SHINT 29
-#define MAX_DEC_PREC_FOR_SHINT 9
+#define MAX_DEC_PREC_FOR_SHINT FPDEC_MAX_DEC_PREC_FOR_SHINT
 
 #define U128_FROM_SHINT(x) U128_RHS(x->lo, x->hi)
 #define U128_FITS_SHINT(x) (U64_HI(U128_HI(x)) == 0)
 
-#define U64_MAGNITUDE(x) ((int) log10(x))
-#define U128_MAGNITUDE(lo, hi) ((int) log10(((double) hi) * 0x100000000UL \
-                                * 0x100000000UL + (double) lo))
+#define U64_MAGNITUDE(x) ((int)u64_n_dec_digits(x) - 1)
+#define U128_MAGNITUDE(lo, hi) ((int)u128_n_dec_digits((lo), (hi)) - 1)
 
 /*****************************************************************************
 *  Functions
@@ -51,8 +51,8 @@ shint_cmp_abs(uint128_t x, fpdec_dec_prec_t x_prec,
 // Converter
 
 error_t
-shint_from_dec_coeff(uint64_t *lo, uint32_t *hi, const dec_digit_t *coeff,
-                     size_t n_dec_digits, size_t n_add_zeros);
+shint_from_dec_repr(uint64_t *lo, uint32_t *hi, const dec_repr_t *dec_repr,
+                    size_t n_add_zeros);
 
 // Decimal shift
 
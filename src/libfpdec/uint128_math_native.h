@@ -122,11 +122,20 @@ u64_mul_u64(uint128_t *z, const uint64_t x, const uint64_t y) {
 
 static inline void
 u128_imul_u64(uint128_t *x, const uint64_t y) {
-    if (U128_HI((uint128_t)U128P_HI(x) * y) != 0) {
+    uint128_t hi = (uint128_t)U128P_HI(x) * y;
+    uint128_t lo = (uint128_t)U128P_LO(x) * y;
+
+    if (U128_HI(hi) != 0) {
+        SIGNAL_OVERFLOW(x);
+        return;
+    }
+    hi = (hi << 64) + lo;
+    // carry-over from lower half?
+    if (hi < lo) {
         SIGNAL_OVERFLOW(x);
         return;
     }
-    *x *= y;
+    *x = hi;
 }
 
 static inline void
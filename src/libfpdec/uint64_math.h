@@ -17,6 +17,7 @@ $Revision$
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 /*****************************************************************************
 *  Macros
@@ -47,6 +48,9 @@ $Revision$
 
 static inline unsigned
 u64_most_signif_bit_pos(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return x == 0 ? 0 : 63U - (unsigned)__builtin_clzll(x);
+#else
     unsigned n = 0;
     uint64_t t;
 
@@ -58,6 +62,7 @@ u64_most_signif_bit_pos(uint64_t x) {
         }
     }
     return n;
+#endif
 }
 
 static inline unsigned
@@ -97,4 +102,132 @@ u64_10_pow_n(int exp) {
     return U64_10_pows[exp];
 }
 
+// number of decimal digits
+
+// 10 ^ 19 .. 10 ^ 38 as pairs of u64 (lo, hi)
+static const uint64_t U128_10_pows[20][2] = {
+    {10000000000000000000UL, 0UL},
+    {7766279631452241920UL, 5UL},
+    {3875820019684212736UL, 54UL},
+    {1864712049423024128UL, 542UL},
+    {200376420520689664UL, 5421UL},
+    {2003764205206896640UL, 54210UL},
+    {1590897978359414784UL, 542101UL},
+    {15908979783594147840UL, 5421010UL},
+    {11515845246265065472UL, 54210108UL},
+    {4477988020393345024UL, 542101086UL},
+    {7886392056514347008UL, 5421010862UL},
+    {5076944270305263616UL, 54210108624UL},
+    {13875954555633532928UL, 542101086242UL},
+    {9632337040368467968UL, 5421010862427UL},
+    {4089650035136921600UL, 54210108624275UL},
+    {4003012203950112768UL, 542101086242752UL},
+    {3136633892082024448UL, 5421010862427522UL},
+    {12919594847110692864UL, 54210108624275221UL},
+    {68739955140067328UL, 542101086242752217UL},
+    {687399551400673280UL, 5421010862427522170UL}
+};
+
+// log10(2) ~ 1233 / 2^12, which gives floor(n_bits * log10(2)) for all
+// n_bits <= 128; the number of decimal digits of a value with n_bits bits
+// is either that or one more.
+
+static inline unsigned
+u64_n_dec_digits(const uint64_t x) {
+    unsigned n_bits = u64_most_signif_bit_pos(x | 1U) + 1U;
+    unsigned n = (n_bits * 1233U) >> 12U;
+    return n + ((x | 1U) >= U64_10_pows[n]);
+}
+
+static inline unsigned
+u128_n_dec_digits(const uint64_t lo, const uint64_t hi) {
+    unsigned n_bits, n;
+
+    if (hi == 0)
+        return u64_n_dec_digits(lo);
+    n_bits = u64_most_signif_bit_pos(hi) + 65U;
+    n = ((n_bits * 1233U) >> 12U) - UINT64_10_POW_N_CUTOFF;
+    assert(n < 20);
+    return n + UINT64_10_POW_N_CUTOFF +
+           (hi > U128_10_pows[n][1] ||
+            (hi == U128_10_pows[n][1] && lo >= U128_10_pows[n][0]));
+}
+
+// Returns the number of trailing decimal zeros of x (> 0), splitting them
+// off in chunks of 16, 8, 4, 2 and 1.
+static inline unsigned
+u64_n_trailing_dec_zeros(uint64_t x) {
+    unsigned n = 0;
+
+    assert(x > 0);
+
+    if (x % 10000000000000000UL == 0) {
+        x /= 10000000000000000UL;
+        n += 16;
+    }
+    if (x % 100000000U == 0) {
+        x /= 100000000U;
+        n += 8;
+    }
+    if (x % 10000U == 0) {
+        x /= 10000U;
+        n += 4;
+    }
+    if (x % 100U == 0) {
+        x /= 100U;
+        n += 2;
+    }
+    return n + (x % 10U == 0);
+}
+
+// decimal digits as chars
+
+// "00" .. "99"
+static const char DEC_DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the n (<= 8) least significant decimal digits of x to buf, two at
+// a time.
+static inline void
+u32_fill_in_dec_digits(uint8_t *buf, uint32_t x, int n) {
+    uint32_t q;
+
+    for (; n >= 2; x = q) {
+        q = x / 100U;
+        n -= 2;
+        memcpy(buf + n, DEC_DIGIT_PAIRS + 2U * (x - 100U * q), 2);
+    }
+    if (n == 1)
+        *buf = '0' + x % 10U;
+}
+
+// Writes x < 10 ^ n as exactly n decimal digits (incl. leading zeros) to
+// buf and returns a pointer to the byte following them. The digits are
+// split into chunks of 8, so that all remaining divisions are 32-bit
+// divisions by a constant.
+static inline uint8_t *
+u64_fill_in_dec_digits(uint8_t *buf, uint64_t x, int n) {
+    uint8_t *stop = buf + n;
+    uint8_t *ch = stop;
+    uint64_t q;
+
+    for (; n > 8; x = q) {
+        q = x / 100000000UL;
+        ch -= 8;
+        n -= 8;
+        u32_fill_in_dec_digits(ch, (uint32_t)(x - 100000000UL * q), 8);
+    }
+    u32_fill_in_dec_digits(buf, (uint32_t)x, n);
+    return stop;
+}
+
 #endif //FPDEC_UINT64_MATH_H
@@ -0,0 +1,286 @@
+/* ---------------------------------------------------------------------------
+Name:        accumulator_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "3", "-0.0000000000000000012",
+    "123456789012.345", "79228162514264337593543950335",
+    "-1234567890123456789012345.6789", "0.00000000000000000000000005",
+    "1.0000000000000000000000000000000000000001",
+    "-99999999999999999999999999999999999999.99999999999999999999",
+    "4.5e30", "-2.5e-40", "-79228162514264337593543950335",
+};
+static const size_t n_literals = sizeof(literals) / sizeof(literals[0]);
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected,
+            fpdec_dec_prec_t dec_prec) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == dec_prec);
+}
+
+// Adds resp. subtracts the literals, starting at the given one, and checks
+// the intermediate results against the sums calculated by fpdec_add /
+// fpdec_sub. The precision of the result is the max precision of the
+// non-zero values added.
+static void
+check_running_sum(size_t start, bool subtract) {
+    fpdec_accumulator_t acc;
+    fpdec_t sum = FPDEC_ZERO;
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t t = FPDEC_ZERO;
+    fpdec_t res = FPDEC_ZERO;
+    fpdec_dec_prec_t dec_prec = 0;
+
+    fpdec_accumulator_init(&acc);
+    for (size_t i = 0; i < n_literals; ++i) {
+        const char *lit = literals[(start + i) % n_literals];
+        REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+        if (subtract && i % 2 == 1) {
+            REQUIRE(fpdec_accumulator_sub(&acc, &x) == FPDEC_OK);
+            REQUIRE(fpdec_sub(&t, &sum, &x) == FPDEC_OK);
+        }
+        else {
+            REQUIRE(fpdec_accumulator_add(&acc, &x) == FPDEC_OK);
+            REQUIRE(fpdec_add(&t, &sum, &x) == FPDEC_OK);
+        }
+        if (!FPDEC_EQ_ZERO(&x))
+            dec_prec = std::max(dec_prec, FPDEC_DEC_PREC(&x));
+        fpdec_reset_to_zero(&sum, 0);
+        sum = t;
+        t = FPDEC_ZERO;
+        REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+        check_equal(&res, &sum, dec_prec);
+        fpdec_reset_to_zero(&res, 0);
+        fpdec_reset_to_zero(&x, 0);
+    }
+    fpdec_accumulator_reset(&acc);
+    fpdec_reset_to_zero(&sum, 0);
+}
+
+TEST_CASE("Accumulator") {
+
+    SECTION("Empty") {
+        fpdec_accumulator_t acc;
+        fpdec_t res = FPDEC_ZERO;
+
+        fpdec_accumulator_init(&acc);
+        REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+        CHECK(FPDEC_EQ_ZERO(&res));
+        CHECK(FPDEC_DEC_PREC(&res) == 0);
+        fpdec_accumulator_reset(&acc);
+    }
+
+    SECTION("Add") {
+        for (size_t start = 0; start < n_literals; ++start)
+            check_running_sum(start, false);
+    }
+
+    SECTION("Add / sub") {
+        for (size_t start = 0; start < n_literals; ++start)
+            check_running_sum(start, true);
+    }
+
+    SECTION("Zero sum keeps precision") {
+        fpdec_accumulator_t acc;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t res = FPDEC_ZERO;
+
+        fpdec_accumulator_init(&acc);
+        REQUIRE(fpdec_from_ascii_literal(&x, "-1234567890123456789012345.6789")
+                == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_add(&acc, &x) == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_sub(&acc, &x) == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+        CHECK(FPDEC_EQ_ZERO(&res));
+        CHECK(FPDEC_DEC_PREC(&res) == 4);
+        fpdec_accumulator_reset(&acc);
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Large shifted ints") {
+        const char *const lits[] = {
+            "0.000000000000000001", "18446744073709551615",
+            "-79228162514264337593543950335", "18446744073709551615",
+            "18446744073709551615", "79228162514264337593543950335",
+            "18446744073709551615", "18446744073709551615",
+            "-0.000000000000000003", "18446744073709551615",
+        };
+        fpdec_accumulator_t acc;
+        fpdec_t sum = FPDEC_ZERO;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t t = FPDEC_ZERO;
+        fpdec_t res = FPDEC_ZERO;
+
+        fpdec_accumulator_init(&acc);
+        for (int i = 0; i < 3; ++i)
+            for (const char *lit : lits) {
+                REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+                REQUIRE(fpdec_accumulator_add(&acc, &x) == FPDEC_OK);
+                REQUIRE(fpdec_add(&t, &sum, &x) == FPDEC_OK);
+                fpdec_reset_to_zero(&sum, 0);
+                sum = t;
+                t = FPDEC_ZERO;
+                fpdec_reset_to_zero(&x, 0);
+            }
+        REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+        check_equal(&res, &sum, 18);
+        fpdec_accumulator_reset(&acc);
+        fpdec_reset_to_zero(&res, 0);
+        fpdec_reset_to_zero(&sum, 0);
+    }
+
+    SECTION("Integers") {
+        const long long vals[] = {
+            LLONG_MAX, LLONG_MIN, 5, -17, LLONG_MIN, LLONG_MIN, 0,
+        };
+        fpdec_accumulator_t acc;
+        fpdec_t sum = FPDEC_ZERO;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t t = FPDEC_ZERO;
+        fpdec_t res = FPDEC_ZERO;
+
+        fpdec_accumulator_init(&acc);
+        for (long long val : vals) {
+            REQUIRE(fpdec_accumulator_add_long_long(&acc, val) == FPDEC_OK);
+            REQUIRE(fpdec_from_long_long(&x, val) == FPDEC_OK);
+            REQUIRE(fpdec_add(&t, &sum, &x) == FPDEC_OK);
+            fpdec_reset_to_zero(&sum, 0);
+            sum = t;
+            t = FPDEC_ZERO;
+            REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+            check_equal(&res, &sum, 0);
+            fpdec_reset_to_zero(&res, 0);
+            fpdec_reset_to_zero(&x, 0);
+        }
+        fpdec_accumulator_reset(&acc);
+        fpdec_reset_to_zero(&sum, 0);
+    }
+}
+
+static size_t n_allocs = 0;
+
+static void *
+counting_alloc(size_t num, size_t size) {
+    n_allocs++;
+    return calloc(num, size);
+}
+
+TEST_CASE("Accumulator: reuse of registers") {
+    fpdec_accumulator_t acc;
+    fpdec_t posting = FPDEC_ZERO;
+    fpdec_t fee = FPDEC_ZERO;
+    fpdec_t res = FPDEC_ZERO;
+    fpdec_t expected = FPDEC_ZERO;
+
+    REQUIRE(fpdec_from_ascii_literal(&posting, "1234567.89") == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&fee, "0.0000000000000000000000025")
+            == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&expected,
+                                     "123456688.9999999999999999999997500")
+            == FPDEC_OK);
+
+    fpdec_accumulator_init(&acc);
+    fpdec_set_mem_funcs(counting_alloc, free);
+    n_allocs = 0;
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(fpdec_accumulator_add(&acc, &posting) == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_sub(&acc, &fee) == FPDEC_OK);
+        if (i % 10 == 0)
+            REQUIRE(fpdec_accumulator_add_long_long(&acc, -1) == FPDEC_OK);
+    }
+    // one register for each sign, plus one for aligning the positive
+    // register to the exponent of the fee
+    CHECK(n_allocs <= 3);
+    fpdec_accumulator_reset(&acc);
+    fpdec_set_mem_funcs(NULL, NULL);
+    REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+    CHECK(FPDEC_EQ_ZERO(&res));
+
+    fpdec_accumulator_init(&acc);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(fpdec_accumulator_add(&acc, &posting) == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_sub(&acc, &fee) == FPDEC_OK);
+        REQUIRE(fpdec_accumulator_add_long_long(&acc, -1) == FPDEC_OK);
+    }
+    REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+    check_equal(&res, &expected, 25);
+    fpdec_accumulator_reset(&acc);
+
+    fpdec_reset_to_zero(&posting, 0);
+    fpdec_reset_to_zero(&fee, 0);
+    fpdec_reset_to_zero(&res, 0);
+    fpdec_reset_to_zero(&expected, 0);
+}
+
+static size_t n_allocs_until_failure = 0;
+
+// fails on the n_allocs_until_failure-th call
+static void *
+failing_alloc(size_t num, size_t size) {
+    if (--n_allocs_until_failure == 0)
+        return NULL;
+    return calloc(num, size);
+}
+
+TEST_CASE("Accumulator: allocation failure") {
+    fpdec_accumulator_t acc;
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t fine = FPDEC_ZERO;
+    fpdec_t res = FPDEC_ZERO;
+    fpdec_t expected = FPDEC_ZERO;
+
+    REQUIRE(fpdec_from_ascii_literal(
+        &x, "12345678901234567890123456789012345678") == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(
+        &y, "-2345678901234567890123456789012345678") == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(
+        &fine, "0.0000000000000000000000000000000000017") == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(
+        &expected,
+        "10000000000000000000000000000000000000."
+        "0000000000000000000000000000000000017") == FPDEC_OK);
+
+    fpdec_accumulator_init(&acc);
+    REQUIRE(fpdec_accumulator_add(&acc, &x) == FPDEC_OK);
+    REQUIRE(fpdec_accumulator_add(&acc, &y) == FPDEC_OK);
+    // aligning both registers to the exponent of fine: the second
+    // allocation fails
+    fpdec_set_thread_mem_funcs(failing_alloc, free);
+    n_allocs_until_failure = 2;
+    CHECK(fpdec_accumulator_add(&acc, &fine) == ENOMEM);
+    fpdec_set_thread_mem_funcs(NULL, NULL);
+    // the sum is unchanged
+    REQUIRE(fpdec_accumulator_add(&acc, &fine) == FPDEC_OK);
+    REQUIRE(fpdec_accumulator_result(&res, &acc) == FPDEC_OK);
+    check_equal(&res, &expected, 37);
+    fpdec_accumulator_reset(&acc);
+
+    fpdec_reset_to_zero(&x, 0);
+    fpdec_reset_to_zero(&y, 0);
+    fpdec_reset_to_zero(&fine, 0);
+    fpdec_reset_to_zero(&res, 0);
+    fpdec_reset_to_zero(&expected, 0);
+}
@@ -619,3 +619,86 @@ TEST_CASE("Subtraction with change of variant") {
     }
 }
 
+
+TEST_CASE("Addition / Subtraction exceeding shint limits") {
+
+    struct test_data {
+        std::string lit_x;
+        std::string lit_y;
+        std::string lit_sum;
+        std::string lit_diff;
+    };
+
+    struct test_data tests[] = {
+            {
+                    .lit_x = "79228162514264337593543950335",
+                    .lit_y = "1",
+                    .lit_sum = "79228162514264337593543950336",
+                    .lit_diff = "79228162514264337593543950334",
+            },
+            {
+                    .lit_x = "79228162514264337593543950335",
+                    .lit_y = "79228162514264337593543950335",
+                    .lit_sum = "158456325028528675187087900670",
+                    .lit_diff = "0",
+            },
+            {
+                    .lit_x = "39614081257132168796771975168",
+                    .lit_y = "-0.5",
+                    .lit_sum = "39614081257132168796771975167.5",
+                    .lit_diff = "39614081257132168796771975168.5",
+            },
+            {
+                    .lit_x = "79228162514264337593543950335",
+                    .lit_y = "0.000000000000000001",
+                    .lit_sum = "79228162514264337593543950335"
+                               ".000000000000000001",
+                    .lit_diff = "79228162514264337593543950334"
+                                ".999999999999999999",
+            },
+            {
+                    .lit_x = "12345678901234567890123",
+                    .lit_y = "-0.123456789012345678",
+                    .lit_sum = "12345678901234567890122.876543210987654322",
+                    .lit_diff = "12345678901234567890123.123456789012345678",
+            },
+    };
+    error_t rc;
+
+    for (const auto &test : tests) {
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t z = FPDEC_ZERO;
+        fpdec_t s = FPDEC_ZERO;
+        fpdec_t d = FPDEC_ZERO;
+
+        const std::string section_name = test.lit_x + " / " + test.lit_y;
+
+        SECTION(section_name) {
+            rc = fpdec_from_ascii_literal(&x, test.lit_x.c_str());
+            REQUIRE(rc == FPDEC_OK);
+            rc = fpdec_from_ascii_literal(&y, test.lit_y.c_str());
+            REQUIRE(rc == FPDEC_OK);
+            REQUIRE((is_shint(&x) && is_shint(&y)));
+            rc = fpdec_from_ascii_literal(&s, test.lit_sum.c_str());
+            REQUIRE(rc == FPDEC_OK);
+            rc = fpdec_from_ascii_literal(&d, test.lit_diff.c_str());
+            REQUIRE(rc == FPDEC_OK);
+
+            rc = fpdec_add(&z, &x, &y);
+            REQUIRE(rc == FPDEC_OK);
+            CHECK(fpdec_compare(&z, &s, false) == 0);
+            fpdec_reset_to_zero(&z, 0);
+
+            rc = fpdec_sub(&z, &x, &y);
+            REQUIRE(rc == FPDEC_OK);
+            CHECK(fpdec_compare(&z, &d, false) == 0);
+            fpdec_reset_to_zero(&z, 0);
+        }
+
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&s, 0);
+        fpdec_reset_to_zero(&d, 0);
+    }
+}
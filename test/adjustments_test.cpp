@@ -574,11 +574,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -630,11 +631,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -689,11 +691,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -745,11 +748,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -803,11 +807,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374700000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -861,11 +866,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -917,11 +923,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -973,11 +980,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374600000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -1029,11 +1037,12 @@ TEST_CASE("Adjust presision") {
                 },
                 {
                     .literal =
-                    "-34028236692093.8563463374607431768211554",
+                    "-34028236692093000000.8563463374607431768211554",
                     .dec_prec = 11,
                     .exp = -1,
                     .digits = {8563463374700000000UL,
-                               34028236692093UL}
+                               4028236692093000000UL,
+                               3UL}
                 },
                 {
                     .literal =
@@ -1114,7 +1123,7 @@ TEST_CASE("Adjust presision") {
         struct test_data tests[] = {
             {
                 .literal = "0.0000007",
-                .dec_prec = 10,
+                .dec_prec = 20,
                 .exp = -1,
                 .digits = {7000000000000UL}
             },
@@ -0,0 +1,161 @@
+/* ---------------------------------------------------------------------------
+Name:        batch_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "-0.0000000000000000012",
+    "123456789012.345", "-98765.4321", "79228162514264337593543950335",
+    "-79228162514264337593543950335", "0.999999999999999999",
+    "-1234567890123456789012345.6789", "0.00000000000000000000000005",
+    "4.5e30",
+};
+static const size_t n_literals = sizeof(literals) / sizeof(literals[0]);
+
+static void
+make_operands(std::vector<fpdec_t> &x, std::vector<fpdec_t> &y) {
+    // all combinations of the literals
+    x.assign(n_literals * n_literals, FPDEC_ZERO);
+    y.assign(n_literals * n_literals, FPDEC_ZERO);
+    for (size_t i = 0; i < n_literals; ++i)
+        for (size_t j = 0; j < n_literals; ++j) {
+            REQUIRE(fpdec_from_ascii_literal(&x[i * n_literals + j],
+                                             literals[i]) == FPDEC_OK);
+            REQUIRE(fpdec_from_ascii_literal(&y[i * n_literals + j],
+                                             literals[j]) == FPDEC_OK);
+        }
+}
+
+static void
+reset_all(std::vector<fpdec_t> &v) {
+    for (auto &fpdec : v)
+        fpdec_reset_to_zero(&fpdec, 0);
+}
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == FPDEC_DEC_PREC(expected));
+}
+
+typedef error_t (*bin_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+typedef error_t (*batch_op)(fpdec_t *, const fpdec_t *, const fpdec_t *,
+                            size_t);
+
+TEST_CASE("Batch arithmetic") {
+    std::vector<fpdec_t> x, y;
+    make_operands(x, y);
+    const size_t n = x.size();
+
+    struct {
+        const char *name;
+        bin_op op;
+        batch_op op_n;
+        batch_op op_scalar_n;
+    } ops[] = {
+        {"add", fpdec_add, fpdec_add_n, fpdec_add_scalar_n},
+        {"sub", fpdec_sub, fpdec_sub_n, NULL},
+        {"mul", fpdec_mul, fpdec_mul_n, fpdec_mul_scalar_n},
+    };
+
+    for (const auto &op : ops) {
+
+        SECTION(op.name) {
+            std::vector<fpdec_t> z(n, FPDEC_ZERO);
+            REQUIRE(op.op_n(z.data(), x.data(), y.data(), n) == FPDEC_OK);
+            for (size_t i = 0; i < n; ++i) {
+                fpdec_t expected = FPDEC_ZERO;
+                REQUIRE(op.op(&expected, &x[i], &y[i]) == FPDEC_OK);
+                check_equal(&z[i], &expected);
+                fpdec_reset_to_zero(&expected, 0);
+            }
+            reset_all(z);
+
+            if (op.op_scalar_n != NULL) {
+                for (size_t k = 0; k < n_literals; ++k) {
+                    const fpdec_t *scalar = &y[k];
+                    REQUIRE(op.op_scalar_n(z.data(), x.data(), scalar, n) ==
+                            FPDEC_OK);
+                    for (size_t i = 0; i < n; ++i) {
+                        fpdec_t expected = FPDEC_ZERO;
+                        REQUIRE(op.op(&expected, &x[i], scalar) == FPDEC_OK);
+                        check_equal(&z[i], &expected);
+                        fpdec_reset_to_zero(&expected, 0);
+                    }
+                    reset_all(z);
+                }
+            }
+        }
+    }
+
+    reset_all(x);
+    reset_all(y);
+}
+
+static void *
+failing_alloc(size_t num, size_t size) {
+    return NULL;
+}
+
+TEST_CASE("Batch arithmetic: error resets results") {
+    std::vector<fpdec_t> x, y;
+    make_operands(x, y);
+    const size_t n = x.size();
+    std::vector<fpdec_t> z(n, FPDEC_ZERO);
+
+    fpdec_set_mem_funcs(failing_alloc, free);
+    error_t rc = fpdec_mul_n(z.data(), x.data(), y.data(), n);
+    fpdec_set_mem_funcs(NULL, NULL);
+    CHECK(rc == ENOMEM);
+    for (const auto &fpdec : z) {
+        CHECK(FPDEC_SIGN(&fpdec) == FPDEC_SIGN_ZERO);
+        CHECK(!FPDEC_IS_DYN_ALLOC(&fpdec));
+    }
+
+    reset_all(x);
+    reset_all(y);
+}
+
+TEST_CASE("Batch compare") {
+    std::vector<fpdec_t> x, y;
+    make_operands(x, y);
+    const size_t n = x.size();
+    std::vector<int> res(n);
+
+    for (bool ignore_sign : {false, true}) {
+
+        SECTION(ignore_sign ? "ignore sign" : "respect sign") {
+            fpdec_compare_n(res.data(), x.data(), y.data(), n, ignore_sign);
+            for (size_t i = 0; i < n; ++i)
+                CHECK(res[i] == fpdec_compare(&x[i], &y[i], ignore_sign));
+            for (size_t k = 0; k < n_literals; ++k) {
+                fpdec_compare_scalar_n(res.data(), x.data(), &y[k], n,
+                                       ignore_sign);
+                for (size_t i = 0; i < n; ++i)
+                    CHECK(res[i] == fpdec_compare(&x[i], &y[k], ignore_sign));
+            }
+        }
+    }
+
+    reset_all(x);
+    reset_all(y);
+}
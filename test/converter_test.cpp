@@ -149,6 +149,22 @@ TEST_CASE("As ASCII literal") {
                 lit = NULL;
             }
 
+            SECTION("into buffer") {
+                char buf[64];
+                size_t len;
+
+                rc = fpdec_as_ascii_literal_to_buffer(buf, sizeof(buf), &len,
+                                                      &dec, false);
+                REQUIRE(rc == FPDEC_OK);
+                CHECK(len == literal.size());
+                CHECK(strcmp(buf, literal.c_str()) == 0);
+                rc = fpdec_as_ascii_literal_to_buffer(buf, sizeof(buf), &len,
+                                                      &dec, true);
+                REQUIRE(rc == FPDEC_OK);
+                CHECK(len == stripped.size());
+                CHECK(strcmp(buf, stripped.c_str()) == 0);
+            }
+
             fpdec_reset_to_zero(&dec, 0);
         }
     }
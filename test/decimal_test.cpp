@@ -101,6 +101,20 @@ TEST_CASE("Decimal from string") {
     }
 }
 
+TEST_CASE("Decimal from chars") {
+    const char buf[] = "-5.30,12";
+
+    Decimal d = Decimal(buf, 5);
+    CHECK(d.sign() == -1);
+    CHECK(d.precision() == 2);
+    CHECK(d == Decimal("-5.3"));
+    CHECK(Decimal(buf + 6, 2) == Decimal(12));
+    CHECK_THROWS_AS(Decimal(buf, 6), InvalidDecimalLiteral);
+#if __cplusplus >= 201703L
+    CHECK(Decimal(std::string_view(buf + 1, 4)) == Decimal("5.30"));
+#endif
+}
+
 template<typename T>
 int sign(T num) {
     static_assert(std::is_arithmetic<T>(), "T must be a number type.");
@@ -172,6 +186,21 @@ TEST_CASE("Decimal from Decimal") {
         CHECK(a != e);
         CHECK(e.precision() == 4);
     }
+
+    SECTION("With thread-specific default rounding") {
+        Decimal a = Decimal{"2.5"};
+        CHECK(2 == Decimal(a, 0));
+        {
+            RoundingContext ctx(Rounding::round_half_up);
+            CHECK(3 == Decimal(a, 0));
+            {
+                RoundingContext inner_ctx(Rounding::round_down);
+                CHECK(2 == Decimal(a, 0));
+            }
+            CHECK(3 == Decimal(a, 0));
+        }
+        CHECK(2 == Decimal(a, 0));
+    }
 }
 
 TEST_CASE("Comparison") {
@@ -344,4 +373,52 @@ TEST_CASE("Arithmetic ops") {
         auto x = Decimal(5);
         CHECK_THROWS_AS(x / zero, DivisionByZero);
     }
+
+    SECTION("Compound assignment") {
+        auto x = Decimal("1001000000780000030000000000.25");
+        auto y = Decimal("-17.4");
+        auto z = x;
+        z += y;
+        CHECK(z == x + y);
+        z -= y;
+        CHECK(z == x);
+        z *= y;
+        CHECK(z == x * y);
+        z /= y;
+        CHECK(z == x);
+        z += z;
+        CHECK(z == x * Decimal(2));
+        CHECK_THROWS_AS(z /= Decimal(), DivisionByZero);
+        CHECK(z == x * Decimal(2));
+    }
+
+    SECTION("Assignment") {
+        auto x = Decimal("1001000000780000030000000000.25");
+        auto y = Decimal(5);
+        y = x;
+        x += Decimal(1);
+        CHECK(y == Decimal("1001000000780000030000000000.25"));
+        y = std::move(x);
+        CHECK(y == Decimal("1001000000780000030000000001.25"));
+    }
+}
+
+TEST_CASE("Decimal accumulator") {
+    auto x = Decimal("1001000000780000030000000000.25");
+    auto y = Decimal("-17.4");
+    auto z = Decimal("0.000000000000000000000007");
+    Accumulator acc;
+
+    CHECK(acc.sum() == Decimal());
+    acc += x;
+    acc += y;
+    acc -= z;
+    acc += 5;
+    CHECK(acc.sum() == x + y - z + Decimal(5));
+    CHECK(acc.sum().precision() == 24);
+    acc -= x;
+    CHECK(acc.sum() == y - z + Decimal(5));
+    acc.clear();
+    CHECK(acc.sum() == Decimal());
+    CHECK(acc.sum().precision() == 0);
 }
@@ -0,0 +1,188 @@
+/* ---------------------------------------------------------------------------
+Name:        decimalcolumn_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "decimalcolumn.hpp"
+
+#ifdef __SIZEOF_INT128__
+
+using fpdec::Accumulator;
+using fpdec::Decimal;
+using fpdec::DecimalColumn;
+
+static std::string
+random_digits(std::mt19937_64 &rng, unsigned n) {
+    std::string digits;
+    for (unsigned i = 0; i < n; ++i)
+        digits += (char)('0' + rng() % 10);
+    return digits;
+}
+
+// mix of shifted ints, digit arrays fitting into 127 bits, huge values and
+// zeros with different precisions
+static std::vector<Decimal>
+random_decimals(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Decimal> vals;
+
+    vals.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::string lit = rng() % 2 ? "-" : "";
+        switch (rng() % 6) {
+            case 0:
+                lit += "0." + std::string(rng() % 25, '0');
+                break;
+            case 1:
+                lit += random_digits(rng, 1 + rng() % 8) + "." +
+                       random_digits(rng, 2);
+                break;
+            case 2:
+                lit += random_digits(rng, 1 + rng() % 20) + "." +
+                       random_digits(rng, rng() % 19);
+                break;
+            case 3:
+                lit += random_digits(rng, 1 + rng() % 15) + "." +
+                       random_digits(rng, 19 + rng() % 20);
+                break;
+            case 4:
+                lit += random_digits(rng, 30 + rng() % 20) + "." +
+                       random_digits(rng, rng() % 30);
+                break;
+            default:
+                lit += random_digits(rng, 1 + rng() % 5) + "." +
+                       random_digits(rng, 2);
+        }
+        vals.emplace_back(lit);
+    }
+    return vals;
+}
+
+static bool
+identical(const Decimal &lhs, const Decimal &rhs) {
+    return lhs == rhs && lhs.precision() == rhs.precision();
+}
+
+TEST_CASE("DecimalColumn element access") {
+    std::vector<Decimal> vals = random_decimals(2000, 4711);
+    vals.emplace_back("170141183460469231731687303715884105727");
+    vals.emplace_back("170141183460469231731687303715884105728");
+    vals.emplace_back("-1.70141183460469231731687303715884105727");
+    vals.emplace_back("1e1000");
+    DecimalColumn col(vals);
+
+    REQUIRE(col.size() == vals.size());
+    for (size_t i = 0; i < vals.size(); ++i) {
+        CHECK(identical(col[i], vals[i]));
+        CHECK(col.signs()[i] == vals[i].sign());
+        CHECK(col.precisions()[i] == vals[i].precision());
+    }
+    CHECK(col.is_inline(vals.size() - 4));
+    CHECK(!col.is_inline(vals.size() - 3));
+    CHECK(col.is_inline(vals.size() - 2));
+    CHECK(!col.is_inline(vals.size() - 1));
+    CHECK(col.coeffs_lo()[vals.size() - 4] == UINT64_MAX);
+    CHECK(col.coeffs_hi()[vals.size() - 4] == INT64_MAX);
+
+    col.clear();
+    CHECK(col.empty());
+    col.push_back(Decimal("-7.25"));
+    CHECK(identical(col[0], Decimal("-7.25")));
+}
+
+TEST_CASE("DecimalColumn element-wise operations") {
+    const std::vector<Decimal> xs = random_decimals(3000, 17);
+    const std::vector<Decimal> ys = random_decimals(3000, 18);
+    const DecimalColumn x(xs);
+    const DecimalColumn y(ys);
+
+    const DecimalColumn sum = x + y;
+    const DecimalColumn diff = x - y;
+    const DecimalColumn prod = x * y;
+    const std::vector<int> cmp = x.compare(y);
+    REQUIRE(sum.size() == xs.size());
+    REQUIRE(cmp.size() == xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+        CHECK(identical(sum[i], xs[i] + ys[i]));
+        CHECK(identical(diff[i], xs[i] - ys[i]));
+        CHECK(identical(prod[i], xs[i] * ys[i]));
+        CHECK(cmp[i] == (xs[i] < ys[i] ? -1 : ys[i] < xs[i] ? 1 : 0));
+    }
+
+    // cancellation and zeros
+    const DecimalColumn zero = x - x;
+    const std::vector<int> eq = x.compare(x);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        CHECK(identical(zero[i], xs[i] - xs[i]));
+        CHECK(eq[i] == 0);
+    }
+
+    DecimalColumn short_col;
+    short_col.push_back(Decimal(1));
+    CHECK_THROWS_AS(x + short_col, std::invalid_argument);
+    CHECK_THROWS_AS(x.compare(short_col), std::invalid_argument);
+}
+
+TEST_CASE("DecimalColumn aggregates") {
+    SECTION("Mixed values") {
+        const std::vector<Decimal> vals = random_decimals(5000, 815);
+        const DecimalColumn col(vals);
+        Accumulator acc;
+
+        for (const Decimal &val : vals)
+            acc += val;
+        CHECK(identical(col.sum(), acc.sum()));
+        CHECK(identical(col.min(), *std::min_element(vals.begin(),
+                                                     vals.end())));
+        CHECK(identical(col.max(), *std::max_element(vals.begin(),
+                                                     vals.end())));
+    }
+
+    SECTION("Uniform precision") {
+        std::mt19937_64 rng(42);
+        std::vector<Decimal> vals;
+        Accumulator acc;
+
+        for (int i = 0; i < 1000; ++i) {
+            std::string lit = (rng() % 3 ? "" : "-") +
+                              random_digits(rng, 1 + rng() % 36) + "." +
+                              random_digits(rng, 2);
+            vals.emplace_back(lit);
+            acc += vals.back();
+        }
+        const DecimalColumn col(vals);
+        CHECK(identical(col.sum(), acc.sum()));
+    }
+
+    SECTION("Special cases") {
+        DecimalColumn col;
+
+        CHECK(identical(col.sum(), Decimal()));
+        CHECK_THROWS_AS(col.min(), std::out_of_range);
+        CHECK_THROWS_AS(col.max(), std::out_of_range);
+        col.push_back(Decimal("0.000"));
+        col.push_back(Decimal("2.5"));
+        col.push_back(Decimal("-2.50"));
+        CHECK(identical(col.sum(), Decimal("0.00")));
+        CHECK(identical(col.min(), Decimal("-2.50")));
+        CHECK(identical(col.max(), Decimal("2.5")));
+    }
+}
+
+#endif // __SIZEOF_INT128__
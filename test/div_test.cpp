@@ -90,6 +90,24 @@ TEST_CASE("Div (w/o limit and default rounding)") {
                 .lit_quot = "4.12",
                 .prec_limit = -1,
             },
+            {
+                .lit_x = "173.849428",
+                .lit_y = "10000.00",
+                .lit_quot = "0.0173849428",
+                .prec_limit = -1,
+            },
+            {
+                .lit_x = "1",
+                .lit_y = "0.000000000000000002",
+                .lit_quot = "500000000000000000",
+                .prec_limit = -1,
+            },
+            {
+                .lit_x = "172.9999948",
+                .lit_y = "41.99029",
+                .lit_quot = "4.1200000000",
+                .prec_limit = 10,
+            },
         };
         for (const auto &test : tests) {
 
@@ -112,12 +130,6 @@ TEST_CASE("Div (w/o limit and default rounding)") {
 
 
         struct div_test_data tests[] = {
-            {
-                .lit_x = "173.849428",
-                .lit_y = "10000.00",
-                .lit_quot = "0.0173849428",
-                .prec_limit = -1,
-            },
             {
                 .lit_x = "3459999896e19",
                 .lit_y = "-0.4199029",
@@ -136,12 +148,6 @@ TEST_CASE("Div (w/o limit and default rounding)") {
                 .lit_quot = "24691357802469134e20",
                 .prec_limit = 0,
             },
-            {
-                .lit_x = "172.9999948",
-                .lit_y = "41.99029",
-                .lit_quot = "4.1200000000",
-                .prec_limit = 10,
-            },
             {
                 .lit_x = "222222222e18",
                 .lit_y = "0.002",
@@ -177,7 +183,7 @@ TEST_CASE("Div (w/o limit and default rounding)") {
         struct div_test_data tests[] = {
             {
                 .lit_x = "173.849428",
-                .lit_y = "0.0173849428",
+                .lit_y = "0.01738494280000000000",
                 .lit_quot = "10000",
                 .prec_limit = -1,
             },
@@ -417,6 +423,18 @@ TEST_CASE("Div (with limit and default rounding)") {
                 .lit_quot = "-0.566666667",
                 .prec_limit = 9,
             },
+            {
+                .lit_x = "1",
+                .lit_y = "3",
+                .lit_quot = "0.333333333333",
+                .prec_limit = 12,
+            },
+            {
+                .lit_x = "3.843",
+                .lit_y = "6.3",
+                .lit_quot = "0.610000000000",
+                .prec_limit = 12,
+            },
         };
         for (const auto &test : tests) {
 
@@ -439,12 +457,6 @@ TEST_CASE("Div (with limit and default rounding)") {
 
 
         struct div_test_data tests[] = {
-            {
-                .lit_x = "1",
-                .lit_y = "3",
-                .lit_quot = "0.333333333333",
-                .prec_limit = 12,
-            },
             {
                 .lit_x = "2.00",
                 .lit_y = "3.0000000",
@@ -458,10 +470,10 @@ TEST_CASE("Div (with limit and default rounding)") {
                 .prec_limit = 33,
             },
             {
-                .lit_x = "3.843",
-                .lit_y = "6.3",
-                .lit_quot = "0.610000000000",
-                .prec_limit = 12,
+                .lit_x = "-264314951917035127194.3105",
+                .lit_y = "-41159632.65053115",
+                .lit_quot = "6421703375275.9753905756169490811954819",
+                .prec_limit = 25,
             },
         };
         for (const auto &test : tests) {
@@ -486,7 +498,7 @@ TEST_CASE("Div (with limit and default rounding)") {
         struct div_test_data tests[] = {
             {
                 .lit_x = "173.849428",
-                .lit_y = "0.0173849428",
+                .lit_y = "0.01738494280000000000",
                 .lit_quot = "10000.000",
                 .prec_limit = 3,
             },
@@ -595,6 +607,84 @@ TEST_CASE("Div (with limit and default rounding)") {
     }
 }
 
+TEST_CASE("Div (w/o limit): long quotients") {
+
+    SECTION("Terminating after many digits") {
+        error_t rc;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t q = FPDEC_ZERO;
+        fpdec_t quot = FPDEC_ZERO;
+
+        // 1 / 2 ^ 200 = 5 ^ 200 / 10 ^ 200
+        rc = fpdec_from_ascii_literal(&x, "1.0000000000000000000000");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&y, "1606938044258990275541962092341162602522202993782792835301376");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&quot, "0.00000000000000000000000000000000000000000000000000000000000062230152778611417071440640537801242405902521687211671331011166147896988340353834411839448231257136169569665895551224821247160434722900390625");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_div(&q, &x, &y, -1, FPDEC_ROUND_DEFAULT);
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(FPDEC_DEC_PREC(&q) == 200);
+        CHECK(fpdec_compare(&q, &quot, false) == 0);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&q, 0);
+        fpdec_reset_to_zero(&quot, 0);
+    }
+
+    SECTION("Product divided by factor") {
+        error_t rc;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t p = FPDEC_ZERO;
+        fpdec_t q = FPDEC_ZERO;
+        const char *lits[] = {
+            "7",
+            "-3.0000000000000000000000000000001",
+            "98765432109876543210987654321098765432109876543210.0123456789",
+            "0.00000000000000000000000000000000000000000000012345678901234",
+            "31415926535897932384626433832795028841971693993751058209749445"
+            "9230781640628620899862803482534211706798214808651328230664709"
+            "38446095505822317253594081284811174502841027019385211055596446",
+        };
+        for (const char *lit_x : lits) {
+            for (const char *lit_y : lits) {
+                rc = fpdec_from_ascii_literal(&x, lit_x);
+                REQUIRE(rc == FPDEC_OK);
+                rc = fpdec_from_ascii_literal(&y, lit_y);
+                REQUIRE(rc == FPDEC_OK);
+                rc = fpdec_mul(&p, &x, &y);
+                REQUIRE(rc == FPDEC_OK);
+                rc = fpdec_div(&q, &p, &y, -1, FPDEC_ROUND_DEFAULT);
+                REQUIRE(rc == FPDEC_OK);
+                CHECK(fpdec_compare(&q, &x, false) == 0);
+                fpdec_reset_to_zero(&x, 0);
+                fpdec_reset_to_zero(&y, 0);
+                fpdec_reset_to_zero(&p, 0);
+                fpdec_reset_to_zero(&q, 0);
+            }
+        }
+    }
+
+    SECTION("Non-terminating") {
+        error_t rc;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t q = FPDEC_ZERO;
+
+        rc = fpdec_from_ascii_literal(&x, "1.00000000000000000000000001");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&y, "300000000000000000000000000000");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_div(&q, &x, &y, -1, FPDEC_ROUND_DEFAULT);
+        CHECK(rc == FPDEC_PREC_LIMIT_EXCEEDED);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&q, 0);
+    }
+}
+
 TEST_CASE("Div (with limit and explicit rounding mode)") {
 
     SECTION("shint / shint -> shint [ROUND_HALF_UP]") {
@@ -744,6 +834,45 @@ TEST_CASE("Div (with limit and explicit rounding mode)") {
         }
     }
 
+    SECTION("shint / shint -> shint [ROUND_05UP]") {
+
+        const struct div_test_variant tv = {
+            .dyn_x = false,
+            .dyn_y = false,
+            .dyn_quot = false,
+        };
+
+        struct div_test_data tests[] = {
+            {
+                .lit_x = "971549313395823.753007854",
+                .lit_y = "1195268.63",
+                .lit_quot = "812829257.801088407220939112",
+                .prec_limit = 18,
+            },
+            {
+                .lit_x = "799114.243587742695886135",
+                .lit_y = "1.676",
+                .lit_quot = "476798.474694357217115832",
+                .prec_limit = 18,
+            },
+            {
+                .lit_x = "65899199243.68150397462706036",
+                .lit_y = "195.03502",
+                .lit_quot = "337883931.017524462912491614",
+                .prec_limit = 18,
+            },
+        };
+        for (const auto &test : tests) {
+
+            const std::string section_name = test.lit_x + " / " + test.lit_y +
+                                             " [ROUND_05UP]";
+
+            SECTION(section_name) {
+                do_div_test(tv, test, FPDEC_ROUND_05UP);
+            }
+        }
+    }
+
     SECTION("dyn / shint -> shint [ROUND_UP]") {
 
         const struct div_test_variant tv = {
@@ -754,17 +883,23 @@ TEST_CASE("Div (with limit and explicit rounding mode)") {
 
         struct div_test_data tests[] = {
             {
-                .lit_x = "-0.160419683452",
+                .lit_x = "-0.1604196834520000000",
                 .lit_y = "1",
                 .lit_quot = "-1",
                 .prec_limit = 0,
             },
             {
-                .lit_x = "0.00000000000606",
+                .lit_x = "0.0000000000060600000",
                 .lit_y = "3.03",
                 .lit_quot = "0.001",
                 .prec_limit = 3,
             },
+            {
+                .lit_x = "-0.4999683452000000000",
+                .lit_y = "-1e17",
+                .lit_quot = "1e-12",
+                .prec_limit = 12,
+            },
         };
         for (const auto &test : tests) {
 
@@ -787,13 +922,7 @@ TEST_CASE("Div (with limit and explicit rounding mode)") {
 
         struct div_test_data tests[] = {
             {
-                .lit_x = "-0.4999683452",
-                .lit_y = "-1e17",
-                .lit_quot = "1e-12",
-                .prec_limit = 12,
-            },
-            {
-                .lit_x = "0.000000000006",
+                .lit_x = "0.0000000000060000000",
                 .lit_y = "3e20",
                 .lit_quot = "1e-23",
                 .prec_limit = 23,
@@ -838,8 +967,8 @@ TEST_CASE("Div (with limit and explicit rounding mode)") {
                 .prec_limit = 1,
             },
             {
-                .lit_x = "0.000000000007",
-                .lit_y = "0.000000000003",
+                .lit_x = "0.0000000000070000000",
+                .lit_y = "0.0000000000030000000",
                 .lit_quot = "2",
                 .prec_limit = 0,
             },
@@ -883,14 +1012,14 @@ TEST_CASE("Div (with limit and explicit rounding mode)") {
                 .prec_limit = 3,
             },
             {
-                .lit_x = "0.000000000007",
-                .lit_y = "0.000000000003",
+                .lit_x = "0.0000000000070000000",
+                .lit_y = "0.0000000000030000000",
                 .lit_quot = "2",
                 .prec_limit = 0,
             },
             {
-                .lit_x = "0.0000000000025",
-                .lit_y = "0.000000000005",
+                .lit_x = "0.0000000000025000000",
+                .lit_y = "0.0000000000050000000",
                 .lit_quot = "0",
                 .prec_limit = 0,
             },
@@ -218,6 +218,18 @@ TEST_CASE("Divmod") {
                 .lit_quot = "24691357802469134e20",
                 .lit_rem = "0.000",
             },
+            {
+                .lit_x = "12345678901234567890123",
+                .lit_y = "0.000000000000000007",
+                .lit_quot = "1763668414462081127160428571428571428571",
+                .lit_rem = "0.000000000000000003",
+            },
+            {
+                .lit_x = "-12345678901234567890123",
+                .lit_y = "0.000000000000000007",
+                .lit_quot = "-1763668414462081127160428571428571428572",
+                .lit_rem = "0.000000000000000004",
+            },
         };
 
         for (const auto &test : tests) {
@@ -242,13 +254,13 @@ TEST_CASE("Divmod") {
         struct divmod_test_data tests[] = {
             {
                 .lit_x = "80000000000000000005",
-                .lit_y = "-0.0000000001",
+                .lit_y = "-0.00000000010000000000",
                 .lit_quot = "-800000000000000000050000000000",
                 .lit_rem = "0",
             },
             {
                 .lit_x = "100000000000000000005.06",
-                .lit_y = "-0.00000000002",
+                .lit_y = "-0.00000000002000000000",
                 .lit_quot = "-5000000000000000000253000000000",
                 .lit_rem = "0",
             },
@@ -276,15 +288,15 @@ TEST_CASE("Divmod") {
         struct divmod_test_data tests[] = {
             {
                 .lit_x = "80000000000000000005",
-                .lit_y = "-4.0003000001",
+                .lit_y = "-4.00030000010000000000",
                 .lit_quot = "-19998500111991638126",
-                .lit_rem = "-1.6369638126",
+                .lit_rem = "-1.63696381260000000000",
             },
             {
                 .lit_x = "-70005.062",
-                .lit_y = "33.00000000002",
+                .lit_y = "33.00000000002000000000",
                 .lit_quot = "-2122",
-                .lit_rem = "20.93800004244",
+                .lit_rem = "20.93800004244000000000",
             },
         };
 
@@ -309,10 +321,10 @@ TEST_CASE("Divmod") {
 
         struct divmod_test_data tests[] = {
             {
-                .lit_x = "8000000000.0000000005",
-                .lit_y = "-4.0003000001",
+                .lit_x = "8000000000.00000000050000000000",
+                .lit_y = "-4.00030000010000000000",
                 .lit_quot = "-1999850012",
-                .lit_rem = "-3.2035850007",
+                .lit_rem = "-3.20358500070000000000",
             },
             {
                 .lit_x = "-3942886002727763569672998513142755570005"
@@ -358,8 +370,8 @@ TEST_CASE("Divmod") {
                 .lit_rem = "-222153261802213102898.84571204",
             },
             {
-                .lit_x = "-4.0006000008",
-                .lit_y = "1.0001500002",
+                .lit_x = "-4.00060000080000000000",
+                .lit_y = "1.00015000020000000000",
                 .lit_quot = "-4",
                 .lit_rem = "0",
             },
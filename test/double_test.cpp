@@ -0,0 +1,309 @@
+/* ---------------------------------------------------------------------------
+Name:        double_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+#include "checks.hpp"
+
+
+static double
+double_from_bits(uint64_t bits) {
+    double val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+static uint64_t
+bits_from_double(double val) {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+static void
+check_literal(const fpdec_t *z, const char *literal, int dec_prec) {
+    fpdec_t expected = FPDEC_ZERO;
+
+    REQUIRE(fpdec_from_ascii_literal(&expected, literal) == FPDEC_OK);
+    CHECK(fpdec_compare(z, &expected, false) == 0);
+    CHECK(FPDEC_DEC_PREC(z) == dec_prec);
+    fpdec_reset_to_zero(&expected, 0);
+}
+
+TEST_CASE("From double") {
+
+    SECTION("Exact") {
+        struct test_data {
+            double val;
+            const char *literal;
+            int dec_prec;
+        };
+        const test_data tests[] = {
+            {0.0, "0", 0},
+            {-0.0, "0", 0},
+            {17.5, "17.5", 1},
+            {-0.25, "-0.25", 2},
+            {0.1, "0.1000000000000000055511151231257827021181583404541015625",
+             55},
+            {1e23, "99999999999999991611392", 0},
+            {1180591620717411303424.0, "1180591620717411303424", 0},
+            {-79228162514264337593543950336.0,
+             "-79228162514264337593543950336", 0},
+            {DBL_MAX, "179769313486231570814527423731704356798070567525844996"
+                      "598917476803157260780028538760589558632766878171540458"
+                      "953514382464234321326889464182768467546703537516986049"
+                      "910576551282076245490090389328944075868508455133942304"
+                      "583236903222948165808559332123348274797826204144723168"
+                      "738177180919299881250404026184124858368", 0},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t z = FPDEC_ZERO;
+
+            REQUIRE(fpdec_from_double(&z, test.val) == FPDEC_OK);
+            check_literal(&z, test.literal, test.dec_prec);
+            fpdec_reset_to_zero(&z, 0);
+        }
+
+        fpdec_t z = FPDEC_ZERO;
+        REQUIRE(fpdec_from_double(&z, std::numeric_limits<double>::
+                                      denorm_min()) == FPDEC_OK);
+        CHECK(fpdec_magnitude(&z) == -324);
+        CHECK(FPDEC_DEC_PREC(&z) == 1074);
+        fpdec_reset_to_zero(&z, 0);
+    }
+
+    SECTION("Rounded") {
+        struct test_data {
+            double val;
+            int32_t dec_prec;
+            enum FPDEC_ROUNDING_MODE rnd;
+            const char *literal;
+            int dec_prec_res;
+        };
+        const test_data tests[] = {
+            {0.125, 2, FPDEC_ROUND_HALF_EVEN, "0.12", 2},
+            {0.125, 2, FPDEC_ROUND_HALF_UP, "0.13", 2},
+            {-0.125, 2, FPDEC_ROUND_FLOOR, "-0.13", 2},
+            // 2.675 is slightly less in binary
+            {2.675, 2, FPDEC_ROUND_HALF_UP, "2.67", 2},
+            {0.1, 20, FPDEC_ROUND_HALF_EVEN, "0.10000000000000000555", 20},
+            {1e-20, 2, FPDEC_ROUND_HALF_EVEN, "0", 2},
+            {1e-20, 2, FPDEC_ROUND_UP, "0.01", 2},
+            {1e-40, 19, FPDEC_ROUND_HALF_UP, "0", 19},
+            {123456.789, -2, FPDEC_ROUND_HALF_EVEN, "123500", 0},
+            {1e23, 3, FPDEC_ROUND_HALF_EVEN, "99999999999999991611392", 3},
+            {1e23, -20, FPDEC_ROUND_CEILING, "1e23", 0},
+            {0.0, 5, FPDEC_ROUND_HALF_EVEN, "0", 5},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t z = FPDEC_ZERO;
+
+            REQUIRE(fpdec_from_double_rounded(&z, test.val, test.dec_prec,
+                                              test.rnd) == FPDEC_OK);
+            check_literal(&z, test.literal, test.dec_prec_res);
+            fpdec_reset_to_zero(&z, 0);
+        }
+    }
+
+    SECTION("Shortest") {
+        struct test_data {
+            double val;
+            const char *literal;
+            int dec_prec;
+        };
+        const test_data tests[] = {
+            {0.1, "0.1", 1},
+            {-0.3, "-0.3", 1},
+            {100.0, "100", 0},
+            {1.0 / 3.0, "0.3333333333333333", 16},
+            {123456.789, "123456.789", 3},
+            {1e23, "1e23", 0},
+            {9223372036854775808.0, "9223372036854776000", 0},
+            {5e-324, "5e-324", 324},
+            {1.5e-323, "1.5e-323", 324},
+            {DBL_MAX, "1.7976931348623157e308", 0},
+            {DBL_MIN, "2.2250738585072014e-308", 324},
+            // next to a power of 2
+            {9007199254740992.0, "9007199254740992", 0},
+            {1.0 / 16777216, "5.960464477539063e-8", 23},
+            {1.0 / 16777216 / 1048576, "5.684341886080802e-14", 29},
+            // digits generated with 128-bit integers
+            {0.01, "0.01", 2},
+            {-2.5e-7, "-2.5e-7", 8},
+            {1e30, "1e30", 0},
+            {std::ldexp(1.0, 100), "1.2676506002282294e30", 0},
+            // digits generated with binary integers
+            {1e-20, "1e-20", 20},
+            {std::ldexp(1.0, -80), "8.271806125530277e-25", 40},
+            {1e-100, "1e-100", 100},
+            {1e100, "1e100", 0},
+            {std::ldexp(1.0, 200), "1.6069380442589903e60", 0},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t z = FPDEC_ZERO;
+
+            REQUIRE(fpdec_from_double_shortest(&z, test.val) == FPDEC_OK);
+            check_literal(&z, test.literal, test.dec_prec);
+            fpdec_reset_to_zero(&z, 0);
+        }
+    }
+
+    SECTION("Infinity and NaN") {
+        const double vals[] = {
+            HUGE_VAL, -HUGE_VAL, std::numeric_limits<double>::quiet_NaN()
+        };
+
+        for (double val : vals) {
+            fpdec_t z = FPDEC_ZERO;
+            CHECK(fpdec_from_double(&z, val) ==
+                  FPDEC_INVALID_DECIMAL_LITERAL);
+            CHECK(fpdec_from_double_rounded(&z, val, 2, FPDEC_ROUND_DEFAULT)
+                  == FPDEC_INVALID_DECIMAL_LITERAL);
+            CHECK(fpdec_from_double_shortest(&z, val) ==
+                  FPDEC_INVALID_DECIMAL_LITERAL);
+        }
+    }
+}
+
+TEST_CASE("As double") {
+
+    SECTION("Correctly rounded") {
+        struct test_data {
+            const char *literal;
+            uint64_t bits;
+        };
+        const test_data tests[] = {
+            {"0", 0x0000000000000000ULL},
+            {"0.1", 0x3FB999999999999AULL},
+            {"-17.5", 0xC031800000000000ULL},
+            {"1e23", 0x44B52D02C7E14AF6ULL},
+            {"123456789012345678901234567.890", 0x455987BF7C563CAAULL},
+            // ties to even
+            {"9007199254740993", 0x4340000000000000ULL},
+            {"9007199254740995", 0x4340000000000002ULL},
+            {"9007199254740993.0000000000000000000000000000000000001",
+             0x4340000000000001ULL},
+            {"1.00000000000000011102230246251565404236316680908203125",
+             0x3FF0000000000000ULL},
+            {"1.00000000000000011102230246251565404236316680908203126",
+             0x3FF0000000000001ULL},
+            // subnormals and underflow
+            {"5e-324", 0x0000000000000001ULL},
+            {"2.4703282292062328e-324", 0x0000000000000001ULL},
+            {"2.4703282292062327e-324", 0x0000000000000000ULL},
+            {"-1e-400", 0x8000000000000000ULL},
+            {"2.2250738585072011e-308", 0x000FFFFFFFFFFFFFULL},
+            {"1.7976931348623158e308", 0x7FEFFFFFFFFFFFFFULL},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            double val;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, test.literal) == FPDEC_OK);
+            REQUIRE(fpdec_as_double(&val, &x) == FPDEC_OK);
+            CHECK(bits_from_double(val) == test.bits);
+            fpdec_reset_to_zero(&x, 0);
+        }
+    }
+
+    SECTION("Many digits") {
+        // 0.1 followed by 1000 zeros and a 1
+        std::string lit = "0.1" + std::string(1000, '0') + "1";
+        fpdec_t x = FPDEC_ZERO;
+        double val;
+
+        REQUIRE(fpdec_from_ascii_literal(&x, lit.c_str()) == FPDEC_OK);
+        REQUIRE(fpdec_as_double(&val, &x) == FPDEC_OK);
+        CHECK(val == 0.1);
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Overflow") {
+        const char *const literals[] = {"1.7976931348623159e308", "-1e309"};
+
+        for (const char *lit : literals) {
+            fpdec_t x = FPDEC_ZERO;
+            double val;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            CHECK(fpdec_as_double(&val, &x) == FPDEC_EXP_LIMIT_EXCEEDED);
+            CHECK(std::isinf(val));
+            CHECK((val < 0) == (lit[0] == '-'));
+            fpdec_reset_to_zero(&x, 0);
+        }
+    }
+}
+
+TEST_CASE("Double round trips") {
+    std::mt19937_64 rng(4711);
+
+    for (int i = 0; i < 2000; ++i) {
+        double val = double_from_bits(rng());
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        double res;
+
+        if (!std::isfinite(val))
+            continue;
+        REQUIRE(fpdec_from_double(&x, val) == FPDEC_OK);
+        REQUIRE(fpdec_as_double(&res, &x) == FPDEC_OK);
+        CHECK(res == val);
+        REQUIRE(fpdec_from_double_shortest(&y, val) == FPDEC_OK);
+        REQUIRE(fpdec_as_double(&res, &y) == FPDEC_OK);
+        CHECK(res == val);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+
+        // rounded conversion gives the same result as adjusting the exact one
+        int32_t dec_prec = (int32_t)(rng() % 30) - 5;
+        enum FPDEC_ROUNDING_MODE rnd =
+            (enum FPDEC_ROUNDING_MODE)(rng() % FPDEC_MAX_ROUNDING_MODE + 1);
+        REQUIRE(fpdec_from_double(&x, val) == FPDEC_OK);
+        REQUIRE(fpdec_from_double_rounded(&y, val, dec_prec, rnd) ==
+                FPDEC_OK);
+        fpdec_t z = FPDEC_ZERO;
+        REQUIRE(fpdec_adjusted(&z, &x, dec_prec, rnd) == FPDEC_OK);
+        CHECK(fpdec_compare(&y, &z, false) == 0);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&z, 0);
+    }
+}
+
+TEST_CASE("Decimal from / to double") {
+    using fpdec::Decimal;
+    using fpdec::Rounding;
+
+    CHECK(Decimal::shortest_from_double(0.1) == Decimal("0.1"));
+    CHECK(Decimal::from_double(0.5) == Decimal("0.5"));
+    CHECK(Decimal::from_double(2.675, 2, Rounding::round_half_up) ==
+          Decimal("2.67"));
+    CHECK(Decimal("-1234.5678").as_double() == -1234.5678);
+    CHECK_THROWS_AS(Decimal::from_double(HUGE_VAL),
+                    fpdec::InvalidDecimalLiteral);
+    CHECK_THROWS_AS(Decimal("1e400").as_double(),
+                    fpdec::InternalLimitExceeded);
+}
@@ -0,0 +1,173 @@
+/* ---------------------------------------------------------------------------
+Name:        fixeddecimal_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <string>
+
+#include "catch.hpp"
+#include "fixeddecimal.hpp"
+
+using namespace fpdec;
+
+typedef FixedDecimal<2> Cents;
+typedef FixedDecimal<8> Satoshis;
+
+// evaluated at compile time
+static_assert(Cents(5) == Cents::from_coefficient(500), "");
+static_assert(Cents::from_coefficient(1999) + Cents(1) ==
+              Cents::from_coefficient(2099), "");
+static_assert(-Cents(3) < Cents(), "");
+static_assert(Cents::from_coefficient(150) * Cents::from_coefficient(333) ==
+              Cents::from_coefficient(500), "");
+static_assert(Cents(1) / Cents(3) == Cents::from_coefficient(33), "");
+static_assert(Cents(2) / Cents(3) == Cents::from_coefficient(67), "");
+static_assert(Cents(Satoshis::from_coefficient(12345000)) ==
+              Cents::from_coefficient(12), "");
+static_assert(Cents(Satoshis::from_coefficient(12500000)) ==
+              Cents::from_coefficient(12), "");
+static_assert(Cents(Satoshis::from_coefficient(13500000)) ==
+              Cents::from_coefficient(14), "");
+static_assert(Satoshis(Cents::from_coefficient(-12)) ==
+              Satoshis::from_coefficient(-12000000), "");
+static_assert(Cents::from_coefficient(-125).rounded(1) ==
+              Cents::from_coefficient(-120), "");
+static_assert(Cents::precision() == 2, "");
+
+TEST_CASE("FixedDecimal arithmetic") {
+
+    SECTION("Add / sub") {
+        auto x = Cents::from_coefficient(123456);
+        auto y = Cents::from_coefficient(-789);
+        CHECK((x + y).coefficient() == 122667);
+        CHECK((x - y).coefficient() == 124245);
+        CHECK((y - x).coefficient() == -124245);
+        x += y;
+        CHECK(x.coefficient() == 122667);
+        x -= y;
+        CHECK(x.coefficient() == 123456);
+    }
+
+    SECTION("Mul / div with rounding") {
+        struct test_data {
+            int64_t x;
+            int64_t y;
+            Rounding rnd;
+            int64_t prod;
+            int64_t quot;
+        };
+        // x, y, prod and quot as coefficients with scale 2
+        const test_data tests[] = {
+            {125, 50, Rounding::round_half_even, 62, 250},
+            {135, 50, Rounding::round_half_even, 68, 270},
+            {-125, 50, Rounding::round_half_even, -62, -250},
+            {125, 50, Rounding::round_half_up, 63, 250},
+            {-125, 50, Rounding::round_half_up, -63, -250},
+            {125, 50, Rounding::round_half_down, 62, 250},
+            {125, 50, Rounding::round_down, 62, 250},
+            {-125, 50, Rounding::round_floor, -63, -250},
+            {125, 50, Rounding::round_ceiling, 63, 250},
+            {-125, 50, Rounding::round_ceiling, -62, -250},
+            {125, 50, Rounding::round_up, 63, 250},
+            {101, 300, Rounding::round_05up, 303, 33},
+            {151, 300, Rounding::round_05up, 453, 51},
+            {100, 300, Rounding::round_05up, 300, 33},
+            {100, 300, Rounding::round_up, 300, 34},
+            {-100, 300, Rounding::round_floor, -300, -34},
+        };
+
+        for (const auto &test : tests) {
+            auto x = Cents::from_coefficient(test.x);
+            auto y = Cents::from_coefficient(test.y);
+            CHECK(x.mul(y, test.rnd).coefficient() == test.prod);
+            CHECK(x.div(y, test.rnd).coefficient() == test.quot);
+            // same as rounding the exact result
+            CHECK(Decimal(Decimal(x) * Decimal(y), 2, test.rnd) ==
+                  Decimal(x.mul(y, test.rnd)));
+        }
+    }
+
+    SECTION("Thread-specific default rounding") {
+        RoundingContext ctx(Rounding::round_up);
+        auto x = Cents::from_coefficient(100);
+        auto y = Cents::from_coefficient(300);
+        CHECK(x.div(y, Rounding::round_default).coefficient() == 34);
+        CHECK((x / y).coefficient() == 33);
+    }
+
+    SECTION("Div by zero") {
+        CHECK_THROWS_AS(Cents(5) / Cents(), DivisionByZero);
+    }
+}
+
+#ifdef __SIZEOF_INT128__
+typedef FixedDecimal<30, __int128> Fine;
+
+static_assert(Fine(Satoshis::from_coefficient(-1)).coefficient() ==
+              -(__int128)1000000000000000000ULL * 10000, "");
+static_assert(Fine(-5) * Fine(5) == Fine(-25), "");
+static_assert(Fine(-2) / Fine(-5) ==
+              Fine(Cents::from_coefficient(40)), "");
+
+TEST_CASE("FixedDecimal with 128-bit storage") {
+    auto x = Fine(Decimal("12345678.123456789012345678901234567"));
+    auto y = Fine(Decimal("-0.000000000000000000000000000002"));
+
+    CHECK(Decimal(x) == Decimal("12345678.123456789012345678901234567"));
+    CHECK(Decimal(x).precision() == 30);
+    CHECK(Decimal(x + y) == Decimal("12345678.123456789012345678901234566998"));
+    CHECK(Decimal(y * y) == Decimal(0LL));
+    CHECK(Decimal(x * Fine(Decimal("-3.000000000000000000000000000001"))) ==
+          Decimal("-37037034.370370367037037036703716046678"));
+    CHECK(Decimal(Fine(7) / Fine(3)) ==
+          Decimal("2.333333333333333333333333333333"));
+    CHECK(Decimal(Fine(-2) / Fine(3)) ==
+          Decimal("-0.666666666666666666666666666667"));
+    CHECK(Decimal(Fine(Decimal("0.1234567890123456789"))) ==
+          Decimal("0.1234567890123456789"));
+    CHECK_THROWS_AS(Fine(Decimal("1e9")), std::range_error);
+}
+#endif // __SIZEOF_INT128__
+
+TEST_CASE("FixedDecimal from / to Decimal") {
+
+    SECTION("Lossless") {
+        const char *const literals[] = {
+            "0", "0.00", "17.5", "-17.5", "92233720368547758.07",
+            "-92233720368547758.08", "0.01",
+        };
+        for (const char *lit : literals) {
+            Decimal dec(lit);
+            Cents x(dec);
+            CHECK(Decimal(x) == dec);
+            CHECK(Decimal(x).precision() == 2);
+            CHECK(Cents(Decimal(x)) == x);
+        }
+    }
+
+    SECTION("Rounding") {
+        CHECK(Cents(Decimal("0.125"), Rounding::round_half_even) ==
+              Cents::from_coefficient(12));
+        CHECK(Cents(Decimal("0.125"), Rounding::round_half_up) ==
+              Cents::from_coefficient(13));
+        CHECK(Cents(Decimal("-1234.5678"), Rounding::round_down) ==
+              Cents::from_coefficient(-123456));
+    }
+
+    SECTION("Out of range") {
+        CHECK_THROWS_AS(Cents(Decimal("92233720368547758.08")),
+                        std::range_error);
+        CHECK_THROWS_AS(Cents(Decimal("-92233720368547758.09")),
+                        std::range_error);
+        CHECK_THROWS_AS(Cents(Decimal("1e40")), std::range_error);
+    }
+}
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------------
+Name:        fma_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "3", "-0.0000000000000000012",
+    "123456789012.345", "79228162514264337593543950335",
+    "-1234567890123456789012345.6789", "0.00000000000000000000000005",
+    "-98765.4321", "18446744073709551615", "0.999999999999999999",
+    "-99999999999999999999999999999999999999.99999999999999999999",
+    "4.5e30",
+    // long enough to be multiplied via digit arrays
+    "-12345678901234567890123456789012345678901234567890123456789"
+    "012345678901234567890123456789012345678901234567890123456789"
+    "01234567890123456789012345678901234567890.098765432109876543"
+    "2109876543210987654321",
+};
+static const size_t n_literals = sizeof(literals) / sizeof(literals[0]);
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == FPDEC_DEC_PREC(expected));
+}
+
+TEST_CASE("Fused multiply-add") {
+    std::vector<fpdec_t> vals(n_literals, FPDEC_ZERO);
+    fpdec_t prod = FPDEC_ZERO;
+    fpdec_t expected = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+
+    for (size_t i = 0; i < n_literals; ++i)
+        REQUIRE(fpdec_from_ascii_literal(&vals[i], literals[i]) == FPDEC_OK);
+
+    for (const auto &x : vals)
+        for (const auto &y : vals)
+            for (const auto &w : vals) {
+                REQUIRE(fpdec_mul(&prod, &x, &y) == FPDEC_OK);
+                REQUIRE(fpdec_add(&expected, &prod, &w) == FPDEC_OK);
+                REQUIRE(fpdec_fma(&z, &x, &y, &w) == FPDEC_OK);
+                check_equal(&z, &expected);
+                fpdec_reset_to_zero(&prod, 0);
+                fpdec_reset_to_zero(&expected, 0);
+                fpdec_reset_to_zero(&z, 0);
+            }
+
+    for (auto &val : vals)
+        fpdec_reset_to_zero(&val, 0);
+}
+
+TEST_CASE("Dot product") {
+    std::vector<fpdec_t> x(n_literals, FPDEC_ZERO);
+    std::vector<fpdec_t> y(n_literals, FPDEC_ZERO);
+    fpdec_t sum = FPDEC_ZERO;
+    fpdec_t prod = FPDEC_ZERO;
+    fpdec_t t = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+    fpdec_dec_prec_t dec_prec = 0;
+
+    for (size_t i = 0; i < n_literals; ++i) {
+        REQUIRE(fpdec_from_ascii_literal(&x[i], literals[i]) == FPDEC_OK);
+        REQUIRE(fpdec_from_ascii_literal(&y[i],
+                                         literals[n_literals - 1 - i])
+                == FPDEC_OK);
+    }
+
+    SECTION("Empty") {
+        REQUIRE(fpdec_dot(&z, x.data(), y.data(), 0) == FPDEC_OK);
+        CHECK(FPDEC_EQ_ZERO(&z));
+    }
+
+    SECTION("Prefixes") {
+        for (size_t n = 1; n <= n_literals; ++n) {
+            REQUIRE(fpdec_mul(&prod, &x[n - 1], &y[n - 1]) == FPDEC_OK);
+            REQUIRE(fpdec_add(&t, &sum, &prod) == FPDEC_OK);
+            if (!FPDEC_EQ_ZERO(&prod))
+                dec_prec = std::max(dec_prec, FPDEC_DEC_PREC(&prod));
+            fpdec_reset_to_zero(&sum, 0);
+            sum = t;
+            t = FPDEC_ZERO;
+            REQUIRE(fpdec_dot(&z, x.data(), y.data(), n) == FPDEC_OK);
+            CHECK(fpdec_compare(&z, &sum, false) == 0);
+            CHECK(FPDEC_DEC_PREC(&z) == dec_prec);
+            fpdec_reset_to_zero(&prod, 0);
+            fpdec_reset_to_zero(&z, 0);
+        }
+    }
+
+    SECTION("Portfolio") {
+        const char *const qty[] = {"1500", "-200", "35.5", "1000000"};
+        const char *const price[] = {"101.25", "99.875", "2500.1", "0.0125"};
+        std::vector<fpdec_t> q(4, FPDEC_ZERO);
+        std::vector<fpdec_t> p(4, FPDEC_ZERO);
+        fpdec_t expected = FPDEC_ZERO;
+
+        for (size_t i = 0; i < 4; ++i) {
+            REQUIRE(fpdec_from_ascii_literal(&q[i], qty[i]) == FPDEC_OK);
+            REQUIRE(fpdec_from_ascii_literal(&p[i], price[i]) == FPDEC_OK);
+        }
+        REQUIRE(fpdec_from_ascii_literal(&expected, "233153.5500")
+                == FPDEC_OK);
+        REQUIRE(fpdec_dot(&z, q.data(), p.data(), 4) == FPDEC_OK);
+        check_equal(&z, &expected);
+        CHECK(!FPDEC_IS_DYN_ALLOC(&z));
+        fpdec_reset_to_zero(&z, 0);
+        fpdec_reset_to_zero(&expected, 0);
+        for (size_t i = 0; i < 4; ++i) {
+            fpdec_reset_to_zero(&q[i], 0);
+            fpdec_reset_to_zero(&p[i], 0);
+        }
+    }
+
+    fpdec_reset_to_zero(&sum, 0);
+    for (size_t i = 0; i < n_literals; ++i) {
+        fpdec_reset_to_zero(&x[i], 0);
+        fpdec_reset_to_zero(&y[i], 0);
+    }
+}
@@ -19,6 +19,7 @@ $Revision$
 #include "format_spec.h"
 #include "fpdec.h"
 #include "fpdec_struct.h"
+#include "fpdecimal.hpp"
 
 
 static inline bool
@@ -31,6 +32,47 @@ utf8c_eq(const utf8c_t a, const utf8c_t b) {
     return true;
 }
 
+static size_t n_allocs = 0;
+
+static void *
+counting_alloc(size_t num, size_t size) {
+    n_allocs++;
+    return calloc(num, size);
+}
+
+static void
+check_formatted_to_buffer(const fpdec_t *dec, const std::string &fmt,
+                          const std::string &expected) {
+    uint8_t buf[512];
+    size_t len = 0;
+    error_t rc;
+
+    // length only
+    rc = fpdec_formatted_to_buffer(NULL, 0, &len, dec,
+                                   (uint8_t *)fmt.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    CHECK(len == expected.size());
+    // buffer too small: left unchanged
+    memset(buf, '#', sizeof(buf));
+    rc = fpdec_formatted_to_buffer(buf, expected.size(), &len, dec,
+                                   (uint8_t *)fmt.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    CHECK(len == expected.size());
+    CHECK(buf[0] == '#');
+    // exact fit
+    rc = fpdec_formatted_to_buffer(buf, expected.size() + 1, &len, dec,
+                                   (uint8_t *)fmt.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    CHECK(len == expected.size());
+    CHECK(strcmp((char *)buf, expected.c_str()) == 0);
+    // large buffer
+    rc = fpdec_formatted_to_buffer(buf, sizeof(buf), &len, dec,
+                                   (uint8_t *)fmt.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    CHECK(len == expected.size());
+    CHECK(strcmp((char *)buf, expected.c_str()) == 0);
+}
+
 static void
 validate_format_spec(std::string fmt, const format_spec_t *check) {
     format_spec_t spec;
@@ -376,6 +418,26 @@ TEST_CASE("Format decimal number") {
                 .fmt = " .2%",
                 .formatted = " 0.00%"
             },
+            {
+                .literal = "79228162514264337593543950335",
+                .fmt = "%",
+                .formatted = "7922816251426433759354395033500%"
+            },
+            {
+                .literal = "79228162514264337593543950335",
+                .fmt = ",",
+                .formatted = "79,228,162,514,264,337,593,543,950,335"
+            },
+            {
+                .literal = "-18446744073709551616.25",
+                .fmt = ",",
+                .formatted = "-18,446,744,073,709,551,616.25"
+            },
+            {
+                .literal = "10000000000000000000",
+                .fmt = ">30,",
+                .formatted = "    10,000,000,000,000,000,000"
+            },
         };
 
         for (auto test : tests) {
@@ -392,6 +454,8 @@ TEST_CASE("Format decimal number") {
                 REQUIRE(formatted != NULL);
                 CHECK(strcmp((char *)formatted, test.formatted.c_str()) == 0);
                 fpdec_mem_free(formatted);
+                check_formatted_to_buffer(&dec, test.fmt, test.formatted);
+                fpdec_reset_to_zero(&dec, 0);
             }
         }
     }
@@ -406,12 +470,12 @@ TEST_CASE("Format decimal number") {
 
         struct test_data tests[] = {
             {
-                .literal = "15006.3575548888",
+                .literal = "15006.35755488880000000000",
                 .fmt = "",
-                .formatted = "15006.3575548888"
+                .formatted = "15006.35755488880000000000"
             },
             {
-                .literal = "-15006.3572777532",
+                .literal = "-15006.35727775320000000000",
                 .fmt = ".1",
                 .formatted = "-15006.4"
             },
@@ -426,11 +490,11 @@ TEST_CASE("Format decimal number") {
                 .formatted = "    +88,793,825,633,715,020,003,856,983.35900"
             },
             {
-                .literal = "0.00999999999",
-                .fmt = "\xe2\x80\xa4>+20,",
+                .literal = "0.009999999990000000000",
+                .fmt = "\xe2\x80\xa4>+30,",
                 .formatted = "\xE2\x80\xA4\xE2\x80\xA4\xE2\x80\xA4"
                              "\xE2\x80\xA4\xE2\x80\xA4\xE2\x80\xA4"
-                             "+0.00999999999"
+                             "+0.009999999990000000000"
             },
             {
                 .literal = "8537150203594e-34",
@@ -449,37 +513,37 @@ TEST_CASE("Format decimal number") {
                              ".0000"
             },
             {
-                .literal = "123456789.1234567890",
-                .fmt = "025",
-                .formatted = "00000123456789.1234567890"
+                .literal = "123456789.12345678900000000000",
+                .fmt = "035",
+                .formatted = "00000123456789.12345678900000000000"
             },
             {
-                .literal = "-0.0930000001",
+                .literal = "-0.09300000010000000000",
                 .fmt = "%",
-                .formatted = "-9.3000000100%"
+                .formatted = "-9.30000001000000000000%"
             },
             {
-                .literal = "-0.0740000001",
+                .literal = "-0.07400000010000000000",
                 .fmt = ".10%",
                 .formatted = "-7.4000000100%"
             },
             {
-                .literal = "0.307400000333",
+                .literal = "0.3074000003330000000000",
                 .fmt = ".10%",
                 .formatted = "30.7400000333%"
             },
             {
-                .literal = "0.0070000000057",
+                .literal = "0.00700000000570000000000",
                 .fmt = ".10%",
                 .formatted = "0.7000000006%"
             },
             {
-                .literal = "4.1319999999",
+                .literal = "4.13199999990000000000",
                 .fmt = " 020,.8%",
                 .formatted = " 0,000,413.19999999%"
             },
             {
-                .literal = "0.0428600000",
+                .literal = "0.04286000000000000000",
                 .fmt = " 020,.9%",
                 .formatted = " 0,000,004.286000000%"
             },
@@ -505,7 +569,118 @@ TEST_CASE("Format decimal number") {
                 REQUIRE(formatted != NULL);
                 CHECK(strcmp((char *)formatted, test.formatted.c_str()) == 0);
                 fpdec_mem_free(formatted);
+                check_formatted_to_buffer(&dec, test.fmt, test.formatted);
+                fpdec_reset_to_zero(&dec, 0);
             }
         }
     }
 }
+
+TEST_CASE("Format decimal number with pre-parsed spec") {
+    const char *literals[] = {"17.5", "-1234567.891", "0.000008"};
+    const char *expected[] = {"     17.50", "-1,234,567.89", "      0.00"};
+    format_spec_t spec;
+    uint8_t buf[64];
+    size_t len;
+
+    REQUIRE(parse_format_spec(&spec, (uint8_t *)">10,.2f") == 0);
+    for (int i = 0; i < 3; ++i) {
+        fpdec_t dec = FPDEC_ZERO;
+
+        SECTION(literals[i]) {
+            REQUIRE(fpdec_from_ascii_literal(&dec, literals[i]) == FPDEC_OK);
+            fpdec_set_mem_funcs(counting_alloc, free);
+            n_allocs = 0;
+            error_t rc = fpdec_formatted_spec_to_buffer(buf, sizeof(buf),
+                                                        &len, &dec, &spec);
+            fpdec_set_mem_funcs(NULL, NULL);
+            REQUIRE(rc == FPDEC_OK);
+            CHECK(n_allocs == 0);
+            CHECK(len == strlen(expected[i]));
+            CHECK(strcmp((char *)buf, expected[i]) == 0);
+            fpdec_reset_to_zero(&dec, 0);
+        }
+    }
+}
+
+TEST_CASE("Format decimal number with compiled format spec") {
+    const char *formats[] = {
+        "", ">10,.2f", "+.3", "*^12", "_<9.1%", "010,.4", " .0f", ",",
+        "x>15", "-.5F", "=+20,.2"
+    };
+    const char *literals[] = {"17.5", "-1234567.891", "0.000008",
+                              "12345678901234567890123.456789"};
+    format_spec_t spec;
+
+    SECTION("Same results as with format string") {
+        // more formats than entries in the cache, used repeatedly
+        for (int round = 0; round < 2; ++round) {
+            for (const char *fmt : formats) {
+                REQUIRE(fpdec_format_compile(&spec, (uint8_t *)fmt) ==
+                        FPDEC_OK);
+                for (const char *lit : literals) {
+                    fpdec_t dec = FPDEC_ZERO;
+                    uint8_t *expected;
+                    uint8_t *formatted;
+
+                    REQUIRE(fpdec_from_ascii_literal(&dec, lit) == FPDEC_OK);
+                    expected = fpdec_formatted(&dec, (uint8_t *)fmt);
+                    formatted = fpdec_format_with(&dec, &spec);
+                    REQUIRE(expected != NULL);
+                    REQUIRE(formatted != NULL);
+                    CHECK(strcmp((char *)formatted, (char *)expected) == 0);
+                    fpdec_mem_free(expected);
+                    fpdec_mem_free(formatted);
+                    fpdec_reset_to_zero(&dec, 0);
+                }
+            }
+        }
+    }
+
+    SECTION("Invalid format") {
+        const char *invalid[] = {"abc", ".f", "10.3g"};
+
+        for (int round = 0; round < 2; ++round) {
+            for (const char *fmt : invalid) {
+                fpdec_t dec = FPDEC_ZERO;
+                size_t len;
+
+                CHECK(fpdec_format_compile(&spec, (uint8_t *)fmt) ==
+                      FPDEC_INVALID_FORMAT);
+                CHECK(fpdec_formatted_to_buffer(NULL, 0, &len, &dec,
+                                                (uint8_t *)fmt) ==
+                      FPDEC_INVALID_FORMAT);
+            }
+        }
+    }
+
+    SECTION("Locale specific formats are not cached") {
+        fpdec_t dec = FPDEC_ZERO;
+        uint8_t *formatted;
+
+        REQUIRE(fpdec_from_ascii_literal(&dec, "1234.5") == FPDEC_OK);
+        setlocale(LC_NUMERIC, "C");
+        formatted = fpdec_formatted(&dec, (uint8_t *)".2n");
+        REQUIRE(formatted != NULL);
+        CHECK(strcmp((char *)formatted, "1234.50") == 0);
+        fpdec_mem_free(formatted);
+        if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL) {
+            formatted = fpdec_formatted(&dec, (uint8_t *)".2n");
+            REQUIRE(formatted != NULL);
+            CHECK(strcmp((char *)formatted, "1234,50") == 0);
+            fpdec_mem_free(formatted);
+            setlocale(LC_NUMERIC, "C");
+        }
+        fpdec_reset_to_zero(&dec, 0);
+    }
+
+    SECTION("Decimal") {
+        fpdec::CompiledFormat fmt(">10,.2f");
+        fpdec::CompiledFormat wide("*>100");
+
+        CHECK(fpdec::Decimal("1234.567").format(fmt) == "  1,234.57");
+        CHECK(fpdec::Decimal("-1").format(wide) ==
+              std::string(98, '*') + "-1");
+        CHECK_THROWS_AS(fpdec::CompiledFormat("abc"), fpdec::InvalidFormat);
+    }
+}
@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------------
+Name:        hash_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+#include "checks.hpp"
+
+
+// groups of literals denoting the same value
+static const std::vector<std::vector<const char *>> equal_values = {
+    {"0", "0.000", "-0.0", "0e-40"},
+    {"1", "1.0", "1.00000000000000000000", "100e-2", "0.001e3"},
+    {"-17.5", "-17.50", "-17.5000000000000000000000000000000"},
+    {"12345678901234567890.5", "12345678901234567890.50000000000000000000"},
+    {"10000000000000000000", "1e19", "10000000000000000000.000000000000000"
+                                     "000000"},
+    {"79228162514264337593543950335", "79228162514264337593543950335.0"
+                                      "00000000000000000000"},
+    {"-0.0000000000000000012", "-0.00000000000000000120",
+     "-12e-19", "-0.000000000000000001200000000000000000000000"},
+    {"4.5e30", "4500000000000000000000000000000.00"},
+};
+
+TEST_CASE("Hash") {
+    std::vector<std::vector<fpdec_t>> vals;
+
+    for (const auto &group : equal_values) {
+        vals.emplace_back();
+        for (const char *lit : group) {
+            fpdec_t x = FPDEC_ZERO;
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            vals.back().push_back(x);
+        }
+    }
+
+    SECTION("Equal values have equal hashes") {
+        for (const auto &group : vals) {
+            for (const auto &x : group) {
+                REQUIRE(fpdec_compare(&x, &group[0], false) == 0);
+                CHECK(fpdec_hash(&x) == fpdec_hash(&group[0]));
+            }
+        }
+    }
+
+    SECTION("Different values") {
+        for (size_t i = 0; i < vals.size(); ++i)
+            for (size_t j = i + 1; j < vals.size(); ++j)
+                CHECK(fpdec_hash(&vals[i][0]) != fpdec_hash(&vals[j][0]));
+    }
+
+    SECTION("Results of arithmetic") {
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t z = FPDEC_ZERO;
+        fpdec_t expected = FPDEC_ZERO;
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "1000000000000000000000000.25")
+                == FPDEC_OK);
+        REQUIRE(fpdec_from_ascii_literal(&y, "999999999999999999999999.75")
+                == FPDEC_OK);
+        REQUIRE(fpdec_from_ascii_literal(&expected, "0.5") == FPDEC_OK);
+        REQUIRE(fpdec_sub(&z, &x, &y) == FPDEC_OK);
+        REQUIRE(fpdec_compare(&z, &expected, false) == 0);
+        CHECK(fpdec_hash(&z) == fpdec_hash(&expected));
+        fpdec_reset_to_zero(&z, 0);
+        REQUIRE(fpdec_adjusted(&z, &x, 0, FPDEC_ROUND_HALF_UP) == FPDEC_OK);
+        fpdec_reset_to_zero(&expected, 0);
+        REQUIRE(fpdec_from_ascii_literal(&expected, "1e24") == FPDEC_OK);
+        REQUIRE(fpdec_compare(&z, &expected, false) == 0);
+        CHECK(fpdec_hash(&z) == fpdec_hash(&expected));
+
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&z, 0);
+        fpdec_reset_to_zero(&expected, 0);
+    }
+
+    for (auto &group : vals)
+        for (auto &x : group)
+            fpdec_reset_to_zero(&x, 0);
+}
+
+TEST_CASE("Decimal as key of unordered map") {
+    using fpdec::Decimal;
+    std::unordered_map<Decimal, int> map;
+
+    for (size_t i = 0; i < equal_values.size(); ++i)
+        map[Decimal(equal_values[i][0])] = (int)i;
+    REQUIRE(map.size() == equal_values.size());
+    for (size_t i = 0; i < equal_values.size(); ++i)
+        for (const char *lit : equal_values[i]) {
+            auto it = map.find(Decimal(lit));
+            REQUIRE(it != map.end());
+            CHECK(it->second == (int)i);
+        }
+}
@@ -0,0 +1,378 @@
+/* ---------------------------------------------------------------------------
+Name:        ieee_decimal_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "basemath.h"
+#include "checks.hpp"
+
+
+static const enum FPDEC_IEEE_ENCODING encodings[] = {
+    FPDEC_IEEE_BID, FPDEC_IEEE_DPD
+};
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == FPDEC_DEC_PREC(expected));
+}
+
+TEST_CASE("IEEE 754 decimal64") {
+
+    SECTION("Known bit patterns") {
+        struct test_data {
+            std::string literal;
+            uint64_t bid;
+            uint64_t dpd;
+        };
+        const test_data tests[] = {
+            {"1", 0x31C0000000000001ULL, 0x2238000000000001ULL},
+            {"0", 0x31C0000000000000ULL, 0x2238000000000000ULL},
+            {"1234567890123456", 0x31C462D53C8ABAC0ULL,
+             0x263934B9C1E28E56ULL},
+            {"-7.50", 0xB1800000000002EEULL, 0xA2300000000003D0ULL},
+            {"9999999999999999", 0x6C7386F26FC0FFFFULL,
+             0x6E38FF3FCFF3FCFFULL},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            fpdec_t y = FPDEC_ZERO;
+            uint64_t bits;
+
+            SECTION(test.literal) {
+                REQUIRE(fpdec_from_ascii_literal(&x, test.literal.c_str())
+                        == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal64(&bits, &x, FPDEC_IEEE_BID,
+                                           FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                CHECK(bits == test.bid);
+                REQUIRE(fpdec_as_decimal64(&bits, &x, FPDEC_IEEE_DPD,
+                                           FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                CHECK(bits == test.dpd);
+                REQUIRE(fpdec_from_decimal64(&y, test.bid, FPDEC_IEEE_BID)
+                        == FPDEC_OK);
+                check_equal(&y, &x);
+                fpdec_reset_to_zero(&y, 0);
+                REQUIRE(fpdec_from_decimal64(&y, test.dpd, FPDEC_IEEE_DPD)
+                        == FPDEC_OK);
+                check_equal(&y, &x);
+            }
+            fpdec_reset_to_zero(&x, 0);
+            fpdec_reset_to_zero(&y, 0);
+        }
+    }
+
+    SECTION("Round trip") {
+        const char *const literals[] = {
+            "0.000", "17.5", "-17.5", "-0.0000000000000000012",
+            "123456789012.345", "0.00000000000000000000000005",
+            "-98765.4321", "4.5e30", "9.99e369", "-1e-398", "0.999999",
+            "8888888888888888", "-9.09090909090909e-100",
+        };
+
+        for (auto enc : encodings)
+            for (const char *lit : literals) {
+                fpdec_t x = FPDEC_ZERO;
+                fpdec_t y = FPDEC_ZERO;
+                uint64_t bits;
+
+                REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal64(&bits, &x, enc,
+                                           FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                REQUIRE(fpdec_from_decimal64(&y, bits, enc) == FPDEC_OK);
+                check_equal(&y, &x);
+                fpdec_reset_to_zero(&x, 0);
+                fpdec_reset_to_zero(&y, 0);
+            }
+    }
+
+    SECTION("Rounding") {
+        struct test_data {
+            const char *literal;
+            enum FPDEC_ROUNDING_MODE rnd;
+            const char *expected;
+        };
+        const test_data tests[] = {
+            {"0.33333333333333333333333333333333333333",
+             FPDEC_ROUND_HALF_EVEN, "0.3333333333333333"},
+            {"0.66666666666666666666666666666666666666",
+             FPDEC_ROUND_HALF_EVEN, "0.6666666666666667"},
+            {"0.66666666666666666666666666666666666666",
+             FPDEC_ROUND_DOWN, "0.6666666666666666"},
+            {"99999999999999999", FPDEC_ROUND_HALF_UP, "1e17"},
+            {"-12345678901234567890", FPDEC_ROUND_CEILING,
+             "-12345678901234560000"},
+            {"1.5e-398", FPDEC_ROUND_HALF_UP, "2e-398"},
+            {"1.5e-399", FPDEC_ROUND_HALF_EVEN, "0"},
+        };
+
+        for (auto enc : encodings)
+            for (const auto &test : tests) {
+                fpdec_t x = FPDEC_ZERO;
+                fpdec_t y = FPDEC_ZERO;
+                fpdec_t expected = FPDEC_ZERO;
+                uint64_t bits;
+
+                REQUIRE(fpdec_from_ascii_literal(&x, test.literal)
+                        == FPDEC_OK);
+                REQUIRE(fpdec_from_ascii_literal(&expected, test.expected)
+                        == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal64(&bits, &x, enc, test.rnd)
+                        == FPDEC_OK);
+                REQUIRE(fpdec_from_decimal64(&y, bits, enc) == FPDEC_OK);
+                CHECK(fpdec_compare(&y, &expected, false) == 0);
+                fpdec_reset_to_zero(&x, 0);
+                fpdec_reset_to_zero(&y, 0);
+                fpdec_reset_to_zero(&expected, 0);
+            }
+    }
+
+    SECTION("Overflow") {
+        fpdec_t x = FPDEC_ZERO;
+        uint64_t bits;
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "1e385") == FPDEC_OK);
+        CHECK(fpdec_as_decimal64(&bits, &x, FPDEC_IEEE_BID,
+                                 FPDEC_ROUND_DEFAULT)
+              == FPDEC_EXP_LIMIT_EXCEEDED);
+        fpdec_reset_to_zero(&x, 0);
+        // clamped: 1e384 = 1000000000000000e369
+        REQUIRE(fpdec_from_ascii_literal(&x, "1e384") == FPDEC_OK);
+        CHECK(fpdec_as_decimal64(&bits, &x, FPDEC_IEEE_BID,
+                                 FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Special values") {
+        const uint64_t specials[] = {
+            0x7800000000000000ULL,      // +Inf
+            0xF800000000000000ULL,      // -Inf
+            0x7C00000000000000ULL,      // NaN
+            0x7E00000000000000ULL,      // sNaN
+        };
+
+        for (auto enc : encodings)
+            for (uint64_t bits : specials) {
+                fpdec_t x = FPDEC_ZERO;
+                CHECK(fpdec_from_decimal64(&x, bits, enc) ==
+                      FPDEC_INVALID_ENCODING);
+            }
+    }
+
+    SECTION("Non-canonical coefficient") {
+        fpdec_t x = FPDEC_ZERO;
+
+        // coefficient 2^53 + 2^51 - 1 > 10^16 - 1
+        REQUIRE(fpdec_from_decimal64(&x, 0x6C7FFFFFFFFFFFFFULL,
+                                     FPDEC_IEEE_BID) == FPDEC_OK);
+        CHECK(FPDEC_EQ_ZERO(&x));
+    }
+}
+
+TEST_CASE("IEEE 754 decimal128") {
+
+    SECTION("Known bit patterns") {
+        struct test_data {
+            std::string literal;
+            uint128_t bid;
+            uint128_t dpd;
+        };
+        const test_data tests[] = {
+            {"1", U128_RHS(1ULL, 0x3040000000000000ULL),
+             U128_RHS(1ULL, 0x2208000000000000ULL)},
+            {"1234567890123456789012345678901234",
+             U128_RHS(0xDE825CD07E96AFF2ULL, 0x30403CDE6FFF9732ULL),
+             U128_RHS(0x6F3C127177823534ULL, 0x2608134B9C1E28E5ULL)},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            fpdec_t y = FPDEC_ZERO;
+            uint128_t bits;
+
+            SECTION(test.literal) {
+                REQUIRE(fpdec_from_ascii_literal(&x, test.literal.c_str())
+                        == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal128(&bits, &x, FPDEC_IEEE_BID,
+                                            FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                CHECK(u128_cmp(bits, test.bid) == 0);
+                REQUIRE(fpdec_as_decimal128(&bits, &x, FPDEC_IEEE_DPD,
+                                            FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                CHECK(u128_cmp(bits, test.dpd) == 0);
+                REQUIRE(fpdec_from_decimal128(&y, test.bid, FPDEC_IEEE_BID)
+                        == FPDEC_OK);
+                check_equal(&y, &x);
+                fpdec_reset_to_zero(&y, 0);
+                REQUIRE(fpdec_from_decimal128(&y, test.dpd, FPDEC_IEEE_DPD)
+                        == FPDEC_OK);
+                check_equal(&y, &x);
+            }
+            fpdec_reset_to_zero(&x, 0);
+            fpdec_reset_to_zero(&y, 0);
+        }
+    }
+
+    SECTION("Round trip") {
+        const char *const literals[] = {
+            "0", "0.000", "17.5", "-17.5", "-0.0000000000000000012",
+            "79228162514264337593543950335",
+            "-1234567890123456789012345.6789",
+            "0.00000000000000000000000005", "5000000000000000000e-19",
+            "-9999999999999999999999999999999999e6111",
+            "1.000000000000000000000000000000001", "4.5e30", "-2.5e-40",
+            "1e-6176", "123456789012345678901234567.8901234",
+        };
+
+        for (auto enc : encodings)
+            for (const char *lit : literals) {
+                fpdec_t x = FPDEC_ZERO;
+                fpdec_t y = FPDEC_ZERO;
+                uint128_t bits;
+
+                REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal128(&bits, &x, enc,
+                                            FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+                REQUIRE(fpdec_from_decimal128(&y, bits, enc) == FPDEC_OK);
+                check_equal(&y, &x);
+                fpdec_reset_to_zero(&x, 0);
+                fpdec_reset_to_zero(&y, 0);
+            }
+    }
+
+    SECTION("Rounding") {
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t y = FPDEC_ZERO;
+        fpdec_t expected = FPDEC_ZERO;
+        uint128_t bits;
+
+        REQUIRE(fpdec_from_ascii_literal(
+            &x, "-99999999999999999999.999999999999999999999999") == FPDEC_OK);
+        REQUIRE(fpdec_from_ascii_literal(&expected, "-1e20") == FPDEC_OK);
+        REQUIRE(fpdec_as_decimal128(&bits, &x, FPDEC_IEEE_DPD,
+                                    FPDEC_ROUND_HALF_EVEN) == FPDEC_OK);
+        REQUIRE(fpdec_from_decimal128(&y, bits, FPDEC_IEEE_DPD) == FPDEC_OK);
+        CHECK(fpdec_compare(&y, &expected, false) == 0);
+        CHECK(FPDEC_DEC_PREC(&y) == 13);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+        fpdec_reset_to_zero(&expected, 0);
+    }
+
+    SECTION("Rounding long digit arrays") {
+        const char *const literals[] = {
+            "12345678901234567890123456789012345",
+            "-12345678901234567890123456789012345",
+            "1234567890123456789.0123456789012345000000000000000000001",
+            "-98765432109876543210.98765432109876543210987654321",
+            "0.00000000000000000000012345678901234567890123456789012345",
+            "99999999999999999999999999999999995000",
+            "-99999999999999999999999999999999994999",
+            "1234567890123456789012345678901234.5",
+            "1234567890123456789012345678901233.5",
+            "1234567890123456789012345678901233.50000000000000000000001",
+            "100000000000000000000000000000000050000000000000000000000",
+        };
+
+        for (const char *lit : literals)
+            for (int rnd = FPDEC_ROUND_05UP; rnd <= FPDEC_MAX_ROUNDING_MODE;
+                 ++rnd) {
+                fpdec_t x = FPDEC_ZERO;
+                fpdec_t y = FPDEC_ZERO;
+                fpdec_t expected = FPDEC_ZERO;
+                uint128_t bits;
+
+                REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+                REQUIRE(fpdec_adjusted(&expected, &x,
+                                       33 - fpdec_magnitude(&x),
+                                       (enum FPDEC_ROUNDING_MODE)rnd)
+                        == FPDEC_OK);
+                REQUIRE(fpdec_as_decimal128(&bits, &x, FPDEC_IEEE_BID,
+                                            (enum FPDEC_ROUNDING_MODE)rnd)
+                        == FPDEC_OK);
+                REQUIRE(fpdec_from_decimal128(&y, bits, FPDEC_IEEE_BID)
+                        == FPDEC_OK);
+                INFO(lit << " rounding " << rnd);
+                CHECK(fpdec_compare(&y, &expected, false) == 0);
+                fpdec_reset_to_zero(&x, 0);
+                fpdec_reset_to_zero(&y, 0);
+                fpdec_reset_to_zero(&expected, 0);
+            }
+    }
+
+    SECTION("Special values and non-canonical coefficients") {
+        fpdec_t x = FPDEC_ZERO;
+
+        CHECK(fpdec_from_decimal128(&x, U128_RHS(0ULL, 0x7C00000000000000ULL),
+                                    FPDEC_IEEE_BID) ==
+              FPDEC_INVALID_ENCODING);
+        CHECK(fpdec_from_decimal128(&x, U128_RHS(0ULL, 0xF800000000000000ULL),
+                                    FPDEC_IEEE_DPD) ==
+              FPDEC_INVALID_ENCODING);
+        // coefficient 10^34
+        REQUIRE(fpdec_from_decimal128(
+            &x, U128_RHS(0x378D8E6400000000ULL, 0x3041ED09BEAD87C0ULL),
+            FPDEC_IEEE_BID) == FPDEC_OK);
+        CHECK(FPDEC_EQ_ZERO(&x));
+    }
+}
+
+TEST_CASE("IEEE 754 decimal columns") {
+    const char *const literals[] = {
+        "17.5", "-0.0000000000000000012", "123456789012.345", "0.000",
+        "-98765.4321", "4.5e30",
+    };
+    const size_t n = sizeof(literals) / sizeof(literals[0]);
+    std::vector<fpdec_t> x(n, FPDEC_ZERO);
+    std::vector<fpdec_t> y(n, FPDEC_ZERO);
+    std::vector<uint64_t> bits64(n);
+    std::vector<uint128_t> bits128(n);
+
+    for (size_t i = 0; i < n; ++i)
+        REQUIRE(fpdec_from_ascii_literal(&x[i], literals[i]) == FPDEC_OK);
+
+    for (auto enc : encodings) {
+        REQUIRE(fpdec_as_decimal64_n(bits64.data(), x.data(), n, enc,
+                                     FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+        REQUIRE(fpdec_from_decimal64_n(y.data(), bits64.data(), n, enc)
+                == FPDEC_OK);
+        for (size_t i = 0; i < n; ++i) {
+            check_equal(&y[i], &x[i]);
+            fpdec_reset_to_zero(&y[i], 0);
+        }
+        REQUIRE(fpdec_as_decimal128_n(bits128.data(), x.data(), n, enc,
+                                      FPDEC_ROUND_DEFAULT) == FPDEC_OK);
+        REQUIRE(fpdec_from_decimal128_n(y.data(), bits128.data(), n, enc)
+                == FPDEC_OK);
+        for (size_t i = 0; i < n; ++i) {
+            check_equal(&y[i], &x[i]);
+            fpdec_reset_to_zero(&y[i], 0);
+        }
+    }
+
+    // a special value resets all results
+    bits64[n - 1] = 0x7800000000000000ULL;
+    CHECK(fpdec_from_decimal64_n(y.data(), bits64.data(), n, FPDEC_IEEE_BID)
+          == FPDEC_INVALID_ENCODING);
+    for (const auto &z : y) {
+        CHECK(FPDEC_EQ_ZERO(&z));
+        CHECK(!FPDEC_IS_DYN_ALLOC(&z));
+    }
+
+    for (auto &z : x)
+        fpdec_reset_to_zero(&z, 0);
+}
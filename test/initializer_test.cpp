@@ -13,6 +13,7 @@ $Revision$
 */
 
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
 #include "catch.hpp"
@@ -94,6 +95,36 @@ TEST_CASE("Initialize from ascii literal") {
                     .dec_prec = 0,
                     .digits = {0UL, 17UL}
                 },
+                {
+                    .literal = "12345678.87654321",
+                    .sign = 1,
+                    .dec_prec = 8,
+                    .digits = {1234567887654321UL, 0UL}
+                },
+                {
+                    .literal = "-1234567.1234567",
+                    .sign = -1,
+                    .dec_prec = 7,
+                    .digits = {12345671234567UL, 0UL}
+                },
+                {
+                    .literal = "1234567890123456.12345678",
+                    .sign = 1,
+                    .dec_prec = 8,
+                    .digits = {11177671081292931406UL, 6692UL}
+                },
+                {
+                    .literal = "  0000000000000000000000000000000123456789",
+                    .sign = 1,
+                    .dec_prec = 0,
+                    .digits = {123456789UL, 0UL}
+                },
+                {
+                    .literal = "79228162514264337593543950335",
+                    .sign = 1,
+                    .dec_prec = 0,
+                    .digits = {18446744073709551615UL, 4294967295UL}
+                },
         };
 
         for (const auto &test : tests) {
@@ -123,12 +154,13 @@ TEST_CASE("Initialize from ascii literal") {
                         .digits = {7000000000000000000UL, 538UL}
                 },
                 {
-                        .literal = "82345678901234567890e-12",
+                        .literal = "82345678901234567890e-22",
                         .sign = 1,
-                        .dec_prec = 12,
-                        .exp = -1,
+                        .dec_prec = 22,
+                        .exp = -2,
                         .n_digits = 2,
-                        .digits = {9012345678900000000UL, 82345678UL}
+                        .digits = {8900000000000000000UL,
+                                   82345678901234567UL}
                 },
                 {
                         .literal = "1e459",
@@ -139,12 +171,12 @@ TEST_CASE("Initialize from ascii literal") {
                         .digits = {1000UL}
                 },
                 {
-                        .literal = "-3.0e-9",
+                        .literal = "-3.0e-19",
                         .sign = -1,
-                        .dec_prec = 10,
+                        .dec_prec = 20,
                         .exp = -1,
                         .n_digits = 1,
-                        .digits = {30000000000UL}
+                        .digits = {3UL}
                 }
         };
 
@@ -238,6 +270,14 @@ TEST_CASE("Initialize from ascii literal") {
                                    5142643375935439504UL,
                                    79228162UL}
                 },
+                {
+                    .literal = "79228162514264337593543950336",
+                    .sign = 1,
+                    .dec_prec = 0,
+                    .exp = 0,
+                    .n_digits = 2,
+                    .digits = {4264337593543950336UL, 7922816251UL}
+                },
                 {
                     .literal = "1e20401094656",
                     .sign = 1,
@@ -272,7 +312,8 @@ TEST_CASE("Initialize from ascii literal") {
     SECTION("Invalid ascii input") {
         std::string literals[] = {
                 " 1.23.5", "1.24e", "--4.92", "", "   ", "3,49E-3",
-                "\t+   \r\n"
+                "\t+   \r\n", "1234567a89", "12345678/9", "1234:5678.9",
+                "0.12345678901234567x", "1e+", "7.5E-"
         };
         for (const auto &literal : literals) {
             fpdec_t fpdec = FPDEC_ZERO;
@@ -320,6 +361,84 @@ TEST_CASE("Initialize from ascii literal") {
     }
 }
 
+TEST_CASE("Initialize from ascii chars") {
+
+    // fields of a record, neither of them terminated by NUL
+    const char buf[] = "17.25|-0.000000000000000000000000000003|"
+                       "123456789012345678901234567890.12|1.e|x7";
+
+    SECTION("Slices") {
+        struct {
+            size_t start;
+            size_t len;
+            const char *literal;
+        } tests[] = {
+            {0, 5, "17.25"},
+            {0, 2, "17"},
+            {6, 33, "-0.000000000000000000000000000003"},
+            {40, 33, "123456789012345678901234567890.12"},
+            {74, 2, "1."},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t fpdec = FPDEC_ZERO;
+            fpdec_t expected = FPDEC_ZERO;
+
+            SECTION(test.literal) {
+                REQUIRE(fpdec_from_ascii_chars(&fpdec, buf + test.start,
+                                               test.len) == FPDEC_OK);
+                REQUIRE(fpdec_from_ascii_literal(&expected, test.literal) ==
+                        FPDEC_OK);
+                CHECK(fpdec_compare(&fpdec, &expected, false) == 0);
+                CHECK(FPDEC_DEC_PREC(&fpdec) == FPDEC_DEC_PREC(&expected));
+            }
+            fpdec_reset_to_zero(&fpdec, 0);
+            fpdec_reset_to_zero(&expected, 0);
+        }
+    }
+
+    SECTION("Invalid slices") {
+        fpdec_t fpdec = FPDEC_ZERO;
+
+        CHECK(fpdec_from_ascii_chars(&fpdec, buf, 0) ==
+              FPDEC_INVALID_DECIMAL_LITERAL);
+        CHECK(fpdec_from_ascii_chars(&fpdec, buf, 6) ==
+              FPDEC_INVALID_DECIMAL_LITERAL);
+        CHECK(fpdec_from_ascii_chars(&fpdec, buf + 74, 3) ==
+              FPDEC_INVALID_DECIMAL_LITERAL);
+    }
+
+    SECTION("Tokenize") {
+        const char *literals[] = {
+            "17.25", "-0.000000000000000000000000000003",
+            "123456789012345678901234567890.12", "1.",
+        };
+        const char *curr = buf;
+        const char *stop = buf + sizeof(buf) - 1;
+        const char *end;
+
+        for (const auto literal : literals) {
+            fpdec_t fpdec = FPDEC_ZERO;
+            fpdec_t expected = FPDEC_ZERO;
+
+            REQUIRE(fpdec_parse_ascii_chars(&fpdec, curr, stop - curr,
+                                            &end) == FPDEC_OK);
+            REQUIRE(fpdec_from_ascii_literal(&expected, literal) ==
+                    FPDEC_OK);
+            CHECK(fpdec_compare(&fpdec, &expected, false) == 0);
+            CHECK(end == curr + strlen(literal));
+            fpdec_reset_to_zero(&fpdec, 0);
+            fpdec_reset_to_zero(&expected, 0);
+            // skip "|" or "e|"
+            curr = (const char *)memchr(end, '|', stop - end) + 1;
+        }
+        fpdec_t fpdec = FPDEC_ZERO;
+        CHECK(fpdec_parse_ascii_chars(&fpdec, curr, stop - curr, &end) ==
+              FPDEC_INVALID_DECIMAL_LITERAL);
+        CHECK(end == curr);
+    }
+}
+
 TEST_CASE("Initialize from unicode literal") {
 
     int offsets[] = {0x000006F0, 0x0000A8D0, 0x00011066, 0x0001E950};
@@ -0,0 +1,162 @@
+/* ---------------------------------------------------------------------------
+Name:        inplace_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cstdlib>
+#include <string>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "3", "-0.0000000000000000012",
+    "123456789012.345", "79228162514264337593543950335",
+    "-1234567890123456789012345.6789", "0.00000000000000000000000005",
+    "1.0000000000000000000000000000000000000001",
+    "-99999999999999999999999999999999999999.99999999999999999999",
+    "4.5e30", "-2.5e-40",
+};
+
+typedef error_t (*bin_op)(fpdec_t *, const fpdec_t *, const fpdec_t *);
+typedef error_t (*in_place_op)(fpdec_t *, const fpdec_t *);
+
+static error_t
+div_limited(fpdec_t *z, const fpdec_t *x, const fpdec_t *y) {
+    return fpdec_div(z, x, y, 30, FPDEC_ROUND_HALF_UP);
+}
+
+static error_t
+idiv_limited(fpdec_t *x, const fpdec_t *y) {
+    return fpdec_idiv(x, y, 30, FPDEC_ROUND_HALF_UP);
+}
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == FPDEC_DEC_PREC(expected));
+}
+
+static void
+check_in_place_op(in_place_op iop, bin_op op, const char *lit_x,
+                  const char *lit_y) {
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t x_orig = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+    error_t rc, rc_expected;
+
+    REQUIRE(fpdec_from_ascii_literal(&x, lit_x) == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&y, lit_y) == FPDEC_OK);
+    REQUIRE(fpdec_copy(&x_orig, &x) == FPDEC_OK);
+    rc_expected = op(&z, &x, &y);
+    rc = iop(&x, &y);
+    CHECK(rc == rc_expected);
+    if (rc == FPDEC_OK)
+        check_equal(&x, &z);
+    else
+        check_equal(&x, &x_orig);
+    fpdec_reset_to_zero(&z, 0);
+
+    // aliased operands
+    fpdec_reset_to_zero(&x, 0);
+    REQUIRE(fpdec_copy(&x, &x_orig) == FPDEC_OK);
+    rc_expected = op(&z, &x_orig, &x_orig);
+    rc = iop(&x, &x);
+    CHECK(rc == rc_expected);
+    if (rc == FPDEC_OK)
+        check_equal(&x, &z);
+    else
+        check_equal(&x, &x_orig);
+
+    fpdec_reset_to_zero(&x, 0);
+    fpdec_reset_to_zero(&y, 0);
+    fpdec_reset_to_zero(&x_orig, 0);
+    fpdec_reset_to_zero(&z, 0);
+}
+
+TEST_CASE("In-place arithmetic") {
+
+    struct {
+        const char *name;
+        in_place_op iop;
+        bin_op op;
+    } ops[] = {
+        {"iadd", fpdec_iadd, fpdec_add},
+        {"isub", fpdec_isub, fpdec_sub},
+        {"imul", fpdec_imul, fpdec_mul},
+        {"idiv", idiv_limited, div_limited},
+    };
+
+    for (const auto &op : ops) {
+
+        SECTION(op.name) {
+            for (const char *lit_x : literals)
+                for (const char *lit_y : literals) {
+                    if (op.op == div_limited && lit_y[0] == '0' &&
+                        std::string(lit_y).find_first_not_of("0.") ==
+                        std::string::npos)
+                        continue;
+                    check_in_place_op(op.iop, op.op, lit_x, lit_y);
+                }
+        }
+    }
+
+    SECTION("Division by zero leaves x unchanged") {
+        check_in_place_op(idiv_limited, div_limited, "17.5", "0");
+        check_in_place_op(idiv_limited, div_limited,
+                          "1.0000000000000000000000000000000000000001", "0");
+    }
+}
+
+static size_t n_allocs = 0;
+
+static void *
+counting_alloc(size_t num, size_t size) {
+    n_allocs++;
+    return calloc(num, size);
+}
+
+TEST_CASE("In-place arithmetic: reuse of digit array") {
+    fpdec_t acc = FPDEC_ZERO;
+    fpdec_t fine = FPDEC_ZERO;
+    fpdec_t price = FPDEC_ZERO;
+    fpdec_t expected = FPDEC_ZERO;
+
+    REQUIRE(fpdec_from_ascii_literal(&acc, "1000000.00000000000000000000001")
+            == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&fine, "0.00000000000000000000000003")
+            == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&price, "-17.25") == FPDEC_OK);
+    REQUIRE(fpdec_from_ascii_literal(&expected,
+                                     "999310.00000000000000000000001120")
+            == FPDEC_OK);
+
+    fpdec_set_mem_funcs(counting_alloc, free);
+    n_allocs = 0;
+    for (int i = 0; i < 40; ++i) {
+        REQUIRE(fpdec_iadd(&acc, &fine) == FPDEC_OK);
+        REQUIRE(fpdec_iadd(&acc, &price) == FPDEC_OK);
+    }
+    fpdec_set_mem_funcs(NULL, NULL);
+    // at most the initial provision for carries
+    CHECK(n_allocs <= 1);
+    check_equal(&acc, &expected);
+
+    fpdec_reset_to_zero(&acc, 0);
+    fpdec_reset_to_zero(&fine, 0);
+    fpdec_reset_to_zero(&price, 0);
+    fpdec_reset_to_zero(&expected, 0);
+}
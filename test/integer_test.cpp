@@ -0,0 +1,253 @@
+/* ---------------------------------------------------------------------------
+Name:        integer_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+#include "checks.hpp"
+
+
+static void
+check_literal(const fpdec_t *z, const char *literal) {
+    fpdec_t expected = FPDEC_ZERO;
+
+    REQUIRE(fpdec_from_ascii_literal(&expected, literal) == FPDEC_OK);
+    CHECK(fpdec_compare(z, &expected, false) == 0);
+    fpdec_reset_to_zero(&expected, 0);
+}
+
+TEST_CASE("From unsigned / 128-bit integers") {
+
+    SECTION("u64") {
+        const struct {
+            uint64_t val;
+            const char *literal;
+        } tests[] = {
+            {0, "0"},
+            {17, "17"},
+            {UINT64_MAX, "18446744073709551615"},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t z = FPDEC_ZERO;
+
+            REQUIRE(fpdec_from_u64(&z, test.val) == FPDEC_OK);
+            check_literal(&z, test.literal);
+            CHECK(FPDEC_DEC_PREC(&z) == 0);
+            fpdec_reset_to_zero(&z, 0);
+        }
+    }
+
+    SECTION("u128 / i128") {
+        const uint128_t two_pow_96 = (uint128_t)1 << 96U;
+        const struct {
+            uint128_t val;
+            bool neg;
+            const char *literal;
+        } tests[] = {
+            {UINT128_ZERO, false, "0"},
+            {(uint128_t)12345, true, "-12345"},
+            {two_pow_96 - 1, false, "79228162514264337593543950335"},
+            {two_pow_96, true, "-79228162514264337593543950336"},
+            {UINT128_MAX, false, "340282366920938463463374607431768211455"},
+            {(uint128_t)1 << 127U, true,
+             "-170141183460469231731687303715884105728"},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t z = FPDEC_ZERO;
+
+            // negated in unsigned arithmetic, as -(__int128)(2 ^ 127)
+            // would overflow
+            if (test.neg)
+                REQUIRE(fpdec_from_i128(&z, (__int128)(0 - test.val)) ==
+                        FPDEC_OK);
+            else
+                REQUIRE(fpdec_from_u128(&z, test.val) == FPDEC_OK);
+            check_literal(&z, test.literal);
+            fpdec_reset_to_zero(&z, 0);
+        }
+    }
+}
+
+TEST_CASE("As integers") {
+
+    SECTION("Rounded") {
+        const struct {
+            const char *literal;
+            enum FPDEC_ROUNDING_MODE rnd;
+            int64_t val;
+        } tests[] = {
+            {"0.000", FPDEC_ROUND_UP, 0},
+            {"17.5", FPDEC_ROUND_HALF_EVEN, 18},
+            {"16.5", FPDEC_ROUND_HALF_EVEN, 16},
+            {"-16.5", FPDEC_ROUND_HALF_UP, -17},
+            {"-0.0001", FPDEC_ROUND_FLOOR, -1},
+            {"-0.0001", FPDEC_ROUND_CEILING, 0},
+            {"9223372036854775807.4", FPDEC_ROUND_HALF_UP, INT64_MAX},
+            {"-9223372036854775808.5", FPDEC_ROUND_DOWN, INT64_MIN},
+            {"1234567890123456789.00000000000000000000001",
+             FPDEC_ROUND_DOWN, 1234567890123456789},
+            {"1234567890123456789.00000000000000000000001",
+             FPDEC_ROUND_UP, 1234567890123456790},
+            {"-1e18", FPDEC_ROUND_DOWN, -1000000000000000000},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            int64_t val;
+            __int128 val128;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, test.literal) == FPDEC_OK);
+            REQUIRE(fpdec_as_i64(&val, &x, test.rnd) == FPDEC_OK);
+            CHECK(val == test.val);
+            REQUIRE(fpdec_as_i128(&val128, &x, test.rnd) == FPDEC_OK);
+            CHECK(val128 == test.val);
+            fpdec_reset_to_zero(&x, 0);
+        }
+    }
+
+    SECTION("Overflow") {
+        const struct {
+            const char *literal;
+            enum FPDEC_ROUNDING_MODE rnd;
+            int64_t val;
+        } tests[] = {
+            {"9223372036854775807.5", FPDEC_ROUND_HALF_UP, INT64_MAX},
+            {"9223372036854775808", FPDEC_ROUND_DOWN, INT64_MAX},
+            {"-9223372036854775808.5", FPDEC_ROUND_UP, INT64_MIN},
+            {"-1e40", FPDEC_ROUND_DOWN, INT64_MIN},
+            {"1e1000", FPDEC_ROUND_DOWN, INT64_MAX},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            int64_t val;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, test.literal) == FPDEC_OK);
+            CHECK(fpdec_as_i64(&val, &x, test.rnd) ==
+                  FPDEC_EXP_LIMIT_EXCEEDED);
+            CHECK(val == test.val);
+            fpdec_reset_to_zero(&x, 0);
+        }
+
+        fpdec_t x = FPDEC_ZERO;
+        __int128 val128;
+
+        REQUIRE(fpdec_from_ascii_literal(
+            &x, "-170141183460469231731687303715884105728.4") == FPDEC_OK);
+        REQUIRE(fpdec_as_i128(&val128, &x, FPDEC_ROUND_HALF_UP) == FPDEC_OK);
+        CHECK(val128 == -(__int128)(UINT128_MAX >> 1U) - 1);
+        CHECK(fpdec_as_i128(&val128, &x, FPDEC_ROUND_UP) ==
+              FPDEC_EXP_LIMIT_EXCEEDED);
+        CHECK(val128 == -(__int128)(UINT128_MAX >> 1U) - 1);
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Scaled") {
+        const struct {
+            const char *literal;
+            int32_t scale;
+            enum FPDEC_ROUNDING_MODE rnd;
+            int64_t val;
+        } tests[] = {
+            {"12.345", 2, FPDEC_ROUND_HALF_EVEN, 1234},
+            {"12.355", 2, FPDEC_ROUND_HALF_EVEN, 1236},
+            {"-12.3", 8, FPDEC_ROUND_DOWN, -1230000000},
+            {"0.00000001", 8, FPDEC_ROUND_DOWN, 1},
+            {"21000000.00000000", 8, FPDEC_ROUND_DOWN, 2100000000000000},
+            {"123456.789", -3, FPDEC_ROUND_HALF_UP, 123},
+            {"0.1", -5, FPDEC_ROUND_UP, 1},
+            {"1.000000000000000000000000000005", 30, FPDEC_ROUND_DOWN,
+             INT64_MIN},
+            {"0.000000000000000000000000000005", 30, FPDEC_ROUND_DOWN, 5},
+            {"1e-40", 25, FPDEC_ROUND_CEILING, 1},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+            int64_t val;
+            error_t rc;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, test.literal) == FPDEC_OK);
+            rc = fpdec_as_scaled_i64(&val, &x, test.scale, test.rnd);
+            if (test.val == INT64_MIN && test.literal[0] != '-') {
+                CHECK(rc == FPDEC_EXP_LIMIT_EXCEEDED);
+                CHECK(val == INT64_MAX);
+            }
+            else {
+                REQUIRE(rc == FPDEC_OK);
+                CHECK(val == test.val);
+            }
+            fpdec_reset_to_zero(&x, 0);
+        }
+
+        fpdec_t x = FPDEC_ZERO;
+        int64_t val;
+
+        REQUIRE(fpdec_from_long_long(&x, 1) == FPDEC_OK);
+        CHECK(fpdec_as_scaled_i64(&val, &x, FPDEC_MAX_DEC_PREC + 1,
+                                  FPDEC_ROUND_DOWN) ==
+              FPDEC_PREC_LIMIT_EXCEEDED);
+    }
+
+    SECTION("Random scaled values") {
+        std::mt19937_64 rng(4711);
+
+        for (int i = 0; i < 2000; ++i) {
+            std::string lit = std::to_string((int64_t)rng() >> (rng() % 60));
+            int32_t lit_exp = (int32_t)(rng() % 50) - 40;
+            int32_t scale = (int32_t)(rng() % 30) - 5;
+            enum FPDEC_ROUNDING_MODE rnd =
+                (enum FPDEC_ROUNDING_MODE)(rng() % FPDEC_MAX_ROUNDING_MODE +
+                                           1);
+            fpdec_t x = FPDEC_ZERO;
+            fpdec_t adj = FPDEC_ZERO;
+            fpdec_t res = FPDEC_ZERO;
+            int64_t val;
+            error_t rc;
+
+            lit += "e" + std::to_string(lit_exp);
+            REQUIRE(fpdec_from_ascii_literal(&x, lit.c_str()) == FPDEC_OK);
+            REQUIRE(fpdec_adjusted(&adj, &x, scale, rnd) == FPDEC_OK);
+            rc = fpdec_as_scaled_i64(&val, &x, scale, rnd);
+            if (rc == FPDEC_OK) {
+                lit = std::to_string(val) + "e" + std::to_string(-scale);
+                REQUIRE(fpdec_from_ascii_literal(&res, lit.c_str()) ==
+                        FPDEC_OK);
+                CHECK(fpdec_compare(&res, &adj, false) == 0);
+            }
+            else {
+                CHECK(rc == FPDEC_EXP_LIMIT_EXCEEDED);
+                CHECK(fpdec_magnitude(&adj) + scale >= 18);
+            }
+            fpdec_reset_to_zero(&x, 0);
+            fpdec_reset_to_zero(&adj, 0);
+            fpdec_reset_to_zero(&res, 0);
+        }
+    }
+}
+
+TEST_CASE("Decimal as integers") {
+    using fpdec::Decimal;
+    using fpdec::Rounding;
+
+    CHECK(Decimal("-17.5").as_i64(Rounding::round_half_even) == -18);
+    CHECK(Decimal("12.345").as_scaled_i64(2, Rounding::round_down) == 1234);
+    CHECK_THROWS_AS(Decimal("1e19").as_i64(), fpdec::InternalLimitExceeded);
+}
@@ -0,0 +1,235 @@
+/* ---------------------------------------------------------------------------
+Name:        key_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "17.50", "3", "-0.0000000000000000012",
+    "123456789012.345", "79228162514264337593543950335",
+    "79228162514264337593543950336", "-1234567890123456789012345.6789",
+    "0.00000000000000000000000005", "0.1", "0.10", "0.105", "-0.1",
+    "-0.105", "1.0000000000000000000000000000000000000000",
+    "-99999999999999999999999999999999999999.99999999999999999999",
+    "4.5e30", "-2.5e-40", "1e-62", "1e-63", "1e61", "1e62", "-1e62",
+    "-1e-65535", "1e-65535", "-123e60000", "123e60000",
+    "1234567890123456789012345678901234567890123456789e-20",
+};
+
+static std::vector<uint8_t>
+key_of(const fpdec_t *x) {
+    std::vector<uint8_t> key(fpdec_key_size(x));
+    size_t len;
+
+    REQUIRE(fpdec_encode_key(key.data(), key.size(), &len, x) == FPDEC_OK);
+    REQUIRE(len == key.size());
+    return key;
+}
+
+static int
+cmp_keys(const std::vector<uint8_t> &k1, const std::vector<uint8_t> &k2) {
+    int rc = memcmp(k1.data(), k2.data(), std::min(k1.size(), k2.size()));
+    if (rc == 0)
+        return (k1.size() > k2.size()) - (k1.size() < k2.size());
+    return rc < 0 ? -1 : 1;
+}
+
+static void
+check_key_order(const fpdec_t *x, const fpdec_t *y) {
+    std::vector<uint8_t> kx = key_of(x);
+    std::vector<uint8_t> ky = key_of(y);
+    int cmp = fpdec_compare(x, y, false);
+
+    if (cmp != 0)
+        CHECK(cmp_keys(kx, ky) == cmp);
+    else {
+        // equal values differ only in the precision
+        REQUIRE(kx.size() == ky.size());
+        CHECK(memcmp(kx.data(), ky.data(), kx.size() - 2) == 0);
+        CHECK(cmp_keys(kx, ky) == (FPDEC_DEC_PREC(x) > FPDEC_DEC_PREC(y)) -
+                                  (FPDEC_DEC_PREC(x) < FPDEC_DEC_PREC(y)));
+    }
+}
+
+static void
+check_round_trip(const fpdec_t *x) {
+    std::vector<uint8_t> key = key_of(x);
+    fpdec_t y = FPDEC_ZERO;
+    size_t len;
+
+    // trailing bytes are not read
+    key.push_back(0xFF);
+    REQUIRE(fpdec_decode_key(&y, key.data(), key.size(), &len) == FPDEC_OK);
+    CHECK(len == key.size() - 1);
+    CHECK(fpdec_compare(&y, x, false) == 0);
+    CHECK(FPDEC_DEC_PREC(&y) == FPDEC_DEC_PREC(x));
+    fpdec_reset_to_zero(&y, 0);
+}
+
+TEST_CASE("Order preserving keys") {
+
+    SECTION("Encoding") {
+        const struct {
+            const char *literal;
+            std::vector<uint8_t> key;
+        } tests[] = {
+            {"0", {0x80, 0x00, 0x00}},
+            {"0.00", {0x80, 0x00, 0x02}},
+            {"1", {0xC1, 20, 0x00, 0x00}},
+            {"-1", {0x3F, 235, 0x00, 0x00}},
+            {"12.50", {0xC2, 25, 100, 0x00, 0x02}},
+            {"-12.50", {0x3E, 230, 155, 0x00, 0x02}},
+            {"0.0123", {0xBF, 25, 60, 0x00, 0x04}},
+            {"1e63", {0xFF, 0x80, 0, 0, 0, 0, 0, 0, 64, 20, 0x00, 0x00}},
+        };
+
+        for (const auto &test : tests) {
+            fpdec_t x = FPDEC_ZERO;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, test.literal) == FPDEC_OK);
+            CHECK(key_of(&x) == test.key);
+            fpdec_reset_to_zero(&x, 0);
+        }
+    }
+
+    SECTION("Literals") {
+        const size_t n = sizeof(literals) / sizeof(literals[0]);
+        fpdec_t xs[n];
+
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = FPDEC_ZERO;
+            REQUIRE(fpdec_from_ascii_literal(&xs[i], literals[i]) ==
+                    FPDEC_OK);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            check_round_trip(&xs[i]);
+            for (size_t j = 0; j < n; ++j)
+                check_key_order(&xs[i], &xs[j]);
+        }
+        for (size_t i = 0; i < n; ++i)
+            fpdec_reset_to_zero(&xs[i], 0);
+    }
+
+    SECTION("Random values") {
+        std::mt19937_64 rng(4711);
+        std::vector<fpdec_t> xs(500, FPDEC_ZERO);
+
+        for (fpdec_t &x : xs) {
+            std::string lit = rng() % 2 ? "-" : "";
+            size_t n_digits = 1 + rng() % 45;
+            for (size_t i = 0; i < n_digits; ++i)
+                lit += (char)('0' + rng() % 10);
+            // make some values collide
+            if (rng() % 4 == 0)
+                lit = lit.substr(0, 1 + rng() % 3) + "0";
+            lit += "e" + std::to_string((int)(rng() % 120) - 80);
+            REQUIRE(fpdec_from_ascii_literal(&x, lit.c_str()) == FPDEC_OK);
+        }
+        for (size_t i = 0; i < xs.size(); ++i) {
+            check_round_trip(&xs[i]);
+            check_key_order(&xs[i], &xs[(i * 7919) % xs.size()]);
+            if (i > 0)
+                check_key_order(&xs[i], &xs[i - 1]);
+        }
+        // sorting by key sorts by value
+        std::vector<std::vector<uint8_t>> keys;
+        for (const fpdec_t &x : xs)
+            keys.push_back(key_of(&x));
+        std::sort(keys.begin(), keys.end(),
+                  [](const std::vector<uint8_t> &k1,
+                     const std::vector<uint8_t> &k2) {
+                      return cmp_keys(k1, k2) < 0;
+                  });
+        fpdec_t prev = FPDEC_ZERO;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            fpdec_t x = FPDEC_ZERO;
+            size_t len;
+
+            REQUIRE(fpdec_decode_key(&x, keys[i].data(), keys[i].size(),
+                                     &len) == FPDEC_OK);
+            if (i > 0)
+                CHECK(fpdec_compare(&prev, &x, false) <= 0);
+            fpdec_reset_to_zero(&prev, 0);
+            prev = x;
+        }
+        fpdec_reset_to_zero(&prev, 0);
+        for (fpdec_t &x : xs)
+            fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Buffer too small") {
+        fpdec_t x = FPDEC_ZERO;
+        uint8_t buf[4] = {1, 2, 3, 4};
+        size_t len;
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "-12.50") == FPDEC_OK);
+        REQUIRE(fpdec_encode_key(buf, 4, &len, &x) == FPDEC_OK);
+        CHECK(len == 5);
+        CHECK(buf[0] == 1);
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Invalid keys") {
+        const std::vector<uint8_t> keys[] = {
+            {},
+            {0x00, 0x00, 0x00},
+            {0x80, 0x00},
+            // missing digits / precision
+            {0xC1},
+            {0xC1, 21, 0x00, 0x00},
+            {0xC1, 20, 0x00},
+            // pair > 99, first digit 0, last pair 00
+            {0xC1, 200, 0x00, 0x00},
+            {0xC1, 8, 0x00, 0x00},
+            {0xC1, 21, 0, 0x00, 0x00},
+            // exponent fitting into the header
+            {0xFF, 0x80, 0, 0, 0, 0, 0, 0, 1, 20, 0x00, 0x00},
+            // precision not covering the fractional digits
+            {0xC1, 25, 100, 0x00, 0x01},
+        };
+
+        for (const auto &key : keys) {
+            fpdec_t x = FPDEC_ZERO;
+            size_t len;
+
+            CHECK(fpdec_decode_key(&x, key.data(), key.size(), &len) ==
+                  FPDEC_INVALID_ENCODING);
+            CHECK(FPDEC_EQ_ZERO(&x));
+            CHECK(!FPDEC_IS_DYN_ALLOC(&x));
+        }
+    }
+}
+
+TEST_CASE("Decimal keys") {
+    using fpdec::Decimal;
+
+    std::vector<uint8_t> k1 = Decimal("-3.25").key();
+    std::vector<uint8_t> k2 = Decimal("1.5").key();
+    size_t n_read;
+
+    CHECK(cmp_keys(k1, k2) < 0);
+    CHECK(Decimal::from_key(k1.data(), k1.size(), &n_read) ==
+          Decimal("-3.25"));
+    CHECK(n_read == k1.size());
+    CHECK_THROWS_AS(Decimal::from_key(k1.data(), 1), fpdec::InvalidEncoding);
+}
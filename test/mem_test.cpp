@@ -0,0 +1,218 @@
+/* ---------------------------------------------------------------------------
+Name:        mem_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cstdlib>
+#include <thread>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "checks.hpp"
+
+static size_t n_allocs = 0;
+static size_t n_frees = 0;
+
+static void *
+counting_alloc(size_t num, size_t size) {
+    n_allocs++;
+    return calloc(num, size);
+}
+
+static void
+counting_free(void *ptr) {
+    n_frees++;
+    free(ptr);
+}
+
+static const char *const big_literal =
+    "1234567890123456789012345678901234567890.0987654321";
+
+TEST_CASE("Pluggable allocator") {
+    fpdec_t fpdec = FPDEC_ZERO;
+    mem_alloc_func alloc_func;
+    mem_free_func free_func;
+    error_t rc;
+
+    n_allocs = n_frees = 0;
+
+    SECTION("Process-wide allocator") {
+        REQUIRE(fpdec_set_mem_funcs(counting_alloc, counting_free) ==
+                FPDEC_OK);
+        fpdec_get_mem_funcs(&alloc_func, &free_func);
+        CHECK(alloc_func == counting_alloc);
+        CHECK(free_func == counting_free);
+        rc = fpdec_from_ascii_literal(&fpdec, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(is_digit_array(&fpdec));
+        CHECK(n_allocs == 1);
+        fpdec_reset_to_zero(&fpdec, 0);
+        CHECK(n_frees == 1);
+        fpdec_set_mem_funcs(NULL, NULL);
+        fpdec_get_mem_funcs(&alloc_func, &free_func);
+        CHECK(alloc_func == calloc);
+        CHECK(free_func == free);
+    }
+
+    SECTION("Process-wide allocator is replaced atomically") {
+        bool mixed = false;
+        std::thread thread([] {
+            for (int i = 0; i < 10000; ++i) {
+                fpdec_set_mem_funcs(counting_alloc, counting_free);
+                fpdec_set_mem_funcs(NULL, NULL);
+            }
+        });
+        for (int i = 0; i < 10000; ++i) {
+            fpdec_get_mem_funcs(&alloc_func, &free_func);
+            mixed |= (alloc_func == calloc) != (free_func == free);
+        }
+        thread.join();
+        CHECK(!mixed);
+        fpdec_get_mem_funcs(&alloc_func, &free_func);
+        CHECK(alloc_func == calloc);
+        CHECK(free_func == free);
+    }
+
+    SECTION("Thread-specific allocator overrides process-wide one") {
+        fpdec_set_thread_mem_funcs(counting_alloc, counting_free);
+        fpdec_get_thread_mem_funcs(&alloc_func, &free_func);
+        CHECK(alloc_func == counting_alloc);
+        CHECK(free_func == counting_free);
+        rc = fpdec_from_ascii_literal(&fpdec, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        fpdec_reset_to_zero(&fpdec, 0);
+        CHECK(n_allocs == 1);
+        CHECK(n_frees == 1);
+        fpdec_set_thread_mem_funcs(NULL, NULL);
+        rc = fpdec_from_ascii_literal(&fpdec, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        fpdec_reset_to_zero(&fpdec, 0);
+        CHECK(n_allocs == 1);
+        CHECK(n_frees == 1);
+    }
+}
+
+TEST_CASE("Pool allocator") {
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+    fpdec_digit_array_t *digit_array;
+    error_t rc;
+
+    fpdec_set_thread_mem_funcs(fpdec_pool_alloc, fpdec_pool_free);
+
+    SECTION("Freed blocks are reused") {
+        rc = fpdec_from_ascii_literal(&x, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        digit_array = x.digit_array;
+        fpdec_reset_to_zero(&x, 0);
+        rc = fpdec_from_ascii_literal(&y, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(y.digit_array == digit_array);
+        fpdec_reset_to_zero(&y, 0);
+    }
+
+    SECTION("Reused blocks are zeroed") {
+        rc = fpdec_from_ascii_literal(&x, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&y, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        for (int i = 0; i < 5; ++i) {
+            rc = fpdec_mul(&z, &x, &y);
+            REQUIRE(rc == FPDEC_OK);
+            char *lit = fpdec_as_ascii_literal(&z, false);
+            CHECK(std::string(lit) ==
+                  "15241578753238836750495351562566681945007773"
+                  "21024785855851726870906297515622742."
+                  "23502514857789971041");
+            fpdec_mem_free(lit);
+            fpdec_reset_to_zero(&z, 0);
+        }
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&y, 0);
+    }
+
+    SECTION("Large blocks") {
+        void *p = fpdec_pool_alloc(10000, 1);
+        REQUIRE(p != NULL);
+        CHECK(((uint8_t *)p)[9999] == 0);
+        fpdec_pool_free(p);
+    }
+
+    SECTION("Other threads") {
+        std::thread thread([] {
+            fpdec_t t = FPDEC_ZERO;
+
+            fpdec_set_thread_mem_funcs(fpdec_pool_alloc, fpdec_pool_free);
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(fpdec_from_ascii_literal(&t, big_literal) ==
+                        FPDEC_OK);
+                fpdec_reset_to_zero(&t, 0);
+            }
+            // cached blocks are freed at thread exit
+        });
+        thread.join();
+    }
+
+    fpdec_pool_clear();
+    fpdec_set_thread_mem_funcs(NULL, NULL);
+}
+
+TEST_CASE("Arena allocator") {
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+    fpdec_digit_array_t *digit_array;
+    error_t rc;
+
+    fpdec_arena_reset();
+    fpdec_set_thread_mem_funcs(fpdec_arena_alloc, fpdec_arena_free);
+
+    SECTION("Reset releases all blocks at once") {
+        rc = fpdec_from_ascii_literal(&x, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        digit_array = x.digit_array;
+        rc = fpdec_from_ascii_literal(&y, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(y.digit_array != digit_array);
+        rc = fpdec_mul(&z, &x, &y);
+        REQUIRE(rc == FPDEC_OK);
+        char *lit = fpdec_as_ascii_literal(&z, false);
+        CHECK(std::string(lit) ==
+              "15241578753238836750495351562566681945007773"
+              "21024785855851726870906297515622742."
+              "23502514857789971041");
+        // values are abandoned, not freed
+        fpdec_arena_reset();
+        x = FPDEC_ZERO;
+        rc = fpdec_from_ascii_literal(&x, big_literal);
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(x.digit_array == digit_array);
+    }
+
+    SECTION("Large blocks") {
+        void *p = fpdec_arena_alloc(100000, 1);
+        void *q = fpdec_arena_alloc(3, 5);
+        REQUIRE(p != NULL);
+        REQUIRE(q != NULL);
+        CHECK(((uint8_t *)p)[99999] == 0);
+        CHECK((uintptr_t)q % alignof(max_align_t) == 0);
+    }
+
+    SECTION("Overflow") {
+        CHECK(fpdec_arena_alloc(SIZE_MAX / 2, 3) == NULL);
+        CHECK(fpdec_arena_alloc(1, SIZE_MAX) == NULL);
+    }
+
+    fpdec_arena_reset();
+    fpdec_set_thread_mem_funcs(NULL, NULL);
+}
@@ -12,7 +12,10 @@ $Source$
 $Revision$
 */
 
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <thread>
 
 #include "catch.hpp"
 #include "fpdec.h"
@@ -96,6 +99,16 @@ TEST_CASE("Multiplication") {
                         .lit_y = "-0.01",
                         .lit_mult = "-10000000000000000000000000.05",
                 },
+                {
+                        .lit_x = "-123456789.012345678",
+                        .lit_y = "-1.00",
+                        .lit_mult = "123456789.01234567800",
+                },
+                {
+                        .lit_x = "-17.05",
+                        .lit_y = "0.00000002",
+                        .lit_mult = "-.0000003410",
+                },
         };
 
         for (const auto &test : tests) {
@@ -117,22 +130,33 @@ TEST_CASE("Multiplication") {
         };
 
         struct mul_test_data tests[] = {
-                {
-                        .lit_x = "-123456789.012345678",
-                        .lit_y = "-1.00",
-                        .lit_mult = "123456789.01234567800",
-                },
-                {
-                        .lit_x = "-17.05",
-                        .lit_y = "0.00000002",
-                        .lit_mult = "-.0000003410",
-                },
                 {
                         .lit_x = "1000000000000000000000000005",
                         .lit_y = "792281625142643.11",
                         .lit_mult =
                         "792281625142643110000000003961408125713215.55",
                 },
+                {
+                        .lit_x = "-0.123456789012345678",
+                        .lit_y = "987654321.987654321",
+                        .lit_mult = "-121932631.246761162347203169222374638",
+                },
+                {
+                        .lit_x = "79228162514.264337593543950335",
+                        .lit_y = "-79228162514.264337593543950335",
+                        .lit_mult = "-6277101735386680763835."
+                                    "789423049210091073826769276946612225",
+                },
+                {
+                        .lit_x = "0.5",
+                        .lit_y = "0.000000000000000002",
+                        .lit_mult = "0.0000000000000000010",
+                },
+                {
+                        .lit_x = "2.000000000000000000",
+                        .lit_y = "3.00",
+                        .lit_mult = "6.00000000000000000000",
+                },
         };
 
         for (const auto &test : tests) {
@@ -161,12 +185,12 @@ TEST_CASE("Multiplication") {
                 },
                 {
                         .lit_x = "-17.05",
-                        .lit_y = "0.0000000002",
-                        .lit_mult = "-.000000003410",
+                        .lit_y = "0.00000000020000000000",
+                        .lit_mult = "-.0000000034100000000000",
                 },
                 {
                         .lit_x = "100000000000000000000000000.5",
-                        .lit_y = "792281625142643.1100000000",
+                        .lit_y = "792281625142643.11000000000000000000",
                         .lit_mult =
                         "79228162514264311000000000396140812571321"
                         ".55500000000",
@@ -193,18 +217,18 @@ TEST_CASE("Multiplication") {
 
         struct mul_test_data tests[] = {
                 {
-                        .lit_x = "-0.0000000001",
+                        .lit_x = "-0.00000000010000000000",
                         .lit_y = "-123456789012345678901234567890",
                         .lit_mult = "12345678901234567890.1234567890",
                 },
                 {
-                        .lit_x = "-0.0000000175",
-                        .lit_y = "0.0000000002",
+                        .lit_x = "-0.00000001750000000000",
+                        .lit_y = "0.00000000020000000000",
                         .lit_mult = "-0.00000000000000000350",
                 },
                 {
                         .lit_x = "10000000000000000000000000000.5",
-                        .lit_y = "792281625142643.1111111111",
+                        .lit_y = "792281625142643.11111111110000000000",
                         .lit_mult =
                         "7922816251426431111111111000396140812571321"
                         ".55555555555",
@@ -250,3 +274,113 @@ TEST_CASE("Multiplication: Limits exceeded") {
         fpdec_reset_to_zero(&x, 0);
     }
 }
+
+static std::string
+random_digits(size_t n, uint64_t &seed) {
+    std::string digits;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        digits += (char)('0' + (seed >> 33U) % 10);
+    }
+    digits[0] = '1' + digits[0] % 9;
+    return digits;
+}
+
+static void
+check_mul_with_karatsuba(const std::string &lit_x, const std::string &lit_y) {
+    error_t rc;
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t y = FPDEC_ZERO;
+    fpdec_t z_school = FPDEC_ZERO;
+    fpdec_t z_karatsuba = FPDEC_ZERO;
+    size_t threshold = fpdec_get_karatsuba_threshold();
+
+    rc = fpdec_from_ascii_literal(&x, lit_x.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    rc = fpdec_from_ascii_literal(&y, lit_y.c_str());
+    REQUIRE(rc == FPDEC_OK);
+    fpdec_set_karatsuba_threshold(SIZE_MAX);
+    rc = fpdec_mul(&z_school, &x, &y);
+    REQUIRE(rc == FPDEC_OK);
+    fpdec_set_karatsuba_threshold(0);
+    rc = fpdec_mul(&z_karatsuba, &x, &y);
+    fpdec_set_karatsuba_threshold(threshold);
+    REQUIRE(rc == FPDEC_OK);
+    CHECK(fpdec_compare(&z_karatsuba, &z_school, false) == 0);
+    fpdec_reset_to_zero(&x, 0);
+    fpdec_reset_to_zero(&y, 0);
+    fpdec_reset_to_zero(&z_school, 0);
+    fpdec_reset_to_zero(&z_karatsuba, 0);
+}
+
+TEST_CASE("Multiplication: Karatsuba") {
+
+    SECTION("Threshold") {
+        size_t threshold = fpdec_get_karatsuba_threshold();
+        CHECK(threshold >= 4);
+        fpdec_set_karatsuba_threshold(0);
+        CHECK(fpdec_get_karatsuba_threshold() == 4);
+        fpdec_set_karatsuba_threshold(threshold);
+        CHECK(fpdec_get_karatsuba_threshold() == threshold);
+    }
+
+    SECTION("Balanced operands") {
+        uint64_t seed = 17;
+        for (size_t n : {76, 95, 133, 152, 190, 400, 777, 1021}) {
+            std::string lit_x = random_digits(n, seed);
+            std::string lit_y = random_digits(n, seed);
+            check_mul_with_karatsuba(lit_x, lit_y);
+            check_mul_with_karatsuba(lit_x.substr(0, n / 3) + "." +
+                                     lit_x.substr(n / 3), lit_y);
+        }
+    }
+
+    SECTION("Unbalanced operands") {
+        uint64_t seed = 29;
+        for (size_t nx : {80, 200, 500, 1000}) {
+            for (size_t ny : {76, 100, 170, 333}) {
+                std::string lit_x = random_digits(nx, seed);
+                std::string lit_y = random_digits(ny, seed);
+                check_mul_with_karatsuba(lit_x, "-" + lit_y);
+            }
+        }
+    }
+
+    SECTION("Carry propagation") {
+        for (size_t n : {76, 152, 399, 760}) {
+            std::string nines(n, '9');
+            check_mul_with_karatsuba(nines, nines);
+            check_mul_with_karatsuba(nines, nines.substr(0, n / 2 + 7));
+            check_mul_with_karatsuba("1" + std::string(n, '0') + "1",
+                                     nines);
+        }
+    }
+
+    SECTION("Threshold changed concurrently") {
+        size_t threshold = fpdec_get_karatsuba_threshold();
+        std::atomic<bool> done{false};
+        uint64_t seed = 41;
+        fpdec_t x = FPDEC_ZERO;
+        fpdec_t expected = FPDEC_ZERO;
+
+        REQUIRE(fpdec_from_ascii_literal(
+            &x, random_digits(1000, seed).c_str()) == FPDEC_OK);
+        REQUIRE(fpdec_mul(&expected, &x, &x) == FPDEC_OK);
+        std::thread thread([&done] {
+            while (!done)
+                for (size_t n : {4, 24, 1000})
+                    fpdec_set_karatsuba_threshold(n);
+        });
+        for (int i = 0; i < 50; ++i) {
+            fpdec_t z = FPDEC_ZERO;
+            REQUIRE(fpdec_mul(&z, &x, &x) == FPDEC_OK);
+            CHECK(fpdec_compare(&z, &expected, false) == 0);
+            fpdec_reset_to_zero(&z, 0);
+        }
+        done = true;
+        thread.join();
+        fpdec_set_karatsuba_threshold(threshold);
+        fpdec_reset_to_zero(&x, 0);
+        fpdec_reset_to_zero(&expected, 0);
+    }
+}
@@ -26,12 +26,21 @@ TEST_CASE("Magnitude") {
 
     SECTION("Shifted int variant") {
 
-        test_data tests[5] = {
-                {"-1234567890e8",           17},
-                {"82345678901234567890e-9", 10},
-                {"9",                       0},
-                {"-7e-4",                   -4},
-                {"0.000000005",             -9},
+        test_data tests[14] = {
+                {"-1234567890e8",                   17},
+                {"82345678901234567890e-9",         10},
+                {"9",                               0},
+                {"-7e-4",                           -4},
+                {"0.000000005",                     -9},
+                {"9999999999999999999",             18},
+                {"10000000000000000000",            19},
+                {"18446744073709551615",            19},
+                {"18446744073709551616",            19},
+                {"99999999999999999999",            19},
+                {"9999999999999999999999999999",    27},
+                {"10000000000000000000000000000",   28},
+                {"79228162514264337593543950335",   28},
+                {"9999999999.999999999999999999",   9},
         };
 
         for (const auto &test : tests) {
@@ -49,9 +58,11 @@ TEST_CASE("Magnitude") {
 
     SECTION("Digit array variant") {
 
-        test_data tests[7] = {
+        test_data tests[9] = {
                 {"-1234567890e83",                       92},
-                {"82345678901234567890e-12",             7},
+                {"9999999999999999999e-56",              -38},
+                {"1000000000000000000e-55",              -37},
+                {"82345678901234567890e-22",             -3},
                 {"123456789012345678901234567890e-12",   17},
                 {"999999999999999999999999999999999e-4", 28},
                 {"-7e-33",                               -33},
@@ -77,6 +77,51 @@ TEST_CASE("Quantize / dflt rounding") {
 }
 
 
+TEST_CASE("Quantize / thread-specific dflt rounding") {
+
+    fpdec_t x = FPDEC_ZERO;
+    fpdec_t q = FPDEC_ZERO;
+    fpdec_t z = FPDEC_ZERO;
+    error_t rc;
+
+    rc = fpdec_from_ascii_literal(&q, "0.5");
+    REQUIRE(rc == FPDEC_OK);
+    REQUIRE(fpdec_get_thread_default_rounding_mode() == FPDEC_ROUND_DEFAULT);
+    REQUIRE(fpdec_get_default_rounding_mode() == FPDEC_ROUND_HALF_EVEN);
+
+    SECTION("Thread-specific mode overrides process-wide mode") {
+        fpdec_set_thread_default_rounding_mode(FPDEC_ROUND_UP);
+        CHECK(fpdec_get_thread_default_rounding_mode() == FPDEC_ROUND_UP);
+        CHECK(fpdec_get_default_rounding_mode() == FPDEC_ROUND_UP);
+        rc = fpdec_from_ascii_literal(&x, "17.2");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_quantize(&x, &q, FPDEC_ROUND_DEFAULT);
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&z, "17.5");
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(fpdec_compare(&x, &z, false) == 0);
+    }
+
+    SECTION("Reset thread-specific mode") {
+        fpdec_set_thread_default_rounding_mode(FPDEC_ROUND_UP);
+        fpdec_set_thread_default_rounding_mode(FPDEC_ROUND_DEFAULT);
+        CHECK(fpdec_get_default_rounding_mode() == FPDEC_ROUND_HALF_EVEN);
+        rc = fpdec_from_ascii_literal(&x, "17.2");
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_quantize(&x, &q, FPDEC_ROUND_DEFAULT);
+        REQUIRE(rc == FPDEC_OK);
+        rc = fpdec_from_ascii_literal(&z, "17.0");
+        REQUIRE(rc == FPDEC_OK);
+        CHECK(fpdec_compare(&x, &z, false) == 0);
+    }
+
+    fpdec_set_thread_default_rounding_mode(FPDEC_ROUND_DEFAULT);
+    fpdec_reset_to_zero(&x, 0);
+    fpdec_reset_to_zero(&q, 0);
+    fpdec_reset_to_zero(&z, 0);
+}
+
+
 TEST_CASE("Quantize / ROUND_HALF_UP") {
 
     struct test_data {
@@ -0,0 +1,231 @@
+/* ---------------------------------------------------------------------------
+Name:        serialization_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <cstring>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdec.h"
+#include "fpdecimal.hpp"
+#include "checks.hpp"
+
+
+static const char *const literals[] = {
+    "0", "0.000", "17.5", "-17.5", "3", "-0.0000000000000000012",
+    "123456789012.345", "79228162514264337593543950335",
+    "-1234567890123456789012345.6789", "0.00000000000000000000000005",
+    "1.0000000000000000000000000000000000000000",
+    "-99999999999999999999999999999999999999.99999999999999999999",
+    "4.5e30", "-2.5e-40", "1e-65535", "-123e60000",
+};
+
+static void
+check_equal(const fpdec_t *z, const fpdec_t *expected) {
+    CHECK(fpdec_compare(z, expected, false) == 0);
+    CHECK(FPDEC_SIGN(z) == FPDEC_SIGN(expected));
+    CHECK(FPDEC_DEC_PREC(z) == FPDEC_DEC_PREC(expected));
+    CHECK(FPDEC_IS_DYN_ALLOC(z) == FPDEC_IS_DYN_ALLOC(expected));
+}
+
+static void
+check_untouched(const fpdec_t *z) {
+    CHECK(!FPDEC_IS_DYN_ALLOC(z));
+    CHECK(FPDEC_EQ_ZERO(z));
+    CHECK(FPDEC_DEC_PREC(z) == 0);
+}
+
+TEST_CASE("Binary serialization") {
+
+    SECTION("Round trip") {
+        for (const char *lit : literals) {
+            fpdec_t x = FPDEC_ZERO;
+            fpdec_t y = FPDEC_ZERO;
+            size_t size, len;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            size = fpdec_encoded_size(&x);
+            // decode from an unaligned position
+            std::vector<uint8_t> buf(size + 1, 0xFF);
+            REQUIRE(fpdec_encode(buf.data() + 1, size, &len, &x) ==
+                    FPDEC_OK);
+            CHECK(len == size);
+            REQUIRE(fpdec_decode(&y, buf.data() + 1, size, &len) ==
+                    FPDEC_OK);
+            CHECK(len == size);
+            check_equal(&y, &x);
+            fpdec_reset_to_zero(&x, 0);
+            fpdec_reset_to_zero(&y, 0);
+        }
+    }
+
+    SECTION("Stable encoding") {
+        fpdec_t x = FPDEC_ZERO;
+        uint8_t buf[32];
+        size_t len;
+        const uint8_t expected_shint[] = {0x12, 0x02, 0xD6, 0x0D, 0x00};
+        const uint8_t expected_dyn[] = {0x15, 0x00, 0x04, 0x01, 0x03};
+        const uint8_t expected_zero[] = {0x10, 0x03};
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "-17.50") == FPDEC_OK);
+        REQUIRE(fpdec_encode(buf, sizeof(buf), &len, &x) == FPDEC_OK);
+        REQUIRE(len == sizeof(expected_shint));
+        CHECK(memcmp(buf, expected_shint, len) == 0);
+        fpdec_reset_to_zero(&x, 0);
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "3e38") == FPDEC_OK);
+        REQUIRE(fpdec_encode(buf, sizeof(buf), &len, &x) == FPDEC_OK);
+        REQUIRE(len == sizeof(expected_dyn));
+        CHECK(memcmp(buf, expected_dyn, len) == 0);
+        fpdec_reset_to_zero(&x, 0);
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "0.000") == FPDEC_OK);
+        REQUIRE(fpdec_encode(buf, sizeof(buf), &len, &x) == FPDEC_OK);
+        REQUIRE(len == sizeof(expected_zero));
+        CHECK(memcmp(buf, expected_zero, len) == 0);
+    }
+
+    SECTION("Buffer too small") {
+        fpdec_t x = FPDEC_ZERO;
+        uint8_t buf[4] = {0xAA, 0xAA, 0xAA, 0xAA};
+        size_t len;
+
+        REQUIRE(fpdec_from_ascii_literal(&x, "-1234567890123456789012345.6789")
+                == FPDEC_OK);
+        REQUIRE(fpdec_encode(buf, sizeof(buf), &len, &x) == FPDEC_OK);
+        CHECK(len == fpdec_encoded_size(&x));
+        CHECK(len > sizeof(buf));
+        for (uint8_t byte : buf)
+            CHECK(byte == 0xAA);
+        REQUIRE(fpdec_encode(NULL, 0, &len, &x) == FPDEC_OK);
+        CHECK(len == fpdec_encoded_size(&x));
+        fpdec_reset_to_zero(&x, 0);
+    }
+
+    SECTION("Sequence of values") {
+        std::vector<uint8_t> buf;
+        size_t pos = 0;
+
+        for (const char *lit : literals) {
+            fpdec_t x = FPDEC_ZERO;
+            size_t len;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            buf.resize(pos + fpdec_encoded_size(&x));
+            REQUIRE(fpdec_encode(buf.data() + pos, buf.size() - pos, &len,
+                                 &x) == FPDEC_OK);
+            pos += len;
+            fpdec_reset_to_zero(&x, 0);
+        }
+        pos = 0;
+        for (const char *lit : literals) {
+            fpdec_t x = FPDEC_ZERO;
+            fpdec_t y = FPDEC_ZERO;
+            size_t len;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            REQUIRE(fpdec_decode(&y, buf.data() + pos, buf.size() - pos,
+                                 &len) == FPDEC_OK);
+            check_equal(&y, &x);
+            pos += len;
+            fpdec_reset_to_zero(&x, 0);
+            fpdec_reset_to_zero(&y, 0);
+        }
+        CHECK(pos == buf.size());
+    }
+}
+
+TEST_CASE("Binary serialization: invalid encodings") {
+
+    SECTION("Truncated") {
+        for (const char *lit : literals) {
+            fpdec_t x = FPDEC_ZERO;
+            size_t size, len;
+
+            REQUIRE(fpdec_from_ascii_literal(&x, lit) == FPDEC_OK);
+            size = fpdec_encoded_size(&x);
+            std::vector<uint8_t> buf(size);
+            REQUIRE(fpdec_encode(buf.data(), size, &len, &x) == FPDEC_OK);
+            for (size_t n = 0; n < size; ++n) {
+                fpdec_t y = FPDEC_ZERO;
+                CHECK(fpdec_decode(&y, buf.data(), n, &len) ==
+                      FPDEC_INVALID_ENCODING);
+                check_untouched(&y);
+            }
+            fpdec_reset_to_zero(&x, 0);
+        }
+    }
+
+    SECTION("Malformed") {
+        const std::vector<std::vector<uint8_t>> encodings = {
+            // unknown version
+            {0x22, 0x02, 0xD6, 0x0D, 0x00},
+            // reserved bit set
+            {0x1A, 0x02, 0xD6, 0x0D, 0x00},
+            // invalid sign
+            {0x13, 0x02, 0xD6, 0x0D, 0x00},
+            // zero flagged as digit array
+            {0x14, 0x02},
+            // precision too large
+            {0x10, 0x80, 0x80, 0x04},
+            // precision too large for a shifted int
+            {0x11, 0x13, 0x01, 0x00},
+            // shifted int with zero coefficient
+            {0x11, 0x02, 0x00, 0x00},
+            // high part of coefficient exceeds 32 bits
+            {0x11, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x10},
+            // varint exceeding 64 bits
+            {0x11, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+             0xFF, 0x02, 0x00},
+            // digit array without digits
+            {0x15, 0x00, 0x04, 0x00},
+            // digit >= 10^19
+            {0x15, 0x00, 0x04, 0x01,
+             0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01},
+            // leading / trailing zero digit
+            {0x15, 0x00, 0x04, 0x02, 0x01, 0x00},
+            {0x15, 0x00, 0x04, 0x02, 0x00, 0x01},
+            // exponent below min
+            {0x15, 0x00, 0xF5, 0x35, 0x01, 0x01},
+            // precision less than number of fractional digits
+            {0x15, 0x12, 0x01, 0x01, 0x01},
+        };
+
+        for (const auto &enc : encodings) {
+            fpdec_t y = FPDEC_ZERO;
+            size_t len;
+            CHECK(fpdec_decode(&y, enc.data(), enc.size(), &len) ==
+                  FPDEC_INVALID_ENCODING);
+            check_untouched(&y);
+        }
+    }
+}
+
+TEST_CASE("Decimal binary serialization") {
+    using fpdec::Decimal;
+
+    for (const char *lit : literals) {
+        Decimal x(lit);
+        std::vector<uint8_t> buf = x.encoded();
+        size_t n_read = 0;
+
+        CHECK(buf.size() == x.encoded_size());
+        Decimal y = Decimal::decoded(buf.data(), buf.size(), &n_read);
+        CHECK(n_read == buf.size());
+        CHECK(y == x);
+        CHECK(y.precision() == x.precision());
+    }
+    const uint8_t invalid[] = {0x22, 0x02, 0xD6, 0x0D, 0x00};
+    CHECK_THROWS_AS(Decimal::decoded(invalid, sizeof(invalid)),
+                    fpdec::InvalidEncoding);
+}
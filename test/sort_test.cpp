@@ -0,0 +1,118 @@
+/* ---------------------------------------------------------------------------
+Name:        sort_test.cpp
+
+Author:      Michael Amrhein (michael@adrhinum.de)
+
+Copyright:   (c) 2020 ff. Michael Amrhein
+License:     This program is part of a larger application. For license
+             details please read the file LICENSE.TXT provided together
+             with the application.
+------------------------------------------------------------------------------
+$Source$
+$Revision$
+*/
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "fpdecimal.hpp"
+
+using fpdec::Decimal;
+
+static std::vector<Decimal>
+random_decimals(size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Decimal> vals;
+
+    vals.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::string lit;
+        if (rng() % 2)
+            lit += '-';
+        // many duplicates and values sharing long prefixes
+        switch (rng() % 4) {
+            case 0:
+                lit += std::to_string(rng() % 100);
+                break;
+            case 1:
+                lit += std::to_string(rng() % 1000) + "." +
+                       std::to_string(rng() % 1000);
+                break;
+            case 2:
+                // longer than the key prefix used for sorting
+                lit += "123456789012345678901234567890123456789012345." +
+                       std::to_string(rng() % 50) + (rng() % 2 ? "0" : "");
+                break;
+            default:
+                lit += std::to_string(rng()) + "e" +
+                       std::to_string((int)(rng() % 200) - 100);
+        }
+        vals.emplace_back(lit);
+    }
+    return vals;
+}
+
+static bool
+identical(const std::vector<Decimal> &lhs, const std::vector<Decimal> &rhs) {
+    for (size_t i = 0; i < lhs.size(); ++i)
+        if (lhs[i] != rhs[i] || lhs[i].precision() != rhs[i].precision())
+            return false;
+    return lhs.size() == rhs.size();
+}
+
+TEST_CASE("Sort Decimals") {
+    const size_t sizes[] = {0, 1, 2, 50, 1000, 70000};
+
+    for (size_t n : sizes) {
+        std::vector<Decimal> vals = random_decimals(n, (unsigned)n);
+        std::vector<Decimal> expected = vals;
+        std::stable_sort(expected.begin(), expected.end());
+
+        for (unsigned n_threads : {1U, 4U}) {
+            std::vector<Decimal> sorted = vals;
+            fpdec::stable_sort(sorted.data(), sorted.data() + n, n_threads);
+            CHECK(identical(sorted, expected));
+            sorted = vals;
+            fpdec::sort(sorted.data(), sorted.data() + n, n_threads);
+            CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+        }
+    }
+}
+
+TEST_CASE("Select nth Decimal") {
+    std::vector<Decimal> vals = random_decimals(5000, 17);
+    std::vector<Decimal> sorted = vals;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (size_t nth : {(size_t)0, (size_t)1, (size_t)2500, (size_t)4999}) {
+        std::vector<Decimal> part = vals;
+        fpdec::nth_element(part.data(), part.data() + nth,
+                           part.data() + part.size());
+        CHECK(part[nth] == sorted[nth]);
+        for (size_t i = 0; i < nth; ++i)
+            REQUIRE(part[i] <= part[nth]);
+        for (size_t i = nth + 1; i < part.size(); ++i)
+            REQUIRE(part[nth] <= part[i]);
+    }
+}
+
+TEST_CASE("Search sorted Decimals") {
+    std::vector<Decimal> sorted = random_decimals(3000, 4711);
+    std::vector<Decimal> probes = random_decimals(500, 815);
+    std::sort(sorted.begin(), sorted.end());
+    probes.insert(probes.end(), sorted.begin(), sorted.begin() + 100);
+    probes.emplace_back(0);
+    probes.emplace_back("1e1000");
+    probes.emplace_back("-1e1000");
+
+    const Decimal *first = sorted.data();
+    const Decimal *last = first + sorted.size();
+    for (const Decimal &probe : probes) {
+        const Decimal *pos = fpdec::lower_bound(first, last, probe);
+        CHECK(pos == std::lower_bound(first, last, probe));
+    }
+    CHECK(fpdec::lower_bound(first, first, probes[0]) == first);
+}